@@ -0,0 +1,116 @@
+#include "catch.hpp"
+#include <vector>
+#include <thread>
+#include <yat/threading/Atomic.h>
+
+namespace
+{
+  struct Triple
+  {
+    yat::int64 a, b, c;
+    bool operator== (const Triple & t) const { return a == t.a && b == t.b && c == t.c; }
+  };
+}
+
+TEST_CASE("atomic_operations", "[Atomic]")
+{
+  yat::Atomic<int> ai(1);
+  int i(ai);
+  CHECK(ai + i == 2);
+  CHECK(++ai == 2);
+  CHECK(ai++ == 2);
+  CHECK(--ai == 2);
+  CHECK((ai += 5) == 7);
+  CHECK((ai -= 2) == 5);
+  CHECK((ai |= 8) == 13);
+  CHECK((ai &= 9) == 9);
+  CHECK((ai ^= 1) == 8);
+  CHECK(ai.exchange(3) == 8);
+  CHECK(ai.fetch_add(2, yat::memory_order_relaxed) == 3);
+  CHECK(ai.load(yat::memory_order_acquire) == 5);
+
+  int expected = 4;
+  CHECK_FALSE(ai.compare_exchange_strong(expected, 10));
+  CHECK(expected == 5);
+  CHECK(ai.compare_exchange_strong(expected, 10, yat::memory_order_acq_rel));
+  CHECK(ai == 10);
+  while( ! ai.compare_exchange_weak(expected, 11, yat::memory_order_release, yat::memory_order_relaxed) ) {}
+  CHECK(ai == 11);
+
+  yat::atomic_double ad(0.5);
+  CHECK((ad += 1.) == 1.5);
+  CHECK(ad.fetch_sub(0.5) == 1.5);
+  CHECK(ad == 1.);
+
+  yat::atomic_bool ab;
+  CHECK_FALSE(ab.load());
+  CHECK_FALSE(ab.exchange(true));
+  CHECK(ab);
+
+#if defined (YAT_CPP11)
+  CHECK(ai.is_lock_free());
+  CHECK(ad.is_lock_free());
+#endif
+
+  //- not lock-free: mutex based
+  Triple t0 = { 1, 2, 3 };
+  Triple t1 = { 4, 5, 6 };
+  yat::Atomic<Triple> at(t0);
+  CHECK_FALSE(at.is_lock_free());
+  CHECK(at.exchange(t1) == t0);
+  Triple e = t0;
+  CHECK_FALSE(at.compare_exchange_strong(e, t0));
+  CHECK(e == t1);
+}
+
+TEST_CASE("atomic_pointer_and_bool", "[Atomic]")
+{
+  int items[4] = { 0, 1, 2, 3 };
+  yat::Atomic<int *> ap(items);
+  CHECK(++ap == items + 1);
+  CHECK(ap++ == items + 1);
+  CHECK((ap += 1) == items + 3);
+  CHECK(--ap == items + 2);
+  CHECK(ap-- == items + 2);
+  CHECK((ap -= 1) == items);
+  CHECK(ap.fetch_add(3) == items);
+  CHECK(*ap.load() == 3);
+
+  //- same operations with the mutex based implementation
+  yat::AtomicImpl<int *, false> mp(items);
+  CHECK(mp.fetch_add(2) == items);
+  CHECK(mp.fetch_sub(1) == items + 2);
+  CHECK(mp.load() == items + 1);
+
+  yat::atomic_bool ab(false);
+  CHECK((ab |= true) == true);
+  CHECK((ab &= true) == true);
+  CHECK((ab ^= true) == false);
+  CHECK((ab &= true) == false);
+  CHECK_FALSE(ab.fetch_or(true));
+  CHECK(ab.fetch_and(false));
+  CHECK_FALSE(ab);
+}
+
+TEST_CASE("atomic_contended_counter", "[Atomic]")
+{
+  const size_t kTHREADS = 4;
+  const size_t kLOOPS = 250000;
+
+  yat::atomic_uint64 counter;
+  yat::Atomic<double> sum(0.);
+  std::vector<std::thread> threads;
+  for( size_t i = 0; i < kTHREADS; ++i )
+    threads.push_back(std::thread([&counter, &sum, kLOOPS]()
+    {
+      for( size_t j = 0; j < kLOOPS; ++j )
+        ++counter;
+      for( size_t j = 0; j < 1000; ++j )
+        sum += 1.;
+    }));
+  for( size_t i = 0; i < kTHREADS; ++i )
+    threads[i].join();
+
+  CHECK(counter == kTHREADS * kLOOPS);
+  CHECK(sum == kTHREADS * 1000.);
+}
@@ -0,0 +1,96 @@
+#include "catch.hpp"
+#include <vector>
+#include <yat/utils/Callback.h>
+
+namespace
+{
+  YAT_DEFINE_CALLBACK(IntCallback, int);
+
+  int free_sum = 0;
+  void add_to_free_sum(int v) { free_sum += v; }
+
+  struct Accumulator
+  {
+    Accumulator() : sum(0) {}
+    void add(int v) { sum += v; }
+    void sub(int v) { sum -= v; }
+    int sum;
+  };
+
+  //- a functor too large to be stored inline
+  struct BigFunctor
+  {
+    BigFunctor(int* t) : target(t) { for( size_t i = 0; i < 8; ++i ) pad[i] = 0; }
+    void operator()(int v) const { *target += v; }
+    bool operator==(const BigFunctor& f) const { return target == f.target; }
+    operator bool() const { return true; }
+    int* target;
+    double pad[8];
+  };
+
+  bool is_inline(const IntCallback& cb)
+  {
+    const char* c = reinterpret_cast<const char*>(cb.get_container());
+    const char* o = reinterpret_cast<const char*>(&cb);
+    return c >= o && c < o + sizeof(cb);
+  }
+
+  void invoke(yat::CallbackRef<int> cb, int v)
+  {
+    cb(v);
+  }
+}
+
+TEST_CASE("callback_inline_storage", "[Callback]")
+{
+  Accumulator acc;
+  IntCallback m = IntCallback::instanciate(acc, &Accumulator::add);
+  IntCallback f = IntCallback::instanciate(&add_to_free_sum);
+  CHECK(is_inline(m));
+  CHECK(is_inline(f));
+
+  //- copies are inline too, and remain equal
+  std::vector<IntCallback> v(3, m);
+  v.push_back(f);
+  for( size_t i = 0; i < v.size(); ++i )
+  {
+    CHECK(is_inline(v[i]));
+    v[i](1);
+  }
+  CHECK(acc.sum == 3);
+  CHECK(free_sum == 1);
+  CHECK(v[0] == m);
+  CHECK_FALSE(v[3] == m);
+  CHECK_FALSE(m == IntCallback::instanciate(acc, &Accumulator::sub));
+
+  //- assignment
+  v[0] = f;
+  CHECK(v[0] == f);
+  v[0] = IntCallback();
+  CHECK(v[0].is_empty());
+  CHECK_THROWS_AS(v[0](1), yat::Exception);
+
+  //- large functor: heap allocated
+  int target = 0;
+  IntCallback big = IntCallback::instanciate(BigFunctor(&target));
+  CHECK_FALSE(is_inline(big));
+  IntCallback big_copy(big);
+  big_copy(2);
+  CHECK(target == 2);
+  CHECK(big_copy == big);
+}
+
+TEST_CASE("callback_ref", "[Callback]")
+{
+  Accumulator acc;
+  IntCallback m = IntCallback::instanciate(acc, &Accumulator::add);
+  invoke(m, 1);
+  invoke(yat::CallbackRef<int>::bind<Accumulator, &Accumulator::sub>(acc), 3);
+  CHECK(acc.sum == -2);
+
+  free_sum = 0;
+  invoke(&add_to_free_sum, 5);
+  CHECK(free_sum == 5);
+
+  CHECK_THROWS_AS(invoke(IntCallback(), 1), yat::Exception);
+}
@@ -0,0 +1,151 @@
+#include "catch.hpp"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <yat/threading/Task.h>
+#include <yat/threading/TaskExecutor.h>
+
+namespace
+{
+  const size_t kTEST_MSG = yat::FIRST_USER_MSG;
+
+  // checks msgs of each producer are handled in posting order and never concurrently
+  class OrderingTask : public yat::Task
+  {
+  public:
+    OrderingTask (const yat::Task::Config & cfg, size_t producers)
+      : yat::Task(cfg), count(0), errors(0), busy(false), last(producers, 0)
+    {}
+    std::atomic<size_t> count;
+    std::atomic<size_t> errors;
+  protected:
+    virtual void handle_message (yat::Message & msg)
+    {
+      if( msg.type() != kTEST_MSG )
+        return;
+      if( busy.exchange(true) )
+        ++errors;
+      std::pair<size_t, size_t> & d = msg.get_data<std::pair<size_t, size_t> >();
+      if( d.second != last[d.first] + 1 )
+        ++errors;
+      last[d.first] = d.second;
+      ++count;
+      busy = false;
+    }
+  private:
+    std::atomic<bool> busy;
+    std::vector<size_t> last;
+  };
+
+  class TimingTask : public yat::Task
+  {
+  public:
+    TimingTask (const yat::Task::Config & cfg)
+      : yat::Task(cfg), timeouts(0), periodics(0)
+    {}
+    std::atomic<size_t> timeouts;
+    std::atomic<size_t> periodics;
+  protected:
+    virtual void handle_message (yat::Message & msg)
+    {
+      if( msg.type() == yat::TASK_TIMEOUT )
+        ++timeouts;
+      else if( msg.type() == yat::TASK_PERIODIC )
+        ++periodics;
+    }
+  };
+}
+
+TEST_CASE("executor_per_task_ordering", "[TaskExecutor]")
+{
+  const size_t kTASKS = 64;
+  const size_t kPRODUCERS = 4;
+  const size_t kMSGS = 200;
+
+  yat::TaskExecutor executor(2);
+  CHECK(executor.num_workers() == 2);
+
+  yat::Task::Config cfg;
+  cfg.executor = &executor;
+  cfg.lo_wm = 64;
+  cfg.hi_wm = 128;
+  std::vector<OrderingTask *> tasks;
+  for( size_t t = 0; t < kTASKS; ++t )
+  {
+    //- mix the single msg and batch modes
+    cfg.msg_batch_size = t % 2 ? 8 : 1;
+    tasks.push_back(new OrderingTask(cfg, kPRODUCERS));
+    tasks.back()->go();
+  }
+
+  std::vector<std::thread> producers;
+  for( size_t p = 0; p < kPRODUCERS; ++p )
+    producers.push_back(std::thread([&tasks, p, kMSGS]()
+    {
+      for( size_t i = 1; i <= kMSGS; ++i )
+        for( size_t t = 0; t < tasks.size(); ++t )
+          tasks[t]->post(kTEST_MSG, std::make_pair(p, i), 5000);
+    }));
+  for( size_t p = 0; p < kPRODUCERS; ++p )
+    producers[p].join();
+
+  for( size_t t = 0; t < kTASKS; ++t )
+  {
+    //- make sure everything has been handled
+    tasks[t]->wait_msg_handled(kTEST_MSG + 1, 5000);
+    CHECK(tasks[t]->count == kPRODUCERS * kMSGS);
+    CHECK(tasks[t]->errors == 0);
+    tasks[t]->exit();
+  }
+}
+
+TEST_CASE("executor_timeout_and_periodic_msgs", "[TaskExecutor]")
+{
+  yat::TaskExecutor executor(1);
+
+  yat::Task::Config cfg;
+  cfg.executor = &executor;
+  cfg.enable_timeout_msg = true;
+  cfg.timeout_msg_period_ms = 20;
+  TimingTask * tmo_task = new TimingTask(cfg);
+
+  cfg.enable_timeout_msg = false;
+  cfg.enable_periodic_msg = true;
+  cfg.periodic_msg_period_ms = 10;
+  TimingTask * periodic_task = new TimingTask(cfg);
+
+  tmo_task->go();
+  periodic_task->go();
+  yat::Thread::sleep(300);
+
+  CHECK(tmo_task->timeouts >= 5);
+  CHECK(tmo_task->timeouts <= 15);
+  CHECK(tmo_task->periodics == 0);
+  CHECK(periodic_task->periodics >= 10);
+  CHECK(periodic_task->periodics <= 30);
+  CHECK(periodic_task->timeouts == 0);
+
+  //- runtime changes
+  periodic_task->enable_periodic_msg(false);
+  tmo_task->enable_timeout_msg(false);
+  //- handled after the WAKEUP msg posted by enable_periodic_msg
+  periodic_task->wait_msg_handled(kTEST_MSG, 1000);
+  tmo_task->wait_msg_handled(kTEST_MSG, 1000);
+  size_t periodics = periodic_task->periodics;
+  size_t timeouts = tmo_task->timeouts;
+  yat::Thread::sleep(100);
+  CHECK(periodic_task->periodics == periodics);
+  CHECK(tmo_task->timeouts == timeouts);
+
+  tmo_task->exit();
+  periodic_task->exit();
+}
+
+TEST_CASE("executor_task_never_started", "[TaskExecutor]")
+{
+  yat::TaskExecutor executor(1);
+  yat::Task::Config cfg;
+  cfg.executor = &executor;
+  TimingTask * t = new TimingTask(cfg);
+  t->exit();
+}
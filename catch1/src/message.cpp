@@ -0,0 +1,231 @@
+#include "catch.hpp"
+#include <vector>
+#include <string>
+#include <thread>
+#include <yat/threading/Message.h>
+
+namespace
+{
+  const size_t kTEST_MSG = yat::FIRST_USER_MSG;
+  const size_t kMSGS = 100;
+
+  class MyMessage : public yat::Message
+  {
+  public:
+    MyMessage () : yat::Message(kTEST_MSG), payload(42) {}
+    double payload;
+  };
+}
+
+TEST_CASE("msg_pool_local_reuse", "[Message]")
+{
+  yat::Message::enable_pool(true);
+  yat::Message::reset_pool_statistics();
+
+  std::thread t([]()
+  {
+    std::vector<yat::Message *> msgs;
+    for( int pass = 0; pass < 2; ++pass )
+    {
+      for( size_t i = 0; i < kMSGS; ++i )
+        msgs.push_back(new yat::Message(kTEST_MSG));
+      for( size_t i = 0; i < kMSGS; ++i )
+        msgs[i]->release();
+      msgs.clear();
+    }
+  });
+  t.join();
+
+  yat::Message::PoolStatistics s = yat::Message::pool_statistics();
+  CHECK(s.hits_ >= kMSGS);
+  CHECK(s.misses_ <= kMSGS);
+  CHECK(s.remote_frees_ == 0);
+  yat::Message::enable_pool(false);
+}
+
+TEST_CASE("msg_pool_remote_free", "[Message]")
+{
+  yat::Message::enable_pool(true);
+  yat::Message::reset_pool_statistics();
+
+  //- msgs allocated by a thread then released by another one
+  std::vector<yat::Message *> msgs;
+  std::thread t([&msgs]()
+  {
+    for( size_t i = 0; i < kMSGS; ++i )
+      msgs.push_back(new (std::nothrow) yat::Message(kTEST_MSG));
+  });
+  t.join();
+  for( size_t i = 0; i < kMSGS; ++i )
+    msgs[i]->release();
+
+  yat::Message::PoolStatistics s = yat::Message::pool_statistics();
+  CHECK(s.remote_frees_ == kMSGS);
+
+  //- derived classes are not pooled but still work
+  MyMessage * m = new MyMessage;
+  CHECK(m->payload == 42);
+  m->release();
+  CHECK(yat::Message::pool_statistics().hits_ == s.hits_);
+
+  yat::Message::enable_pool(false);
+  CHECK(! yat::Message::pool_enabled());
+}
+
+TEST_CASE("msg_pool_remote_free_capacity", "[Message]")
+{
+  yat::Message::enable_pool(true);
+  yat::Message::reset_pool_statistics();
+
+  //- msgs allocated by an exited thread: its pool has no owner anymore
+  const size_t n = kMSG_POOL_CAPACITY + kMSGS;
+  std::vector<yat::Message *> msgs;
+  std::thread t([&msgs, n]()
+  {
+    for( size_t i = 0; i < n; ++i )
+      msgs.push_back(new yat::Message(kTEST_MSG));
+  });
+  t.join();
+
+  //- released by a thread that never allocated: the blocks beyond the pool
+  //- capacity go back to the heap
+  std::thread r([&msgs, n]()
+  {
+    for( size_t i = 0; i < n; ++i )
+      msgs[i]->release();
+  });
+  r.join();
+
+  CHECK(yat::Message::pool_statistics().remote_frees_ == kMSG_POOL_CAPACITY);
+  yat::Message::enable_pool(false);
+}
+
+TEST_CASE("msg_inline_data", "[Message]")
+{
+  struct Event
+  {
+    yat::uint32 number;
+    double timestamp;
+  };
+  CHECK(yat::MessageInlineData<yat::uint32>::value);
+  CHECK(yat::MessageInlineData<Event>::value);
+  CHECK(! yat::MessageInlineData<std::string>::value);
+
+  yat::Message * m = new yat::Message(kTEST_MSG);
+  m->attach_data(yat::uint32(12));
+  CHECK(m->get_data<yat::uint32>() == 12);
+  CHECK(! m->check_attached_data_type<double>());
+
+  //- re-attach data of another type
+  Event e = { 7, 1.5 };
+  m->attach_data(e);
+  CHECK(m->get_data<Event>().number == 7);
+  CHECK_THROWS(m->get_data<yat::uint32>());
+
+  //- detaching inline data moves it to the caller and leaves the message empty
+  Event * pe = m->detach_data<Event>();
+  REQUIRE(pe != 0);
+  CHECK(pe->timestamp == 1.5);
+  delete pe;
+  CHECK_FALSE(m->check_attached_data_type<Event>());
+  CHECK_THROWS(m->get_data<Event>());
+  CHECK(m->detach_data<Event>() == 0);
+
+  //- external data replaces inline data
+  m->attach_data(new Event(e), true);
+  CHECK(m->get_data<Event>().number == 7);
+  m->release();
+}
+
+TEST_CASE("msg_move_data", "[Message]")
+{
+  std::vector<double> v(1000, 1.0);
+  const double * p = &v[0];
+
+  yat::Message * m = new yat::Message(kTEST_MSG);
+  m->attach_data(std::move(v));
+  std::vector<double> & d = m->get_data<std::vector<double> >();
+  CHECK(d.size() == 1000);
+  CHECK(&d[0] == p);
+
+  std::vector<double> * dd = 0;
+  m->detach_data(dd);
+  REQUIRE(dd != 0);
+  CHECK(&(*dd)[0] == p);
+  delete dd;
+  //- the message is left empty
+  CHECK_FALSE(m->check_attached_data_type<std::vector<double> >());
+  CHECK_THROWS(m->get_data<std::vector<double> >());
+  CHECK_THROWS(m->detach_data(dd));
+  m->release();
+}
+
+TEST_CASE("container_type_tags", "[Message]")
+{
+  CHECK(yat::TypeTag<int>::id() == yat::TypeTag<int>::id());
+  CHECK(yat::TypeTag<int>::id() != yat::TypeTag<unsigned int>::id());
+
+  yat::GenericContainer<int> ci(3);
+  yat::Container & c = ci;
+  CHECK(c.type_tag() == yat::TypeTag<int>::id());
+  CHECK(yat::container_cast<int>(&c) == &ci);
+  CHECK(yat::any_cast<double>(&c) == 0);
+  CHECK(yat::any_cast<int>(c) == 3);
+  CHECK_THROWS(yat::any_cast<long>(c));
+}
+
+namespace
+{
+  //- a container built by another shared library: same type, different tag
+  char foreign_int_tag = 0;
+
+  class ForeignIntContainer : public yat::GenericContainer<int>
+  {
+  public:
+    ForeignIntContainer (int i)
+      : yat::GenericContainer<int>(i, &foreign_int_tag)
+    {}
+  };
+}
+
+TEST_CASE("container_type_tag_mismatch", "[Message]")
+{
+  ForeignIntContainer fi(5);
+  yat::Container & c = fi;
+  CHECK(c.type_tag() != yat::TypeTag<int>::id());
+  //- RTTI fallback
+  CHECK(yat::container_cast<int>(&c) == &fi);
+  CHECK(yat::any_cast<int>(c) == 5);
+  CHECK(yat::container_cast<unsigned int>(&c) == 0);
+  CHECK_THROWS(yat::any_cast<long>(c));
+}
+
+TEST_CASE("shared_object_contended_refcount", "[Message]")
+{
+  const size_t kTHREADS = 4;
+  const size_t kLOOPS = 250000;
+
+  struct Counted : public yat::SharedObject {};
+  Counted * o = new Counted;
+  yat::Message * m = new yat::Message(kTEST_MSG);
+
+  //- all threads hammer the same reference counts
+  std::vector<std::thread> threads;
+  for( size_t i = 0; i < kTHREADS; ++i )
+    threads.push_back(std::thread([o, m, kLOOPS]()
+    {
+      for( size_t j = 0; j < kLOOPS; ++j )
+      {
+        o->duplicate();
+        m->duplicate();
+        o->release();
+        m->release();
+      }
+    }));
+  for( size_t i = 0; i < kTHREADS; ++i )
+    threads[i].join();
+
+  CHECK(o->reference_count() == 1);
+  CHECK(o->release() == 0);
+  m->release();
+}
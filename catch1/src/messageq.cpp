@@ -0,0 +1,567 @@
+#include "catch.hpp"
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <yat/threading/Task.h>
+
+namespace
+{
+  const size_t kTEST_MSG = yat::FIRST_USER_MSG;
+
+  // post msgs of various priorities then check they are extracted in the expected order
+  void check_priority_order (bool lock_free)
+  {
+    yat::MessageQ q(8, 64, false, lock_free);
+    const size_t prio[] = { 1, 5, 3, 5, 0 };
+    for( size_t i = 0; i < 5; ++i )
+    {
+      yat::Message * m = new yat::Message(kTEST_MSG + i, prio[i]);
+      REQUIRE(q.post(m) == 0);
+    }
+    const size_t expected[] = { 1, 3, 2, 0, 4 };
+    for( size_t i = 0; i < 5; ++i )
+    {
+      yat::Message * m = q.next_message(100);
+      REQUIRE(m != 0);
+      CHECK(m->type() == kTEST_MSG + expected[i]);
+      m->release();
+    }
+  }
+
+  class CountingTask : public yat::Task
+  {
+  public:
+    CountingTask (const yat::Task::Config & cfg)
+      : yat::Task(cfg), count(0)
+    {}
+    std::atomic<size_t> count;
+  protected:
+    virtual void handle_message (yat::Message & msg)
+    {
+      if( msg.type() == kTEST_MSG )
+        ++count;
+    }
+  };
+
+  class BatchTask : public CountingTask
+  {
+  public:
+    BatchTask (const yat::Task::Config & cfg)
+      : CountingTask(cfg), batches(0), max_batch(0)
+    {}
+    std::atomic<size_t> batches;
+    std::atomic<size_t> max_batch;
+  protected:
+    virtual void handle_messages (std::vector<yat::Message *> & msgs)
+    {
+      ++batches;
+      if( msgs.size() > max_batch )
+        max_batch = msgs.size();
+      yat::Task::handle_messages(msgs);
+    }
+  };
+
+  class SleepingTask : public CountingTask
+  {
+  public:
+    SleepingTask (const yat::Task::Config & cfg)
+      : CountingTask(cfg)
+    {}
+  protected:
+    virtual void handle_message (yat::Message & msg)
+    {
+      if( msg.type() == kTEST_MSG + 1 )
+        yat::Thread::sleep(2);
+      CountingTask::handle_message(msg);
+    }
+  };
+
+  // counts the PERIODIC msgs, optionally overruns the <overrun>th period
+  class PeriodicTask : public CountingTask
+  {
+  public:
+    PeriodicTask (const yat::Task::Config & cfg)
+      : CountingTask(cfg), periodics(0), overrun(0)
+    {}
+    std::atomic<size_t> periodics;
+    size_t overrun;
+  protected:
+    virtual void handle_message (yat::Message & msg)
+    {
+      if( msg.type() == yat::TASK_PERIODIC && ++periodics == overrun )
+        yat::Thread::sleep(35);
+      CountingTask::handle_message(msg);
+    }
+  };
+
+  // sums the values of the coalesced msgs
+  class SumCoalescer : public yat::MessageQ::Coalescer
+  {
+  public:
+    virtual void merge (yat::Message & pending, yat::Message & posted)
+    {
+      pending.get_data<size_t>() += posted.get_data<size_t>();
+    }
+  };
+
+  // post a flood of coalesced msgs (more than the hi wm) between two regular msgs
+  void check_coalescing (bool lock_free, yat::MessageQ::Coalescer * merger)
+  {
+    yat::MessageQ q(8, 16, false, lock_free);
+    q.enable_coalescing(kTEST_MSG + 1, merger);
+    CHECK(q.coalescing_enabled(kTEST_MSG + 1));
+    CHECK_FALSE(q.coalescing_enabled(kTEST_MSG));
+
+    REQUIRE(q.post(new yat::Message(kTEST_MSG), 0) == 0);
+    for( size_t i = 1; i <= 100; ++i )
+    {
+      yat::Message * m = new yat::Message(kTEST_MSG + 1);
+      m->attach_data(i);
+      REQUIRE(q.post(m, 0) == 0);
+    }
+    REQUIRE(q.post(new yat::Message(kTEST_MSG + 2), 0) == 0);
+
+    const yat::MessageQ::Statistics & stats = q.statistics();
+    CHECK(stats.coalesced_msg_counter_ == 99);
+    CHECK(stats.trashed_on_post_tmo_counter_ == 0);
+
+    const size_t expected[] = { kTEST_MSG, kTEST_MSG + 1, kTEST_MSG + 2 };
+    for( size_t i = 0; i < 3; ++i )
+    {
+      yat::Message * m = q.next_message(100);
+      REQUIRE(m != 0);
+      CHECK(m->type() == expected[i]);
+      if( m->type() == kTEST_MSG + 1 )
+        CHECK(m->get_data<size_t>() == (merger ? 5050 : 100));
+      m->release();
+    }
+    CHECK(q.next_message(10) == 0);
+
+    //- nothing pending: the next msg is enqueued
+    q.disable_coalescing(kTEST_MSG + 1);
+    REQUIRE(q.post(new yat::Message(kTEST_MSG + 1), 0) == 0);
+    REQUIRE(q.post(new yat::Message(kTEST_MSG + 1), 0) == 0);
+    CHECK(q.statistics().pending_mgs_ == 2);
+    CHECK(q.statistics().coalesced_msg_counter_ == 99);
+  }
+
+  // a replacing msg takes its own priority
+  void check_coalescing_priority (bool lock_free)
+  {
+    yat::MessageQ q(8, 16, false, lock_free);
+    q.enable_coalescing(kTEST_MSG + 1);
+
+    REQUIRE(q.post(new yat::Message(kTEST_MSG + 1, 0), 0) == 0);
+    REQUIRE(q.post(new yat::Message(kTEST_MSG, 5), 0) == 0);
+    REQUIRE(q.post(new yat::Message(kTEST_MSG + 1, 10), 0) == 0);
+    CHECK(q.statistics().coalesced_msg_counter_ == 1);
+
+    yat::Message * m = q.next_message(100);
+    REQUIRE(m != 0);
+    CHECK(m->type() == kTEST_MSG + 1);
+    CHECK(m->priority() == 10);
+    m->release();
+    m = q.next_message(100);
+    REQUIRE(m != 0);
+    CHECK(m->type() == kTEST_MSG);
+    m->release();
+    CHECK(q.next_message(10) == 0);
+  }
+
+  // a consumer blocked on an empty msgQ is woken up once per msg, the others are not disturbed
+  void check_wakeup (bool lock_free)
+  {
+    yat::MessageQ q(8, 16, false, lock_free);
+
+    //- nobody waiting: no wakeup
+    for( size_t i = 0; i < 4; ++i )
+      REQUIRE(q.post(new yat::Message(kTEST_MSG), 0) == 0);
+    for( size_t i = 0; i < 4; ++i )
+      q.next_message(10)->release();
+    CHECK(q.statistics().consumer_woken_counter_ == 0);
+    CHECK(q.statistics().consumer_parked_counter_ == 0);
+
+    std::thread consumer([&q]()
+    {
+      for( size_t i = 0; i < 5; ++i )
+      {
+        yat::Message * m = q.next_message(5000);
+        if( m )
+          m->release();
+      }
+    });
+    for( size_t i = 0; i < 5; ++i )
+    {
+      yat::Thread::sleep(20);
+      REQUIRE(q.post(new yat::Message(kTEST_MSG), 0) == 0);
+    }
+    consumer.join();
+    //- one wakeup per msg posted while the consumer was blocked
+    CHECK(q.statistics().consumer_woken_counter_ >= 1);
+    CHECK(q.statistics().consumer_woken_counter_ <= 5);
+    CHECK(q.statistics().consumer_parked_counter_ >= q.statistics().consumer_woken_counter_);
+    CHECK(q.statistics().consumer_spun_counter_ == 0);
+  }
+
+  // a spinning consumer gets the msg without blocking
+  void check_spin (bool lock_free)
+  {
+    yat::MessageQ q(8, 16, false, lock_free);
+    q.consumer_spin_usecs(2000000);
+    CHECK(q.consumer_spin_usecs() == 2000000);
+
+    std::thread producer([&q]()
+    {
+      yat::Thread::sleep(20);
+      q.post(new yat::Message(kTEST_MSG), 0);
+    });
+    yat::Message * m = q.next_message(5000);
+    producer.join();
+    REQUIRE(m != 0);
+    m->release();
+    CHECK(q.statistics().consumer_spun_counter_ == 1);
+    CHECK(q.statistics().consumer_parked_counter_ == 0);
+    CHECK(q.statistics().consumer_woken_counter_ == 0);
+
+    //- the spin is bounded by the tmo, and counts in it
+    yat::Timer t;
+    CHECK(q.next_message(50) == 0);
+    double ms = t.elapsed_msec();
+    CHECK(ms >= 49.);
+    CHECK(ms < 90.);
+    CHECK(q.statistics().consumer_parked_counter_ == 0);
+
+    //- a shorter spin: the consumer blocks for the rest of the tmo only
+    q.consumer_spin_usecs(30000);
+    t.restart();
+    CHECK(q.next_message(50) == 0);
+    ms = t.elapsed_msec();
+    CHECK(ms >= 49.);
+    CHECK(ms < 75.);
+    CHECK(q.statistics().consumer_parked_counter_ == 1);
+  }
+
+  // post a batch then extract it in one go
+  void check_batch (bool lock_free)
+  {
+    yat::MessageQ q(64, 128, false, lock_free);
+    std::vector<yat::Message *> msgs;
+    for( size_t i = 0; i < 10; ++i )
+      msgs.push_back(new yat::Message(kTEST_MSG + i, i == 5 ? 10 : 0));
+    REQUIRE(q.post_batch(msgs) == 0);
+    CHECK(msgs.empty());
+    //- a ctrl msg is never part of a batch
+    REQUIRE(q.post(new yat::Message(yat::TASK_EXIT, LOWEST_MSG_PRIORITY)) == 0);
+
+    std::vector<yat::Message *> out;
+    CHECK(q.next_messages(out, 4, 100) == 4);
+    CHECK(q.next_messages(out, 8, 100) == 4);
+    REQUIRE(out.size() == 8);
+    CHECK(out[0]->type() == kTEST_MSG + 5);
+    CHECK(out[1]->type() == kTEST_MSG);
+    CHECK(out[4]->type() == kTEST_MSG + 3);
+    CHECK(q.next_messages(out, 16, 100) == 2);
+    CHECK(q.next_messages(out, 16, 100) == 1);
+    CHECK(out.back()->type() == yat::TASK_EXIT);
+    CHECK(q.next_messages(out, 16, 10) == 0);
+    for( size_t i = 0; i < out.size(); ++i )
+      out[i]->release();
+  }
+}
+
+TEST_CASE("msgq_priority_order", "[MessageQ]")
+{
+  check_priority_order(false);
+}
+
+TEST_CASE("msgq_lock_free_priority_order", "[MessageQ]")
+{
+  check_priority_order(true);
+}
+
+TEST_CASE("msgq_lock_free_ctrl_msg_bypass_saturation", "[MessageQ]")
+{
+  yat::MessageQ q(8, 16, false, true);
+  for( size_t i = 0; i < 16; ++i )
+    REQUIRE(q.post(new yat::Message(kTEST_MSG), 1) == 0);
+  //- saturated: user msg is trashed on tmo
+  CHECK(q.post(new yat::Message(kTEST_MSG), 1) == -1);
+  //- ctrl msg is always posted and extracted first
+  REQUIRE(q.post(new yat::Message(yat::TASK_EXIT, EXIT_MSG_PRIORITY)) == 0);
+  yat::Message * m = q.next_message(100);
+  REQUIRE(m != 0);
+  CHECK(m->type() == yat::TASK_EXIT);
+  m->release();
+  CHECK(q.statistics().trashed_on_post_tmo_counter_ == 1);
+  CHECK(q.clear() == 16);
+}
+
+TEST_CASE("task_lock_free_msgq_multi_producers", "[MessageQ]")
+{
+  const size_t kPRODUCERS = 8;
+  const size_t kMSGS = 2000;
+
+  yat::Task::Config cfg;
+  cfg.lock_free_msgq = true;
+  cfg.lo_wm = 8;
+  cfg.hi_wm = 16;
+  CountingTask * t = new CountingTask(cfg);
+  t->go();
+
+  std::vector<std::thread> producers;
+  for( size_t p = 0; p < kPRODUCERS; ++p )
+    producers.push_back(std::thread([t, kMSGS]()
+    {
+      for( size_t i = 0; i < kMSGS; ++i )
+        t->post(new yat::Message(kTEST_MSG), 5000);
+    }));
+  for( size_t p = 0; p < kPRODUCERS; ++p )
+    producers[p].join();
+
+  //- make sure everything has been handled
+  t->wait_msg_handled(kTEST_MSG + 1, 5000);
+  CHECK(t->count == kPRODUCERS * kMSGS);
+  CHECK(t->msgq_statistics().trashed_on_post_tmo_counter_ == 0);
+  t->exit();
+}
+
+TEST_CASE("msgq_deep_backlog_fifo_within_priority", "[MessageQ]")
+{
+  const size_t kMSGS = 3000;
+  yat::MessageQ q(kMSGS, 2 * kMSGS);
+  //- spread msgs over 3 priorities (one of them beyond the first priority page)
+  const size_t prio[] = { 0, 1000, 7 };
+  for( size_t i = 0; i < kMSGS; ++i )
+  {
+    yat::Message * m = new yat::Message(kTEST_MSG + (i % 2), prio[i % 3]);
+    m->attach_data(i);
+    REQUIRE(q.post(m) == 0);
+  }
+  //- remove half the msgs by type
+  CHECK(q.clear_pending_messages(kTEST_MSG + 1) == kMSGS / 2);
+  CHECK(q.clear_pending_messages(kTEST_MSG + 64) == 0);
+
+  //- remaining msgs come out highest priority first, in posting order
+  size_t last_prio = 1000;
+  size_t last_idx = 0;
+  bool first = true;
+  for( size_t n = 0; n < kMSGS / 2; ++n )
+  {
+    yat::Message * m = q.next_message(100);
+    REQUIRE(m != 0);
+    CHECK(m->type() == kTEST_MSG);
+    size_t idx = m->get_data<size_t>();
+    size_t p = prio[idx % 3];
+    CHECK(p <= last_prio);
+    if( p == last_prio && ! first )
+      CHECK(idx > last_idx);
+    last_prio = p;
+    last_idx = idx;
+    first = false;
+    m->release();
+  }
+  CHECK(q.next_message(10) == 0);
+}
+
+TEST_CASE("msgq_batch", "[MessageQ]")
+{
+  check_batch(false);
+}
+
+TEST_CASE("msgq_lock_free_batch", "[MessageQ]")
+{
+  check_batch(true);
+}
+
+TEST_CASE("task_batch_handling", "[MessageQ]")
+{
+  const size_t kBATCHES = 100;
+  const size_t kMSGS = 50;
+
+  yat::Task::Config cfg;
+  cfg.msg_batch_size = 32;
+  cfg.lo_wm = 64;
+  cfg.hi_wm = 128;
+  BatchTask * t = new BatchTask(cfg);
+  t->go();
+
+  for( size_t b = 0; b < kBATCHES; ++b )
+  {
+    std::vector<yat::Message *> msgs;
+    for( size_t i = 0; i < kMSGS; ++i )
+      msgs.push_back(new yat::Message(kTEST_MSG));
+    t->post_batch(msgs, 5000);
+  }
+
+  //- make sure everything has been handled
+  t->wait_msg_handled(kTEST_MSG + 1, 5000);
+  CHECK(t->count == kBATCHES * kMSGS);
+  CHECK(t->max_batch <= 32);
+  CHECK(t->batches < kBATCHES * kMSGS);
+  t->exit();
+}
+
+TEST_CASE("msgq_latency_histogram", "[MessageQ]")
+{
+  yat::MessageQ::LatencyHistogram h;
+  CHECK(h.percentile(50) == 0);
+  //- no buckets until a value is recorded
+  CHECK(h.buckets_ == 0);
+  for( size_t i = 0; i < 1000; ++i )
+    h.record(10);
+  h.record(1000000);
+  CHECK(h.count_ == 1001);
+  CHECK(h.min_ == 10);
+  CHECK(h.max_ == 1000000);
+  //- small values are exact, large ones within the bucket resolution (1/8)
+  CHECK(h.percentile(50) == 10);
+  CHECK(h.percentile(99) == 10);
+  CHECK(h.percentile(100) >= 1000000);
+  CHECK(h.percentile(100) <= 1125000);
+  yat::MessageQ::LatencyHistogram c(h);
+  CHECK(c.buckets_ != h.buckets_);
+  CHECK(c.count_ == 1001);
+  CHECK(c.percentile(99) == 10);
+  h.reset();
+  CHECK(h.count_ == 0);
+  c = h;
+  CHECK(c.count_ == 0);
+  CHECK(c.percentile(50) == 0);
+}
+
+TEST_CASE("task_msgq_latency_stats", "[MessageQ]")
+{
+  yat::Task::Config cfg;
+  SleepingTask * t = new SleepingTask(cfg);
+  t->msgq_latency_stats_mode(yat::MessageQ::LATENCY_STATS_PER_MSG_TYPE);
+  CHECK(t->msgq_latency_stats_mode() == yat::MessageQ::LATENCY_STATS_PER_MSG_TYPE);
+  t->go();
+
+  for( size_t i = 0; i < 10; ++i )
+  {
+    t->post(kTEST_MSG, 1000);
+    t->post(kTEST_MSG + 1, 1000);
+  }
+  //- handling durations are folded into the stats on the next msg extraction
+  t->wait_msg_handled(kTEST_MSG + 2, 5000);
+  t->wait_msg_handled(kTEST_MSG + 2, 5000);
+
+  yat::MessageQ::Statistics stats = t->msgq_statistics();
+  CHECK(stats.latency_.queue_wait_.count_ >= 21);
+  CHECK(stats.latency_.handling_.count_ >= 21);
+  const yat::MessageQ::MsgLatency & slow = stats.latency_per_msg_type_[kTEST_MSG + 1];
+  CHECK(slow.queue_wait_.count_ == 10);
+  CHECK(slow.handling_.count_ == 10);
+  CHECK(slow.handling_.min_ >= 1900000);
+  const yat::MessageQ::MsgLatency & fast = stats.latency_per_msg_type_[kTEST_MSG];
+  CHECK(fast.handling_.count_ == 10);
+  CHECK(fast.handling_.max_ < slow.handling_.min_);
+  //- the queue wait of the fast msgs includes the handling of the slow ones
+  CHECK(fast.queue_wait_.max_ >= 1900000);
+
+  t->msgq_latency_stats_mode(yat::MessageQ::LATENCY_STATS_OFF);
+  t->reset_msgq_statistics();
+  t->wait_msg_handled(kTEST_MSG + 2, 5000);
+  stats = t->msgq_statistics();
+  CHECK(stats.latency_.queue_wait_.count_ == 0);
+  CHECK(stats.latency_per_msg_type_.empty());
+  t->exit();
+}
+
+TEST_CASE("msgq_coalescing", "[MessageQ]")
+{
+  SumCoalescer sum;
+  check_coalescing(false, 0);
+  check_coalescing(false, &sum);
+  check_coalescing(true, 0);
+  check_coalescing(true, &sum);
+  check_coalescing_priority(false);
+  check_coalescing_priority(true);
+}
+
+TEST_CASE("msgq_targeted_consumer_wakeup", "[MessageQ]")
+{
+  check_wakeup(false);
+  check_wakeup(true);
+}
+
+TEST_CASE("msgq_consumer_spin", "[MessageQ]")
+{
+  check_spin(false);
+  check_spin(true);
+}
+
+TEST_CASE("msgq_producers_woken_one_at_a_time", "[MessageQ]")
+{
+  const size_t kPRODUCERS = 8;
+  const size_t kMSGS = 200;
+
+  for( size_t lf = 0; lf < 2; ++lf )
+  {
+    yat::Task::Config cfg;
+    cfg.lo_wm = 2;
+    cfg.hi_wm = 4;
+    cfg.lock_free_msgq = lf == 1;
+    cfg.msgq_spin_usecs = lf ? 50 : 0;
+    SleepingTask * t = new SleepingTask(cfg);
+    t->go();
+
+    //- the producers keep the msgQ saturated
+    std::vector<std::thread> producers;
+    for( size_t p = 0; p < kPRODUCERS; ++p )
+      producers.push_back(std::thread([t, kMSGS]()
+      {
+        for( size_t i = 0; i < kMSGS; ++i )
+          t->post(i % 50 ? kTEST_MSG : kTEST_MSG + 1, 5000);
+      }));
+    for( size_t p = 0; p < kPRODUCERS; ++p )
+      producers[p].join();
+
+    t->wait_msg_handled(kTEST_MSG + 2, 5000);
+    CHECK(t->count == kPRODUCERS * (kMSGS - kMSGS / 50));
+    const yat::MessageQ::Statistics & stats = t->msgq_statistics();
+    CHECK(stats.trashed_on_post_tmo_counter_ == 0);
+    CHECK(stats.has_been_saturated_ > 0);
+    CHECK(stats.producer_woken_counter_ > 0);
+    t->exit();
+  }
+}
+
+TEST_CASE("task_high_precision_periodic_msgs", "[MessageQ]")
+{
+  yat::Task::Config cfg;
+  cfg.enable_periodic_msg = true;
+  cfg.periodic_msg_period_ms = 10.;
+  cfg.enable_high_precision_periodic_timing = true;
+  cfg.periodic_msg_spin_usecs = 200;
+  PeriodicTask * t = new PeriodicTask(cfg);
+  t->overrun = 10;
+  CHECK(t->high_precision_periodic_timing_enabled());
+  t->go();
+
+  //- user msgs don't delay the periodic series
+  yat::Timer timer;
+  for( size_t i = 0; i < 50; ++i )
+  {
+    t->post(kTEST_MSG, 1000);
+    yat::Thread::sleep(4);
+  }
+  while( timer.elapsed_msec() < 400. )
+    yat::Thread::sleep(1);
+  double elapsed_ms = timer.elapsed_msec();
+  size_t periodics = t->periodics;
+  size_t count = t->count;
+
+  yat::MessageQ::Statistics stats = t->msgq_statistics();
+  t->exit();
+
+  CHECK(count == 50);
+  //- the 35 ms overrun of the 10th period skips 2 periods: the series stays in phase
+  CHECK(stats.periodic_overrun_counter_ >= 2);
+  CHECK(stats.periodic_overrun_counter_ <= 3);
+  size_t expected = static_cast<size_t>(elapsed_ms / 10.) - stats.periodic_overrun_counter_;
+  CHECK(periodics + 2 >= expected);
+  CHECK(periodics <= expected + 2);
+  CHECK(stats.periodic_jitter_.count_ >= periodics);
+  CHECK(stats.periodic_jitter_.percentile(50.) < 2000000);
+}
@@ -0,0 +1,162 @@
+#include "catch.hpp"
+#include <atomic>
+#include <yat/threading/Pipeline.h>
+
+namespace
+{
+  // parses the items: fan-out to its downstream stages
+  class Source : public yat::PipelineStage<int, long>
+  {
+  public:
+    Source () : yat::PipelineStage<int, long>("source", 4) {}
+  protected:
+    virtual void process (int & in)
+    {
+      if( in < 0 )
+        THROW_YAT_ERROR("BAD_ARG", "negative item", "Source::process");
+      emit(in);
+    }
+  };
+
+  class Scale : public yat::PipelineStage<long>
+  {
+  public:
+    Scale (long f) : yat::PipelineStage<long>("scale"), factor(f) {}
+  protected:
+    virtual void process (long & in)
+    {
+      emit(factor * in);
+    }
+    long factor;
+  };
+
+  // fan-in: slow consumer
+  class Sink : public yat::PipelineStage<long>
+  {
+  public:
+    Sink (std::atomic<long> & s, std::atomic<size_t> & c)
+      : yat::PipelineStage<long>("sink"), sum(s), count(c)
+    {}
+  protected:
+    virtual void process (long & in)
+    {
+      if( ! (count % 100) )
+        yat::Thread::sleep(1);
+      sum += in;
+      ++count;
+    }
+    std::atomic<long> & sum;
+    std::atomic<size_t> & count;
+  };
+
+  yat::Task::Config batch_config ()
+  {
+    yat::Task::Config cfg;
+    cfg.msg_batch_size = 16;
+    return cfg;
+  }
+
+  // batched stage: the first item is held until the producer is done
+  class Batched : public yat::PipelineStage<int>
+  {
+  public:
+    Batched (std::atomic<bool> & g)
+      : yat::PipelineStage<int>("batched", kDEFAULT_PIPELINE_CREDITS, batch_config()),
+        go(g), count(0), max_batch(0)
+    {}
+    std::atomic<bool> & go;
+    std::atomic<size_t> count;
+    std::atomic<size_t> max_batch;
+  protected:
+    virtual void handle_messages (std::vector<yat::Message *>& msgs)
+    {
+      if( msgs.size() > max_batch )
+        max_batch = msgs.size();
+      yat::PipelineStage<int>::handle_messages(msgs);
+    }
+    virtual void process (int &)
+    {
+      while( ! go )
+        yat::Thread::sleep(1);
+      ++count;
+    }
+  };
+}
+
+TEST_CASE("pipeline_fan_out_fan_in_backpressure", "[Pipeline]")
+{
+  const int kITEMS = 2000;
+  std::atomic<long> sum(0);
+  std::atomic<size_t> count(0);
+
+  yat::Pipeline p;
+  Source * src = p.add(new Source);
+  Scale * x1 = p.add(new Scale(1));
+  Scale * x2 = p.add(new Scale(2));
+  //- stages are started/stopped in the upstream to downstream order, whatever the add order
+  Sink * sink = new Sink(sum, count);
+  p.add(sink);
+  x1->connect(*sink, 2);
+  x2->connect(*sink, 2);
+  src->connect(*x1, 2);
+  src->connect(*x2, 2);
+  p.start();
+
+  src->push(-1);
+  for( int i = 0; i < kITEMS; ++i )
+    src->push(i);
+
+  while( count < 2 * kITEMS )
+    yat::Thread::sleep(1);
+
+  std::vector<yat::PipelineStageStatistics> stats = p.statistics();
+  p.stop();
+
+  //- no item lost
+  CHECK(count == 2 * kITEMS);
+  CHECK(sum == 3L * kITEMS * (kITEMS - 1) / 2);
+
+  REQUIRE(stats.size() == 4);
+  CHECK(stats[0].name_ == "source");
+  CHECK(stats[0].items_in_ == kITEMS + 1);
+  CHECK(stats[0].errors_ == 1);
+  CHECK(stats[0].items_out_ == 2 * kITEMS);
+  //- the slow sink throttled the upstream stages
+  CHECK(stats[1].emit_blocked_counter_ + stats[2].emit_blocked_counter_ > 0);
+  CHECK(stats[3].name_ == "sink");
+  CHECK(stats[3].items_in_ == 2 * kITEMS);
+  CHECK(stats[3].throughput() > 0.);
+}
+
+TEST_CASE("pipeline_cycle", "[Pipeline]")
+{
+  yat::Pipeline p;
+  Scale * a = p.add(new Scale(1));
+  Scale * b = p.add(new Scale(1));
+  a->connect(*b);
+  b->connect(*a);
+  CHECK_THROWS_AS(p.start(), yat::Exception);
+  CHECK_THROWS_AS(a->connect(*a), yat::Exception);
+  CHECK_THROWS_AS(a->connect(*b, 0), yat::Exception);
+}
+
+TEST_CASE("pipeline_batched_stage", "[Pipeline]")
+{
+  const int kITEMS = 10;
+  std::atomic<bool> go(false);
+
+  yat::Pipeline p;
+  Batched * b = p.add(new Batched(go));
+  p.start();
+
+  for( int i = 0; i < kITEMS; ++i )
+    b->push(i);
+  go = true;
+
+  while( b->count < static_cast<size_t>(kITEMS) )
+    yat::Thread::sleep(1);
+
+  //- the items are handled by batches
+  CHECK(b->max_batch > 1);
+  p.stop();
+}
@@ -0,0 +1,150 @@
+#include "catch.hpp"
+#include <vector>
+#include <thread>
+#include <yat/threading/SeqLocked.h>
+#include <yat/threading/Published.h>
+#include <yat/threading/Utilities.h>
+
+namespace
+{
+  struct Position
+  {
+    yat::uint64 x, y, z;
+  };
+
+  yat::atomic_int live_configs;
+
+  struct Config
+  {
+    Config() : values(16, 0) { ++live_configs; }
+    Config(const Config& c) : values(c.values) { ++live_configs; }
+    ~Config() { --live_configs; }
+    bool consistent() const
+    {
+      for( size_t i = 1; i < values.size(); ++i )
+        if( values[i] != values[0] )
+          return false;
+      return true;
+    }
+    std::vector<int> values;
+  };
+
+  void set_all(Config& c, int v)
+  {
+    for( size_t i = 0; i < c.values.size(); ++i )
+      c.values[i] = v;
+  }
+
+  struct Increment
+  {
+    void operator()(Position& p) const { ++p.x; ++p.y; ++p.z; }
+  };
+}
+
+TEST_CASE("seqlocked_consistency", "[SeqLocked]")
+{
+  const size_t kREADERS = 3;
+  const yat::uint64 kSTORES = 100000;
+
+  yat::SeqLocked<Position> pos;
+  CHECK(pos.version() == 0);
+  CHECK(pos.load().x == 0);
+
+  yat::atomic_bool done;
+  yat::atomic_bool torn;
+  std::vector<std::thread> threads;
+  for( size_t i = 0; i < kREADERS; ++i )
+    threads.push_back(std::thread([&pos, &done, &torn]()
+    {
+      while( ! done )
+      {
+        Position p = pos.load();
+        if( p.x != p.y || p.y != p.z )
+          torn = true;
+      }
+    }));
+  for( yat::uint64 i = 1; i <= kSTORES; ++i )
+  {
+    Position p = { i, i, i };
+    pos.store(p);
+  }
+  done = true;
+  for( size_t i = 0; i < kREADERS; ++i )
+    threads[i].join();
+
+  CHECK_FALSE(torn);
+  CHECK(pos.version() == kSTORES);
+  pos.update(Increment());
+  CHECK(pos.load().z == kSTORES + 1);
+}
+
+TEST_CASE("published_snapshots", "[Published]")
+{
+  const size_t kREADERS = 3;
+  const int kPUBLISHES = 2000;
+
+  {
+    yat::Published<Config> config;
+    yat::atomic_bool done;
+    yat::atomic_bool torn;
+    std::vector<std::thread> threads;
+    for( size_t i = 0; i < kREADERS; ++i )
+      threads.push_back(std::thread([&config, &done, &torn]()
+      {
+        while( ! done )
+        {
+          yat::Published<Config>::Snapshot cfg(config);
+          if( ! cfg->consistent() )
+            torn = true;
+        }
+      }));
+    for( int i = 1; i <= kPUBLISHES; ++i )
+    {
+      if( i % 2 )
+        config.update([i](Config& c) { set_all(c, i); });
+      else
+      {
+        Config c;
+        set_all(c, i);
+        config.publish(c);
+      }
+    }
+    done = true;
+    for( size_t i = 0; i < kREADERS; ++i )
+      threads[i].join();
+
+    CHECK_FALSE(torn);
+    CHECK(config.load().values[0] == kPUBLISHES);
+    //- former values reclaimed
+    CHECK(live_configs == 1);
+  }
+  CHECK(live_configs == 0);
+}
+
+TEST_CASE("published_deferred_reclamation", "[Published]")
+{
+  yat::Published<Config> config;
+  yat::atomic_bool published;
+  std::thread writer;
+  {
+    yat::Published<Config>::Snapshot cfg(config);
+    writer = std::thread([&config, &published]()
+    {
+      config.update([](Config& c) { set_all(c, 1); });
+      published = true;
+    });
+    yat::ThreadingUtilities::sleep(0, 50000000);
+
+    //- the writer waits for the snapshot release
+    CHECK_FALSE(published);
+    CHECK(live_configs == 2);
+    CHECK(cfg->values[0] == 0);
+
+    //- new snapshots see the new value
+    CHECK(config.load().values[0] == 1);
+    CHECK_FALSE(published);
+  }
+  writer.join();
+  CHECK(published);
+  CHECK(live_configs == 1);
+}
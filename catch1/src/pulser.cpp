@@ -0,0 +1,171 @@
+#include "catch.hpp"
+#include <vector>
+#include <atomic>
+#include <yat/threading/Pulser.h>
+#include <yat/time/Timer.h>
+
+namespace
+{
+  class PulseCounter
+  {
+  public:
+    PulseCounter () : calls(0) {}
+    void on_pulse (yat::Thread::IOArg)
+    {
+      ++calls;
+    }
+    std::atomic<size_t> calls;
+  };
+
+  //- generous timeout: the pulses may be late on a loaded machine
+  const double kWAIT_TMO_MSECS = 10000.;
+
+  //- waits for <counter> to reach <calls> - returns false on timeout
+  bool wait_calls (const PulseCounter & counter, size_t calls)
+  {
+    yat::Timer t;
+    while( counter.calls < calls )
+    {
+      if( t.elapsed_msec() > kWAIT_TMO_MSECS )
+        return false;
+      yat::Thread::sleep(1);
+    }
+    return true;
+  }
+
+  //- waits for <p> to be done - returns false on timeout
+  bool wait_done (yat::Pulser & p)
+  {
+    yat::Timer t;
+    while( ! p.is_done() )
+    {
+      if( t.elapsed_msec() > kWAIT_TMO_MSECS )
+        return false;
+      yat::Thread::sleep(1);
+    }
+    return true;
+  }
+}
+
+TEST_CASE("pulser_many_pulsers_num_pulses", "[Pulser]")
+{
+  const size_t kPULSERS = 200;
+
+  std::vector<PulseCounter> counters(kPULSERS);
+  std::vector<yat::Pulser *> pulsers;
+  for( size_t i = 0; i < kPULSERS; ++i )
+  {
+    yat::Pulser::Config cfg;
+    cfg.period_in_msecs = 5 + i % 10;
+    cfg.num_pulses = 5;
+    cfg.callback = yat::PulserCallback::instanciate(counters[i], &PulseCounter::on_pulse);
+    pulsers.push_back(new yat::Pulser(cfg));
+    pulsers.back()->start();
+  }
+
+  for( size_t i = 0; i < kPULSERS; ++i )
+  {
+    CHECK(wait_done(*pulsers[i]));
+    CHECK(counters[i].calls == 5);
+    CHECK(pulsers[i]->is_done());
+    CHECK_FALSE(pulsers[i]->is_running());
+    delete pulsers[i];
+  }
+}
+
+TEST_CASE("pulser_suspend_resume_set_period", "[Pulser]")
+{
+  PulseCounter counter;
+  yat::Pulser::Config cfg;
+  cfg.period_in_msecs = 10;
+  cfg.callback = yat::PulserCallback::instanciate(counter, &PulseCounter::on_pulse);
+  yat::Pulser p(cfg);
+
+  p.start_sync();
+  CHECK(wait_calls(counter, 10));
+  CHECK(p.is_running());
+
+  //- no pulse while suspended
+  p.suspend_sync();
+  size_t calls = counter.calls;
+  yat::Thread::sleep(100);
+  CHECK(counter.calls == calls);
+  CHECK_FALSE(p.is_running());
+
+  //- resumed with a longer period
+  p.set_period(50);
+  CHECK(p.get_period() == 50);
+  yat::Timer t;
+  p.resume_sync();
+  CHECK(wait_calls(counter, calls + 3));
+  //- 3 pulses take at least 3 periods (timed waits never return early)
+  CHECK(t.elapsed_msec() >= 140.);
+
+  //- a limited number of pulses
+  p.set_num_pulses(2);
+  p.start_sync();
+  CHECK(wait_done(p));
+  p.stop_sync();
+}
+
+namespace
+{
+  class SelfDeleter
+  {
+  public:
+    SelfDeleter () : pulser(0), deleted(false) {}
+    void on_pulse (yat::Thread::IOArg)
+    {
+      delete pulser;
+      deleted = true;
+    }
+    yat::Pulser * pulser;
+    std::atomic<bool> deleted;
+  };
+}
+
+TEST_CASE("pulser_deleted_from_its_callback", "[Pulser]")
+{
+  //- once as the only pulser (the service must not join itself), then along
+  //- with another one (the service must keep pulsing it)
+  for( size_t n = 0; n < 2; ++n )
+  {
+    PulseCounter counter;
+    yat::Pulser::Config other_cfg;
+    other_cfg.period_in_msecs = 5;
+    other_cfg.callback = yat::PulserCallback::instanciate(counter, &PulseCounter::on_pulse);
+    yat::Pulser * other = n ? new yat::Pulser(other_cfg) : 0;
+    if( other )
+      other->start();
+
+    SelfDeleter deleter;
+    yat::Pulser::Config cfg;
+    cfg.period_in_msecs = 10;
+    cfg.callback = yat::PulserCallback::instanciate(deleter, &SelfDeleter::on_pulse);
+    deleter.pulser = new yat::Pulser(cfg);
+    deleter.pulser->start();
+
+    yat::Timer t;
+    while( ! deleter.deleted && t.elapsed_msec() < kWAIT_TMO_MSECS )
+      yat::Thread::sleep(1);
+    CHECK(deleter.deleted);
+
+    if( other )
+    {
+      size_t calls = counter.calls;
+      CHECK(wait_calls(counter, calls + 1));
+      delete other;
+    }
+  }
+
+  //- the service is still usable
+  PulseCounter counter;
+  yat::Pulser::Config cfg;
+  cfg.period_in_msecs = 5;
+  cfg.num_pulses = 3;
+  cfg.callback = yat::PulserCallback::instanciate(counter, &PulseCounter::on_pulse);
+  yat::Pulser p(cfg);
+  p.start();
+  CHECK(wait_done(p));
+  CHECK(counter.calls == 3);
+}
@@ -0,0 +1,122 @@
+#include "catch.hpp"
+#include <vector>
+#include <thread>
+#include <yat/threading/ReadersWriterMutex.h>
+#include <yat/threading/Utilities.h>
+
+namespace
+{
+  const yat::ReadersWriterMutex::ReadersMode kMODES[] =
+  {
+    yat::ReadersWriterMutex::RW_SHARED_COUNTER,
+    yat::ReadersWriterMutex::RW_PER_CORE_COUNTERS
+  };
+}
+
+TEST_CASE("rw_mutex_many_readers", "[ReadersWriterMutex]")
+{
+  //- more simultaneous readers than the former 32 readers limit
+  const size_t kREADERS = 40;
+
+  for( size_t m = 0; m < 2; ++m )
+  {
+    yat::ReadersWriterMutex rw(kMODES[m]);
+    CHECK(rw.readers_mode() == kMODES[m]);
+
+    yat::atomic_uint32 inside;
+    yat::atomic_uint32 all_inside;
+    std::vector<std::thread> threads;
+    for( size_t i = 0; i < kREADERS; ++i )
+      threads.push_back(std::thread([&rw, &inside, &all_inside, kREADERS]()
+      {
+        yat::AutoReaderMutex guard(rw);
+        ++inside;
+        for( size_t j = 0; j < 5000 && inside < kREADERS; ++j )
+          yat::ThreadingUtilities::sleep(0, 1000000);
+        if( inside == kREADERS )
+          ++all_inside;
+      }));
+    for( size_t i = 0; i < kREADERS; ++i )
+      threads[i].join();
+    CHECK(all_inside == kREADERS);
+
+    //- no reader left
+    yat::AutoWriterMutex guard(rw);
+  }
+}
+
+TEST_CASE("rw_mutex_writers_exclusion", "[ReadersWriterMutex]")
+{
+  const size_t kREADERS = 4;
+  const size_t kWRITERS = 2;
+  const size_t kLOOPS = 20000;
+
+  for( size_t m = 0; m < 2; ++m )
+  {
+    yat::ReadersWriterMutex rw(kMODES[m]);
+    //- written under the writer lock only: a == b for any reader
+    volatile size_t a = 0, b = 0;
+    yat::atomic_bool torn;
+    std::vector<std::thread> threads;
+    for( size_t i = 0; i < kWRITERS; ++i )
+      threads.push_back(std::thread([&rw, &a, &b, kLOOPS]()
+      {
+        for( size_t j = 0; j < kLOOPS / 10; ++j )
+        {
+          yat::AutoWriterMutex guard(rw);
+          a = a + 1;
+          b = b + 1;
+        }
+      }));
+    for( size_t i = 0; i < kREADERS; ++i )
+      threads.push_back(std::thread([&rw, &a, &b, &torn, kLOOPS]()
+      {
+        for( size_t j = 0; j < kLOOPS; ++j )
+        {
+          yat::AutoReaderMutex guard(rw);
+          if( a != b )
+            torn = true;
+        }
+      }));
+    for( size_t i = 0; i < threads.size(); ++i )
+      threads[i].join();
+
+    CHECK_FALSE(torn);
+    CHECK(a == kWRITERS * (kLOOPS / 10));
+    CHECK(b == a);
+  }
+}
+
+TEST_CASE("rw_mutex_writer_preference", "[ReadersWriterMutex]")
+{
+  for( size_t m = 0; m < 2; ++m )
+  {
+    yat::ReadersWriterMutex rw(kMODES[m]);
+    yat::atomic_uint32 order;
+    yat::atomic_uint32 writer_rank;
+    yat::atomic_uint32 reader_rank;
+
+    rw.lock_for_reading();
+    std::thread writer([&rw, &order, &writer_rank]()
+    {
+      yat::AutoWriterMutex guard(rw);
+      writer_rank = ++order;
+    });
+    yat::ThreadingUtilities::sleep(0, 50000000);
+
+    //- a writer is pending: new readers must wait
+    std::thread reader([&rw, &order, &reader_rank]()
+    {
+      yat::AutoReaderMutex guard(rw);
+      reader_rank = ++order;
+    });
+    yat::ThreadingUtilities::sleep(0, 50000000);
+    CHECK(order == 0);
+
+    rw.unlock_for_reading();
+    writer.join();
+    reader.join();
+    CHECK(writer_rank == 1);
+    CHECK(reader_rank == 2);
+  }
+}
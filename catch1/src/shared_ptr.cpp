@@ -0,0 +1,81 @@
+#include "catch.hpp"
+#include <string>
+#include <thread>
+#include <yat/memory/SharedPtr.h>
+
+namespace
+{
+  struct Tracked
+  {
+    Tracked (int v, const std::string & n) : value(v), name(n) { ++alive; }
+    ~Tracked () { --alive; }
+    int value;
+    std::string name;
+    static int alive;
+  };
+  int Tracked::alive = 0;
+
+  struct Throwing
+  {
+    Throwing () { throw std::string("ctor failed"); }
+  };
+}
+
+TEST_CASE("shared_ptr_make_shared", "[SharedPtr]")
+{
+  {
+    yat::SharedPtr<Tracked> p = yat::make_shared<Tracked>(7, "seven");
+    CHECK(Tracked::alive == 1);
+    CHECK(p->value == 7);
+    CHECK(p->name == "seven");
+    CHECK(p.unique());
+
+    yat::SharedPtr<Tracked> q(p);
+    CHECK(p.use_count() == 2);
+
+    //- the object is destroyed with its last shared reference, even if weak references remain
+    yat::WeakPtr<Tracked> w(p);
+    p.reset();
+    q.reset();
+    CHECK(Tracked::alive == 0);
+    CHECK(w.expired());
+    CHECK(w.lock().is_null());
+  }
+
+  //- constructor failure
+  CHECK_THROWS_AS(yat::make_shared<Throwing>(), std::string);
+}
+
+TEST_CASE("shared_ptr_weak_lock_race", "[SharedPtr]")
+{
+  //- last shared reference released while other threads promote weak references
+  for( int pass = 0; pass < 200; ++pass )
+  {
+    yat::SharedPtr<Tracked> p = yat::make_shared<Tracked>(pass, "racy");
+    yat::WeakPtr<Tracked> w(p);
+    bool ok = true;
+    std::thread t([w, &ok]()
+    {
+      for( int i = 0; i < 50; ++i )
+      {
+        yat::SharedPtr<Tracked> s = w.lock();
+        if( s.is_null() )
+          break;
+        ok = ok && s->name == "racy";
+      }
+    });
+    p.reset();
+    t.join();
+    CHECK(ok);
+    CHECK(w.expired());
+  }
+  CHECK(Tracked::alive == 0);
+}
+
+TEST_CASE("shared_ptr_null_mutex_policy", "[SharedPtr]")
+{
+  //- single threaded policy
+  yat::SharedPtr<int, yat::NullMutex> n(new int(3));
+  yat::SharedPtr<int, yat::NullMutex> m(n);
+  CHECK(n.use_count() == 2);
+}
@@ -0,0 +1,147 @@
+#include "catch.hpp"
+#include <vector>
+#include <thread>
+#include <yat/threading/SignalTask.h>
+#include <yat/threading/Utilities.h>
+#include <yat/time/Timer.h>
+
+namespace
+{
+  typedef yat::Signal<int, yat::Mutex> IntSignal;
+
+  struct Observer
+  {
+    Observer() : sum(0), calls(0) {}
+    void on_value(int v) { sum += v; ++calls; }
+    void on_error(int) { THROW_YAT_ERROR("ERROR", "observer error", "Observer::on_error"); }
+    void on_slow(int) { yat::ThreadingUtilities::sleep(0, 200000000); ++calls; }
+    yat::atomic_int sum;
+    yat::atomic_int calls;
+  };
+
+  //- an observer disconnecting itself
+  struct OneShot
+  {
+    OneShot(IntSignal& s) : signal(s), calls(0) {}
+    void on_value(int)
+    {
+      ++calls;
+      signal.disconnect(IntSignal::Slot::instanciate(*this, &OneShot::on_value));
+    }
+    IntSignal& signal;
+    int calls;
+  };
+}
+
+TEST_CASE("signal_connect_run", "[Signal]")
+{
+  IntSignal s;
+  Observer a, b;
+  CHECK_FALSE(s.connected());
+  CHECK(s.run(1));
+
+  s.connect(IntSignal::Slot::instanciate(a, &Observer::on_value));
+  s.connect(IntSignal::Slot::instanciate(b, &Observer::on_value));
+  //- connected twice: called once
+  s.connect(IntSignal::Slot::instanciate(a, &Observer::on_value));
+  CHECK(s.connected());
+  CHECK(s.run(2));
+  CHECK(a.sum == 2);
+  CHECK(b.sum == 2);
+
+  //- copies share the observers
+  IntSignal c(s);
+  c.run(1);
+  CHECK(a.sum == 3);
+
+  s.connect(IntSignal::Slot::instanciate(b, &Observer::on_error));
+  CHECK_FALSE(s.run(1));
+  CHECK(a.sum == 4);
+
+  s.disconnect(IntSignal::Slot::instanciate(b, &Observer::on_error));
+  s.disconnect(IntSignal::Slot::instanciate(a, &Observer::on_value));
+  CHECK(s.run(1));
+  CHECK(a.sum == 4);
+  CHECK(b.sum == 5);
+
+  //- disconnection from an observer: applies to the next emissions
+  OneShot o(s);
+  s.connect(IntSignal::Slot::instanciate(o, &OneShot::on_value));
+  s.run(1);
+  s.run(1);
+  CHECK(o.calls == 1);
+
+  s.disconnect(IntSignal::Slot::instanciate(b, &Observer::on_value));
+  CHECK_FALSE(s.connected());
+}
+
+TEST_CASE("signal_slow_observer", "[Signal]")
+{
+  IntSignal s;
+  Observer slow, other;
+  s.connect(IntSignal::Slot::instanciate(slow, &Observer::on_slow));
+
+  std::thread emitter([&s]() { s.run(1); });
+  yat::ThreadingUtilities::sleep(0, 20000000);
+
+  //- neither connect nor the other emitters wait for the slow observer
+  yat::Timer t;
+  s.connect(IntSignal::Slot::instanciate(other, &Observer::on_value));
+  s.disconnect(IntSignal::Slot::instanciate(slow, &Observer::on_slow));
+  s.run(3);
+  double elapsed_ms = t.elapsed_msec();
+  int slow_calls = slow.calls;
+  emitter.join();
+
+  CHECK(elapsed_ms < 100.);
+  CHECK(slow_calls == 0);
+  CHECK(slow.calls == 1);
+  CHECK(other.sum == 3);
+}
+
+TEST_CASE("signal_run_async", "[Signal]")
+{
+  yat::SignalTask * task = new yat::SignalTask();
+  task->go();
+
+  IntSignal s;
+  Observer a;
+  s.connect(IntSignal::Slot::instanciate(a, &Observer::on_value));
+
+  std::vector<yat::Future<bool> > results;
+  for( int i = 1; i <= 100; ++i )
+    results.push_back(task->run_async(s, i));
+  //- observers snapshot taken when posted
+  s.connect(IntSignal::Slot::instanciate(a, &Observer::on_error));
+  yat::Future<bool> failed = task->run_async(s, 0);
+
+  for( size_t i = 0; i < results.size(); ++i )
+    CHECK(results[i].get(1000));
+  CHECK_FALSE(failed.get(1000));
+  CHECK(a.sum == 5050);
+  CHECK(a.calls == 101);
+
+  task->exit();
+}
+
+TEST_CASE("signal_contended_run", "[Signal]")
+{
+  const size_t kTHREADS = 4;
+  const size_t kLOOPS = 100000;
+
+  IntSignal s;
+  Observer a;
+  s.connect(IntSignal::Slot::instanciate(a, &Observer::on_value));
+
+  std::vector<std::thread> threads;
+  for( size_t i = 0; i < kTHREADS; ++i )
+    threads.push_back(std::thread([&s, kLOOPS]()
+    {
+      for( size_t j = 0; j < kLOOPS; ++j )
+        s.run(1);
+    }));
+  for( size_t i = 0; i < kTHREADS; ++i )
+    threads[i].join();
+
+  CHECK(a.sum == static_cast<int>(kTHREADS * kLOOPS));
+}
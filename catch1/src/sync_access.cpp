@@ -0,0 +1,49 @@
+#include "catch.hpp"
+#include <vector>
+#include <thread>
+#include <yat/threading/SyncAccess.h>
+
+namespace
+{
+  void nested_lock(int* obj, int depth)
+  {
+    LOCK(obj)
+    ++*obj;
+    if( depth )
+      nested_lock(obj, depth - 1);
+  }
+}
+
+TEST_CASE("sync_access_exclusion", "[SyncAccess]")
+{
+  const size_t kTHREADS = 4;
+  const int kLOOPS = 20000;
+
+  //- recursive locking by the same thread
+  int obj = 0;
+  nested_lock(&obj, 3);
+  CHECK(obj == 4);
+
+  //- a shared object and a private one per thread
+  int shared = 0;
+  std::vector<int> own(kTHREADS, 0);
+  std::vector<std::thread> threads;
+  for( size_t i = 0; i < kTHREADS; ++i )
+    threads.push_back(std::thread([&shared, &own, i, kLOOPS]()
+    {
+      for( int j = 0; j < kLOOPS; ++j )
+      {
+        {
+          yat::SyncAccess guard(&shared);
+          shared = shared + 1;
+        }
+        nested_lock(&own[i], 1);
+      }
+    }));
+  for( size_t i = 0; i < kTHREADS; ++i )
+    threads[i].join();
+
+  CHECK(shared == static_cast<int>(kTHREADS) * kLOOPS);
+  for( size_t i = 0; i < kTHREADS; ++i )
+    CHECK(own[i] == 2 * kLOOPS);
+}
@@ -0,0 +1,205 @@
+#include "catch.hpp"
+#include <string>
+#include <vector>
+#include <yat/threading/Task.h>
+
+namespace
+{
+  const size_t kPOS_MSG = yat::FIRST_USER_MSG;
+  const size_t kNAME_MSG = yat::FIRST_USER_MSG + 1;
+  const size_t kRAW_MSG = yat::FIRST_USER_MSG + 2;
+  const size_t kOTHER_MSG = yat::FIRST_USER_MSG + 3;
+
+  // typed handlers for some msg types, handle_message for the others
+  class DispatchTask : public yat::Task
+  {
+  public:
+    DispatchTask ()
+      : yat::Task(Config()), pos(0.), raw(0), fallback(0), periodics(0)
+    {
+      on<kPOS_MSG, DispatchTask, double, &DispatchTask::set_position>();
+      on<kNAME_MSG, DispatchTask, const std::string, &DispatchTask::set_name>();
+      on<kRAW_MSG, DispatchTask, yat::Message, &DispatchTask::handle_raw>();
+    }
+    void unregister_raw ()
+    {
+      off(kRAW_MSG);
+    }
+    double pos;
+    std::string name;
+    size_t raw;
+    size_t fallback;
+    size_t periodics;
+  protected:
+    virtual void handle_message (yat::Message & msg)
+    {
+      if( msg.type() >= yat::FIRST_USER_MSG )
+        ++fallback;
+    }
+  private:
+    void set_position (double & p)
+    {
+      pos = p;
+    }
+    void set_name (const std::string & n)
+    {
+      if( n.empty() )
+        THROW_YAT_ERROR("BAD_ARG", "empty name", "DispatchTask::set_name");
+      name = n;
+    }
+    void handle_raw (yat::Message & msg)
+    {
+      if( msg.type() == kRAW_MSG )
+        ++raw;
+    }
+  };
+}
+
+TEST_CASE("task_typed_handlers", "[Task]")
+{
+  DispatchTask * t = new DispatchTask();
+  t->go();
+
+  t->wait_msg_handled(kPOS_MSG, 1.5, 1000);
+  CHECK(t->pos == 1.5);
+
+  t->wait_msg_handled(kNAME_MSG, std::string("motor"), 1000);
+  CHECK(t->name == "motor");
+
+  //- handler exceptions and payload type mismatch are reported to the poster
+  CHECK_THROWS_AS(t->wait_msg_handled(kNAME_MSG, std::string(), 1000), yat::Exception);
+  CHECK_THROWS_AS(t->wait_msg_handled(kPOS_MSG, 1, 1000), yat::Exception);
+  CHECK(t->pos == 1.5);
+
+  t->wait_msg_handled(kRAW_MSG, 1000);
+  CHECK(t->raw == 1);
+
+  //- no typed handler: handle_message
+  t->wait_msg_handled(kOTHER_MSG, 1000);
+  CHECK(t->fallback == 1);
+
+  t->unregister_raw();
+  t->wait_msg_handled(kRAW_MSG, 1000);
+  CHECK(t->raw == 1);
+  CHECK(t->fallback == 2);
+
+  t->exit();
+}
+
+TEST_CASE("task_typed_handler_bad_msg_type", "[Task]")
+{
+  struct BadTask : public yat::Task
+  {
+    BadTask () : yat::Task(Config())
+    {
+      on<kMAX_TASK_HANDLER_MSG_TYPE, BadTask, yat::Message, &BadTask::noop>();
+    }
+    void noop (yat::Message &) {}
+    virtual void handle_message (yat::Message &) {}
+  };
+  CHECK_THROWS_AS(new BadTask(), yat::Exception);
+}
+
+namespace
+{
+  const size_t kSQUARE_MSG = yat::FIRST_USER_MSG;
+  const size_t kFAIL_MSG = yat::FIRST_USER_MSG + 1;
+  const size_t kSLOW_MSG = yat::FIRST_USER_MSG + 2;
+  const size_t kNO_REPLY_MSG = yat::FIRST_USER_MSG + 3;
+
+  class ReplyTask : public yat::Task
+  {
+  public:
+    ReplyTask () : yat::Task(Config()) {}
+  protected:
+    virtual void handle_message (yat::Message & msg)
+    {
+      switch( msg.type() )
+      {
+        case kSQUARE_MSG:
+        {
+          int v = msg.get_data<int>();
+          msg.reply(v * v);
+          break;
+        }
+        case kFAIL_MSG:
+          THROW_YAT_ERROR("BAD_ARG", "request failed", "ReplyTask::handle_message");
+          break;
+        case kSLOW_MSG:
+          yat::Thread::sleep(200);
+          msg.reply(std::string("slow"));
+          break;
+      }
+    }
+  };
+
+  struct ReplyCollector
+  {
+    ReplyCollector () : calls(0), sum(0), errors(0) {}
+    void on_reply (yat::Message & msg)
+    {
+      ++calls;
+      if( msg.has_error() )
+        ++errors;
+      else
+        sum += msg.get_reply<int>();
+    }
+    size_t calls;
+    long sum;
+    size_t errors;
+  };
+}
+
+TEST_CASE("task_post_with_reply", "[Task]")
+{
+  ReplyTask * t = new ReplyTask();
+  t->go();
+
+  //- many outstanding requests
+  std::vector<yat::Future<int> > futures;
+  for( int i = 0; i < 1000; i++ )
+    futures.push_back(t->post_with_reply<int>(kSQUARE_MSG, i, 1000));
+  bool all_replied = true;
+  for( int i = 0; i < 1000; i++ )
+    all_replied = all_replied && futures[i].get(5000) == i * i;
+  CHECK(all_replied);
+  CHECK(futures[10].ready());
+
+  //- completion callbacks (called from the task thread, or immediately once completed)
+  ReplyCollector rc;
+  yat::ReplyCallback cb = yat::ReplyCallback::instanciate(rc, &ReplyCollector::on_reply);
+  for( int i = 0; i < 10; i++ )
+    t->post_with_reply<int>(kSQUARE_MSG, i, 1000).then(cb);
+  t->post_with_reply<int>(kFAIL_MSG, 1000).then(cb);
+  t->wait_msg_handled(kNO_REPLY_MSG, 1000);
+  CHECK(rc.calls == 11);
+  CHECK(rc.sum == 285);
+  CHECK(rc.errors == 1);
+  futures[3].then(cb);
+  CHECK(rc.calls == 12);
+  CHECK(rc.sum == 294);
+
+  //- handler errors and missing reply
+  yat::Future<int> f = t->post_with_reply<int>(kFAIL_MSG, 1000);
+  CHECK_THROWS_AS(f.get(1000), yat::Exception);
+  f = t->post_with_reply<int>(kNO_REPLY_MSG, 1000);
+  CHECK_THROWS_AS(f.get(1000), yat::Exception);
+
+  //- timeout
+  yat::Future<std::string> slow = t->post_with_reply<std::string>(kSLOW_MSG, 1000);
+  CHECK_THROWS_AS(slow.get(20), yat::Exception);
+
+  //- requests dropped before being handled are completed
+  yat::Future<int> dropped = t->post_with_reply<int>(kSQUARE_MSG, 2, 1000);
+  CHECK(t->clear_pending_messages(kSQUARE_MSG) == 1);
+  CHECK(dropped.ready());
+  CHECK_THROWS_AS(dropped.get(1000), yat::Exception);
+
+  CHECK(slow.get(0) == "slow");
+
+  yat::Future<int> unbound;
+  CHECK_FALSE(unbound.valid());
+  CHECK_THROWS_AS(unbound.ready(), yat::Exception);
+
+  t->exit();
+}
@@ -0,0 +1,88 @@
+#include "catch.hpp"
+#include <atomic>
+#include <yat/threading/Task.h>
+#if defined (YAT_LINUX)
+# include <sched.h>
+#endif
+
+namespace
+{
+  const size_t kTEST_MSG = yat::FIRST_USER_MSG;
+
+  // queries its own thread settings from its message handler
+  class SettingsTask : public yat::Task
+  {
+  public:
+    SettingsTask (const yat::Task::Config & cfg)
+      : yat::Task(cfg), stack(0)
+    {}
+    yat::Thread::CpuSet cpus;
+    size_t stack;
+  protected:
+    virtual void handle_message (yat::Message & msg)
+    {
+      if( msg.type() != kTEST_MSG )
+        return;
+      cpus = cpu_affinity();
+      stack = stack_size();
+    }
+  };
+
+  // a cpu the process is allowed to run on
+  size_t allowed_cpu ()
+  {
+#if defined (YAT_LINUX)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if( ::sched_getaffinity(0, sizeof(set), &set) == 0 )
+    {
+      for( size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+        if( CPU_ISSET(cpu, &set) )
+          return cpu;
+    }
+#endif
+    return 0;
+  }
+}
+
+TEST_CASE("thread_affinity_and_stack_size", "[Thread]")
+{
+  yat::Task::Config cfg;
+  cfg.cpu_affinity.insert(allowed_cpu());
+  cfg.stack_size = 256 * 1024;
+  SettingsTask * t = new SettingsTask(cfg);
+
+  //- not started yet: the requested settings
+  CHECK(t->cpu_affinity() == cfg.cpu_affinity);
+  CHECK(t->stack_size() == cfg.stack_size);
+  CHECK(t->sched_policy() == yat::Thread::SCHED_POLICY_DEFAULT);
+
+  t->go();
+  t->wait_msg_handled(kTEST_MSG, 5000);
+
+  //- running: the actual settings
+#if defined (YAT_LINUX)
+  CHECK(t->cpus == cfg.cpu_affinity);
+  //- no upper bound: the stack may be enlarged (e.g. by sanitizers)
+  CHECK(t->stack >= cfg.stack_size);
+#endif
+  CHECK(t->sched_policy() == yat::Thread::SCHED_POLICY_DEFAULT);
+  CHECK(t->sched_priority() == 0);
+
+  //- the stack is already allocated
+  CHECK_THROWS(t->stack_size(1024 * 1024));
+
+  //- back to any cpu
+  t->cpu_affinity(yat::Thread::CpuSet());
+  CHECK_FALSE(t->cpu_affinity().empty());
+
+  t->exit();
+}
+
+TEST_CASE("thread_sched_policy_bad_priority", "[Thread]")
+{
+  yat::Task::Config cfg;
+  cfg.sched_policy = yat::Thread::SCHED_POLICY_FIFO;
+  cfg.sched_priority = 100000;
+  CHECK_THROWS_AS(new SettingsTask(cfg), yat::Exception);
+}
@@ -0,0 +1,52 @@
+#include "catch.hpp"
+#include <ctime>
+#include <yat/time/Timer.h>
+#include <yat/threading/Mutex.h>
+#include <yat/threading/Condition.h>
+#include <yat/threading/Utilities.h>
+
+TEST_CASE("timer_monotonic_and_fast_timer", "[Timer]")
+{
+  yat::Timer t;
+  yat::FastTimer ft;
+
+  yat::ThreadingUtilities::sleep(0, 20000000);
+
+  double t_ms = t.elapsed_msec();
+  double ft_ms = ft.elapsed_msec();
+  CHECK(t_ms >= 20.);
+  CHECK(ft_ms >= 19.);
+  CHECK(ft_ms < t_ms + 1.);
+  CHECK(ft.elapsed_nsec() > 0.);
+
+  ft.restart();
+  CHECK(ft.elapsed_usec() < 1000.);
+}
+
+TEST_CASE("condition_timed_wait_accuracy", "[Timer]")
+{
+  yat::Mutex m;
+  yat::Condition c(m);
+  yat::MutexLock guard(m);
+
+  yat::Timer t;
+  CHECK_FALSE(c.timed_wait(50));
+  double ms = t.elapsed_msec();
+  CHECK(ms >= 49.);
+  CHECK(ms < 500.);
+
+  //- sub-second delays with a nanoseconds carry
+  t.restart();
+  CHECK_FALSE(c.timed_wait(0, 999999999));
+  CHECK(t.elapsed_msec() >= 999.);
+}
+
+TEST_CASE("get_time_is_real_time", "[Timer]")
+{
+  unsigned long secs = 0, nsecs = 0;
+  yat::ThreadingUtilities::get_time(secs, nsecs, 10);
+  long now = static_cast<long>(::time(0));
+  CHECK(static_cast<long>(secs) >= now + 9);
+  CHECK(static_cast<long>(secs) <= now + 11);
+  CHECK(nsecs < 1000000000UL);
+}
@@ -47,6 +47,31 @@
 namespace yat
 {
 
+// ============================================================================
+//! \struct TypeTag
+//! \brief Compile-time type identifier (RTTI-free).
+//!
+//! Each type \<T\> gets a unique tag: the address of a static object.
+//! Comparing two tags is a simple pointer comparison.
+//! \remark A given type may get different tags in different shared libraries
+//! (e.g. Windows DLLs, or libraries built with hidden symbols visibility): the
+//! casts fall back to RTTI on tag mismatch (see yat::container_cast).
+// ============================================================================
+template <typename T>
+struct TypeTag
+{
+  //! \brief Returns the tag of type \<T\>.
+  static const void * id ()
+  {
+    return &TypeTag<T>::tag_;
+  }
+
+private:
+  static const char tag_;
+};
+
+template <typename T> const char TypeTag<T>::tag_ = 0;
+
 // ============================================================================
 //! \class Container
 //! \brief Basic container class only used for genericity constraints.
@@ -56,6 +81,7 @@ class YAT_DECL Container
 public:
   //! \brief Constructor.
   Container ()
+    : type_tag_(0)
   {
     //- noop
   };
@@ -65,6 +91,27 @@ public:
   {
     //- noop
   };
+
+  //! \brief Returns the tag of the content type (see yat::TypeTag).
+  //!
+  //! Returns 0 for containers not derived from GenericContainer.
+  const void * type_tag () const
+  {
+    return type_tag_;
+  }
+
+protected:
+  //! \brief Constructor with parameters.
+  //! \param _type_tag Tag of the content type.
+  explicit Container (const void * _type_tag)
+    : type_tag_(_type_tag)
+  {
+    //- noop
+  };
+
+private:
+  //- Tag of the content type.
+  const void * type_tag_;
 };
 
 // ============================================================================
@@ -83,7 +130,7 @@ public:
 
   //! \brief Default constructor.
   GenericContainer ()
-    : ptr_(0), own_(false)
+    : Container(TypeTag<T>::id()), ptr_(0), own_(false)
   {
     //- noop
   }
@@ -96,7 +143,7 @@ public:
   //! \param _transfer_ownership If set to true, ownership of source data is transfered
   //! to *this*.
   GenericContainer(T* _data, bool _transfer_ownership = true)
-    : ptr_(0), own_(false)
+    : Container(TypeTag<T>::id()), ptr_(0), own_(false)
   {
     set(_data, _transfer_ownership);
   }
@@ -106,7 +153,7 @@ public:
   //! Makes a copy of source data.
   //! \param _data The source data.
   GenericContainer (const T& _data)
-    : ptr_(0), own_(false)
+    : Container(TypeTag<T>::id()), ptr_(0), own_(false)
   {
     set(_data);
   }
@@ -114,11 +161,26 @@ public:
   //! \brief Copy constructor.
   //! \param _src The source container.
   GenericContainer(const GenericContainer<T>& _src)
-    : ptr_(0), own_(false)
+    : Container(TypeTag<T>::id()), ptr_(0), own_(false)
   {
     *this = _src;
   }
 
+protected:
+  //! \brief Constructor with an explicit content type tag.
+  //!
+  //! Makes a copy of source data. Emulates a container built by another shared
+  //! library, in which the content type got a different tag.
+  //! \param _data The source data.
+  //! \param _type_tag Tag of the content type.
+  GenericContainer (const T& _data, const void * _type_tag)
+    : Container(_type_tag), ptr_(0), own_(false)
+  {
+    set(_data);
+  }
+
+public:
+
   //! \brief Destructor.
   //!
   //! Deletes data if the ownership flag is set to true.
@@ -314,6 +376,66 @@ private:
 };
 
 
+// ============================================================================
+//! \class InlineContainer
+//! \brief Generic container storing its content inline (i.e. no data allocation).
+//!
+//! The content is copied into the container itself. Mainly used to store small
+//! data into a preallocated storage (see yat::Message).
+//! \remark Transferring the content ownership is meaningless for this container: the
+//! caller must make its own copy of the content (see Message::detach_data).
+//!
+//! Implementation constraint: class \<T\> must have a copy constructor.
+// ============================================================================
+template <typename T>
+class InlineContainer : public GenericContainer<T>
+{
+public:
+  //! \brief Constructor with parameters.
+  //!
+  //! Makes a copy of source data.
+  //! \param _data The source data.
+  InlineContainer (const T& _data)
+    : GenericContainer<T>(&value_, false), value_(_data)
+  {
+    //- noop
+  }
+
+  //! \brief Returns true if the container content is the inline value.
+  //!
+  //! Returns false if the content has been replaced by an external data.
+  bool holds_inline_value ()
+  {
+    return this->get(false) == &value_;
+  }
+
+private:
+  //- Inline content.
+  T value_;
+
+  // = Disallow these operations.
+  //--------------------------------------------
+  InlineContainer (const InlineContainer<T>&);
+  InlineContainer& operator= (const InlineContainer<T>&);
+};
+
+//! \brief Cast function from Container type to GenericContainer\<T\> type.
+//!
+//! Compares the type tags (see yat::TypeTag). Falls back to RTTI on mismatch
+//! since the same type may have different tags in different shared libraries.
+//! Returns NULL pointer if bad cast conversion.
+//! \param _c Container to cast.
+template<typename T>
+GenericContainer<T> * container_cast (Container * _c)
+{
+  if (! _c)
+    return 0;
+  if (_c->type_tag() == TypeTag<T>::id())
+    return static_cast<GenericContainer<T>*>(_c);
+  //- the same type may have different tags in different shared libraries
+  return dynamic_cast<GenericContainer<T>*>(_c);
+}
+
 //! \brief Cast function from Container type to \<T\> type.
 //!
 //! Returns NULL pointer if bad cast conversion.
@@ -323,7 +445,7 @@ private:
 template<typename T>
 T * any_cast (Container * _c, bool _transfer_ownership = false)
 {
-  GenericContainer<T> * gc = dynamic_cast<GenericContainer<T>*>(_c);
+  GenericContainer<T> * gc = container_cast<T>(_c);
   return gc
        ? gc->get_content(_transfer_ownership)
        : 0;
@@ -47,6 +47,10 @@
 #include <yat/memory/UniquePtr.h>
 #include <iostream>
 #include <map>
+#include <new>
+#if defined (YAT_CPP11)
+# include <utility>
+#endif
 
 
 namespace yat
@@ -55,7 +59,12 @@ namespace yat
 // ============================================================================
 // forward declaration class: WeakPtr
 // ============================================================================
-template <typename T, typename L = yat::Mutex> class WeakPtr;
+template <typename T, typename L = yat::DefaultCountLock> class WeakPtr;
+
+// ============================================================================
+// forward declaration class: SharedPtrFactory
+// ============================================================================
+template <typename T, typename L = yat::DefaultCountLock> struct SharedPtrFactory;
 
 /* TO BE CONTINUED... DO NOT DELETE !
 // ============================================================================
@@ -63,7 +72,7 @@ template <typename T, typename L = yat::Mutex> class WeakPtr;
 //! \brief A allow the pointed object to return a SharedPtr from itself
 //!
 // ============================================================================
-template <typename T, typename L = yat::Mutex> class enable_shared_from_this
+template <typename T, typename L = yat::DefaultCountLock> class enable_shared_from_this
 {
   template<typename U, typename V> friend class SharedPtr;
 
@@ -98,16 +107,17 @@ private:
 //! If object lock is not necessary, use a yat::NullMutex type, for example :
 //! \verbatim myPointer = new SharedPtr<mySimpleObjectType, yat::NullMutex>(ptr); // defines a "simple" object pointer \endverbatim
 //!
-//! If object lock is necessary, use a mutex type (default value in template definition
-//! uses yat::Mutex), for example :
+//! Otherwise, use yat::AtomicCount (lock-free reference counting - default value in
+//! template definition if c++11 support) or a mutex type, for example :
 //! \verbatim myPointer = new SharedPtr<mySharedObjectType>(ptr); // defines a shared object pointer \endverbatim
 //!
 // ============================================================================
-template <typename T, typename L = yat::Mutex>
+template <typename T, typename L = yat::DefaultCountLock>
 class SharedPtr
 {
   template<typename U, typename V> friend class WeakPtr;
   template<typename U, typename V> friend class SharedPtr;
+  template<typename U, typename V> friend struct SharedPtrFactory;
 
   typedef SharedPtr<T,L> ThisType;
   typedef SharedCounter<counter_t, L> ThisTypeRefCnt;
@@ -116,7 +126,7 @@ public:
   //! \brief Default constructor.
   //!
   //! Data pointer and reference counter are initialized to null value.
-  //! Default yat::Mutex type used for locking strategy.
+  //! Default yat::DefaultCountLock type used for locking strategy.
   SharedPtr ()
     : m_data(0), m_ref_count((T*)0)
   {
@@ -125,7 +135,7 @@ public:
 
   //! \brief Constructor from data pointer.
   //! \param p Pointer to type \<T\> data.
-  //! Default yat::Mutex type used for locking strategy.
+  //! Default yat::DefaultCountLock type used for locking strategy.
   SharedPtr (T* p)
     : m_data(p), m_ref_count(p)
   {
@@ -135,7 +145,7 @@ public:
   //! \brief Constructor from data pointer and specific deleter.
   //! \param p Pointer to type \<T\> data.
   //! \param d Specific deleter. See yat::SharedCounter definition.
-  //! Default yat::Mutex type used for locking strategy.
+  //! Default yat::DefaultCountLock type used for locking strategy.
   template <typename D>
   SharedPtr (T* p, D d)
     : m_data(p), m_ref_count(p, d)
@@ -371,6 +381,16 @@ public:
 
 private:
 
+  //- Tag for the constructor from an existing counter.
+  struct CounterTag {};
+
+  //- Constructor from an existing counter (takes ownership of its initial reference).
+  SharedPtr (T* p, CountBase<counter_t,L>* cnt, CounterTag)
+    : m_data(p), m_ref_count(cnt)
+  {
+    PTR_DBG("SharedPtr::SharedPtr(" << std::hex << (void*)p << ", cnt)");
+  }
+
   //- Tries to copy data pointer of foreign type.
   template<typename Y>
   void cast_copy_data(Y* data)
@@ -424,6 +444,155 @@ inline bool operator==( const SharedPtr<T>& a, const SharedPtr<U>& b )
   return a.get() == b.get();
 }
 
+// ============================================================================
+//! \struct SharedPtrFactory
+//! \brief SharedPtr\<T,L\> factory.
+//!
+//! Builds the \<T\> type object and its reference counter in a single allocation
+//! (see CountInplace). Prefer the yat::make_shared convenience function for the
+//! default locking strategy.
+// ============================================================================
+template <typename T, typename L> struct SharedPtrFactory
+{
+#if defined (YAT_CPP11)
+  //! \brief Creates a new \<T\> type object from the specified constructor arguments.
+  template <typename... A>
+  static SharedPtr<T,L> create (A&&... args)
+  {
+    Counter * c = new Counter;
+    try
+    {
+      ::new (c->storage()) T(std::forward<A>(args)...);
+    }
+    catch (...)
+    {
+      delete c;
+      throw;
+    }
+    return adopt_i(c);
+  }
+#else
+  //! \brief Creates a new default constructed \<T\> type object.
+  static SharedPtr<T,L> create ()
+  {
+    Counter * c = new Counter;
+    try
+    {
+      ::new (c->storage()) T();
+    }
+    catch (...)
+    {
+      delete c;
+      throw;
+    }
+    return adopt_i(c);
+  }
+
+  //! \brief Creates a new \<T\> type object from the specified constructor argument.
+  template <typename A1>
+  static SharedPtr<T,L> create (const A1 & a1)
+  {
+    Counter * c = new Counter;
+    try
+    {
+      ::new (c->storage()) T(a1);
+    }
+    catch (...)
+    {
+      delete c;
+      throw;
+    }
+    return adopt_i(c);
+  }
+
+  //! \brief Creates a new \<T\> type object from the specified constructor arguments.
+  template <typename A1, typename A2>
+  static SharedPtr<T,L> create (const A1 & a1, const A2 & a2)
+  {
+    Counter * c = new Counter;
+    try
+    {
+      ::new (c->storage()) T(a1, a2);
+    }
+    catch (...)
+    {
+      delete c;
+      throw;
+    }
+    return adopt_i(c);
+  }
+
+  //! \brief Creates a new \<T\> type object from the specified constructor arguments.
+  template <typename A1, typename A2, typename A3>
+  static SharedPtr<T,L> create (const A1 & a1, const A2 & a2, const A3 & a3)
+  {
+    Counter * c = new Counter;
+    try
+    {
+      ::new (c->storage()) T(a1, a2, a3);
+    }
+    catch (...)
+    {
+      delete c;
+      throw;
+    }
+    return adopt_i(c);
+  }
+#endif
+
+private:
+  typedef CountInplace<T, counter_t, L> Counter;
+
+  //- the object is constructed: the shared pointer takes ownership of the counter
+  static SharedPtr<T,L> adopt_i (Counter * c)
+  {
+    return SharedPtr<T,L>(c->constructed(), c, typename SharedPtr<T,L>::CounterTag());
+  }
+};
+
+#if defined (YAT_CPP11)
+//! \brief Creates a new \<T\> type object managed by a SharedPtr\<T\>.
+//!
+//! The object and its reference counter share a single allocation.
+//! Example :
+//! \verbatim yat::SharedPtr<MyType> p = yat::make_shared<MyType>(1, "one"); \endverbatim
+template <typename T, typename... A>
+inline SharedPtr<T> make_shared (A&&... args)
+{
+  return SharedPtrFactory<T>::create(std::forward<A>(args)...);
+}
+#else
+//! \brief Creates a new default constructed \<T\> type object managed by a SharedPtr\<T\>.
+//!
+//! The object and its reference counter share a single allocation.
+template <typename T>
+inline SharedPtr<T> make_shared ()
+{
+  return SharedPtrFactory<T>::create();
+}
+
+//! \brief Creates a new \<T\> type object managed by a SharedPtr\<T\>.
+template <typename T, typename A1>
+inline SharedPtr<T> make_shared (const A1 & a1)
+{
+  return SharedPtrFactory<T>::create(a1);
+}
+
+//! \brief Creates a new \<T\> type object managed by a SharedPtr\<T\>.
+template <typename T, typename A1, typename A2>
+inline SharedPtr<T> make_shared (const A1 & a1, const A2 & a2)
+{
+  return SharedPtrFactory<T>::create(a1, a2);
+}
+
+//! \brief Creates a new \<T\> type object managed by a SharedPtr\<T\>.
+template <typename T, typename A1, typename A2, typename A3>
+inline SharedPtr<T> make_shared (const A1 & a1, const A2 & a2, const A3 & a3)
+{
+  return SharedPtrFactory<T>::create(a1, a2, a3);
+}
+#endif
+
 // ============================================================================
 //! \class WeakPtr
 //! \brief A weak pointer abstraction class.
@@ -434,8 +603,8 @@ inline bool operator==( const SharedPtr<T>& a, const SharedPtr<U>& b )
 //! If object lock is not necessary, use a yat::NullMutex type, for example :
 //! \verbatim myPointer = new WeakPtr<mySimpleObjectType, yat::NullMutex>(ptr); // defines a "simple" object pointer \endverbatim
 //!
-//! If object lock is necessary, use a mutex type (default value in template
-//! definition uses yat::Mutex), for example :
+//! Otherwise, use yat::AtomicCount (lock-free reference counting - default value in
+//! template definition if c++11 support) or a mutex type, for example :
 //! \verbatim myPointer = new WeakPtr<mySharedObjectType>(ptr); // defines a shared object pointer \endverbatim
 //!
 // ============================================================================
@@ -451,7 +620,7 @@ public:
   //! \brief Default constructor.
   //!
   //! Data pointer and reference counter are initialized to null value.
-  //! Default yat::Mutex type used for locking strategy.
+  //! Default yat::DefaultCountLock type used for locking strategy.
   WeakPtr ()
     : m_data(0)
   {
@@ -762,11 +931,11 @@ private:
 } //- namespace
 
 //! Convenience declarations. To prepare a smooth move to C++ 11
-#define YAT_SHARED_PTR(T) yat::SharedPtr<T, yat::Mutex>
-#define YAT_WEAK_PTR(T) yat::WeakPtr<T, yat::Mutex>
+#define YAT_SHARED_PTR(T) yat::SharedPtr<T>
+#define YAT_WEAK_PTR(T) yat::WeakPtr<T>
 
 // Deprecated maco definitions
-#define YAT_THREADSAFE_SHARED_PTR(T) yat::SharedPtr<T, yat::Mutex>
-#define YAT_THREADSAFE_WEAK_PTR(T) yat::WeakPtr<T, yat::Mutex>
+#define YAT_THREADSAFE_SHARED_PTR(T) yat::SharedPtr<T>
+#define YAT_THREADSAFE_WEAK_PTR(T) yat::WeakPtr<T>
 
 #endif //- _YAT_SHARED_PTR_H_
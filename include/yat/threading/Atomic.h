@@ -43,131 +43,592 @@
 // ============================================================================
 // DEPENDENCIES
 // ============================================================================
+#include <yat/CommonHeader.h>
 #include <yat/threading/Mutex.h>
+#include <algorithm>
+#include <cstddef>
+#if defined (YAT_CPP11)
+# include <atomic>
+# include <type_traits>
+#endif
+
+namespace yat
+{
+
+// ============================================================================
+//! Memory ordering constraints of the atomic operations (see Atomic).
+// ============================================================================
+#if defined (YAT_CPP11)
+using std::memory_order;
+using std::memory_order_relaxed;
+using std::memory_order_consume;
+using std::memory_order_acquire;
+using std::memory_order_release;
+using std::memory_order_acq_rel;
+using std::memory_order_seq_cst;
+#else
+typedef enum
+{
+  memory_order_relaxed,
+  memory_order_consume,
+  memory_order_acquire,
+  memory_order_release,
+  memory_order_acq_rel,
+  memory_order_seq_cst
+} memory_order;
+#endif
+
+//- lock-free Atomic: c++11 atomics or, without c++11 support, gcc atomic builtins
+#if defined (YAT_CPP11)
+# define YAT_ATOMIC_LOCK_FREE
+#elif defined (YAT_LINUX) \
+      && (defined (__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+# define YAT_GCC_ATOMIC_BUILTINS
+# define YAT_ATOMIC_LOCK_FREE
+#endif
+
+// ============================================================================
+//! \struct AtomicLockFree
+//! \brief Tells whether or not Atomic\<T\> is lock-free.
+//!
+//! Trivially copyable types of 1, 2, 4 or 8 bytes are handled by the hardware
+//! atomic instructions (c++11 atomics or, on linux, the gcc atomic builtins so
+//! that Atomic\<T\> has the same layout whatever the c++ standard the code is
+//! compiled with). Other types are protected by a mutex.
+// ============================================================================
+template <typename T> struct AtomicLockFree
+{
+#if defined (YAT_CPP11)
+  static const bool value = std::is_trivially_copyable<T>::value
+                         && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+#elif defined (YAT_GCC_ATOMIC_BUILTINS)
+  static const bool value = __has_trivial_copy(T) && __has_trivial_assign(T) && __has_trivial_destructor(T)
+                         && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+#else
+  static const bool value = false;
+#endif
+};
+
+// ============================================================================
+//! \struct AtomicDifference
+//! \brief The type of the operand of Atomic\<T\>::fetch_add and fetch_sub.
+//!
+//! T itself for the arithmetic types, std::ptrdiff_t for the pointers.
+// ============================================================================
+template <typename T> struct AtomicDifference
+{
+  typedef T type;
+};
+
+template <typename T> struct AtomicDifference<T *>
+{
+  typedef std::ptrdiff_t type;
+};
+
+// ============================================================================
+//! \class AtomicImpl
+//! \brief Atomic\<T\> storage and primitive operations - mutex based implementation.
+//!
+//! The memory ordering arguments are ignored (the mutex provides sequential consistency).
+// ============================================================================
+template <typename T, bool LockFree = AtomicLockFree<T>::value>
+class AtomicImpl
+{
+public:
+  //! The fetch_add/fetch_sub operand type.
+  typedef typename AtomicDifference<T>::type Difference;
+
+  //! \brief Constructor.
+  explicit AtomicImpl (const T & v) : m_value(v) {}
+
+  //! \brief Returns true if the operations are lock-free (i.e. false).
+  bool is_lock_free () const
+  {
+    return false;
+  }
+
+  //! \brief Returns the value.
+  T load (memory_order = memory_order_seq_cst) const
+  {
+    AutoMutex<> _lock(m_mtx);
+    return m_value;
+  }
+
+  //! \brief Changes the value.
+  void store (T desired, memory_order = memory_order_seq_cst)
+  {
+    AutoMutex<> _lock(m_mtx);
+    m_value = desired;
+  }
+
+  //! \brief Changes the value, returns the previous one.
+  T exchange (T desired, memory_order = memory_order_seq_cst)
+  {
+    AutoMutex<> _lock(m_mtx);
+    std::swap(desired, m_value);
+    return desired;
+  }
+
+  //! \brief Changes the value to \<desired\> if it equals to \<expected\>.
+  //!
+  //! Returns true on success. Otherwise, returns false and \<expected\> gets the current value.
+  bool compare_exchange_strong (T & expected, T desired, memory_order, memory_order)
+  {
+    AutoMutex<> _lock(m_mtx);
+    if( m_value == expected )
+    {
+      m_value = desired;
+      return true;
+    }
+    expected = m_value;
+    return false;
+  }
+
+  //! \brief Same as compare_exchange_strong (never fails spuriously).
+  bool compare_exchange_weak (T & expected, T desired, memory_order s, memory_order f)
+  {
+    return compare_exchange_strong(expected, desired, s, f);
+  }
+
+  //! \brief Adds \<v\>, returns the previous value.
+  T fetch_add (Difference v, memory_order = memory_order_seq_cst)
+  {
+    AutoMutex<> _lock(m_mtx);
+    T prev = m_value;
+    m_value += v;
+    return prev;
+  }
+
+  //! \brief Subtracts \<v\>, returns the previous value.
+  T fetch_sub (Difference v, memory_order = memory_order_seq_cst)
+  {
+    AutoMutex<> _lock(m_mtx);
+    T prev = m_value;
+    m_value -= v;
+    return prev;
+  }
+
+  //! \brief Bitwise and with \<v\>, returns the previous value.
+  T fetch_and (T v, memory_order = memory_order_seq_cst)
+  {
+    AutoMutex<> _lock(m_mtx);
+    T prev = m_value;
+    m_value &= v;
+    return prev;
+  }
+
+  //! \brief Bitwise or with \<v\>, returns the previous value.
+  T fetch_or (T v, memory_order = memory_order_seq_cst)
+  {
+    AutoMutex<> _lock(m_mtx);
+    T prev = m_value;
+    m_value |= v;
+    return prev;
+  }
+
+  //! \brief Bitwise xor with \<v\>, returns the previous value.
+  T fetch_xor (T v, memory_order = memory_order_seq_cst)
+  {
+    AutoMutex<> _lock(m_mtx);
+    T prev = m_value;
+    m_value ^= v;
+    return prev;
+  }
+
+private:
+  T             m_value;
+  mutable Mutex m_mtx;
+};
+
+#if defined (YAT_CPP11)
+// ============================================================================
+//! \class AtomicImpl
+//! \brief Atomic\<T\> storage and primitive operations - lock-free implementation.
+//!
+//! Integral types use the hardware fetch-and-op instructions (pointers for
+//! fetch_add/fetch_sub only), the other ones (e.g. floating point types, bool)
+//! a compare-and-swap loop.
+// ============================================================================
+template <typename T>
+class AtomicImpl<T, true>
+{
+  //- has native fetch-and-op instructions?
+  typedef std::integral_constant<bool, std::is_integral<T>::value && ! std::is_same<T, bool>::value> Native;
+
+  //- has native fetch_add/fetch_sub instructions?
+  typedef std::integral_constant<bool, Native::value || std::is_pointer<T>::value> NativeArith;
+
+public:
+  //! The fetch_add/fetch_sub operand type.
+  typedef typename AtomicDifference<T>::type Difference;
+
+  //! \brief Constructor.
+  explicit AtomicImpl (const T & v) : m_value(v) {}
+
+  //! \brief Returns true if the operations are lock-free.
+  bool is_lock_free () const
+  {
+    return m_value.is_lock_free();
+  }
+
+  //! \brief Returns the value.
+  T load (memory_order o = memory_order_seq_cst) const
+  {
+    return m_value.load(o);
+  }
+
+  //! \brief Changes the value.
+  void store (T desired, memory_order o = memory_order_seq_cst)
+  {
+    m_value.store(desired, o);
+  }
+
+  //! \brief Changes the value, returns the previous one.
+  T exchange (T desired, memory_order o = memory_order_seq_cst)
+  {
+    return m_value.exchange(desired, o);
+  }
+
+  //! \brief Changes the value to \<desired\> if it equals to \<expected\>.
+  //!
+  //! Returns true on success. Otherwise, returns false and \<expected\> gets the current value.
+  bool compare_exchange_strong (T & expected, T desired, memory_order s, memory_order f)
+  {
+    return m_value.compare_exchange_strong(expected, desired, s, f);
+  }
+
+  //! \brief Changes the value to \<desired\> if it equals to \<expected\> (may fail spuriously).
+  //!
+  //! Returns true on success. Otherwise, returns false and \<expected\> gets the current value.
+  bool compare_exchange_weak (T & expected, T desired, memory_order s, memory_order f)
+  {
+    return m_value.compare_exchange_weak(expected, desired, s, f);
+  }
+
+  //! \brief Adds \<v\>, returns the previous value.
+  T fetch_add (Difference v, memory_order o = memory_order_seq_cst)
+  {
+    return fetch_add_i(v, o, NativeArith());
+  }
+
+  //! \brief Subtracts \<v\>, returns the previous value.
+  T fetch_sub (Difference v, memory_order o = memory_order_seq_cst)
+  {
+    return fetch_sub_i(v, o, NativeArith());
+  }
+
+  //! \brief Bitwise and with \<v\>, returns the previous value.
+  T fetch_and (T v, memory_order o = memory_order_seq_cst)
+  {
+    return fetch_and_i(v, o, Native());
+  }
+
+  //! \brief Bitwise or with \<v\>, returns the previous value.
+  T fetch_or (T v, memory_order o = memory_order_seq_cst)
+  {
+    return fetch_or_i(v, o, Native());
+  }
+
+  //! \brief Bitwise xor with \<v\>, returns the previous value.
+  T fetch_xor (T v, memory_order o = memory_order_seq_cst)
+  {
+    return fetch_xor_i(v, o, Native());
+  }
+
+private:
+  T fetch_add_i (Difference v, memory_order o, std::true_type)
+  {
+    return m_value.fetch_add(v, o);
+  }
+
+  T fetch_add_i (Difference v, memory_order o, std::false_type)
+  {
+    T prev = m_value.load(memory_order_relaxed);
+    while( ! m_value.compare_exchange_weak(prev, prev + v, o, memory_order_relaxed) ) {}
+    return prev;
+  }
+
+  T fetch_sub_i (Difference v, memory_order o, std::true_type)
+  {
+    return m_value.fetch_sub(v, o);
+  }
+
+  T fetch_sub_i (Difference v, memory_order o, std::false_type)
+  {
+    T prev = m_value.load(memory_order_relaxed);
+    while( ! m_value.compare_exchange_weak(prev, prev - v, o, memory_order_relaxed) ) {}
+    return prev;
+  }
+
+  T fetch_and_i (T v, memory_order o, std::true_type)
+  {
+    return m_value.fetch_and(v, o);
+  }
+
+  T fetch_and_i (T v, memory_order o, std::false_type)
+  {
+    T prev = m_value.load(memory_order_relaxed);
+    while( ! m_value.compare_exchange_weak(prev, static_cast<T>(prev & v), o, memory_order_relaxed) ) {}
+    return prev;
+  }
+
+  T fetch_or_i (T v, memory_order o, std::true_type)
+  {
+    return m_value.fetch_or(v, o);
+  }
+
+  T fetch_or_i (T v, memory_order o, std::false_type)
+  {
+    T prev = m_value.load(memory_order_relaxed);
+    while( ! m_value.compare_exchange_weak(prev, static_cast<T>(prev | v), o, memory_order_relaxed) ) {}
+    return prev;
+  }
+
+  T fetch_xor_i (T v, memory_order o, std::true_type)
+  {
+    return m_value.fetch_xor(v, o);
+  }
+
+  T fetch_xor_i (T v, memory_order o, std::false_type)
+  {
+    T prev = m_value.load(memory_order_relaxed);
+    while( ! m_value.compare_exchange_weak(prev, static_cast<T>(prev ^ v), o, memory_order_relaxed) ) {}
+    return prev;
+  }
+
+  std::atomic<T> m_value;
+};
+#elif defined (YAT_GCC_ATOMIC_BUILTINS)
+// ============================================================================
+//! \class AtomicImpl
+//! \brief Atomic\<T\> storage and primitive operations - lock-free implementation
+//! without c++11 support.
+//!
+//! Based on the gcc atomic builtins. The storage has the size and alignment of
+//! a std::atomic\<T\>. The fetch-and-op functions use a compare-and-swap loop.
+// ============================================================================
+template <typename T>
+class AtomicImpl<T, true>
+{
+public:
+  //! The fetch_add/fetch_sub operand type.
+  typedef typename AtomicDifference<T>::type Difference;
+
+  //! \brief Constructor.
+  explicit AtomicImpl (const T & v) : m_value(v) {}
+
+  //! \brief Returns true if the operations are lock-free.
+  bool is_lock_free () const
+  {
+    return __atomic_always_lock_free(sizeof(T), 0);
+  }
+
+  //! \brief Returns the value.
+  T load (memory_order o = memory_order_seq_cst) const
+  {
+    T v;
+    __atomic_load(&m_value, &v, o);
+    return v;
+  }
+
+  //! \brief Changes the value.
+  void store (T desired, memory_order o = memory_order_seq_cst)
+  {
+    __atomic_store(&m_value, &desired, o);
+  }
+
+  //! \brief Changes the value, returns the previous one.
+  T exchange (T desired, memory_order o = memory_order_seq_cst)
+  {
+    T prev;
+    __atomic_exchange(&m_value, &desired, &prev, o);
+    return prev;
+  }
+
+  //! \brief Changes the value to \<desired\> if it equals to \<expected\>.
+  //!
+  //! Returns true on success. Otherwise, returns false and \<expected\> gets the current value.
+  bool compare_exchange_strong (T & expected, T desired, memory_order s, memory_order f)
+  {
+    return __atomic_compare_exchange(&m_value, &expected, &desired, false, s, f);
+  }
+
+  //! \brief Changes the value to \<desired\> if it equals to \<expected\> (may fail spuriously).
+  //!
+  //! Returns true on success. Otherwise, returns false and \<expected\> gets the current value.
+  bool compare_exchange_weak (T & expected, T desired, memory_order s, memory_order f)
+  {
+    return __atomic_compare_exchange(&m_value, &expected, &desired, true, s, f);
+  }
+
+  //! \brief Adds \<v\>, returns the previous value.
+  T fetch_add (Difference v, memory_order o = memory_order_seq_cst)
+  {
+    T prev = load(memory_order_relaxed);
+    while( ! compare_exchange_weak(prev, static_cast<T>(prev + v), o, memory_order_relaxed) ) {}
+    return prev;
+  }
+
+  //! \brief Subtracts \<v\>, returns the previous value.
+  T fetch_sub (Difference v, memory_order o = memory_order_seq_cst)
+  {
+    T prev = load(memory_order_relaxed);
+    while( ! compare_exchange_weak(prev, static_cast<T>(prev - v), o, memory_order_relaxed) ) {}
+    return prev;
+  }
+
+  //! \brief Bitwise and with \<v\>, returns the previous value.
+  T fetch_and (T v, memory_order o = memory_order_seq_cst)
+  {
+    T prev = load(memory_order_relaxed);
+    while( ! compare_exchange_weak(prev, static_cast<T>(prev & v), o, memory_order_relaxed) ) {}
+    return prev;
+  }
+
+  //! \brief Bitwise or with \<v\>, returns the previous value.
+  T fetch_or (T v, memory_order o = memory_order_seq_cst)
+  {
+    T prev = load(memory_order_relaxed);
+    while( ! compare_exchange_weak(prev, static_cast<T>(prev | v), o, memory_order_relaxed) ) {}
+    return prev;
+  }
+
+  //! \brief Bitwise xor with \<v\>, returns the previous value.
+  T fetch_xor (T v, memory_order o = memory_order_seq_cst)
+  {
+    T prev = load(memory_order_relaxed);
+    while( ! compare_exchange_weak(prev, static_cast<T>(prev ^ v), o, memory_order_relaxed) ) {}
+    return prev;
+  }
+
+private:
+  T m_value __attribute__ ((aligned (sizeof(T))));
+};
+#endif
 
 // ============================================================================
-//! \class Atom<T>
-//! \brief Non lock-free atomic storage.
-//! Provide threadsafe access to bacic-type variables by avoiding the declaration
-//! of lock object in user code
+//! \class Atomic
+//! \brief Atomic storage.
+//!
+//! Provide threadsafe access to basic-type variables by avoiding the declaration
+//! of lock object in user code.
 //!
-//! \todo lock-free implementation (at least on linux)
+//! Lock-free (i.e. based on the hardware atomic instructions) for the trivially
+//! copyable types of 1, 2, 4 or 8 bytes (see AtomicLockFree), mutex based otherwise.
+//! The operators are sequentially consistent, the named functions accept an
+//! explicit memory ordering.
 //!
 //! \notice The main use is for basic-type object
 //!
 //! \verbatim
-//! yat::Atomint<int> ai = 1;
+//! yat::Atomic<int> ai(1);
 //! int i(ai);
 //! int j = ai + i;
+//! ai.fetch_add(1, yat::memory_order_relaxed);
 //! \endverbatim
 // ============================================================================
 template<typename T>
-class Atomic
+class Atomic : public AtomicImpl<T>
 {
+  typedef AtomicImpl<T> Impl;
+  typedef typename Impl::Difference Difference;
+
 public:
   //! c-tor
-  Atomic<T>()            { }
-  Atomic<T>(const T& v)  { m_value = v; }
+  Atomic<T>() : Impl(T()) { }
+  Atomic<T>(const T& v) : Impl(v) { }
 
   //! Accessor, return a copy
   operator const T() const
   {
-    AutoMutex<> _lock(m_mtx);
-    return m_value;
+    return this->load();
   }
 
   //! Equal operator
   T operator=(const T& v)
   {
-    AutoMutex<> _lock(m_mtx);
-    m_value = v;
-    return m_value;
+    this->store(v);
+    return v;
   }
 
   T operator++()
   {
-    AutoMutex<> _lock(m_mtx);
-    return ++m_value;
+    return this->fetch_add(Difference(1)) + Difference(1);
   }
 
   T operator++(int)
   {
-    AutoMutex<> _lock(m_mtx);
-    return m_value++;
+    return this->fetch_add(Difference(1));
   }
 
   T operator--()
   {
-    AutoMutex<> _lock(m_mtx);
-    return --m_value;
+    return this->fetch_sub(Difference(1)) - Difference(1);
   }
 
   T operator--(int)
   {
-    AutoMutex<> _lock(m_mtx);
-    return m_value--;
+    return this->fetch_sub(Difference(1));
   }
 
-  T operator+=(T v)
+  T operator+=(Difference v)
   {
-    AutoMutex<> _lock(m_mtx);
-    m_value += v;
-    return m_value;
+    return this->fetch_add(v) + v;
   }
 
-  T operator-=(T v)
+  T operator-=(Difference v)
   {
-    AutoMutex<> _lock(m_mtx);
-    m_value -= v;
-    return m_value;
+    return this->fetch_sub(v) - v;
   }
 
   T operator&=(T v)
   {
-    AutoMutex<> _lock(m_mtx);
-    m_value &= v;
-    return m_value;
+    return static_cast<T>(this->fetch_and(v) & v);
   }
 
   T operator|=(T v)
   {
-    AutoMutex<> _lock(m_mtx);
-    m_value |= v;
-    return m_value;
+    return static_cast<T>(this->fetch_or(v) | v);
   }
 
   T operator^=(T v)
   {
-    AutoMutex<> _lock(m_mtx);
-    m_value ^= v;
-    return m_value;
+    return static_cast<T>(this->fetch_xor(v) ^ v);
   }
 
-  T exchange(T desired)
+  using Impl::compare_exchange_strong;
+  using Impl::compare_exchange_weak;
+
+  //! \brief Changes the value to \<desired\> if it equals to \<expected\>.
+  //!
+  //! Returns true on success. Otherwise, returns false and \<expected\> gets the current value.
+  bool compare_exchange_strong(T& expected, T desired, memory_order o = memory_order_seq_cst)
   {
-    AutoMutex<> _lock(m_mtx);
-    std::swap(desired, m_value);
-    return desired;
+    return Impl::compare_exchange_strong(expected, desired, o, failure_order(o));
   }
 
-  T load()
+  //! \brief Changes the value to \<desired\> if it equals to \<expected\> (may fail spuriously).
+  //!
+  //! Returns true on success. Otherwise, returns false and \<expected\> gets the current value.
+  bool compare_exchange_weak(T& expected, T desired, memory_order o = memory_order_seq_cst)
   {
-    AutoMutex<> _lock(m_mtx);
-    return m_value;
+    return Impl::compare_exchange_weak(expected, desired, o, failure_order(o));
   }
 
-  void store(T desired)
+private:
+  //- the failure ordering can't be a release one
+  static memory_order failure_order(memory_order o)
   {
-    AutoMutex<> _lock(m_mtx);
-    m_value = desired;
+    if( o == memory_order_acq_rel )
+      return memory_order_acquire;
+    if( o == memory_order_release )
+      return memory_order_relaxed;
+    return o;
   }
 
-  //! non lock-free implementation
-  bool is_lock_free() { return false; }
-
-private:
-  T             m_value;
-  mutable Mutex m_mtx;
+  //- Not implemented private member
+  Atomic(const Atomic&);
+  Atomic& operator=(const Atomic&);
 };
 
 //! Common types
@@ -51,10 +51,26 @@
 #include <yat/threading/SharedObject.h>
 #include <yat/threading/Condition.h>
 #include <yat/threading/Mutex.h>
-#if defined(_USE_MSG_CACHE_)
-# include <yat/memory/Allocator.h>
+#include <yat/utils/Callback.h>
+#include <new>
+#if defined (YAT_CPP11)
+# include <type_traits>
+# include <utility>
 #endif
 
+// ============================================================================
+// CONSTs
+// ============================================================================
+//! Max. number of messages kept by each per-thread message pool.
+#define kMSG_POOL_CAPACITY 1024
+//-----------------------------------------------------------------------------
+//! Size of the inline message data storage (small data doesn't require any allocation).
+#define kMSG_INLINE_DATA_SIZE 48
+//-----------------------------------------------------------------------------
+//! Number of mutex/condition pairs shared by the request/reply messages (see Future).
+#define kMSG_REPLY_SYNC_STRIPES 32
+//-----------------------------------------------------------------------------
+
 namespace yat
 {
 
@@ -107,6 +123,51 @@ typedef enum
   FIRST_USER_MSG
 } MessageType;
 
+// ============================================================================
+//! \enum yat::ReservedMessageType
+//! \brief Message types reserved for the yat tasks (ex: Pipeline stages).
+//!
+//! These types are located at the top of the (32 bits) message type space,
+//! from FIRST_RESERVED_MSG to LAST_RESERVED_MSG, so that they never overlap
+//! the user types. They are handled as user messages (e.g. batched).
+// ============================================================================
+typedef enum
+{
+  //--------------------
+  FIRST_RESERVED_MSG = 0xFFFFFF00,
+  //-------------------- yat tasks msgs
+  PIPELINE_ITEM_MSG = FIRST_RESERVED_MSG,
+  PIPELINE_FLUSH_MSG,
+  SIGNAL_EMISSION_MSG,
+  //--------------------
+  LAST_RESERVED_MSG = 0xFFFFFFFF
+} ReservedMessageType;
+
+// ============================================================================
+//! \struct MessageInlineData
+//! \brief Tells whether or not data of type \<T\> is stored inline in a Message.
+//!
+//! Small (i.e. up to about kMSG_INLINE_DATA_SIZE bytes) trivially copyable data
+//! attached to a Message by copy is stored inline (requires c++11 support).
+// ============================================================================
+template <typename T> struct MessageInlineData
+{
+#if defined (YAT_CPP11)
+  static const bool value = std::is_trivially_copyable<T>::value
+                         && alignof(T) <= alignof(yat::uint64)
+                         && sizeof(InlineContainer<T>) <= kMSG_INLINE_DATA_SIZE + 4 * sizeof(void *);
+#else
+  static const bool value = false;
+#endif
+};
+
+class Message;
+
+// ============================================================================
+//! Defines the ReplyCallback callback type (see Future::then).
+// ============================================================================
+YAT_DEFINE_CALLBACK(ReplyCallback, yat::Message&);
+
 // ============================================================================
 //! \class Message
 //! \brief Message exchanged between Task objects.
@@ -114,15 +175,20 @@ typedef enum
 //! Inherits from SharedObject class. Its main characteristics are : type, priority,
 //! waitable and associated data. \n
 //! The waitable characteristic is based on a Condition object.
+//!
+//! %Message objects can be recycled through per-thread pools (see Message::enable_pool).
+//! A message released by another thread than the allocating one is given back to
+//! the pool of the allocating thread without locking (up to kMSG_POOL_CAPACITY
+//! messages, the next ones go back to the heap).
+//! \remark Each message block starts with a hidden header read by the class
+//! operator delete (called by release): a Message (or an instance of a derived
+//! class) MUST be allocated with a plain new expression. Placement new into a user
+//! storage and custom allocators are not supported.
 // ============================================================================
 class YAT_DECL Message : private yat::SharedObject
 {
-#if defined(_USE_MSG_CACHE_)
-  //- define what a message cache is
-  typedef CachedAllocator<Message, Mutex> Cache;
-  //- "global" message cache
-  static Cache m_cache;
-#endif
+  friend class MessageQ;
+  template <typename R> friend class Future;
 
 public:
 
@@ -130,13 +196,45 @@ public:
   typedef unsigned long MessageID;
 #endif
 
-#if defined(_USE_MSG_CACHE_)
-  //- overloads the new operator (makes class "cachable")
+  //! \brief %Message pools statistics (all threads).
+  struct YAT_DECL PoolStatistics
+  {
+    //! Number of messages allocated from a pool.
+    unsigned long hits_;
+    //! Number of pooled messages allocated from the heap (empty pool).
+    unsigned long misses_;
+    //! Number of messages given back to the pool of another thread.
+    unsigned long remote_frees_;
+
+    //! \brief Default constructor.
+    PoolStatistics ();
+  };
+
+  //- overloads the new operator (makes class "poolable" - see placement new remark)
   void * operator new (size_t);
+  void * operator new (size_t, const std::nothrow_t &) throw();
 
-  //- overloads the delete operator (makes class "cachable")
+  //- overloads the delete operator (makes class "poolable")
   void operator delete (void *);
-#endif
+  void operator delete (void *, const std::nothrow_t &) throw();
+
+  //! \brief Enables/disables the per-thread message pools.
+  //!
+  //! When enabled, each thread keeps the messages it releases (up to
+  //! kMSG_POOL_CAPACITY messages) for its subsequent allocations.
+  //! Default value : false.
+  //! \param enable True = enabled, false = disabled.
+  //! \remark Requires c++11 support (no effect otherwise).
+  static void enable_pool (bool enable);
+
+  //! \brief Returns true if the per-thread message pools are enabled.
+  static bool pool_enabled ();
+
+  //! \brief Returns the message pools statistics.
+  static PoolStatistics pool_statistics ();
+
+  //! \brief Resets the message pools statistics.
+  static void reset_pool_statistics ();
 
   //! \brief Message factory.
   //!
@@ -225,11 +323,23 @@ public:
   template <typename T> void attach_data (T * _data, bool _transfer_ownership = true);
   //! \brief Template function to associate any type of data to a message (makes a copy of _data).
   //!
+  //! Small trivially copyable data is stored inline (see MessageInlineData).
   //! Example :
   //! \verbatim m.attach_data<double>(myDouble); \endverbatim
   //! \param _data Data buffer.
   //! \exception OUT_OF_MEMORY Thrown if allocation fails due to lack of memory.
   template <typename T> void attach_data (const T & _data);
+#if defined (YAT_CPP11)
+  //! \brief Template function to associate any type of data to a message (moves _data).
+  //!
+  //! Example :
+  //! \verbatim m.attach_data(std::move(myVector)); \endverbatim
+  //! \param _data Data buffer (rvalue).
+  //! \exception OUT_OF_MEMORY Thrown if allocation fails due to lack of memory.
+  template <typename T>
+  typename std::enable_if<! std::is_reference<T>::value && ! std::is_pointer<T>::value>::type
+  attach_data (T && _data);
+#endif
   //! \brief Template function that returns the message associated data.
   //!
   //! Data is left in message and will be deleted with message.
@@ -245,6 +355,8 @@ public:
   //! \brief Template function that detaches data from message,
   //! i.e. data is not left in the message and will not be deleted with message.
   //!
+  //! The message has no more attached data on return (inline data is moved to
+  //! a heap allocation owned by the caller).
   //! Before extracting data, checks specified type and data type.
   //! Example :
   //! \verbatim m.detach_data<double>(myDouble); \endverbatim
@@ -256,7 +368,8 @@ public:
   //!
   //! Example :
   //! \verbatim myDouble = m.detach_data<double>(); \endverbatim
-  //! \remark There is no data type check !
+  //! \remark Returns NULL (and leaves the data attached) if the attached data is
+  //! not a \<T\>.
   template <typename T> T * detach_data () const;
 
   //! \brief Template function that checks the message associated data type.
@@ -296,6 +409,23 @@ public:
   //! \brief Gets attached errors (exceptions) on message.
   const Exception & get_error () const;
 
+  //! \brief Template function that attaches a reply to the message (makes a copy of _reply).
+  //!
+  //! Called by the message handler of a request posted with Task::post_with_reply.
+  //! Example :
+  //! \verbatim m.reply<double>(myDouble); \endverbatim
+  //! \param _reply The reply.
+  //! \exception OUT_OF_MEMORY Thrown if allocation fails due to lack of memory.
+  template <typename R> void reply (const R & _reply);
+
+  //! \brief Returns true if a reply is attached to the message.
+  bool has_reply () const;
+
+  //! \brief Template function that returns the reply attached to the message.
+  //!
+  //! \exception RUNTIME_ERROR Thrown if no reply or wrong reply type put in \<R\>.
+  template <typename R> R & get_reply () const;
+
   //! \brief Writes in cout message dump.
   virtual void dump () const;
 
@@ -348,6 +478,62 @@ protected:
   //! \brief Size of message content in bytes.
   size_t size_in_bytes_;
 
+  //! \brief Is the message data stored inline?
+  bool inline_data_;
+
+  //- inline message data storage (an InlineContainer<T>)
+  yat::uint64 inline_data_storage_[(kMSG_INLINE_DATA_SIZE + 4 * sizeof(void *)) / sizeof(yat::uint64)];
+
+  //- returns the inline message data storage
+  void * inline_data_storage ();
+
+  //- deletes the attached data container (if any)
+  void release_data_i ();
+
+  //- post date in nsecs (see MessageQ latency statistics - 0 if not stamped)
+  yat::uint64 post_time_ns_;
+
+  //- lock-free msgQ mode: next msg in the producers inbox (see MessageQ)
+  Message * inbox_next_;
+
+  //- request/reply: the reply attached by the handler
+  Container * reply_data_;
+
+  //- request/reply: the completion callback (see Future::then)
+  ReplyCallback * reply_cb_;
+
+  //- request/reply: number of Future objects bound to the message
+  //- guarded by the reply sync stripe of the message (as <replied_> and <released_>)
+  int future_refs_;
+
+  //- request/reply: a Future has been bound to the message (set before the message is posted)
+  bool reply_expected_;
+
+  //- request/reply: the request is completed (handled or dropped)
+  bool replied_;
+
+  //- request/reply: all the message references are released (Future objects excepted)
+  bool released_;
+
+  //- request/reply: binds/unbinds a Future to/from the message
+  void attach_future_i ();
+  void detach_future_i ();
+
+  //- request/reply: waits for the request to be completed (returns false on tmo expiration)
+  bool wait_reply_i (size_t tmo_msecs);
+
+  //- request/reply: returns true if the request is completed
+  bool reply_completed_i ();
+
+  //- request/reply: installs the completion callback (called immediately if the request is completed)
+  void on_reply_i (const ReplyCallback & cb);
+
+  //- request/reply: completes the request (notifies the waiters and calls the completion callback)
+  void complete_reply_i ();
+
+  //- request/reply: last message reference released - completes the request if not already done
+  void release_reply_i ();
+
 #if defined (YAT_DEBUG)
   //- msg id
   MessageID id_;
@@ -389,6 +575,84 @@ protected:
   WaitableMessage (const WaitableMessage &);
 };
 
+// ============================================================================
+//! \class Future
+//! \brief Handle on the reply of a request posted with Task::post_with_reply.
+//!
+//! The reply state is embedded into the request Message: the future only refers
+//! to the message, so that a request/reply exchange costs no more allocation than
+//! a regular (pooled) message. Waiters block on a condition variable taken from a
+//! small shared pool (see kMSG_REPLY_SYNC_STRIPES) - no Condition is allocated.
+//!
+//! The request is completed once handled by the task or dropped (e.g. msgQ closed,
+//! post timeout expired or message coalesced). \n
+//! %Future objects are copyable: all the copies refer to the same request.
+//! Example :
+//! \verbatim yat::Future<double> f = task->post_with_reply<double>(kGET_VALUE_MSG);
+//! double v = f.get(1000); \endverbatim
+// ============================================================================
+template <typename R> class Future
+{
+  friend class Task;
+
+public:
+  //! \brief Default constructor (the future is not bound to any request).
+  Future ();
+
+  //! \brief Copy constructor (refers to the same request).
+  Future (const Future & f);
+
+  //! \brief Destructor.
+  ~Future ();
+
+  //! \brief Assignment operator (refers to the same request).
+  Future & operator= (const Future & f);
+
+  //! \brief Returns true if the future is bound to a request.
+  bool valid () const;
+
+  //! \brief Returns true if the request is completed (handled or dropped).
+  //! \exception PROGRAMMING_ERROR Thrown if the future is not bound to any request.
+  bool ready () const;
+
+  //! \brief Waits for the request to be completed.
+  //!
+  //! Returns false in case the specified timeout expired before the
+  //! request was completed. Returns true otherwise.
+  //! \param tmo_msecs Timeout in ms (0 means wait forever).
+  //! \exception PROGRAMMING_ERROR Thrown if the future is not bound to any request.
+  bool wait (size_t tmo_msecs) const;
+
+  //! \brief Waits for the request to be completed then returns the reply.
+  //!
+  //! The returned reference remains valid as long as the future (or a copy of it) exists.
+  //! \param tmo_msecs Timeout in ms (0 means wait forever).
+  //! \exception TIMEOUT_EXPIRED Thrown when timeout expires.
+  //! \exception RUNTIME_ERROR Thrown if the request was dropped or not replied (or wrong reply type).
+  //! \remark Rethrows the exception thrown by the message handler (if any).
+  const R & get (size_t tmo_msecs) const;
+
+  //! \brief Installs a completion callback (replaces the previous one if any).
+  //!
+  //! The callback receives the request message (see Message::has_error, Message::get_reply).
+  //! It is called by the thread completing the request - usually the task thread, right after
+  //! the message handling - or immediately by the calling thread if the request is already
+  //! completed. Exceptions thrown by the callback from the task thread are ignored.
+  //! \param cb The completion callback.
+  //! \exception PROGRAMMING_ERROR Thrown if the future is not bound to any request.
+  Future & then (const ReplyCallback & cb);
+
+private:
+  //- binds the future to the specified request (before it is posted)
+  explicit Future (Message * m);
+
+  //- throws a PROGRAMMING_ERROR if the future is not bound to any request
+  void check_bound_i (const char * origin) const;
+
+  //- the request
+  Message * msg_;
+};
+
 //---------------------------------------------
 // Message::attach_data
 //---------------------------------------------
@@ -399,10 +663,7 @@ template <typename T> void Message::attach_data (T * _data, bool _transfer_owner
   {
     //- is <msg_data_> content a <T>?
     if (! this->check_attached_data_type<T>())
-    {
-      delete this->msg_data_;
-      this->msg_data_ = 0;
-    }
+      this->release_data_i();
   }
   //- no existing or deleted data
   if (! this->msg_data_)
@@ -431,15 +692,20 @@ template <typename T> void Message::attach_data (T * _data, bool _transfer_owner
 //---------------------------------------------
 template <typename T> void Message::attach_data (const T & _data)
 {
+  //- small trivially copyable data: copy it into the inline storage
+  if (MessageInlineData<T>::value)
+  {
+    this->release_data_i();
+    this->msg_data_ = ::new (this->inline_data_storage()) InlineContainer<T>(_data);
+    this->inline_data_ = true;
+    return;
+  }
   //- try to avoid GenericContainer<T> reallocation
   if (this->msg_data_)
   {
     //- is <msg_data_> content a <T>?
     if (! this->check_attached_data_type<T>())
-    {
-      delete this->msg_data_;
-      this->msg_data_ = 0;
-    }
+      this->release_data_i();
   }
   //- no existing or deleted data
   if (! this->msg_data_)
@@ -463,23 +729,48 @@ template <typename T> void Message::attach_data (const T & _data)
   }
 }
 
+#if defined (YAT_CPP11)
 //---------------------------------------------
-// Message::get_data
+// Message::attach_data (moves _data)
 //---------------------------------------------
-template <typename T> T& Message::get_data () const
+template <typename T>
+typename std::enable_if<! std::is_reference<T>::value && ! std::is_pointer<T>::value>::type
+Message::attach_data (T && _data)
 {
-  GenericContainer<T> * c = 0;
+  //- small trivially copyable data: copy it into the inline storage
+  if (MessageInlineData<T>::value)
+  {
+    this->attach_data(static_cast<const T&>(_data));
+    return;
+  }
+  //- move the data into its own allocation
+  T * data = new (std::nothrow) T(std::move(_data));
+  if (data == 0)
+  {
+    THROW_YAT_ERROR("OUT_OF_MEMORY",
+                    "MessageData allocation failed",
+                    "Message::attach_data");
+  }
+  //- transfer its ownership to the message
   try
   {
-    c = dynamic_cast<GenericContainer<T>*>(this->msg_data_);
-    if (c == 0)
-    {
-      THROW_YAT_ERROR("RUNTIME_ERROR",
-                      "could not extract data from message [attached data type is not the requested type]",
-                      "Message::get_data");
-    }
+    this->attach_data(data, true);
+  }
+  catch (...)
+  {
+    delete data;
+    throw;
   }
-  catch(const std::bad_cast&)
+}
+#endif
+
+//---------------------------------------------
+// Message::get_data
+//---------------------------------------------
+template <typename T> T& Message::get_data () const
+{
+  GenericContainer<T> * c = container_cast<T>(this->msg_data_);
+  if (c == 0)
   {
     THROW_YAT_ERROR("RUNTIME_ERROR",
                     "could not extract data from message [attached data type is not the requested type]",
@@ -493,18 +784,8 @@ template <typename T> T& Message::get_data () const
 //---------------------------------------------
 template <typename T> void Message::get_data (T*& data) const
 {
-  GenericContainer<T> * c = 0;
-  try
-  {
-    c = dynamic_cast<GenericContainer<T>*>(this->msg_data_);
-    if (c == 0)
-    {
-      THROW_YAT_ERROR("RUNTIME_ERROR",
-                      "could not extract data from message [attached data type is not the requested type]",
-                      "Message::get_data");
-    }
-  }
-  catch(const std::bad_cast&)
+  GenericContainer<T> * c = container_cast<T>(this->msg_data_);
+  if (c == 0)
   {
     THROW_YAT_ERROR("RUNTIME_ERROR",
                     "could not extract data from message [attached data type is not the requested type]",
@@ -518,7 +799,7 @@ template <typename T> void Message::get_data (T*& data) const
 //---------------------------------------------
 template <typename T> void Message::detach_data (T*& _data) const
 {
-  _data = yat::any_cast<T>(this->msg_data_, true);
+  _data = this->detach_data<T>();
   if (! _data)
   {
     THROW_YAT_ERROR("RUNTIME_ERROR",
@@ -532,7 +813,29 @@ template <typename T> void Message::detach_data (T*& _data) const
 //---------------------------------------------
 template <typename T> T * Message::detach_data () const
 {
-  return yat::any_cast<T>(this->msg_data_, true);
+  GenericContainer<T> * c = container_cast<T>(this->msg_data_);
+  if (c == 0)
+    return 0;
+  T * data = 0;
+  //- inline data: moved out to the heap (trivially copyable, i.e. a plain copy)
+  //- since the inline storage dies with the message
+  if (this->inline_data_ && static_cast<InlineContainer<T>*>(c)->holds_inline_value())
+  {
+    data = new (std::nothrow) T(c->get());
+    if (data == 0)
+    {
+      THROW_YAT_ERROR("OUT_OF_MEMORY",
+                      "MessageData allocation failed",
+                      "Message::detach_data");
+    }
+  }
+  else
+  {
+    data = c->get(true);
+  }
+  //- the data is no longer attached to the message: drop the (now empty) container
+  const_cast<Message *>(this)->release_data_i();
+  return data;
 }
 
 //---------------------------------------------
@@ -545,6 +848,161 @@ template <typename T> bool Message::check_attached_data_type () const
        : false;
 }
 
+//---------------------------------------------
+// Message::reply
+//---------------------------------------------
+template <typename R> void Message::reply (const R & _reply)
+{
+  Container * r = new (std::nothrow) GenericContainer<R>(_reply);
+  if (r == 0)
+  {
+    THROW_YAT_ERROR("OUT_OF_MEMORY",
+                    "reply allocation failed",
+                    "Message::reply");
+  }
+  delete this->reply_data_;
+  this->reply_data_ = r;
+}
+
+//---------------------------------------------
+// Message::get_reply
+//---------------------------------------------
+template <typename R> R & Message::get_reply () const
+{
+  GenericContainer<R> * c = container_cast<R>(this->reply_data_);
+  if (c == 0)
+  {
+    THROW_YAT_ERROR("RUNTIME_ERROR",
+                    "could not extract reply from message [no reply or reply type is not the requested type]",
+                    "Message::get_reply");
+  }
+  return c->get_content();
+}
+
+//---------------------------------------------
+// Future::Future
+//---------------------------------------------
+template <typename R> Future<R>::Future ()
+  : msg_ (0)
+{
+}
+
+//---------------------------------------------
+// Future::Future
+//---------------------------------------------
+template <typename R> Future<R>::Future (Message * _m)
+  : msg_ (_m)
+{
+  //- the msg is not posted yet: no need to lock
+  this->msg_->reply_expected_ = true;
+  this->msg_->attach_future_i();
+}
+
+//---------------------------------------------
+// Future::Future
+//---------------------------------------------
+template <typename R> Future<R>::Future (const Future & _f)
+  : msg_ (_f.msg_)
+{
+  if (this->msg_)
+    this->msg_->attach_future_i();
+}
+
+//---------------------------------------------
+// Future::~Future
+//---------------------------------------------
+template <typename R> Future<R>::~Future ()
+{
+  if (this->msg_)
+    this->msg_->detach_future_i();
+}
+
+//---------------------------------------------
+// Future::operator=
+//---------------------------------------------
+template <typename R> Future<R> & Future<R>::operator= (const Future & _f)
+{
+  if (this->msg_ == _f.msg_)
+    return *this;
+  if (_f.msg_)
+    _f.msg_->attach_future_i();
+  if (this->msg_)
+    this->msg_->detach_future_i();
+  this->msg_ = _f.msg_;
+  return *this;
+}
+
+//---------------------------------------------
+// Future::valid
+//---------------------------------------------
+template <typename R> bool Future<R>::valid () const
+{
+  return this->msg_ ? true : false;
+}
+
+//---------------------------------------------
+// Future::check_bound_i
+//---------------------------------------------
+template <typename R> void Future<R>::check_bound_i (const char * _origin) const
+{
+  if (! this->msg_)
+  {
+    THROW_YAT_ERROR("PROGRAMMING_ERROR",
+                    "the future is not bound to any request [check code]",
+                    _origin);
+  }
+}
+
+//---------------------------------------------
+// Future::ready
+//---------------------------------------------
+template <typename R> bool Future<R>::ready () const
+{
+  this->check_bound_i("Future::ready");
+  return this->msg_->reply_completed_i();
+}
+
+//---------------------------------------------
+// Future::wait
+//---------------------------------------------
+template <typename R> bool Future<R>::wait (size_t _tmo_msecs) const
+{
+  this->check_bound_i("Future::wait");
+  return this->msg_->wait_reply_i(_tmo_msecs);
+}
+
+//---------------------------------------------
+// Future::get
+//---------------------------------------------
+template <typename R> const R & Future<R>::get (size_t _tmo_msecs) const
+{
+  if (! this->wait(_tmo_msecs))
+  {
+    THROW_YAT_ERROR("TIMEOUT_EXPIRED",
+                    "timeout expired while waiting for the request to be handled",
+                    "Future::get");
+  }
+  if (this->msg_->has_error())
+    throw this->msg_->get_error();
+  if (! this->msg_->processed_)
+  {
+    THROW_YAT_ERROR("RUNTIME_ERROR",
+                    "the request was dropped before being handled [msgQ closed, post timeout expired or message coalesced]",
+                    "Future::get");
+  }
+  return this->msg_->get_reply<R>();
+}
+
+//---------------------------------------------
+// Future::then
+//---------------------------------------------
+template <typename R> Future<R> & Future<R>::then (const ReplyCallback & _cb)
+{
+  this->check_bound_i("Future::then");
+  this->msg_->on_reply_i(_cb);
+  return *this;
+}
+
 } // namespace
 
 #if defined (YAT_INLINE_IMPL)
@@ -33,28 +33,6 @@
 namespace yat
 {
 
-#if defined(_USE_MSG_CACHE_)
-// ============================================================================
-// Message::operator new - overload new operator (make class "cachable")
-// ============================================================================
-YAT_INLINE void * Message::operator new (size_t)
-{
-  YAT_TRACE_STATIC("Message::operator new");
-
-  return (void *) Message::m_cache.malloc();
-}
-
-// ============================================================================
-// Message::operator delete - overload delete operator (make class "cachable")
-// ============================================================================
-YAT_INLINE void Message::operator delete (void * p)
-{
-  YAT_TRACE_STATIC("Message::operator delete");
-
-  Message::m_cache.free(reinterpret_cast<Message*>(p));
-}
-#endif
-
 // ============================================================================
 // Message::duplicate
 // ============================================================================
@@ -68,7 +46,14 @@ YAT_INLINE Message * Message::duplicate ()
 // ============================================================================
 YAT_INLINE void Message::release ()
 {
-  this->SharedObject::release ();
+  if (! this->reply_expected_)
+  {
+    this->SharedObject::release ();
+    return;
+  }
+  //- request/reply: the message outlives its last reference while a Future refers to it
+  if (! this->SharedObject::release (false))
+    this->release_reply_i ();
 }
 
 // ============================================================================
@@ -156,12 +141,18 @@ YAT_INLINE void Message::processed ()
 {
   YAT_TRACE("Message::processed");
 
-  AutoMutex<Mutex> guard(this->lock_);
+  {
+    AutoMutex<Mutex> guard(this->lock_);
+
+    this->processed_ = true;
 
-  this->processed_ = true;
+    if (this->cond_)
+      this->cond_->broadcast();
+  }
 
-  if (this->cond_)
-    this->cond_->broadcast();
+  //- request/reply: notify the Future(s)
+  if (this->reply_expected_)
+    this->complete_reply_i();
 }
 
 // ============================================================================
@@ -197,6 +188,38 @@ YAT_INLINE const Exception & Message::get_error () const
   return this->exception_;
 }
 
+// ============================================================================
+// Message::has_reply
+// ============================================================================
+YAT_INLINE bool Message::has_reply () const
+{
+  return this->reply_data_ ? true : false;
+}
+
+// ============================================================================
+// Message::inline_data_storage
+// ============================================================================
+YAT_INLINE void * Message::inline_data_storage ()
+{
+  return static_cast<void *>(this->inline_data_storage_);
+}
+
+// ============================================================================
+// Message::release_data_i
+// ============================================================================
+YAT_INLINE void Message::release_data_i ()
+{
+  if (! this->msg_data_)
+    return;
+  //- inline data: only destroy the container (no deallocation)
+  if (this->inline_data_)
+    this->msg_data_->~Container();
+  else
+    delete this->msg_data_;
+  this->msg_data_ = 0;
+  this->inline_data_ = false;
+}
+
 // ============================================================================
 // Message::size_in_bytes
 // ============================================================================
@@ -45,12 +45,14 @@
 // ============================================================================
 #include <iostream>
 #include <yat/CommonHeader.h>
-#include <list>
+#include <map>
+#include <vector>
 #if defined (YAT_WIN32)
 # include <sys/timeb.h>
 #else
 # include <sys/time.h>
 #endif
+#include <yat/threading/Atomic.h>
 #include <yat/threading/Semaphore.h>
 #include <yat/threading/Condition.h>
 #include <yat/threading/Message.h>
@@ -70,6 +72,9 @@
 //-----------------------------------------------------------------------------
 #define kMIN_WATER_MARKS_DIFF   kDEFAULT_LO_WATER_MARK
 //-----------------------------------------------------------------------------
+//! Number of buckets of a MessageQ::LatencyHistogram.
+#define kLATENCY_HISTOGRAM_BUCKETS  496
+//-----------------------------------------------------------------------------
 
 namespace yat
 {
@@ -80,12 +85,116 @@ namespace yat
 //!
 //! MessageQ is used to manage Message transmission/reception between Task objects.
 //! It is a FIFO message queue for equal priority messages.
+//!
+//! In its default mode, producers and consumer are serialized on a single mutex.
+//! The optional lock-free mode (multi-producer/single-consumer) lets producers
+//! post without taking the msgQ lock: posted messages are pushed onto a lock-free
+//! inbox that the consumer merges into the priority ordered queue. Producers only
+//! block when the msgQ is saturated, and the consumer only blocks when the msgQ
+//! is empty. The lock-free mode requires c++11 support (YAT_CPP11) - otherwise
+//! the msgQ silently falls back to its default mode.
 // ============================================================================
 class YAT_DECL MessageQ
 {
   friend class Task;
 
-  typedef std::list<yat::Message *> MessageQImpl;
+  //- priority bucketed msg storage
+  //- one FIFO per priority value plus a two levels bitmap of the non-empty
+  //- priorities: insertion and extraction are done in constant time while
+  //- keeping the FIFO order of equal priority messages. msgs are also linked
+  //- into a msg type index so that removing the msgs of a given type does not
+  //- require to scan the whole storage.
+  class MessageQImpl
+  {
+  public:
+    MessageQImpl ();
+    ~MessageQImpl ();
+
+    //- returns true if there is no pending msg
+    bool empty () const;
+
+    //- returns the number of pending msgs
+    size_t size () const;
+
+    //- inserts a msg at the tail of its priority FIFO
+    //- throws std::bad_alloc on memory allocation failure
+    void push (Message * msg);
+
+    //- returns the highest priority msg (storage must not be empty)
+    Message * front () const;
+
+    //- removes the highest priority msg (storage must not be empty)
+    void pop_front ();
+
+    //- removes the pending msgs of type <msg_type> and appends them to <removed>
+    //- (msgs are not released). returns the number of removed msgs.
+    size_t remove (size_t msg_type, std::vector<Message *> & removed);
+
+    //- returns the last posted pending msg of type <msg_type> (0 if none)
+    Message * find_last (size_t msg_type) const;
+
+    //- substitutes <msg> to the last posted pending msg of the same type
+    //- (which must exist). <msg> takes its place in the storage if they have
+    //- the same priority, is queued in its priority band otherwise. returns
+    //- the replaced msg (not released). throws std::bad_alloc on memory
+    //- allocation failure (the storage is then unchanged).
+    Message * replace_last (Message * msg);
+
+  private:
+    //- a storage node
+    struct Node
+    {
+      Message * msg;
+      size_t prio;
+      size_t type;
+      Node * prev;
+      Node * next;
+      Node * type_prev;
+      Node * type_next;
+    };
+
+    //- a priority FIFO
+    struct Band
+    {
+      Node * head;
+      Node * tail;
+    };
+
+    //- a page of consecutive priorities (allocated on first use)
+    struct Page
+    {
+      Band bands[256];
+      yat::uint64 bits[4];
+    };
+
+    //- the highest non-empty priority
+    size_t top_priority () const;
+
+    //- the node of the last posted pending msg of type <msg_type> (0 if none)
+    Node * find_last_node (size_t msg_type) const;
+
+    //- unlinks <node> from both its priority FIFO and the type index
+    void unlink (Node * node);
+
+    //- pages of priorities [i * 256, i * 256 + 255]
+    Page * pages_[256];
+
+    //- bitmap of the non-empty pages
+    yat::uint64 page_bits_[4];
+
+    //- msg type index: one list per (msg type % 64) bucket
+    Node * types_[64];
+
+    //- recycled nodes
+    Node * free_nodes_;
+
+    //- number of pending msgs
+    size_t size_;
+
+    //- Disallow these operations.
+    MessageQImpl & operator= (const MessageQImpl &);
+    MessageQImpl (const MessageQImpl &);
+  };
 
 public:
   //! %Message queue state.
@@ -104,6 +213,72 @@ public:
     NUM_OF_BYTES
   } WmUnit;
 
+  //! Latency statistics mode.
+  typedef enum
+  {
+    //! No latency statistics.
+    LATENCY_STATS_OFF,
+    //! Queue wait and handling latencies of all the messages (default).
+    //! Low overhead: two clock readings and a few increments per message.
+    LATENCY_STATS_ON,
+    //! Same as LATENCY_STATS_ON plus a breakdown per message type.
+    LATENCY_STATS_PER_MSG_TYPE
+  } LatencyStatsMode;
+
+  //! HDR-style (log-linear) latency histogram.
+  //!
+  //! Values are recorded in nanoseconds: values below 16 ns are recorded exactly,
+  //! the others into 8 linear sub-buckets per power of 2 (i.e. a relative
+  //! precision of 12.5% over the whole 64 bits range). The buckets are allocated
+  //! on the first recorded value, so that an unused histogram costs a few bytes.
+  struct YAT_DECL LatencyHistogram
+  {
+    //! Default constructor.
+    LatencyHistogram ();
+    //! Copy constructor.
+    LatencyHistogram (const LatencyHistogram & h);
+    //! Destructor.
+    ~LatencyHistogram ();
+    //! Assignment operator (reuses the buckets of the histogram, if any).
+    LatencyHistogram & operator= (const LatencyHistogram & h);
+    //! Allocates the buckets (otherwise done on the first recorded value).
+    void reserve ();
+    //! Records a value.
+    //! \param ns Value in nanoseconds.
+    void record (yat::uint64 ns);
+    //! Resets the histogram.
+    void reset ();
+    //! Returns the value (in nanoseconds) below which \<p\> percent of the recorded
+    //! values fall (upper bound of the matching bucket).
+    //! \param p Percentile in [0, 100].
+    yat::uint64 percentile (double p) const;
+    //! Returns the mean value in nanoseconds.
+    double mean () const;
+    //! Dumps the histogram summary (count, min, mean, percentiles, max) in usecs.
+    //! \param out Output
+    //! \param name Histogram name
+    void dump (std::ostream& out, const std::string & name) const;
+    //! Number of recorded values.
+    yat::uint64 count_;
+    //! Min. recorded value (ns).
+    yat::uint64 min_;
+    //! Max. recorded value (ns).
+    yat::uint64 max_;
+    //! Sum of the recorded values (ns).
+    double sum_;
+    //! The kLATENCY_HISTOGRAM_BUCKETS buckets (0 until allocated).
+    yat::uint64 * buckets_;
+  };
+
+  //! %Message latencies.
+  struct YAT_DECL MsgLatency
+  {
+    //! Time spent in the message queue (from post to extraction).
+    LatencyHistogram queue_wait_;
+    //! Time spent in the message handler.
+    LatencyHistogram handling_;
+  };
+
   //! %Message queue statistics.
   struct YAT_DECL Statistics
   {
@@ -128,12 +303,69 @@ public:
     unsigned long trashed_msg_counter_;
     //! Total number of messages trashed on post timeout.
     unsigned long trashed_on_post_tmo_counter_;
+    //! Total number of messages coalesced with a pending message (see MessageQ::enable_coalescing).
+    unsigned long coalesced_msg_counter_;
+    //! Number of times the consumer blocked waiting for a message.
+    unsigned long consumer_parked_counter_;
+    //! Number of times a message arrived while the consumer was spinning (i.e. it didn't block).
+    unsigned long consumer_spun_counter_;
+    //! Number of wakeups sent to a blocked consumer.
+    unsigned long consumer_woken_counter_;
+    //! Number of wakeups sent to a blocked producer.
+    unsigned long producer_woken_counter_;
+    //! High precision periodic mode: number of missed periods (i.e. skipped because
+    //! a PERIODIC message was delivered more than one period late).
+    unsigned long periodic_overrun_counter_;
+    //! High precision periodic mode: PERIODIC messages delivery jitter (i.e. delay
+    //! between the period deadline and the message extraction).
+    LatencyHistogram periodic_jitter_;
     //! Current pending charge in bytes.
     unsigned long pending_charge_;
     //! Current pending charge in number of messages.
     unsigned long pending_mgs_;
     //! MessageQ unit.
     WmUnit wm_unit_;
+    //! Latencies of all the messages (see MessageQ::latency_stats_mode).
+    MsgLatency latency_;
+    //! Latencies per message type (LATENCY_STATS_PER_MSG_TYPE mode only).
+    std::map<size_t, MsgLatency> latency_per_msg_type_;
+  };
+
+  //! \brief %Message posting notification interface.
+  //!
+  //! A notifier is called by the posting thread (outside of any msgQ lock) each
+  //! time a message is actually inserted into the message queue. It is used by
+  //! the TaskExecutor to schedule the tasks it runs when their msgQ becomes non-empty.
+  class YAT_DECL Notifier
+  {
+  public:
+    //! \brief Destructor.
+    virtual ~Notifier ();
+
+    //! \brief Called after a message has been posted.
+    //! \remark Must not post into the notifying message queue.
+    virtual void message_posted () = 0;
+  };
+
+  //! \brief %Message coalescing hook interface.
+  //!
+  //! Merges a posted message into the pending message of the same type it
+  //! coalesces with (see MessageQ::enable_coalescing). Called by the posting
+  //! thread with the msgQ locked.
+  class YAT_DECL Coalescer
+  {
+  public:
+    //! \brief Destructor.
+    virtual ~Coalescer ();
+
+    //! \brief Merges \<posted\> into \<pending\>.
+    //!
+    //! \<pending\> stays in the message queue, \<posted\> is released on return.
+    //! \remark Must not post into the message queue. If it throws, \<posted\>
+    //! is enqueued as usual.
+    //! \param pending The pending message.
+    //! \param posted The message being posted.
+    virtual void merge (Message & pending, Message & posted) = 0;
   };
 
   struct Time_ns
@@ -146,9 +378,13 @@ public:
   //! \param lo_wm Low water mark.
   //! \param hi_wm High water mark.
   //! \param throw_on_post_tmo Enables exception creation on post timeout expiration.
+  //! \param lock_free Enables the lock-free multi-producer/single-consumer mode.
+  //! \remark In lock-free mode, the water marks are "soft" limits: concurrent producers
+  //! may push the pending charge slightly above the high water mark.
   MessageQ (size_t lo_wm = kDEFAULT_LO_WATER_MARK,
             size_t hi_wm = kDEFAULT_HI_WATER_MARK,
-            bool throw_on_post_tmo = false);
+            bool throw_on_post_tmo = false,
+            bool lock_free = false);
 
   //! \brief Destructor.
   virtual ~ MessageQ ();
@@ -165,6 +401,21 @@ public:
   //! to true.
   int post (yat::Message * msg, size_t tmo_msecs = kDEFAULT_POST_MSG_TMO);
 
+  //! \brief Posts a batch of messages.
+  //!
+  //! The message queue is locked once for the whole batch and the consumer is
+  //! notified once. Messages are posted in the order of the vector (then ordered
+  //! according to their priority in the message queue).
+  //! Returns 0 if all messages were successfully posted, -1 otherwise.
+  //! \param msgs Messages to send. The vector is cleared on return.
+  //! \param tmo_msecs Timeout in ms (applies to each message waiting for room in the queue).
+  //! \remark Once the timeout expired, the remaining messages are destroyed (i.e. released).
+  //! \remark Can NOT post any TIMEOUT or PERIODIC msg (yat::Task model violation).
+  //!
+  //! \exception TIMEOUT_EXPIRED Thrown on timeout expiration, if *throw_on_post_msg_timeout* is set
+  //! to true.
+  int post_batch (std::vector<yat::Message *> & msgs, size_t tmo_msecs = kDEFAULT_POST_MSG_TMO);
+
   //! \brief Extracts next message from the message queue.
   //!
   //! Waits for a message the specified time.
@@ -177,6 +428,40 @@ public:
   //! \param tmo_msecs Tiemout in ms.
   Message * next_message_ex (double tmo_msecs);
 
+  //! \brief Extracts up to \<max_msgs\> messages from the message queue in one go.
+  //!
+  //! Waits for a message the specified time, then extracts the pending user messages
+  //! without releasing the message queue lock. Task messages (INIT, EXIT, TIMEOUT,
+  //! PERIODIC, WAKEUP) are always returned alone.
+  //! Returns the number of messages appended to \<msgs\>.
+  //! \param msgs Extracted messages (appended to the vector).
+  //! \param max_msgs Maximum size of \<msgs\> on return.
+  //! \param tmo_msecs Tiemout in ms.
+  size_t next_messages (std::vector<Message *> & msgs, size_t max_msgs, double tmo_msecs);
+
+  //! \brief Extracts up to \<max_msgs\> messages from the message queue in one go.
+  //! Same as next_messages, with accurate timing of TASK_PERIODIC messages dispatching
+  //! (see next_message_ex).
+  //! \param msgs Extracted messages (appended to the vector).
+  //! \param max_msgs Maximum size of \<msgs\> on return.
+  //! \param tmo_msecs Tiemout in ms.
+  size_t next_messages_ex (std::vector<Message *> & msgs, size_t max_msgs, double tmo_msecs);
+
+  //! \brief Extracts up to \<max_msgs\> pending messages without waiting.
+  //!
+  //! Same as next_messages but never blocks and never generates any TIMEOUT or
+  //! PERIODIC message (the caller is in charge of the timing - see TaskExecutor).
+  //! Returns the number of messages appended to \<msgs\> (0 if the msgQ is empty).
+  //! \param msgs Extracted messages (appended to the vector).
+  //! \param max_msgs Maximum size of \<msgs\> on return.
+  size_t try_next_messages (std::vector<Message *> & msgs, size_t max_msgs);
+
+  //! \brief Installs the message posting notifier (0 to remove it).
+  //!
+  //! Must be called before any message is posted (the notifier is read without lock).
+  //! \param n The notifier (not owned by the msgQ).
+  void notifier (Notifier * n);
+
   //! \brief Water marks unit mutator.
   //! \param _wmu Water mark unit.
   void wm_unit (WmUnit _wmu);
@@ -214,11 +499,62 @@ public:
   //! \param msg_type %Message type.
   size_t clear_pending_messages (size_t msg_type);
 
+  //! \brief Consumer spin duration mutator.
+  //!
+  //! When greater than 0, a consumer finding the message queue empty spins (without
+  //! holding the msgQ lock) up to the specified duration before blocking. This saves
+  //! the block/wakeup round trip (i.e. two context switches) when messages are posted
+  //! at a high rate, at the price of some CPU time. Requires c++11 support (ignored otherwise).
+  //! Default value : 0 (no spin).
+  //! \param usecs Max. spin duration in microseconds.
+  void consumer_spin_usecs (size_t usecs);
+
+  //! \brief Consumer spin duration accessor.
+  size_t consumer_spin_usecs () const;
+
+  //! \brief Enables latest-value coalescing of the messages of the specified type.
+  //!
+  //! Posting a message of type \<msg_type\> while a message of the same type is
+  //! still pending doesn't enqueue a new message:
+  //! - without \<merger\>, the posted message replaces the pending one, which is
+  //!   released. It keeps the position of the pending one in the queue if they have
+  //!   the same priority, otherwise it is queued with its own priority,
+  //! - otherwise, the posted message is merged into the pending one (see Coalescer).
+  //!
+  //! A coalesced post never waits for room in the message queue, so a slow consumer
+  //! only handles the latest value instead of a backlog of stale ones.
+  //! Waitable messages and task ctrl messages are never coalesced.
+  //! Coalesced messages are counted in Statistics::coalesced_msg_counter_.
+  //! \param msg_type %Message type.
+  //! \param merger Optional merging hook (not owned by the msgQ).
+  //! \remark The messages posted while the coalescing is being enabled or disabled
+  //! may or may not be coalesced.
+  void enable_coalescing (size_t msg_type, Coalescer * merger = 0);
+
+  //! \brief Disables coalescing of the messages of the specified type.
+  //! \param msg_type %Message type.
+  void disable_coalescing (size_t msg_type);
+
+  //! \brief Returns true if coalescing is enabled for the specified message type.
+  //! \param msg_type %Message type.
+  bool coalescing_enabled (size_t msg_type);
+
   //! \brief Closes the message queue.
   void close ();
 
   //! Returns the MessageQ Statistics.
-  const Statistics & statistics ();
+  //! \remark Returns a snapshot of the statistics taken at call time.
+  Statistics statistics ();
+
+  //! \brief Latency statistics mode mutator.
+  //!
+  //! Should be set before the msgQ is used (in lock-free mode, producers read it
+  //! without locking the msgQ).
+  //! \param m The latency statistics mode.
+  void latency_stats_mode (LatencyStatsMode m);
+
+  //! \brief Latency statistics mode accessor.
+  LatencyStatsMode latency_stats_mode () const;
 
   //! \brief Resets the MessageQ Statistics.
   void reset_statistics ();
@@ -237,10 +573,76 @@ public:
   //! \brief Returns period messages handling status.
   bool periodic_msg_enabled () const;
 
+  //! \brief Enable/disable the high precision periodic mode.
+  //!
+  //! In this mode, the PERIODIC messages are scheduled on absolute deadlines of
+  //! the monotonic clock (deadline n = start + n * period), so the period never
+  //! drifts and the delivery jitter only depends on the wakeup latency:
+  //! - the consumer waits for the next deadline (or a msg) on the msgQ condition
+  //!   with a timeout recomputed from the absolute deadline at each wakeup (the
+  //!   wakeup accuracy is bounded by the OS timer slack - see PR_SET_TIMERSLACK
+  //!   on Linux, which may be reduced by the task on its own thread),
+  //! - optionally, it spins during the last microseconds before the deadline
+  //!   (see periodic_msg_spin_usecs).
+  //!
+  //! When a PERIODIC message is delivered more than one period late (e.g. its
+  //! handling took longer than the period), the missed deadlines are skipped
+  //! (no burst of late messages) and counted as overruns. The overruns and the
+  //! delivery jitter are reported in the Statistics.
+  //! \param enable True = enabled, false = disabled.
+  void enable_high_precision_periodic_msg (bool enable);
+
+  //! \brief Returns the high precision periodic mode status.
+  bool high_precision_periodic_msg_enabled () const;
+
+  //! \brief High precision periodic mode: spin duration mutator.
+  //!
+  //! Time (in microseconds) the consumer spins before each deadline instead of
+  //! blocking, in order to get rid of the wakeup latency at the price of some
+  //! CPU time. Requires c++11 support (ignored otherwise).
+  //! Default value : 0 (no spin).
+  //! \param usecs Spin duration in microseconds.
+  void periodic_msg_spin_usecs (size_t usecs);
+
+  //! \brief High precision periodic mode: spin duration accessor.
+  size_t periodic_msg_spin_usecs () const;
+
+  //! \brief Returns true if the msgQ runs in lock-free (multi-producer/single-consumer) mode.
+  bool lock_free () const;
+
 private:
   //- periodic msg tmo expired?
   bool periodic_tmo_expired_i (double _tmo_msecs);
 
+  //- posts a msg (<this->lock_> MUST be locked by the calling thread).
+  //- returns 1 if the msg was inserted, 0 if it was trashed or coalesced, -1 on tmo expiration.
+  int post_i (Message * msg, size_t tmo_msecs);
+
+  //- coalesces <msg> with the pending msg of the same type, if any and if enabled
+  //- (<this->lock_> MUST be locked by the calling thread). returns true if <msg>
+  //- has been coalesced (i.e. the msgQ took care of it).
+  bool coalesce_i (Message * msg);
+
+  //- updates <coalesced_types_> from <coalescing_> (<this->lock_> MUST be locked
+  //- by the calling thread)
+  void update_coalesced_types_i ();
+
+  //- next_message/next_message_ex impl (<this->lock_> MUST be locked by the calling thread).
+  Message * next_message_i (double tmo_msecs);
+  Message * next_message_ex_i (double tmo_msecs);
+
+  //- next_message impl in high precision periodic mode (<this->lock_> MUST be
+  //- locked by the calling thread).
+  Message * next_message_hp_i (double tmo_msecs);
+
+  //- extracts the msg at the front of the msgQ (<this->lock_> MUST be locked by
+  //- the calling thread and the msgQ must not be empty).
+  Message * pop_front_i ();
+
+  //- extracts the pending user msgs (<this->lock_> MUST be locked by the calling thread).
+  //- returns the number of msgs appended to <msgs_>.
+  size_t next_user_messages_i (std::vector<Message *> & msgs_, size_t max_msgs);
+
   //- clears msgQ content (returns num of trashed messages).
   size_t clear_i (bool notify_waiters = true);
 
@@ -251,6 +653,21 @@ private:
 
   void compute_next_periodic_period (double _requested_tmo_ms);
 
+  //- spins (msgQ unlocked) up to <max_usecs> waiting for a msg to be posted.
+  //- returns true if a msg has been posted meanwhile (<this->lock_> MUST be locked
+  //- by the calling thread).
+  bool spin_not_empty_i (size_t max_usecs);
+
+  //- spins (msgQ unlocked) until the <deadline_ns> (see latency_clock_ns) waiting
+  //- for a msg to be posted. returns true if a msg has been posted meanwhile.
+  bool spin_until_i (yat::uint64 deadline_ns);
+
+  //- wakes up a blocked consumer, if any (<num_msgs> msgs have been posted).
+  void wakeup_consumer_i (size_t num_msgs = 1);
+
+  //- wakes up the next blocked producer, if any and if the msgQ is not saturated.
+  void wakeup_producer_i ();
+
   //- waits for the msQ to have room for new messages.
   //- returns false if tmo expired, true otherwise.
   bool wait_not_full_i (size_t tmo_msecs);
@@ -264,7 +681,59 @@ private:
   //- decrements the pending charge.
   void dec_pending_charge_i (Message * msg);
 
-  //- use a std::deque to implement msgQ
+  //- returns the msg charge (in msgQ current unit).
+  size_t msg_charge_i (Message * msg) const;
+
+  //- returns the current pending charge.
+  size_t pending_charge_i () const;
+
+  //- marks the msgQ as unsaturated and wakes up the msg producer(s).
+  void unsaturate_i ();
+
+  //- the latency statistics clock (nsecs).
+  static yat::uint64 latency_clock_ns ();
+
+  //- latency stats: records the time <msg> spent in the msgQ.
+  void record_queue_wait_i (Message * msg);
+
+  //- latency stats: records a msg handling duration (called by the consumer
+  //- without locking the msgQ - folded into the stats on next extraction).
+  void record_handling (size_t msg_type, yat::uint64 duration);
+
+  //- latency stats: folds the pending handling durations into the stats.
+  void fold_handling_i ();
+
+#if defined (YAT_CPP11)
+  //- lock-free mode: posts a msg without locking the msgQ (unless saturated).
+  int post_lf_i (Message * msg, size_t tmo_msecs);
+
+  //- lock-free mode: coalesces <msg> (slow path - takes the lock).
+  //- returns true if <msg> has been coalesced.
+  bool coalesce_lf_i (Message * msg);
+
+  //- lock-free mode: waits for room in the msgQ (slow path - takes the lock).
+  bool wait_not_full_lf_i (size_t tmo_msecs);
+
+  //- lock-free mode: pushes a msg onto the producers inbox.
+  void push_lf_i (Message * msg);
+
+  //- lock-free mode: moves the inbox content into the priority ordered msgQ.
+  //- <this->lock_> MUST be locked by the calling thread.
+  void drain_inbox_i ();
+
+  //- lock-free mode: tells producers the consumer is about to block.
+  //- returns false if msgs were posted meanwhile (i.e. no need to block).
+  bool park_consumer_i ();
+
+  //- lock-free mode: leaves the parked state after a wait on the consumer condition.
+  //- returns true if there is at least one msg in the msgQ or if <signaled> is true.
+  bool unpark_consumer_i (bool signaled);
+
+  //- lock-free mode: folds the atomic counters into the msgQ statistics.
+  void fold_lf_statistics_i ();
+#endif
+
+  //- the msgQ storage
   MessageQImpl msg_q_;
 
   //- sync. object in order to make the msgQ thread safe
@@ -305,6 +774,18 @@ private:
 
   double last_requested_tmo_;
 
+  //- high precision periodic mode flag
+  bool hp_periodic_;
+
+  //- high precision periodic mode: spin duration before deadlines (usecs)
+  size_t hp_spin_usecs_;
+
+  //- high precision periodic mode: current period (nsecs)
+  yat::uint64 hp_period_ns_;
+
+  //- high precision periodic mode: next deadline (see latency_clock_ns - 0: none)
+  yat::uint64 hp_next_deadline_ns_;
+
   //- low water marks
   size_t lo_wm_;
 
@@ -336,6 +817,58 @@ private:
   //- some task/msgQ stats
   Statistics stats_;
 
+  //- latency stats mode
+  LatencyStatsMode latency_stats_mode_;
+
+  //- latency stats: handling durations not yet folded into the stats (consumer side)
+  std::vector<std::pair<size_t, yat::uint64> > pending_handling_;
+
+  //- lock-free mode flag
+  bool lock_free_;
+
+  //- message posting notifier (if any)
+  Notifier * notifier_;
+
+  //- coalesced msg types and their merging hook (if any)
+  std::map<size_t, Coalescer *> coalescing_;
+
+  //- bit <msg type % 64> set if a msg type of this index is coalesced: read by
+  //- the lock-free mode producers instead of <coalescing_> (which they can't
+  //- access without locking the msgQ)
+  Atomic<yat::uint64> coalesced_types_;
+
+  //- number of consumers blocked on <msg_consumer_sync_>
+  size_t consumers_waiting_;
+
+  //- number of producers blocked on <msg_producer_sync_>
+  size_t producers_waiting_;
+
+  //- consumer spin duration in usecs (0: no spin)
+  size_t spin_usecs_;
+
+  //- default mode: incremented on each msg insertion (watched by a spinning consumer)
+  Atomic<size_t> post_seq_;
+
+  //- lock-free mode: producers inbox (intrusive lock-free LIFO, linked through
+  //- Message::inbox_next_ and reversed by the consumer)
+  Atomic<Message *> lf_inbox_;
+
+  //- lock-free mode: pending charge (msgQ + inbox)
+  Atomic<size_t> lf_pending_charge_;
+
+  //- lock-free mode: set by the consumer when it is about to block on an empty msgQ
+  Atomic<bool> lf_consumer_parked_;
+
+  //- lock-free mode: mirror of <saturated_> readable without locking the msgQ
+  Atomic<bool> lf_saturated_;
+
+  //- lock-free mode: mirror of <state_> readable without locking the msgQ
+  Atomic<bool> lf_closed_;
+
+  //- lock-free mode: stats counters updated outside the critical section
+  Atomic<unsigned long> lf_posted_without_waiting_;
+  Atomic<unsigned long> lf_trashed_;
+
   // = Disallow these operations.
   //--------------------------------------------
   MessageQ & operator= (const MessageQ &);
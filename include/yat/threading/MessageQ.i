@@ -33,6 +33,22 @@
 namespace yat
 {
 
+// ============================================================================
+// MessageQ::MessageQImpl::empty
+// ============================================================================
+YAT_INLINE bool MessageQ::MessageQImpl::empty () const
+{
+  return this->size_ == 0;
+}
+
+// ============================================================================
+// MessageQ::MessageQImpl::size
+// ============================================================================
+YAT_INLINE size_t MessageQ::MessageQImpl::size () const
+{
+  return this->size_;
+}
+
 // ============================================================================
 // MessageQ::periodic_tmo_expired
 // ============================================================================
@@ -119,14 +135,27 @@ YAT_INLINE MessageQ::WmUnit MessageQ::wm_unit () const
   return this->wm_unit_;
 }
 
+// ============================================================================
+// MessageQ::msg_charge_i
+// ============================================================================
+YAT_INLINE size_t MessageQ::msg_charge_i (Message * _msg) const
+{
+  return (this->wm_unit_ == NUM_OF_MSGS)
+         ? 1
+         : _msg->size_in_bytes();
+}
+
 // ============================================================================
 // MessageQ::inc_pending_charge_i
 // ============================================================================
 YAT_INLINE void MessageQ::inc_pending_charge_i (Message * _msg)
 {
-  this->pending_charge_ += (this->wm_unit_ == NUM_OF_MSGS)
-                         ? 1
-                         : _msg->size_in_bytes();
+#if defined (YAT_CPP11)
+  //- lock-free mode: the charge is accounted by the producer (see post_lf_i)
+  if (this->lock_free_)
+    return;
+#endif
+  this->pending_charge_ += this->msg_charge_i(_msg);
 }
 
 // ============================================================================
@@ -134,23 +163,75 @@ YAT_INLINE void MessageQ::inc_pending_charge_i (Message * _msg)
 // ============================================================================
 YAT_INLINE void MessageQ::dec_pending_charge_i (Message * _msg)
 {
-  this->pending_charge_ -= (this->wm_unit_ == NUM_OF_MSGS)
-                         ? 1
-                         : _msg->size_in_bytes();
+#if defined (YAT_CPP11)
+  if (this->lock_free_)
+  {
+    this->lf_pending_charge_.fetch_sub(this->msg_charge_i(_msg));
+    return;
+  }
+#endif
+  this->pending_charge_ -= this->msg_charge_i(_msg);
+}
+
+// ============================================================================
+// MessageQ::pending_charge_i
+// ============================================================================
+YAT_INLINE size_t MessageQ::pending_charge_i () const
+{
+#if defined (YAT_CPP11)
+  if (this->lock_free_)
+    return this->lf_pending_charge_.load();
+#endif
+  return this->pending_charge_;
 }
 
 // ============================================================================
 // MessageQ::statistics
 // ============================================================================
-YAT_INLINE const MessageQ::Statistics & MessageQ::statistics ()
+YAT_INLINE MessageQ::Statistics MessageQ::statistics ()
 {
+  //- allocate the snapshot histograms outside of the critical section: the
+  //- copy then reuses them (the per msg type ones are allocated by the copy)
+  Statistics s;
+  if (this->latency_stats_mode_ != LATENCY_STATS_OFF)
+  {
+    s.latency_.queue_wait_.reserve();
+    s.latency_.handling_.reserve();
+  }
+  if (this->hp_periodic_)
+    s.periodic_jitter_.reserve();
+
   {
     MutexLock guard(this->lock_);
-    this->stats_.pending_charge_ = this->pending_charge_;
+#if defined (YAT_CPP11)
+    if (this->lock_free_)
+    {
+      this->drain_inbox_i();
+      this->fold_lf_statistics_i();
+    }
+#endif
+    this->stats_.pending_charge_ = this->pending_charge_i();
     this->stats_.pending_mgs_ = this->msg_q_.size();
+    s = this->stats_;
   }
 
-  return this->stats_;
+  return s;
+}
+
+// ============================================================================
+// MessageQ::latency_stats_mode
+// ============================================================================
+YAT_INLINE void MessageQ::latency_stats_mode (MessageQ::LatencyStatsMode m)
+{
+  latency_stats_mode_ = m;
+}
+
+// ============================================================================
+// MessageQ::latency_stats_mode
+// ============================================================================
+YAT_INLINE MessageQ::LatencyStatsMode MessageQ::latency_stats_mode () const
+{
+  return latency_stats_mode_;
 }
 
 // ============================================================================
@@ -185,4 +266,102 @@ YAT_INLINE bool MessageQ::periodic_msg_enabled () const
   return enable_periodic_msg_;
 }
 
+// ============================================================================
+// MessageQ::enable_high_precision_periodic_msg
+// ============================================================================
+YAT_INLINE void MessageQ::enable_high_precision_periodic_msg (bool b)
+{
+  MutexLock guard(this->lock_);
+  this->hp_periodic_ = b;
+  //- start a new periodic series
+  this->hp_next_deadline_ns_ = 0;
+}
+
+// ============================================================================
+// MessageQ::high_precision_periodic_msg_enabled
+// ============================================================================
+YAT_INLINE bool MessageQ::high_precision_periodic_msg_enabled () const
+{
+  return this->hp_periodic_;
+}
+
+// ============================================================================
+// MessageQ::periodic_msg_spin_usecs
+// ============================================================================
+YAT_INLINE void MessageQ::periodic_msg_spin_usecs (size_t usecs)
+{
+  MutexLock guard(this->lock_);
+  this->hp_spin_usecs_ = usecs;
+}
+
+// ============================================================================
+// MessageQ::periodic_msg_spin_usecs
+// ============================================================================
+YAT_INLINE size_t MessageQ::periodic_msg_spin_usecs () const
+{
+  return this->hp_spin_usecs_;
+}
+
+// ============================================================================
+// MessageQ::lock_free
+// ============================================================================
+YAT_INLINE bool MessageQ::lock_free () const
+{
+  return lock_free_;
+}
+
+// ============================================================================
+// MessageQ::consumer_spin_usecs
+// ============================================================================
+YAT_INLINE void MessageQ::consumer_spin_usecs (size_t usecs)
+{
+  MutexLock guard(this->lock_);
+  this->spin_usecs_ = usecs;
+}
+
+// ============================================================================
+// MessageQ::consumer_spin_usecs
+// ============================================================================
+YAT_INLINE size_t MessageQ::consumer_spin_usecs () const
+{
+  return this->spin_usecs_;
+}
+
+// ============================================================================
+// MessageQ::enable_coalescing
+// ============================================================================
+YAT_INLINE void MessageQ::enable_coalescing (size_t msg_type, MessageQ::Coalescer * merger)
+{
+  MutexLock guard(this->lock_);
+  this->coalescing_[msg_type] = merger;
+  this->update_coalesced_types_i();
+}
+
+// ============================================================================
+// MessageQ::disable_coalescing
+// ============================================================================
+YAT_INLINE void MessageQ::disable_coalescing (size_t msg_type)
+{
+  MutexLock guard(this->lock_);
+  this->coalescing_.erase(msg_type);
+  this->update_coalesced_types_i();
+}
+
+// ============================================================================
+// MessageQ::coalescing_enabled
+// ============================================================================
+YAT_INLINE bool MessageQ::coalescing_enabled (size_t msg_type)
+{
+  MutexLock guard(this->lock_);
+  return this->coalescing_.find(msg_type) != this->coalescing_.end();
+}
+
+// ============================================================================
+// MessageQ::notifier
+// ============================================================================
+YAT_INLINE void MessageQ::notifier (MessageQ::Notifier * n)
+{
+  notifier_ = n;
+}
+
 } //- namespace
@@ -0,0 +1,531 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2004-2021 Synchrotron SOLEIL
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the GNU Lesser Public License v3
+// which accompanies this distribution, and is available at
+// http://www.gnu.org/licenses/lgpl.html
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// YAT LIBRARY
+//----------------------------------------------------------------------------
+//
+// Copyright (C) 2006-2021 The Tango Community
+//
+// Part of the code comes from the ACE Framework (asm bytes swaping code)
+// see http://www.cs.wustl.edu/~schmidt/ACE.html for more about ACE
+//
+// The thread native implementation has been initially inspired by omniThread
+// - the threading support library that comes with omniORB.
+// see http://omniorb.sourceforge.net/ for more about omniORB.
+//
+// Contributors form the TANGO community:
+// See AUTHORS file
+//
+// The YAT library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// The YAT library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// See COPYING file for license details
+//
+// Contact:
+//      Stephane Poirier
+//      Synchrotron SOLEIL
+//------------------------------------------------------------------------------
+/*!
+ * \author See AUTHORS file
+ */
+
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+// ============================================================================
+// DEPENDENCIES
+// ============================================================================
+#include <iostream>
+#include <string>
+#include <vector>
+#include <yat/threading/Task.h>
+#include <yat/threading/Semaphore.h>
+
+// ============================================================================
+// CONSTs
+// ============================================================================
+//! Default number of credits of a pipeline link (i.e. max. number of in-flight items).
+#define kDEFAULT_PIPELINE_CREDITS   64
+//! %Message type carrying a pipeline item.
+#define kPIPELINE_ITEM_MSG          yat::PIPELINE_ITEM_MSG
+//! %Message type used to drain a pipeline stage.
+#define kPIPELINE_FLUSH_MSG         yat::PIPELINE_FLUSH_MSG
+//-----------------------------------------------------------------------------
+
+namespace yat
+{
+
+// ============================================================================
+//! Forward declarations
+// ============================================================================
+class PipelineStageBase;
+
+// ============================================================================
+//! \class PipelineLink
+//! \brief A bounded connection between two pipeline stages.
+//!
+//! The link owns a number of credits: sending an item takes a credit (waiting
+//! for one if none is left) and the receiving stage gives it back once the item
+//! has been processed. The number of items in flight on the link (i.e. pending
+//! in the receiving stage message queue or being processed) is thus bounded by
+//! the link credits.
+// ============================================================================
+class YAT_DECL PipelineLink
+{
+  friend class PipelineStageBase;
+  friend class Pipeline;
+
+public:
+  //! \brief Sends an item to the receiving stage.
+  //!
+  //! Blocks while the link has no credit left.
+  //! \param data The item.
+  //! \return The time spent waiting for a credit (in seconds).
+  //! \exception OUT_OF_MEMORY Thrown when the message allocation failed.
+  template <typename T> double send (const T & data);
+
+  //! \brief Gives a credit back (called by the receiving stage).
+  void release ();
+
+  //! \brief Returns the link credits.
+  size_t credits () const;
+
+private:
+  PipelineLink (PipelineStageBase * to, size_t credits);
+
+  //- takes a credit, returns the time spent waiting for it (secs)
+  double acquire ();
+
+  //- the receiving stage
+  PipelineStageBase * to_;
+
+  //- the available credits
+  Semaphore available_;
+
+  //- the link credits
+  size_t credits_;
+
+  // = Disallow these operations.
+  //--------------------------------------------
+  PipelineLink & operator= (const PipelineLink &);
+  PipelineLink (const PipelineLink &);
+};
+
+// ============================================================================
+//! \struct PipelineItem
+//! \brief A pipeline item and the link it has been sent on.
+// ============================================================================
+template <typename T> struct PipelineItem
+{
+  //! \brief Constructor.
+  PipelineItem (const T & d, PipelineLink * l)
+    : data (d), link (l)
+  {}
+  //! The item.
+  T data;
+  //! The link the item has been sent on (its credit is given back once processed).
+  PipelineLink * link;
+};
+
+// ============================================================================
+//! \struct PipelineStageStatistics
+//! \brief Throughput metrics of a pipeline stage.
+// ============================================================================
+struct YAT_DECL PipelineStageStatistics
+{
+  //! Default constructor.
+  PipelineStageStatistics ();
+  //! Returns the processing throughput (items per second since the stage started).
+  double throughput () const;
+  //! Returns the stage utilization (fraction of the elapsed time spent in process).
+  double utilization () const;
+  //! Dumps the statistics to specified output.
+  //! \param out Output
+  void dump (std::ostream & out = std::cout) const;
+  //! The stage name.
+  std::string name_;
+  //! Number of processed items.
+  unsigned long items_in_;
+  //! Number of emitted items (one per downstream stage).
+  unsigned long items_out_;
+  //! Number of items whose processing threw an exception.
+  unsigned long errors_;
+  //! Number of emissions which had to wait for a downstream credit (backpressure).
+  unsigned long emit_blocked_counter_;
+  //! Time spent waiting for downstream credits (seconds).
+  double emit_blocked_secs_;
+  //! Time spent processing the items, emissions included (seconds).
+  double busy_secs_;
+  //! Time elapsed since the stage started (seconds).
+  double elapsed_secs_;
+};
+
+// ============================================================================
+//! \class PipelineStageBase
+//! \brief Untyped part of a pipeline stage (see PipelineStage).
+//!
+//! A pipeline stage is a Task: items are delivered through its message queue
+//! and processed by its own thread.
+// ============================================================================
+class YAT_DECL PipelineStageBase : public Task
+{
+  friend class Pipeline;
+  friend class PipelineLink;
+
+public:
+  //! \brief Destructor.
+  virtual ~PipelineStageBase ();
+
+  //! \brief Returns the stage name.
+  const std::string & name () const;
+
+  //! \brief Returns the stage statistics.
+  PipelineStageStatistics statistics ();
+
+protected:
+  //! \brief Constructor.
+  //! \param name Stage name.
+  //! \param cfg Task configuration (the message queue water marks are adjusted
+  //! to the stage input credits).
+  PipelineStageBase (const std::string & name, const Task::Config & cfg);
+
+  //! \brief Default message handler: no-op.
+  //!
+  //! The items are not passed to this handler (see PipelineStage::process), only
+  //! the task messages (INIT, EXIT, TIMEOUT, PERIODIC) and the user messages.
+  virtual void handle_message (yat::Message & msg);
+
+  //- creates a link from this stage to <next>
+  void connect_i (PipelineStageBase & next, size_t credits);
+
+  //- sends <data> to all the downstream stages
+  template <typename T> void emit_i (const T & data);
+
+  //- creates a link to this stage (i.e. one more input)
+  PipelineLink * add_input_i (size_t credits);
+
+  //- processing stats
+  void processed_i (double busy_secs, bool error);
+
+  //- the external input (see PipelineInput::push)
+  PipelineLink * push_link_;
+
+private:
+  //- emission stats
+  void emitted_i (size_t num_items, double blocked_secs);
+
+  //- the stage name
+  std::string name_;
+
+  //- input links (owned)
+  std::vector<PipelineLink *> inputs_;
+
+  //- output links (owned by the downstream stages)
+  std::vector<PipelineLink *> outputs_;
+
+  //- the stage statistics
+  PipelineStageStatistics stats_;
+
+  //- protects <stats_>
+  Mutex stats_lock_;
+
+  //- the stage clock (started on first item)
+  Timer clock_;
+
+  //- true once the first item has been processed
+  bool started_;
+};
+
+// ============================================================================
+//! \class PipelineInput
+//! \brief A pipeline stage consuming items of type \<In\>.
+// ============================================================================
+template <typename In> class PipelineInput : public PipelineStageBase
+{
+public:
+  //! \brief Feeds an item into the stage from outside the pipeline.
+  //!
+  //! Blocks while the items previously pushed (up to the stage input credits) are
+  //! not processed: a producer feeding the pipeline runs at the pipeline rate.
+  //! \param in The item.
+  void push (const In & in);
+
+protected:
+  //! \brief Constructor.
+  //! \param name Stage name.
+  //! \param credits Credits of the external input (see push).
+  //! \param cfg Task configuration.
+  PipelineInput (const std::string & name, size_t credits, const Task::Config & cfg);
+
+  //! \brief Item processing (called by the stage thread).
+  //!
+  //! An exception escaping this method is counted in PipelineStageStatistics::errors_
+  //! (the item is dropped).
+  //! \param in The item.
+  virtual void process (In & in) = 0;
+
+private:
+  //- typed handler of the kPIPELINE_ITEM_MSG msgs
+  void handle_item (PipelineItem<In> & item);
+};
+
+// ============================================================================
+//! \class PipelineStage
+//! \brief A typed pipeline stage: consumes \<In\> items and emits \<Out\> items.
+//!
+//! Stages are connected with bounded links using credit-based backpressure
+//! instead of post timeouts: a stage emitting an item to a downstream stage
+//! which has no credit left waits for it to process an item. Saturation
+//! propagates upstream, up to the producer feeding the pipeline, and no item
+//! is ever trashed.
+//! - fan-out: a stage connected to several downstream stages emits a copy of
+//!   each item to each of them,
+//! - fan-in: several upstream stages connected to the same stage share its
+//!   message queue (each link keeping its own credits).
+//!
+//! \verbatim
+//! class Scale : public yat::PipelineStage<double, double>
+//! {
+//! public:
+//!   Scale () : yat::PipelineStage<double, double>("scale") {}
+//! protected:
+//!   virtual void process (double & in) { emit(2. * in); }
+//! };
+//! \endverbatim
+//! \remark The pipeline must be acyclic (see Pipeline).
+//! \remark A stage must run its own thread (i.e. no Task::Config::executor):
+//! its thread blocks while waiting for downstream credits.
+// ============================================================================
+template <typename In, typename Out = In>
+class PipelineStage : public PipelineInput<In>
+{
+public:
+  //! \brief Connects the stage output to the input of \<next\>.
+  //! \param next Downstream stage.
+  //! \param credits Link credits (max. number of items in flight on the link).
+  //! \exception BAD_ARG Thrown if \<credits\> is 0.
+  void connect (PipelineInput<Out> & next, size_t credits = kDEFAULT_PIPELINE_CREDITS);
+
+protected:
+  //! \brief Constructor.
+  //! \param name Stage name.
+  //! \param credits Credits of the external input (see PipelineInput::push).
+  //! \param cfg Task configuration.
+  PipelineStage (const std::string & name,
+                 size_t credits = kDEFAULT_PIPELINE_CREDITS,
+                 const Task::Config & cfg = Task::Config());
+
+  //! \brief Emits an item to the downstream stages (if any).
+  //!
+  //! Blocks while a downstream stage has no credit left.
+  //! \param out The item.
+  void emit (const Out & out);
+};
+
+// ============================================================================
+//! \class Pipeline
+//! \brief A set of connected PipelineStage.
+//!
+//! The pipeline owns its stages: it starts them, then stops them in the
+//! upstream to downstream order, draining each stage before stopping it
+//! so that no item is lost.
+//!
+//! \verbatim
+//! yat::Pipeline p;
+//! Parse * parse = p.add(new Parse);
+//! Scale * scale = p.add(new Scale);
+//! Store * store = p.add(new Store);
+//! parse->connect(*scale);
+//! scale->connect(*store);
+//! p.start();
+//! parse->push(line);
+//! ...
+//! p.stop();
+//! \endverbatim
+// ============================================================================
+class YAT_DECL Pipeline
+{
+public:
+  //! \brief Constructor.
+  Pipeline ();
+
+  //! \brief Destructor: stops the pipeline (if started) and deletes its stages.
+  virtual ~Pipeline ();
+
+  //! \brief Adds a stage (the pipeline takes ownership of the stage).
+  //! \param stage The stage.
+  //! \exception PROGRAMMING_ERROR Thrown if the pipeline is started.
+  template <typename S> S * add (S * stage);
+
+  //! \brief Starts the stages.
+  //! \param tmo_msecs Timeout in ms (per stage).
+  //! \exception PROGRAMMING_ERROR Thrown if the stages connections contain a cycle.
+  void start (size_t tmo_msecs = kDEFAULT_MSG_TMO_MSECS);
+
+  //! \brief Drains then stops the stages, in the upstream to downstream order.
+  //!
+  //! Each stage handles all its pending items before being stopped. The stages
+  //! are deleted on return.
+  //! \param tmo_msecs Max. time to wait for each stage to be drained (in ms).
+  //! \remark The external producers must have stopped pushing items.
+  void stop (size_t tmo_msecs = kINFINITE_WAIT);
+
+  //! \brief Returns the statistics of the stages (in the upstream to downstream order).
+  std::vector<PipelineStageStatistics> statistics ();
+
+  //! \brief Dumps the statistics of the stages to specified output.
+  //! \param out Output
+  void dump_statistics (std::ostream & out = std::cout);
+
+private:
+  //- adds a stage
+  void add_i (PipelineStageBase * stage);
+
+  //- sorts the stages in the upstream to downstream order
+  void sort_i ();
+
+  //- the stages
+  std::vector<PipelineStageBase *> stages_;
+
+  //- true if started
+  bool started_;
+
+  // = Disallow these operations.
+  //--------------------------------------------
+  Pipeline & operator= (const Pipeline &);
+  Pipeline (const Pipeline &);
+};
+
+// ============================================================================
+// PipelineLink::send
+// ============================================================================
+template <typename T> double PipelineLink::send (const T & _data)
+{
+  double blocked_secs = this->acquire();
+
+  try
+  {
+    Message * m = new (std::nothrow) Message(kPIPELINE_ITEM_MSG, DEFAULT_MSG_PRIORITY, false);
+    if (! m)
+    {
+      THROW_YAT_ERROR("OUT_OF_MEMORY",
+                      "yat::Message allocation failed",
+                      "PipelineLink::send");
+    }
+    m->attach_data(PipelineItem<T>(_data, this));
+    this->to_->post(m);
+  }
+  catch (...)
+  {
+    //- the item didn't make it: give the credit back
+    this->release();
+    throw;
+  }
+
+  return blocked_secs;
+}
+
+// ============================================================================
+// PipelineStageBase::emit_i
+// ============================================================================
+template <typename T> void PipelineStageBase::emit_i (const T & _data)
+{
+  if (this->outputs_.empty())
+    return;
+
+  double blocked_secs = 0.;
+  for (size_t i = 0; i < this->outputs_.size(); i++)
+    blocked_secs += this->outputs_[i]->send(_data);
+
+  this->emitted_i(this->outputs_.size(), blocked_secs);
+}
+
+// ============================================================================
+// PipelineInput::PipelineInput
+// ============================================================================
+template <typename In>
+PipelineInput<In>::PipelineInput (const std::string & _name, size_t _credits, const Task::Config & _cfg)
+  : PipelineStageBase(_name, _cfg)
+{
+  this->push_link_ = this->add_input_i(_credits ? _credits : kDEFAULT_PIPELINE_CREDITS);
+  this->template on<kPIPELINE_ITEM_MSG, PipelineInput<In>, PipelineItem<In>, &PipelineInput<In>::handle_item>();
+}
+
+// ============================================================================
+// PipelineInput::push
+// ============================================================================
+template <typename In> void PipelineInput<In>::push (const In & _in)
+{
+  this->push_link_->send(_in);
+}
+
+// ============================================================================
+// PipelineInput::handle_item
+// ============================================================================
+template <typename In> void PipelineInput<In>::handle_item (PipelineItem<In> & _item)
+{
+  FastTimer t;
+  try
+  {
+    this->process(_item.data);
+  }
+  catch (...)
+  {
+    _item.link->release();
+    this->processed_i(t.elapsed_sec(), true);
+    throw;
+  }
+  _item.link->release();
+  this->processed_i(t.elapsed_sec(), false);
+}
+
+// ============================================================================
+// PipelineStage::PipelineStage
+// ============================================================================
+template <typename In, typename Out>
+PipelineStage<In, Out>::PipelineStage (const std::string & _name, size_t _credits, const Task::Config & _cfg)
+  : PipelineInput<In>(_name, _credits, _cfg)
+{
+}
+
+// ============================================================================
+// PipelineStage::connect
+// ============================================================================
+template <typename In, typename Out>
+void PipelineStage<In, Out>::connect (PipelineInput<Out> & _next, size_t _credits)
+{
+  this->connect_i(_next, _credits);
+}
+
+// ============================================================================
+// PipelineStage::emit
+// ============================================================================
+template <typename In, typename Out> void PipelineStage<In, Out>::emit (const Out & _out)
+{
+  this->emit_i(_out);
+}
+
+// ============================================================================
+// Pipeline::add
+// ============================================================================
+template <typename S> S * Pipeline::add (S * _stage)
+{
+  this->add_i(_stage);
+  return _stage;
+}
+
+} // namespace
+
+#endif // _PIPELINE_H_
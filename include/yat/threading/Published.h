@@ -0,0 +1,276 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2004-2021 Synchrotron SOLEIL
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the GNU Lesser Public License v3
+// which accompanies this distribution, and is available at
+// http://www.gnu.org/licenses/lgpl.html
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// YAT LIBRARY
+//----------------------------------------------------------------------------
+//
+// Copyright (C) 2006-2022 The Tango Community
+//
+// Part of the code comes from the ACE Framework (asm bytes swaping code)
+// see http://www.cs.wustl.edu/~schmidt/ACE.html for more about ACE
+//
+// The thread native implementation has been initially inspired by omniThread
+// - the threading support library that comes with omniORB.
+// see http://omniorb.sourceforge.net/ for more about omniORB.
+// The YAT library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// The YAT library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// See COPYING file for license details
+//
+// Contact:
+//      Stephane Poirier
+//      Synchrotron SOLEIL
+//------------------------------------------------------------------------------
+/*!
+ * \author See AUTHORS file
+ */
+
+#ifndef _YAT_PUBLISHED_H_
+#define _YAT_PUBLISHED_H_
+
+// ============================================================================
+// DEPENDENCIES
+// ============================================================================
+#include <yat/threading/Atomic.h>
+#include <yat/threading/Mutex.h>
+
+//! Max. number of readers counters of a PublishedReaders registry.
+#define kPUBLISHED_MAX_READERS_COUNTERS 64
+
+namespace yat
+{
+
+// ============================================================================
+//! \class PublishedReaders
+//! \brief Readers registry of a Published value (RCU-like grace periods).
+//!
+//! Each reader registers on a counter of its own (one cache line per counter,
+//! the counters being spread over the threads), the writer waits for the readers
+//! which may hold an unpublished value (i.e. a grace period) before reclaiming it.
+//! Used by Published\<T\> and Signal\<P\>.
+// ============================================================================
+class YAT_DECL PublishedReaders
+{
+public:
+  //! \brief A reader registration.
+  typedef Atomic<yat::uint32> * Token;
+
+  //! \brief Constructor.
+  //! \param max_counters Max. number of readers counters (the actual number
+  //! depends on the hardware concurrency).
+  explicit PublishedReaders (size_t max_counters = kPUBLISHED_MAX_READERS_COUNTERS);
+
+  //! \brief Destructor.
+  ~PublishedReaders ();
+
+  //! \brief Registers the calling thread as a reader.
+  //! Returns the token to pass to read_unlock.
+  Token read_lock ();
+
+  //! \brief Unregisters a reader.
+  static void read_unlock (Token t)
+  {
+    t->fetch_sub(1, memory_order_release);
+  }
+
+  //! \brief Waits for all the readers registered so far to unregister.
+  //! The writers must be serialized by the caller.
+  void synchronize ();
+
+private:
+  //- readers counters of both phases (one cache line each)
+  struct ReadersCounters
+  {
+    Atomic<yat::uint32> count[2];
+    char pad[64];
+  };
+
+  //- waits for the readers of the given phase to unregister
+  void wait_readers_i (size_t phase);
+
+  //- the current phase: new readers register on the counters of this phase
+  Atomic<yat::uint32> m_phase;
+
+  //- the readers counters
+  ReadersCounters * m_readers;
+  size_t m_readers_counters;
+
+  //- Not implemented private member
+  PublishedReaders (const PublishedReaders&);
+  PublishedReaders & operator= (const PublishedReaders&);
+};
+
+// ============================================================================
+//! \class Published
+//! \brief A read-mostly object published RCU-style.
+//!
+//! Readers access the current (immutable) value through a Snapshot, without any
+//! lock and without writing any shared cache line. A writer publishes a new value
+//! then reclaims the former one once the readers which may still use it are gone
+//! (deferred reclamation): readers never wait, writers do.
+//!
+//! Suited to large objects (ex: a configuration) read at high rate and rarely
+//! modified. For small trivially copyable data, see SeqLocked\<T\>.
+//!
+//! \remark A Snapshot must be short-lived: it delays the writers.
+//!
+//! \verbatim
+//! yat::Published<Config> config;
+//! {
+//!   yat::Published<Config>::Snapshot cfg(config);
+//!   do_something(cfg->value);
+//! }
+//! config.update(set_value);   // writer (set_value(Config&))
+//! \endverbatim
+// ============================================================================
+template <typename T>
+class Published
+{
+public:
+  // ==========================================================================
+  //! \class Snapshot
+  //! \brief Read access to the value published at construction time.
+  // ==========================================================================
+  class Snapshot
+  {
+  public:
+    //! \brief Constructor.
+    explicit Snapshot (const Published<T>& p)
+      : m_token (p.m_readers.read_lock()),
+        m_value (p.m_value.load())
+    {
+    }
+
+    //! \brief Destructor (releases the snapshot).
+    ~Snapshot ()
+    {
+      PublishedReaders::read_unlock(this->m_token);
+    }
+
+    //! \brief Returns the value.
+    const T* get () const
+    {
+      return this->m_value;
+    }
+
+    //! \brief Returns the value.
+    const T& operator* () const
+    {
+      return *this->m_value;
+    }
+
+    //! \brief Returns the value.
+    const T* operator-> () const
+    {
+      return this->m_value;
+    }
+
+  private:
+    PublishedReaders::Token m_token;
+    const T* m_value;
+
+    //- Not implemented private member
+    Snapshot (const Snapshot&);
+    Snapshot & operator= (const Snapshot&);
+  };
+
+  //! \brief Constructor (default constructed value).
+  Published ()
+    : m_value (new T())
+  {
+  }
+
+  //! \brief Constructor.
+  //! \param v Initial value.
+  explicit Published (const T& v)
+    : m_value (new T(v))
+  {
+  }
+
+  //! \brief Destructor.
+  ~Published ()
+  {
+    delete this->m_value.load();
+  }
+
+  //! \brief Returns a copy of the value.
+  T load () const
+  {
+    Snapshot s(*this);
+    return *s;
+  }
+
+  //! \brief Publishes a new value.
+  //!
+  //! Returns once the former value is reclaimed.
+  void publish (const T& v)
+  {
+    this->publish(new T(v));
+  }
+
+  //! \brief Publishes a new value (heap allocated, ownership transferred).
+  //!
+  //! Returns once the former value is reclaimed.
+  void publish (T* v)
+  {
+    MutexLock guard(this->m_writer_mutex);
+    this->publish_i(v);
+  }
+
+  //! \brief Modifies the value: calls \<f(T&)\> on a copy of the current value
+  //! then publishes it (read-modify-write, serialized with the other writers).
+  template <typename F>
+  void update (F f)
+  {
+    MutexLock guard(this->m_writer_mutex);
+    T* v = new T(*this->m_value.load());
+    try
+    {
+      f(*v);
+    }
+    catch (...)
+    {
+      delete v;
+      throw;
+    }
+    this->publish_i(v);
+  }
+
+private:
+  //- publishes v then reclaims the former value (grace period)
+  void publish_i (T* v)
+  {
+    T* former = this->m_value.exchange(v);
+    this->m_readers.synchronize();
+    delete former;
+  }
+
+  //- the readers registry
+  mutable PublishedReaders m_readers;
+
+  //- the current value
+  Atomic<T*> m_value;
+
+  //- serializes the writers
+  Mutex m_writer_mutex;
+
+  //- Not implemented private member
+  Published (const Published&);
+  Published & operator= (const Published&);
+};
+
+} // namespace yat
+
+#endif //- _YAT_PUBLISHED_H_
@@ -167,6 +167,11 @@ class PulserCoreImpl;
     }
     \endverbatim */
 //! \brief Periodically call a callback accepting a Thread::IOArg as input arg.
+//!
+//! All the pulsers of the process share a single timer thread (started with the
+//! first pulser, stopped with the last one). The callbacks are called from that
+//! thread, one at a time: a callback blocking for a long time delays the other pulsers.
+//! A pulser may be deleted from its own callback.
 // ============================================================================
 class YAT_DECL Pulser
 {
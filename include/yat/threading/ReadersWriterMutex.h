@@ -48,7 +48,15 @@
 // DEPENDENCIES
 // ============================================================================
 #include <yat/threading/Mutex.h>
-#include <yat/threading/Semaphore.h>
+#include <yat/threading/Condition.h>
+#include <yat/threading/Atomic.h>
+
+// ============================================================================
+// CONSTs
+// ============================================================================
+//! Max. number of readers counters (see ReadersWriterMutex::RW_PER_CORE_COUNTERS).
+#define kRW_MUTEX_MAX_READERS_COUNTERS 64
+//-----------------------------------------------------------------------------
 
 namespace yat {
 
@@ -62,56 +70,100 @@ namespace yat {
 //! but as soon as one thread wants to write to the resource, all other threads
 //! must be blocked until the writing is complete.
 //!
+//! The number of simultaneous readers is not bounded. The mutex is writer-preferring:
+//! once a writer is waiting, new readers are blocked until no more writer is pending
+//! (as a consequence, a thread must not lock a resource it already holds for reading).
+//!
+//! Uncontended locking for reading costs a single atomic increment (no mutex).
+//! In RW_PER_CORE_COUNTERS mode, readers running on different cores increment
+//! distinct counters (one cache line each) so that they don't contend at all;
+//! locking for writing is a bit more expensive in this mode (all the counters
+//! must be checked).
+//!
 //! \remark This class is not supposed to be derived.
 // ============================================================================
 class YAT_DECL ReadersWriterMutex
 {
 public:
-  //! \brief Constructor.
-  ReadersWriterMutex (size_t max_readers = 32)
-      : m_semaphore(max_readers),
-        m_max_readers(max_readers)
+  //! \brief Readers accounting modes.
+  typedef enum
   {
-    //- noop
-  }
+    //! a single readers counter (default mode)
+    RW_SHARED_COUNTER,
+    //! per-core readers counters (for read mostly resources locked by many threads)
+    RW_PER_CORE_COUNTERS
+  } ReadersMode;
+
+  //! \brief Constructor.
+  //! \param max_readers Obsolete (ignored - the number of readers is not bounded).
+  ReadersWriterMutex (size_t max_readers = 32);
+
+  //! \brief Constructor.
+  //! \param mode Readers accounting mode.
+  explicit ReadersWriterMutex (ReadersMode mode);
 
   //! \brief Destructor.
-  virtual ~ReadersWriterMutex ()
-  {
-    //- noop
-  }
+  virtual ~ReadersWriterMutex ();
 
   //! Locks the resource for reading
-  inline void lock_for_reading ()
-  {
-    this->m_semaphore.wait();
-  }
+  void lock_for_reading ();
 
   //! Unlocks the resource for reading
-  inline void unlock_for_reading ()
-  {
-    this->m_semaphore.post();
-  }
+  void unlock_for_reading ();
 
   //! Locks the resource for writing
-  inline void lock_for_writing ()
-  {
-    yat::MutexLock guard(this->m_mutex);
-    for (size_t i = 0; i < this->m_max_readers; ++i)
-      m_semaphore.wait();
-  }
+  void lock_for_writing ();
 
   //! Unocks the resource for writing
-  inline void unlock_for_writing ()
-  {
-    for (size_t i = 0; i < this->m_max_readers; ++i)
-      m_semaphore.post();
-  }
+  void unlock_for_writing ();
+
+  //! Returns the readers accounting mode
+  ReadersMode readers_mode () const;
 
 private:
-    size_t m_max_readers;
-    yat::Semaphore m_semaphore;
-    yat::Mutex m_mutex;
+  //- a readers counter (one cache line each)
+  struct ReadersCounter
+  {
+    Atomic<yat::uint32> count;
+    char pad[64];
+  };
+
+  //- allocates the readers counters
+  void init_i (ReadersMode mode);
+
+  //- returns the readers counter of the calling thread
+  ReadersCounter & readers_counter_i ();
+
+  //- returns true if some readers hold the mutex
+  bool has_readers_i ();
+
+  //- the readers accounting mode
+  ReadersMode m_mode;
+
+  //- the readers counters (a single one in RW_SHARED_COUNTER mode)
+  ReadersCounter * m_readers;
+  size_t m_readers_counters;
+
+  //- number of pending (i.e. waiting or active) writers
+  Atomic<yat::uint32> m_writers;
+
+  //- serializes the writers
+  yat::Mutex m_writer_mutex;
+
+  //- protects the waits (no reader or writer state)
+  yat::Mutex m_mutex;
+
+  //- signaled when the last writer leaves
+  yat::Condition m_readers_cond;
+
+  //- signaled when a reader leaves while a writer is pending
+  yat::Condition m_writer_cond;
+
+  //- Not implemented private member
+  ReadersWriterMutex (const ReadersWriterMutex&);
+
+  //- Not implemented private member
+  ReadersWriterMutex & operator= (const ReadersWriterMutex&);
 };
 
 // ============================================================================
@@ -0,0 +1,186 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2004-2021 Synchrotron SOLEIL
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the GNU Lesser Public License v3
+// which accompanies this distribution, and is available at
+// http://www.gnu.org/licenses/lgpl.html
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// YAT LIBRARY
+//----------------------------------------------------------------------------
+//
+// Copyright (C) 2006-2022 The Tango Community
+//
+// Part of the code comes from the ACE Framework (asm bytes swaping code)
+// see http://www.cs.wustl.edu/~schmidt/ACE.html for more about ACE
+//
+// The thread native implementation has been initially inspired by omniThread
+// - the threading support library that comes with omniORB.
+// see http://omniorb.sourceforge.net/ for more about omniORB.
+// The YAT library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// The YAT library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// See COPYING file for license details
+//
+// Contact:
+//      Stephane Poirier
+//      Synchrotron SOLEIL
+//------------------------------------------------------------------------------
+/*!
+ * \author See AUTHORS file
+ */
+
+#ifndef _YAT_SEQLOCKED_H_
+#define _YAT_SEQLOCKED_H_
+
+// ============================================================================
+// DEPENDENCIES
+// ============================================================================
+#include <cstring>
+#include <yat/threading/Atomic.h>
+#include <yat/threading/Utilities.h>
+
+namespace yat
+{
+
+// ============================================================================
+//! \class SeqLocked
+//! \brief A small read-mostly value protected by a sequence lock.
+//!
+//! Readers never block the writers nor each other: they only read the shared
+//! memory (no lock, no reference count) and retry when a store happened meanwhile.
+//! Stores are serialized by a mutex.
+//!
+//! Typical use: a small snapshot (ex: motors positions) updated by one thread
+//! and read at high rate by many others.
+//!
+//! \remark T must be trivially copyable (copied word by word).
+//!
+//! \verbatim
+//! struct Position { double x, y, z; };
+//! yat::SeqLocked<Position> pos;
+//! pos.store(new_position);   // writer
+//! Position p = pos.load();   // readers
+//! \endverbatim
+// ============================================================================
+template <typename T>
+class SeqLocked
+{
+#if defined (YAT_CPP11)
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLocked<T> requires a trivially copyable T");
+#endif
+
+public:
+  //! \brief Constructor (value initialized T).
+  SeqLocked ()
+  {
+    this->write_i(T());
+  }
+
+  //! \brief Constructor.
+  //! \param v Initial value.
+  explicit SeqLocked (const T& v)
+  {
+    this->write_i(v);
+  }
+
+  //! \brief Returns a consistent copy of the value.
+  T load () const
+  {
+    T v;
+    this->load(v);
+    return v;
+  }
+
+  //! \brief Copies the value into \<v\> (consistent copy).
+  void load (T& v) const
+  {
+    yat::uint64 words[kWORDS];
+    for (size_t attempt = 1; ; ++attempt)
+    {
+      yat::uint64 seq = this->m_seq.load(memory_order_acquire);
+      //- even sequence: no store in progress
+      if (! (seq & 1))
+      {
+        //- acquire: reading a word written by a later store implies reading its sequence
+        for (size_t i = 0; i < kWORDS; ++i)
+          words[i] = this->m_words[i].load(memory_order_acquire);
+        if (this->m_seq.load(memory_order_relaxed) == seq)
+          break;
+      }
+      //- the writer may have been preempted in the middle of a store
+      if (! (attempt % 64))
+        ThreadingUtilities::yield();
+    }
+    std::memcpy(&v, words, sizeof(T));
+  }
+
+  //! \brief Stores a new value.
+  void store (const T& v)
+  {
+    MutexLock guard(this->m_writer_mutex);
+    this->write_i(v);
+  }
+
+  //! \brief Modifies the value in place: calls \<f(T&)\> on a copy of the
+  //! current value then stores it (read-modify-write, serialized with the stores).
+  template <typename F>
+  void update (F f)
+  {
+    MutexLock guard(this->m_writer_mutex);
+    yat::uint64 words[kWORDS];
+    for (size_t i = 0; i < kWORDS; ++i)
+      words[i] = this->m_words[i].load(memory_order_relaxed);
+    T v;
+    std::memcpy(&v, words, sizeof(T));
+    f(v);
+    this->write_i(v);
+  }
+
+  //! \brief Returns the number of stores so far (initial value excluded).
+  yat::uint64 version () const
+  {
+    return (this->m_seq.load(memory_order_acquire) >> 1) - 1;
+  }
+
+private:
+  enum { kWORDS = (sizeof(T) + sizeof(yat::uint64) - 1) / sizeof(yat::uint64) };
+
+  //- writes the value (odd sequence during the write)
+  void write_i (const T& v)
+  {
+    yat::uint64 words[kWORDS];
+    words[kWORDS - 1] = 0;
+    std::memcpy(words, &v, sizeof(T));
+    yat::uint64 seq = this->m_seq.load(memory_order_relaxed);
+    this->m_seq.store(seq + 1, memory_order_relaxed);
+    //- release: the odd sequence is visible to whoever reads a new word
+    for (size_t i = 0; i < kWORDS; ++i)
+      this->m_words[i].store(words[i], memory_order_release);
+    this->m_seq.store(seq + 2, memory_order_release);
+  }
+
+  //- the sequence number (odd while a store is in progress)
+  Atomic<yat::uint64> m_seq;
+
+  //- the value
+  Atomic<yat::uint64> m_words[kWORDS];
+
+  //- serializes the writers
+  Mutex m_writer_mutex;
+
+  //- Not implemented private member
+  SeqLocked (const SeqLocked&);
+  SeqLocked & operator= (const SeqLocked&);
+};
+
+} // namespace yat
+
+#endif //- _YAT_SEQLOCKED_H_
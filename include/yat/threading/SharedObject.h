@@ -45,6 +45,7 @@
 // ============================================================================
 #include <yat/CommonHeader.h>
 #include <yat/threading/Mutex.h>
+#include <yat/threading/Atomic.h>
 
 namespace yat
 {
@@ -54,6 +55,8 @@ namespace yat
 //! \brief A reference counted object abstraction.
 //!
 //! Base class for any reference counted (i.e. shared) object.
+//! The reference count is an atomic counter where Atomic is lock-free (see
+//! YAT_ATOMIC_LOCK_FREE) - it is protected by the object mutex otherwise.
 // ============================================================================
 class YAT_DECL SharedObject
 {
@@ -100,7 +103,11 @@ private:
   SharedObject * release_i ();
 
   //- Reference count for "shallow" copies (used to avoid deep copies).
+#if defined (YAT_ATOMIC_LOCK_FREE)
+  Atomic<int> reference_count_;
+#else
   int reference_count_;
+#endif
 
   //- Disallow these operations.
   //--------------------------------------------
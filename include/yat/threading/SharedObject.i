@@ -38,7 +38,11 @@ namespace yat
 // ============================================================================
 YAT_INLINE int SharedObject::reference_count () const
 {
+#if defined (YAT_ATOMIC_LOCK_FREE)
+  return this->reference_count_.load(memory_order_acquire);
+#else
   return this->reference_count_;
+#endif
 }
 
 // ============================================================================
@@ -0,0 +1,179 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2004-2021 Synchrotron SOLEIL
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the GNU Lesser Public License v3
+// which accompanies this distribution, and is available at
+// http://www.gnu.org/licenses/lgpl.html
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// YAT LIBRARY
+//----------------------------------------------------------------------------
+//
+// Copyright (C) 2006-2022 The Tango Community
+//
+// Part of the code comes from the ACE Framework (asm bytes swaping code)
+// see http://www.cs.wustl.edu/~schmidt/ACE.html for more about ACE
+//
+// The thread native implementation has been initially inspired by omniThread
+// - the threading support library that comes with omniORB.
+// see http://omniorb.sourceforge.net/ for more about omniORB.
+// The YAT library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// The YAT library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// See COPYING file for license details
+//
+// Contact:
+//      Stephane Poirier
+//      Synchrotron SOLEIL
+//------------------------------------------------------------------------------
+/*!
+ * \author See AUTHORS file
+ */
+
+#ifndef _YAT_SIGNAL_TASK_H_
+#define _YAT_SIGNAL_TASK_H_
+
+// ============================================================================
+// DEPENDENCIES
+// ============================================================================
+#include <yat/utils/Signal.h>
+#include <yat/memory/SharedPtr.h>
+#include <yat/threading/Task.h>
+
+// ============================================================================
+// CONSTs
+// ============================================================================
+//! %Message type carrying an asynchronous Signal emission.
+#define kSIGNAL_EMISSION_MSG yat::SIGNAL_EMISSION_MSG
+//-----------------------------------------------------------------------------
+
+namespace yat
+{
+
+// ============================================================================
+//! \class SignalEmission
+//! \brief A pending asynchronous emission (see SignalTask::run_async).
+// ============================================================================
+class YAT_DECL SignalEmission
+{
+public:
+  //! \brief Destructor.
+  virtual ~SignalEmission () {}
+
+  //! \brief Calls the observers. Returns true if no problem occurs, false otherwise.
+  virtual bool emit () = 0;
+};
+
+// ============================================================================
+//! \struct SignalParam
+//! \brief The parameter type stored by an asynchronous emission (a copy).
+// ============================================================================
+template <typename T> struct SignalParam
+{
+  typedef T type;
+};
+
+template <typename T> struct SignalParam<T&>
+{
+  typedef T type;
+};
+
+template <typename T> struct SignalParam<const T&>
+{
+  typedef T type;
+};
+
+// ============================================================================
+//! \class SignalAsyncEmission
+//! \brief The asynchronous emission of a Signal\<P, L\>.
+//!
+//! Holds the observers connected when the emission is posted and a copy of
+//! the parameter.
+// ============================================================================
+template <typename P, typename L>
+class SignalAsyncEmission : public SignalEmission
+{
+public:
+  //! \brief Constructor.
+  //! \param s The emitted signal.
+  //! \param param %Callback parameter.
+  SignalAsyncEmission (const Signal<P, L> & s, const typename SignalParam<P>::type & param)
+    : observers_ (s._observers()), param_ (param)
+  {
+  }
+
+  //! \brief Destructor.
+  virtual ~SignalAsyncEmission ()
+  {
+    if (this->observers_)
+      this->observers_->release();
+  }
+
+  //! \brief Calls the observers. Returns true if no problem occurs, false otherwise.
+  virtual bool emit ()
+  {
+    return ! this->observers_ || Signal<P, L>::_run(this->param_, this->observers_->slots);
+  }
+
+private:
+  typename Signal<P, L>::Observers * observers_;
+  typename SignalParam<P>::type param_;
+};
+
+// ============================================================================
+//! \class SignalTask
+//! \brief A task calling the observers of the signals emitted asynchronously.
+//!
+//! The emissions are handled in the order they are posted, by the task thread
+//! (or by its executor).
+//!
+//! \verbatim
+//! yat::SignalTask * st = new yat::SignalTask();
+//! st->go();
+//! yat::Future<bool> done = st->run_async(mySignal, myParam);
+//! \endverbatim
+// ============================================================================
+class YAT_DECL SignalTask : public Task
+{
+public:
+  //! \brief Constructor.
+  //! \param cfg Task configuration.
+  SignalTask (const Task::Config & cfg = Task::Config());
+
+  //! \brief Asynchronous run of \<s\>.
+  //!
+  //! The observers of \<s\> connected when this function is called are called
+  //! by the task with a copy of \<param\>. The returned future gets the run result
+  //! (true if no problem occurs, false otherwise) and may be ignored.
+  //! \param s The signal.
+  //! \param param %Callback parameter.
+  //! \param tmo_msecs Post timeout in milliseconds.
+  //! \exception TIMEOUT_EXPIRED Thrown if the emission can't be posted in time.
+  template <typename P, typename L>
+  Future<bool> run_async (const Signal<P, L> & s,
+                          const typename SignalParam<P>::type & param,
+                          size_t tmo_msecs = kDEFAULT_POST_MSG_TMO)
+  {
+    SharedPtr<SignalEmission> e(new SignalAsyncEmission<P, L>(s, param));
+    return this->post_with_reply<bool>(kSIGNAL_EMISSION_MSG, e, tmo_msecs);
+  }
+
+protected:
+  //! \brief Default message handler: no-op.
+  virtual void handle_message (yat::Message & msg);
+
+private:
+  //- kSIGNAL_EMISSION_MSG handler
+  void emit_i (yat::Message & msg);
+};
+
+} // namespace yat
+
+#endif //- _YAT_SIGNAL_TASK_H_
@@ -48,10 +48,13 @@
 #include <yat/threading/Mutex.h>
 #include <yat/threading/Utilities.h>
 #include <yat/threading/Task.h>
-#include <map>
+#include <yat/threading/Atomic.h>
 
 #define LOCK(ptr) yat::SyncAccess _lock(ptr);
 
+//! Number of stripes of the synchronized objects table (power of 2).
+#define kSYNC_ACCESS_STRIPES 64
+
 namespace yat
 {
 // ============================================================================
@@ -60,6 +63,10 @@ namespace yat
 //!
 //! The synchronization is implemented in the object constructor and destructor
 //! functions.
+//!
+//! The synchronized objects are registered in a table split in kSYNC_ACCESS_STRIPES
+//! stripes (selected by hashing the object address), each one having its own mutex:
+//! accesses to different objects rarely contend.
 // ============================================================================
 class YAT_DECL SyncAccess
 {
@@ -90,8 +97,8 @@ private:
     //- Locked by using thread.
     yat::Mutex     m_Mutex;
 
-    //- Thread currently locking access.
-    yat::ThreadUID m_CurrentThreadId;
+    //- Thread currently locking access (read without the object lock).
+    yat::Atomic<yat::ThreadUID> m_CurrentThreadId;
 
     //- Constructor.
     SyncObject(void *ptr) : m_pObj(ptr), m_uiThreadCount(0), m_uiLockCount(0),
@@ -101,11 +108,11 @@ private:
   //- Synchronized object.
   SyncObject *m_pSyncObj;
 
-  //- Synchronization map.
-  static std::map<void *, SyncObject *> m_sSynObjMap;
+  //- A stripe of the synchronized objects table.
+  struct Stripe;
 
-  //- To lock synchronization map access.
-  static yat::Mutex m_sLock;
+  //- Returns the stripe of the given object.
+  static Stripe & stripe(void *pObj);
 
   //- Locks synchronized object.
   void lock_obj(void *pObj);
@@ -52,10 +52,46 @@
 #define kDEFAULT_TASK_TMO_MSECS         5000
 #define kDEFAULT_THD_PERIODIC_TMO_MSECS 1000
 //-----------------------------------------------------------------------------
+//! Upper bound (excluded) of the message types accepted by Task::on.
+#define kMAX_TASK_HANDLER_MSG_TYPE      65536
+//-----------------------------------------------------------------------------
 
 namespace yat
 {
 
+// ============================================================================
+//! Forward declarations
+// ============================================================================
+class TaskExecutor;
+class TaskExecutorSlot;
+
+// ============================================================================
+//! \struct TaskHandlerArg
+//! \brief Extracts the argument of a typed Task handler (see Task::on) from a Message.
+//!
+//! The argument is the data attached to the message (see Message::get_data),
+//! or the message itself for handlers taking a Message.
+// ============================================================================
+template <typename T> struct TaskHandlerArg
+{
+  //! \brief Returns the data of type \<T\> attached to \<msg\>.
+  static T & get (Message & msg)
+  {
+    return msg.get_data<T>();
+  }
+};
+
+template <typename T> struct TaskHandlerArg<const T> : public TaskHandlerArg<T>
+{};
+
+template <> struct TaskHandlerArg<Message>
+{
+  static Message & get (Message & msg)
+  {
+    return msg;
+  }
+};
+
 // ============================================================================
 //! \class Task
 //! \brief Undetached thread in association with a message queue.
@@ -65,9 +101,12 @@ namespace yat
 //! %Message types are defined in yat::MessageType enumeration.
 //! \remark The yat4Tango::DeviceTask provides the same features than the yat::Task
 //! but the former is better adapted to the context of TANGO Device (exception handling/conversion).
+//! \remark A task configured with Config::executor doesn't start its own thread: it
+//! runs on the worker threads of the specified TaskExecutor (see TaskExecutor).
 // ============================================================================
-class YAT_DECL Task : public yat::Thread
+class YAT_DECL Task : public yat::Thread, private MessageQ::Notifier
 {
+  friend class TaskExecutor;
 
 public:
 
@@ -90,6 +129,17 @@ public:
     double periodic_msg_period_ms;
     //! Use new precise algorithm for TASK_PERIODIC dispatching
     bool enable_precise_periodic_timing;
+    //! Enables the high precision periodic mode (see MessageQ::enable_high_precision_periodic_msg).
+    //!
+    //! PERIODIC messages are scheduled on absolute monotonic deadlines with bounded
+    //! jitter. Overruns and jitter are reported in the message queue statistics.
+    //! Takes precedence over \<enable_precise_periodic_timing\>. Ignored in executor mode.
+    //! Default value : false.
+    bool enable_high_precision_periodic_timing;
+    //! High precision periodic mode: time (in microseconds) the task spins before each
+    //! period deadline instead of blocking (see MessageQ::periodic_msg_spin_usecs).
+    //! Default value : 0 (no spin).
+    size_t periodic_msg_spin_usecs;
     //! \remark Obsolete attribute.
     //! Enables message processing under critical section.
     //! Not recommended! For backward compatibility only.
@@ -101,6 +151,46 @@ public:
     size_t hi_wm;
     //! Enables throwing exception on post message timeout.
     bool throw_on_post_tmo;
+    //! Enables the lock-free (multi-producer/single-consumer) message queue mode.
+    //!
+    //! Producers post without locking the message queue unless it is saturated.
+    //! Recommended for tasks fed by many concurrent producers.
+    //! Requires c++11 support (ignored otherwise).
+    //! Default value : false.
+    bool lock_free_msgq;
+    //! Maximum number of messages extracted from the message queue per access.
+    //!
+    //! When greater than 1, the pending user messages are extracted in batches (i.e.
+    //! one message queue lock per batch) and passed to Task::handle_messages.
+    //! Default value : 1 (no batching).
+    size_t msg_batch_size;
+    //! Max. time (in microseconds) the task spins waiting for a message before blocking.
+    //!
+    //! See MessageQ::consumer_spin_usecs. Lowers the message handling latency of a
+    //! task fed at a high rate, at the price of some CPU time.
+    //! Requires c++11 support (ignored otherwise).
+    //! Default value : 0 (no spin).
+    size_t msgq_spin_usecs;
+    //! CPUs the task thread is allowed to run on (see Thread::cpu_affinity).
+    //! Default value : empty (any CPU).
+    Thread::CpuSet cpu_affinity;
+    //! Scheduling policy of the task thread (see Thread::scheduling).
+    //! Default value : Thread::SCHED_POLICY_DEFAULT.
+    Thread::SchedPolicy sched_policy;
+    //! Scheduling priority of the task thread in the range of \<sched_policy\>.
+    //! Default value : 0.
+    int sched_priority;
+    //! Stack size of the task thread in bytes (see Thread::stack_size).
+    //! Default value : 0 (system default).
+    size_t stack_size;
+    //! Executor running the task (not owned by the task).
+    //!
+    //! When set, the task doesn't start its own thread: its messages are handled
+    //! by the executor worker threads (one worker at a time, in the msgQ order).
+    //! The cpu affinity, scheduling and stack size settings are then ignored.
+    //! The executor must outlive the task.
+    //! Default value : 0 (the task runs its own thread).
+    TaskExecutor * executor;
     //! User data (passed back in all messages).
     Thread::IOArg user_data;
 
@@ -234,6 +324,16 @@ public:
   //! \exception TIMEOUT_EXPIRED Thrown when timeout expires.
   template <typename T> void post (size_t msg_type, const T & data, size_t tmo_msecs);
 
+  //! \brief Posts a batch of messages to the task asynchronously (i.e. does NOT wait for the
+  //! messages to be handled, but still waits for the messages to be posted).
+  //!
+  //! The message queue is locked once for the whole batch (see MessageQ::post_batch).
+  //! \param msgs Messages to send. The vector is cleared on return.
+  //! \param tmo_msecs Timeout in ms.
+  //! \exception INTERNAL_ERROR Thrown when messages cannot be posted (msgQ error).
+  //! \exception TIMEOUT_EXPIRED Thrown when timeout expires.
+  void post_batch (std::vector<Message *> & msgs, size_t tmo_msecs = kDEFAULT_POST_MSG_TMO);
+
   //! \brief Posts the specified message to the task then waits for this message to be handled
   //! (synchronous approach).
   //! \param msg Message to send.
@@ -269,6 +369,31 @@ public:
   //! \exception TIMEOUT_EXPIRED Thrown when timeout expires.
   template <typename T> void wait_msg_handled (size_t msg_type, const T & data, size_t tmo_msecs);
 
+  //! \brief Posts the specified message type to the task asynchronously then returns a Future
+  //! on the reply (request/reply approach).
+  //!
+  //! The message handler replies using Message::reply\<R\>. The future is completed once the
+  //! message is handled (or dropped). Example :
+  //! \verbatim yat::Future<double> f = task->post_with_reply<double>(kGET_VALUE_MSG);
+  //! double v = f.get(1000); \endverbatim
+  //! \param msg_type Message type to send.
+  //! \param tmo_msecs Post timeout in ms.
+  //! \exception INTERNAL_ERROR Thrown when message cannot be posted (msgQ error).
+  //! \exception TIMEOUT_EXPIRED Thrown when timeout expires.
+  template <typename R> Future<R> post_with_reply (size_t msg_type, size_t tmo_msecs = kDEFAULT_POST_MSG_TMO);
+
+  //! \brief Posts the specified message type with specified data to the task asynchronously then
+  //! returns a Future on the reply (request/reply approach).
+  //!
+  //! The message handler replies using Message::reply\<R\>. The future is completed once the
+  //! message is handled (or dropped).
+  //! \param msg_type Message type to send.
+  //! \param data Data buffer to send with the message (copied).
+  //! \param tmo_msecs Post timeout in ms.
+  //! \exception INTERNAL_ERROR Thrown when message cannot be posted (msgQ error).
+  //! \exception TIMEOUT_EXPIRED Thrown when timeout expires.
+  template <typename R, typename T> Future<R> post_with_reply (size_t msg_type, const T & data, size_t tmo_msecs);
+
   //! \brief Timeout message period mutator.
   //! \param p_msecs Timeout in ms.
   void set_timeout_msg_period (size_t p_msecs);
@@ -301,6 +426,15 @@ public:
   //! \param enable True = enabled, false = disabled.
   void enable_precise_periodic_timing (bool enable);
 
+  //! \brief Enable/disable high precision periodic timing for TASK_PERIODIC messages.
+  //!
+  //! See MessageQ::enable_high_precision_periodic_msg.
+  //! \param enable True = enabled, false = disabled.
+  void enable_high_precision_periodic_timing (bool enable);
+
+  //! \brief Returns the high precision periodic timing status.
+  bool high_precision_periodic_timing_enabled () const;
+
   //! \brief %Message queue water marks unit mutator.
   //! \param _wmu %Message queue unit.
   void msgq_wm_unit (MessageQ::WmUnit _wmu);
@@ -324,8 +458,30 @@ public:
   //! (message queue unit dependent).
   size_t msgq_hi_wm () const;
 
+  //! \brief %Message queue latency statistics mode mutator.
+  //!
+  //! Default value : MessageQ::LATENCY_STATS_ON.
+  //! \param _m Latency statistics mode (see MessageQ::LatencyStatsMode).
+  void msgq_latency_stats_mode (MessageQ::LatencyStatsMode _m);
+
+  //! \brief %Message queue latency statistics mode accessor.
+  MessageQ::LatencyStatsMode msgq_latency_stats_mode () const;
+
+  //! \brief Enables latest-value coalescing of the messages of the specified type.
+  //!
+  //! See MessageQ::enable_coalescing.
+  //! \param msg_type %Message type.
+  //! \param merger Optional merging hook (not owned by the task).
+  void enable_msgq_coalescing (size_t msg_type, MessageQ::Coalescer * merger = 0);
+
+  //! \brief Disables coalescing of the messages of the specified type.
+  //! \param msg_type %Message type.
+  void disable_msgq_coalescing (size_t msg_type);
+
   //! \brief %Message queue Statistics accessor.
-  const MessageQ::Statistics & msgq_statistics ();
+  //!
+  //! Includes the queue wait and handling latencies of the messages (see MessageQ::Statistics).
+  MessageQ::Statistics msgq_statistics ();
 
   //! \brief Resets the message queue statistics.
   void reset_msgq_statistics ();
@@ -353,13 +509,100 @@ protected:
   //! \remark After processing message, do NOT release the message (done by yat).
   virtual void handle_message (yat::Message& msg) = 0;
 
+  //! \brief Batch message handler.
+  //!
+  //! Called with the user messages extracted in one go from the message queue when
+  //! Config::msg_batch_size is greater than 1. Task messages (INIT, EXIT, TIMEOUT,
+  //! PERIODIC) are still passed to handle_message.
+  //! The default implementation calls handle_message for each message (storing
+  //! its error, if any, into the message).
+  //! \param msgs Messages to handle.
+  //! \remark An exception escaping this method is stored into each message of the
+  //! batch which is not already in error.
+  //! \remark After processing messages, do NOT release them (done by yat).
+  virtual void handle_messages (std::vector<yat::Message *>& msgs);
+
   //! \brief Returns the underlying message queue.
   MessageQ & message_queue ();
 
+  //! \brief Registers a typed handler for the messages of type \<MsgType\>.
+  //!
+  //! The messages of type \<MsgType\> are dispatched to \<Handler\>, a member
+  //! function of the task class \<C\> taking a \<T\>&, through a directly indexed
+  //! table (one indirect call, no switch on the msg type) instead of being passed
+  //! to handle_message, which remains the fallback for the message types without
+  //! a registered handler. The handler argument is:
+  //! - the data attached to the message (extracted with Message::get_data), or
+  //! - the message itself for a handler taking a yat::Message.
+  //!
+  //! \verbatim
+  //! MyTask::MyTask (const Task::Config& cfg) : Task(cfg)
+  //! {
+  //!   // void set_position (double& pos)
+  //!   on<kSET_POSITION_MSG, MyTask, double, &MyTask::set_position>();
+  //!   // void periodic (yat::Message& msg)
+  //!   on<TASK_PERIODIC, MyTask, yat::Message, &MyTask::periodic>();
+  //! }
+  //! \endverbatim
+  //! As for handle_message, an exception thrown by the handler (including a data
+  //! type mismatch) is stored into the message.
+  //! \exception BAD_ARG Thrown if \<MsgType\> is neither below kMAX_TASK_HANDLER_MSG_TYPE
+  //! nor a reserved message type (see ReservedMessageType).
+  //! \remark The handlers must be registered before the task is started (e.g. in
+  //! the task constructor) or from the task message handlers.
+  template <size_t MsgType, typename C, typename T, void (C::*Handler) (T&)>
+  void on ();
+
+  //! \brief Unregisters the typed handler of the messages of type \<msg_type\> (if any).
+  //!
+  //! These messages are then passed to handle_message.
+  //! \param msg_type %Message type.
+  void off (size_t msg_type);
+
 private:
+  //- dispatch table entry (indexed by msg type): calls a typed handler of the task
+  typedef void (*Dispatch) (Task *, Message &);
+
+  //- the typed handlers trampoline (see Task::on)
+  template <typename C, typename T, void (C::*Handler) (T&)>
+  static void dispatch (Task * task, Message & msg)
+  {
+    (static_cast<C *>(task)->*Handler)(TaskHandlerArg<T>::get(msg));
+  }
+
+  //- registers <d> as the dispatcher of the <msg_type> msgs
+  void on_i (size_t msg_type, Dispatch d);
+
+  //- returns the dispatch table entry of the <msg_type> msgs (0 if out of the table)
+  Dispatch * dispatch_entry_i (size_t msg_type);
+
+  //- passes <msg> to its typed handler or to handle_message
+  void dispatch_i (Message & msg);
+
   //- actual_timeout
   double actual_timeout () const;
 
+  //- starts the underlying thread (or attaches the task to its executor)
+  void start_i ();
+
+  //- handles a msg then releases it. returns true if the msg was TASK_EXIT.
+  bool handle_message_i (Message * msg);
+
+  //- handles a batch of user msgs then releases them.
+  void handle_messages_i (std::vector<Message *> & msgs);
+
+  //- executor mode: handles the pending msgs (up to kEXECUTOR_TASK_QUANTUM) and
+  //- the due TIMEOUT/PERIODIC msg. returns true if msgs are still pending.
+  //- <deadline> receives the date of the next TIMEOUT/PERIODIC msg (-1 if none).
+  bool run_slice_i (double & deadline);
+
+  //- executor mode: MessageQ::Notifier impl. (schedules the task)
+  virtual void message_posted ();
+
+  //- gets/waits next message(s) from the msgQ (batch mode: <msgs_> receives
+  //- all the extracted msgs). returns the first extracted msg.
+  Message * next_message_i (double tmo_msecs, std::vector<Message *> & msgs_);
+
   //- the associated messageQ
   MessageQ msg_q_;
 
@@ -378,9 +621,36 @@ private:
   //- should we process msg under critical section?
   bool lock_msg_handling_;
 
+  //- max num of msgs extracted per msgQ access
+  size_t msg_batch_size_;
+
   //- true if TASK_INIT msg received, false ortherwise
   bool received_init_msg_;
 
+  //- executor mode: the executor (0 if the task runs its own thread)
+  TaskExecutor * executor_;
+
+  //- executor mode: the task scheduling slot
+  TaskExecutorSlot * exec_slot_;
+
+  //- executor mode: date of the last handled msg (executor clock)
+  double exec_last_activity_ms_;
+
+  //- executor mode: date of the next PERIODIC msg (-1 if not computed yet)
+  double exec_next_periodic_ms_;
+
+  //- executor mode: true if TASK_EXIT msg handled
+  bool exec_exited_;
+
+  //- executor mode: msgs extracted from the msgQ
+  std::vector<Message *> exec_msgs_;
+
+  //- typed handlers, indexed by msg type
+  std::vector<Dispatch> dispatch_;
+
+  //- typed handlers of the reserved msg types, indexed by msg type - FIRST_RESERVED_MSG
+  std::vector<Dispatch> reserved_dispatch_;
+
 #if defined (YAT_DEBUG)
   //- some statistics counter
   unsigned long next_msg_counter;
@@ -389,6 +659,15 @@ private:
 #endif
 };
 
+// ============================================================================
+// Task::on
+// ============================================================================
+template <size_t MsgType, typename C, typename T, void (C::*Handler) (T&)>
+void Task::on ()
+{
+  this->on_i(MsgType, &Task::dispatch<C, T, Handler>);
+}
+
 // ============================================================================
 // Task::post
 // ============================================================================
@@ -460,6 +739,53 @@ template <typename T> void Task::wait_msg_handled (size_t msg_type,
   this->wait_msg_handled(m, tmo_msecs);
 }
 
+// ============================================================================
+// Task::post_with_reply
+// ============================================================================
+template <typename R> Future<R> Task::post_with_reply (size_t msg_type,
+                                                       size_t tmo_msecs)
+{
+  Message * m = new (std::nothrow) Message(msg_type, DEFAULT_MSG_PRIORITY, false);
+  if (! m)
+  {
+    THROW_YAT_ERROR("OUT_OF_MEMORY",
+                    "yat::Message allocation failed",
+                    "Task::post_with_reply");
+  }
+  //- bind the future before posting (the msg may be handled before we return)
+  Future<R> f(m);
+  this->post(m, tmo_msecs);
+  return f;
+}
+// ============================================================================
+// Task::post_with_reply
+// ============================================================================
+template <typename R, typename T> Future<R> Task::post_with_reply (size_t msg_type,
+                                                                   const T & data,
+                                                                   size_t tmo_msecs)
+{
+  Message * m = new (std::nothrow) Message(msg_type, DEFAULT_MSG_PRIORITY, false);
+  if (! m)
+  {
+    THROW_YAT_ERROR("OUT_OF_MEMORY",
+                    "yat::Message allocation failed",
+                    "Task::post_with_reply");
+  }
+  try
+  {
+    m->attach_data(data);
+  }
+  catch (...)
+  {
+    m->release();
+    throw;
+  }
+  //- bind the future before posting (the msg may be handled before we return)
+  Future<R> f(m);
+  this->post(m, tmo_msecs);
+  return f;
+}
+
 // ============================================================================
 //! \struct TaskExiter
 //! \brief 'Deleter' object to instanciate when using yat::SharedPtr<yat::Task>
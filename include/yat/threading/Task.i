@@ -71,12 +71,44 @@ YAT_INLINE MessageQ & Task::message_queue ()
   return this->msg_q_;
 }
 
+// ============================================================================
+// Task::dispatch_entry_i
+// ============================================================================
+YAT_INLINE Task::Dispatch * Task::dispatch_entry_i (size_t msg_type)
+{
+  if (msg_type < this->dispatch_.size())
+    return &this->dispatch_[msg_type];
+  if (msg_type >= FIRST_RESERVED_MSG
+        &&
+      msg_type - FIRST_RESERVED_MSG < this->reserved_dispatch_.size())
+    return &this->reserved_dispatch_[msg_type - FIRST_RESERVED_MSG];
+  return 0;
+}
+
+// ============================================================================
+// Task::dispatch_i
+// ============================================================================
+YAT_INLINE void Task::dispatch_i (Message & msg)
+{
+  Dispatch * d = this->dispatch_entry_i(msg.type());
+  if (d && *d)
+    (*d)(this, msg);
+  else
+    this->handle_message(msg);
+}
+
 // ============================================================================
 // Task::enable_timeout_msg
 // ============================================================================
 YAT_INLINE void Task::enable_timeout_msg (bool behaviour)
 {
+  bool was_not_enabled = ! this->msg_q_.enable_timeout_msg_;
   this->msg_q_.enable_timeout_msg_ = behaviour;
+  //- executor mode: the task timer must be (re)armed
+  if ( this->executor_ && was_not_enabled && behaviour && this->received_init_msg_ )
+  {
+    this->post(TASK_WAKEUP);
+  }
 }
 
 // ============================================================================
@@ -133,6 +165,27 @@ YAT_INLINE void Task::enable_precise_periodic_timing (bool b)
   }
 }
 
+// ============================================================================
+// Task::enable_high_precision_periodic_timing
+// ============================================================================
+YAT_INLINE void Task::enable_high_precision_periodic_timing (bool b)
+{
+  bool enable_state = this->msg_q_.high_precision_periodic_msg_enabled();
+  this->msg_q_.enable_high_precision_periodic_msg(b);
+  if ( enable_state != b && this->received_init_msg_ )
+  {
+    this->post(TASK_WAKEUP);
+  }
+}
+
+// ============================================================================
+// Task::high_precision_periodic_timing_enabled
+// ============================================================================
+YAT_INLINE bool Task::high_precision_periodic_timing_enabled () const
+{
+  return this->msg_q_.high_precision_periodic_msg_enabled();
+}
+
 // ============================================================================
 // Task::periodic_msg_enabled
 // ============================================================================
@@ -181,6 +234,14 @@ YAT_INLINE void Task::post (yat::Message * _msg, size_t _tmo_msecs)
   this->msg_q_.post (_msg, _tmo_msecs);
 }
 
+// ============================================================================
+// Task::post_batch
+// ============================================================================
+YAT_INLINE void Task::post_batch (std::vector<yat::Message *> & _msgs, size_t _tmo_msecs)
+{
+  this->msg_q_.post_batch (_msgs, _tmo_msecs);
+}
+
 // ============================================================================
 // Task::msgq_lo_wm
 // ============================================================================
@@ -229,10 +290,38 @@ YAT_INLINE MessageQ::WmUnit Task::msgq_wm_unit () const
   return this->msg_q_.wm_unit();
 }
 
+// ============================================================================
+// Task::msgq_latency_stats_mode
+// ============================================================================
+YAT_INLINE void Task::msgq_latency_stats_mode (MessageQ::LatencyStatsMode _m)
+{
+  this->msg_q_.latency_stats_mode(_m);
+}
+// ============================================================================
+// Task::msgq_latency_stats_mode
+// ============================================================================
+YAT_INLINE MessageQ::LatencyStatsMode Task::msgq_latency_stats_mode () const
+{
+  return this->msg_q_.latency_stats_mode();
+}
+// ============================================================================
+// Task::enable_msgq_coalescing
+// ============================================================================
+YAT_INLINE void Task::enable_msgq_coalescing (size_t msg_type, MessageQ::Coalescer * merger)
+{
+  this->msg_q_.enable_coalescing(msg_type, merger);
+}
+// ============================================================================
+// Task::disable_msgq_coalescing
+// ============================================================================
+YAT_INLINE void Task::disable_msgq_coalescing (size_t msg_type)
+{
+  this->msg_q_.disable_coalescing(msg_type);
+}
 // ============================================================================
 // Task::msgq_statistics
 // ============================================================================
-YAT_INLINE const MessageQ::Statistics & Task::msgq_statistics ()
+YAT_INLINE MessageQ::Statistics Task::msgq_statistics ()
 {
   return this->msg_q_.statistics();
 }
@@ -0,0 +1,199 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2004-2021 Synchrotron SOLEIL
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the GNU Lesser Public License v3
+// which accompanies this distribution, and is available at
+// http://www.gnu.org/licenses/lgpl.html
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// YAT LIBRARY
+//----------------------------------------------------------------------------
+//
+// Copyright (C) 2006-2021 The Tango Community
+//
+// Part of the code comes from the ACE Framework (asm bytes swaping code)
+// see http://www.cs.wustl.edu/~schmidt/ACE.html for more about ACE
+//
+// The thread native implementation has been initially inspired by omniThread
+// - the threading support library that comes with omniORB.
+// see http://omniorb.sourceforge.net/ for more about omniORB.
+//
+// Contributors form the TANGO community:
+// See AUTHORS file
+//
+// The YAT library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// The YAT library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// See COPYING file for license details
+//
+// Contact:
+//      Stephane Poirier
+//      Synchrotron SOLEIL
+//------------------------------------------------------------------------------
+/*!
+ * \author See AUTHORS file
+ */
+
+#ifndef _TASK_EXECUTOR_H_
+#define _TASK_EXECUTOR_H_
+
+// ============================================================================
+// DEPENDENCIES
+// ============================================================================
+#include <map>
+#include <vector>
+#include <yat/threading/Atomic.h>
+#include <yat/threading/Condition.h>
+#include <yat/time/Timer.h>
+
+// ============================================================================
+// CONSTs
+// ============================================================================
+//! Default number of worker threads of a TaskExecutor.
+#define kDEFAULT_EXECUTOR_WORKERS   4
+//! Max. number of messages handled by a task before it yields its worker.
+#define kEXECUTOR_TASK_QUANTUM      32
+//-----------------------------------------------------------------------------
+
+namespace yat
+{
+
+// ============================================================================
+//! Forward declarations
+// ============================================================================
+class Task;
+class TaskExecutorSlot;
+class TaskExecutorRunQueue;
+class TaskExecutorWorker;
+
+// ============================================================================
+//! \class TaskExecutor
+//! \brief A pool of worker threads shared by several Task instances.
+//!
+//! By default, each yat::Task owns a dedicated thread. A task configured with
+//! Task::Config::executor has no thread of its own: it is scheduled on one of
+//! the executor workers each time its message queue becomes non-empty (or when
+//! its next TIMEOUT/PERIODIC message is due), handles up to kEXECUTOR_TASK_QUANTUM
+//! messages then yields the worker. Workers pick tasks from their own run queue
+//! first and steal from the other workers when idle.
+//!
+//! The Task model is preserved: a task runs on at most one worker at a time, so its
+//! messages are still handled one by one and in the msgQ order.
+//!
+//! \remark A message handler blocking its worker (e.g. waiting for a message to be
+//! handled by another task of the same executor) reduces the executor capacity
+//! accordingly - don't do that with a single worker.
+//! \remark All the tasks must have exited before the executor is destroyed.
+//!
+//! \verbatim
+//! yat::TaskExecutor executor(4);
+//! yat::Task::Config cfg;
+//! cfg.executor = &executor;
+//! MyTask * t = new MyTask(cfg);
+//! t->go();
+//! ...
+//! t->exit();
+//! \endverbatim
+// ============================================================================
+class YAT_DECL TaskExecutor
+{
+  friend class Task;
+  friend class TaskExecutorWorker;
+
+public:
+  //! \brief Constructor: starts the worker threads.
+  //! \param num_workers Number of worker threads (at least 1).
+  //! \exception OUT_OF_MEMORY Thrown when a worker thread can't be started.
+  TaskExecutor (size_t num_workers = kDEFAULT_EXECUTOR_WORKERS);
+
+  //! \brief Destructor: stops the worker threads.
+  virtual ~TaskExecutor ();
+
+  //! \brief Returns the number of worker threads.
+  size_t num_workers () const;
+
+private:
+  //- Task interface: creates/deletes the scheduling slot of a task
+  TaskExecutorSlot * register_task (Task * t);
+  void unregister_task (TaskExecutorSlot * s);
+
+  //- Task interface: starts scheduling the task (called once by Task::go)
+  void attach (TaskExecutorSlot * s);
+
+  //- Task interface: returns true if the task is attached
+  bool attached (TaskExecutorSlot * s);
+
+  //- Task interface: waits for the task to leave its worker then stops scheduling it
+  void detach (TaskExecutorSlot * s);
+
+  //- Task interface: a msg has been posted to the task
+  void notify (TaskExecutorSlot * s);
+
+  //- Task interface: the executor clock (in msecs)
+  double now_msec ();
+
+  //- worker thread body
+  void work (size_t w);
+
+  //- runs a task slice on worker <w> then requeues/parks the task
+  void run_i (TaskExecutorSlot * s, size_t w);
+
+  //- pushes a task onto the run queue of worker <w> and wakes up an idle worker
+  void enqueue_i (TaskExecutorSlot * s, size_t w);
+
+  //- pops a task from the run queue of worker <w> or steals one from another run queue
+  TaskExecutorSlot * dequeue_i (size_t w);
+
+  //- returns true if any run queue is non-empty
+  bool has_work_i ();
+
+  //- (re)arms/disarms the timer of a task (<lock_> MUST be locked by the calling thread)
+  void arm_timer_i (TaskExecutorSlot * s, double deadline);
+
+  //- schedules the tasks whose timer expired (<lock_> MUST be locked by the calling thread)
+  void fire_timers_i (double now, std::vector<TaskExecutorSlot *> & fired);
+
+  //- the workers
+  std::vector<TaskExecutorWorker *> workers_;
+
+  //- the run queues (one per worker) - deleted once all the workers are gone
+  std::vector<TaskExecutorRunQueue *> run_queues_;
+
+  //- protects the timers (and the idle workers count updates)
+  Mutex lock_;
+
+  //- idle workers wait on this condition
+  Condition work_cond_;
+
+  //- number of workers waiting on <work_cond_> - read without <lock_> by the
+  //- enqueuing threads which only lock it when there's a worker to wake up
+  Atomic<size_t> idle_workers_;
+
+  //- task timers (TIMEOUT/PERIODIC deadlines in msecs)
+  std::multimap<double, TaskExecutorSlot *> timers_;
+
+  //- round robin worker selection for tasks notified by a foreign thread
+  Atomic<size_t> next_worker_;
+
+  //- set when the executor is about to be destroyed
+  bool stop_;
+
+  //- the executor clock
+  Timer clock_;
+
+  // = Disallow these operations.
+  //--------------------------------------------
+  TaskExecutor & operator= (const TaskExecutor &);
+  TaskExecutor (const TaskExecutor &);
+};
+
+} // namespace
+
+#endif // _TASK_EXECUTOR_H_
@@ -43,6 +43,7 @@
 // ----------------------------------------------------------------------------
 // DEPENDENCIES
 // ----------------------------------------------------------------------------
+#include <set>
 #include <yat/threading/Mutex.h>
 
 // ----------------------------------------------------------------------------
@@ -84,6 +85,22 @@ public:
     PRIORITY_RT
   };
 
+  //! The possible scheduling policies (default is SCHED_POLICY_DEFAULT).
+  //! Be aware that the real-time policies may prevent other threads from
+  //! running (CPU starvation) and usually require specific privileges.
+  enum SchedPolicy
+  {
+    //! The OS default time-sharing policy (i.e. SCHED_OTHER).
+    SCHED_POLICY_DEFAULT,
+    //! Real-time first in first out policy (i.e. SCHED_FIFO).
+    SCHED_POLICY_FIFO,
+    //! Real-time round robin policy (i.e. SCHED_RR).
+    SCHED_POLICY_RR
+  };
+
+  //! A set of CPU (i.e. core) indexes.
+  typedef std::set<size_t> CpuSet;
+
   //! The possible thread states.
   enum State
   {
@@ -115,6 +132,60 @@ public:
   //! \remarks Locks the associated Mutex (\c m_lock).
   Thread::State state ();
 
+  //! \brief Set the CPU affinity of the thread.
+  //!
+  //! The thread will only run on the specified CPUs (an empty set means any CPU).
+  //! In case the thread is running, the affinity is immediately applied, otherwise
+  //! it is applied when the thread starts.
+  //! \param cpus CPU indexes.
+  //! \exception RUNTIME_ERROR Thrown in case the affinity can't be applied.
+  //! \remark Not supported on MacOSX (silently ignored).
+  void cpu_affinity (const CpuSet & cpus);
+
+  //! \brief Returns the CPU affinity of the thread.
+  //!
+  //! In case the thread is running, returns the actual affinity of the thread.
+  //! Otherwise, returns the affinity it will get when started (empty means any CPU).
+  Thread::CpuSet cpu_affinity ();
+
+  //! \brief Set the scheduling policy and priority of the thread.
+  //!
+  //! In case the thread is running, the policy is immediately applied, otherwise
+  //! it is applied when the thread starts (then the thread doesn't inherit the
+  //! scheduling policy of its creator).
+  //! \param p Scheduling policy.
+  //! \param prio Priority in the range of the policy (see sched_get_priority_min/max).
+  //! Ignored for SCHED_POLICY_DEFAULT.
+  //! \exception BAD_ARG Thrown in case the priority is out of the policy range.
+  //! \exception RUNTIME_ERROR Thrown in case the policy can't be applied (e.g. not enough privileges).
+  //! \remark The real-time policies are not supported on Windows (use priority() instead).
+  void scheduling (SchedPolicy p, int prio = 0);
+
+  //! \brief Returns the scheduling policy of the thread.
+  //!
+  //! In case the thread is running, returns its actual policy.
+  Thread::SchedPolicy sched_policy ();
+
+  //! \brief Returns the scheduling priority of the thread (see scheduling()).
+  //!
+  //! In case the thread is running, returns its actual priority.
+  int sched_priority ();
+
+  //! \brief Set the stack size of the thread.
+  //!
+  //! Must be called before the thread is started. The size is rounded up to the
+  //! system minimum.
+  //! \param bytes Stack size in bytes (0 means the system default).
+  //! \exception PROGRAMMING_ERROR Thrown in case the thread is already running.
+  void stack_size (size_t bytes);
+
+  //! \brief Returns the stack size of the thread.
+  //!
+  //! In case the thread is running, returns its actual stack size (when the
+  //! platform supports it). Otherwise, returns the requested stack size (0
+  //! means the system default).
+  size_t stack_size ();
+
   //! \brief This pure virtual member _must_ cause the "run" (for detached threads)
   //! or "run_undetached" (for undetached threads) to return.
   //!
@@ -202,6 +273,18 @@ private:
   //- The current TPriority of the thread.
   Priority m_priority;
 
+  //- The requested CPU affinity (empty: any CPU)
+  CpuSet m_cpu_affinity;
+
+  //- The requested scheduling policy
+  SchedPolicy m_sched_policy;
+
+  //- The requested scheduling priority
+  int m_sched_priority;
+
+  //- The requested stack size (0: system default)
+  size_t m_stack_size;
+
   //- The thread input argument
   Thread::IOArg  m_iarg;
 
@@ -90,9 +90,22 @@ public:
   //! \note equivalent to c++11 std::thread::hardware_concurrency
   static unsigned int harware_concurrency();
 
+  //! \brief Relinquishes the CPU (the calling thread is moved to the end of the run queue).
+  static void yield ();
+
+  //! \brief Returns a small index for the calling thread.
+  //!
+  //! Indexes are given in turn to the threads (when supported, a hash of the
+  //! thread identifier otherwise), so that per-thread data (ex: counters) can be
+  //! spread over a few slots indexed by <thread_index() % number of slots>.
+  static unsigned int thread_index ();
+
   //! \brief Calculates an absolute time in seconds and nanoseconds, suitable for
   //! use in timed waits (ex: Condition, Semaphore), which is the current
   //! time plus the given relative offset.
+  //!
+  //! The current time is read from the real time clock (i.e. the system time).
+  //! yat::Condition computes its own deadlines on the monotonic clock.
   //! \param abs_sec Absolute time in seconds.
   //! \param abs_nsec Nanoseconds precision of absolute time.
   //! \param offset_sec Offset in seconds.
@@ -53,6 +53,13 @@
 # include <time.h>
 #else
 # include <sys/time.h>
+# include <time.h>
+#endif
+
+//- FastTimer: use the x86 time stamp counter when available (read through the
+//- compiler builtin: no intrinsics header, clock_gettime fallback elsewhere)
+#if ! defined (YAT_WIN32) && defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+# define YAT_FAST_TIMER_TSC
 #endif
 
 typedef struct _timeval
@@ -156,6 +163,8 @@ namespace yat
 //! \brief The YAT timer class.
 //!
 //! This class implements a basic timer object, with microsecond precision.
+//! The timer uses the monotonic clock: it is not affected by the system time
+//! changes (e.g. NTP steps).
 // ============================================================================
 class YAT_DECL Timer
 {
@@ -169,35 +178,35 @@ public:
   //! \brief Resets the timer.
   inline void restart()
   {
-    ::gettimeofday(&_start_time, NULL);
+    ::clock_gettime(CLOCK_MONOTONIC, &_start_time);
   }
 
   //! \brief Returns the elapsed time in seconds.
   inline double elapsed_sec ()
   {
-    struct timeval now;
-    ::gettimeofday(&now, NULL);
-    return (now.tv_sec - _start_time.tv_sec) + 1e-6 * (now.tv_usec - _start_time.tv_usec);
+    struct timespec now;
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - _start_time.tv_sec) + 1e-9 * (now.tv_nsec - _start_time.tv_nsec);
   }
 
   //! \brief Returns the elapsed time in milliseconds.
   inline double elapsed_msec ()
   {
-    struct timeval now;
-    ::gettimeofday(&now, NULL);
-    return 1e3 * (now.tv_sec - _start_time.tv_sec) + 1e-3 * (now.tv_usec - _start_time.tv_usec);
+    struct timespec now;
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return 1e3 * (now.tv_sec - _start_time.tv_sec) + 1e-6 * (now.tv_nsec - _start_time.tv_nsec);
   }
 
   //! \brief Returns the elapsed time in microseconds.
   inline double elapsed_usec ()
   {
-    struct timeval now;
-    ::gettimeofday(&now, NULL);
-    return 1e6 * (now.tv_sec - _start_time.tv_sec) + (now.tv_usec - _start_time.tv_usec);
+    struct timespec now;
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return 1e6 * (now.tv_sec - _start_time.tv_sec) + 1e-3 * (now.tv_nsec - _start_time.tv_nsec);
   }
 
 private:
-  struct timeval _start_time;
+  struct timespec _start_time;
 };
 
 #else // ! YAT_WIN32
@@ -260,6 +269,98 @@ private:
 
 #endif // ! YAT_WIN32
 
+// ============================================================================
+//! \class FastTimer
+//! \brief A low overhead timer for hot path measurements.
+//!
+//! Same interface as Timer, plus nanosecond readings. On x86 CPUs providing an
+//! invariant time stamp counter, the timer reads the TSC (a few nanoseconds, no
+//! system call) and converts the ticks using a frequency calibrated against the
+//! monotonic clock. Otherwise, it falls back to the monotonic clock.
+//!
+//! \remark The calibration (a few milliseconds) is done once per process, on the
+//! first FastTimer instanciation.
+//! \remark Intended for measuring short durations: use Timer for long ones.
+// ============================================================================
+class YAT_DECL FastTimer
+{
+public:
+  //! \brief Creates/resets the timer.
+  FastTimer ()
+  {
+    const Calibration & c = FastTimer::calibration();
+    _tsc = c.tsc;
+    _nsecs_per_tick = c.nsecs_per_tick;
+    this->restart();
+  }
+
+  //! \brief Resets the timer.
+  inline void restart ()
+  {
+    _start = this->ticks();
+  }
+
+  //! \brief Returns the elapsed time in seconds.
+  inline double elapsed_sec ()
+  {
+    return 1e-9 * this->elapsed_nsec();
+  }
+
+  //! \brief Returns the elapsed time in milliseconds.
+  inline double elapsed_msec ()
+  {
+    return 1e-6 * this->elapsed_nsec();
+  }
+
+  //! \brief Returns the elapsed time in microseconds.
+  inline double elapsed_usec ()
+  {
+    return 1e-3 * this->elapsed_nsec();
+  }
+
+  //! \brief Returns the elapsed time in nanoseconds.
+  inline double elapsed_nsec ()
+  {
+    return _nsecs_per_tick * static_cast<double>(this->ticks() - _start);
+  }
+
+  //! \brief Returns true if the timer uses the CPU time stamp counter.
+  static bool tsc_based ();
+
+private:
+  //- the process wide calibration
+  struct Calibration
+  {
+    bool tsc;
+    double nsecs_per_tick;
+  };
+
+  //- returns the calibration (done on first call)
+  static const Calibration & calibration ();
+
+  //- reads the current ticks count
+  inline yat::uint64 ticks () const
+  {
+#if defined (YAT_FAST_TIMER_TSC)
+    if (_tsc)
+      return __builtin_ia32_rdtsc();
+#endif
+#if defined (YAT_WIN32)
+    LARGE_INTEGER li;
+    ::QueryPerformanceCounter(&li);
+    return static_cast<yat::uint64>(li.QuadPart);
+#else
+    struct timespec now;
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<yat::uint64>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+#endif
+  }
+
+  yat::uint64 _start;
+  bool _tsc;
+  double _nsecs_per_tick;
+};
+
 // ============================================================================
 //! \class Timeout
 //! \brief The YAT timeout class.
@@ -40,8 +40,16 @@
 #ifndef _YAT_CALLBACK_H_
 #define _YAT_CALLBACK_H_
 
+#include <new>
 #include <yat/CommonHeader.h>
 
+// ============================================================================
+// CONSTs
+// ============================================================================
+//! Size of the Callback inline storage: a member function callback (object
+//! reference and member function pointer) is stored inline, without allocation.
+#define kCALLBACK_INLINE_SIZE (4 * sizeof(void*))
+
 namespace yat
 {
 
@@ -67,37 +75,77 @@ public:
   //! \brief Deep copy.
   virtual CallbackContainer<P>* clone () const = 0;
 
+  //! \brief Deep copy into \<storage\> if it fits in \<size\> bytes, on the heap otherwise.
+  //!
+  //! The default implementation calls clone().
+  virtual CallbackContainer<P>* clone_to (void *, size_t) const
+  {
+    return this->clone();
+  }
+
   //! \brief Comparison operator with another CallbackContainer\<P\> object.
   virtual bool is_equal (const CallbackContainer<P> *) const = 0;
 };
 
+// ============================================================================
+//! \struct CallbackInline
+//! \brief Tag of the Callback constructor copying a container inline.
+// ============================================================================
+struct CallbackInline {};
+
+// ============================================================================
+//! \brief Copies \<c\> into \<storage\> if it fits in \<size\> bytes, on the heap otherwise.
+//!
+//! Helper for the CallbackContainer::clone_to implementations.
+// ============================================================================
+template <typename P, typename C>
+CallbackContainer<P>* callback_clone_to (const C& c, void * storage, size_t size)
+{
+#if defined (YAT_CPP11)
+  if (sizeof(C) <= size && alignof(C) <= alignof(void*) && storage)
+#else
+  if (sizeof(C) <= size && storage)
+#endif
+    return new (storage) C(c);
+  return new C(c);
+}
+
 // ============================================================================
 //! \class Callback
 //! \brief Generic callback class.
 //!
-//! This template class has a CallbackContainer member.
+//! This template class has a CallbackContainer member. Small containers (up to
+//! kCALLBACK_INLINE_SIZE bytes, which includes the 'free' and member function
+//! containers defined by YAT_DEFINE_CALLBACK) are stored inline: instantiating
+//! and copying such callbacks does not allocate.
 // ============================================================================
 template <typename P>
 class Callback
 {
 public:
   //! \brief Constructor from a CallbackContainer object.
-  //! \param c CallbackContainer object.
+  //! \param c CallbackContainer object (heap allocated, ownership transferred).
   Callback (CallbackContainer<P>* c)
     : container(c)
   {};
 
+  //! \brief Constructor from a CallbackContainer object copied inline (if small enough).
+  //! \param c CallbackContainer object.
+  template <typename C>
+  Callback (const C& c, CallbackInline)
+    : container(c.clone_to(&this->storage, sizeof(this->storage)))
+  {};
+
   //! \brief Copy constructor.
   //! \param c The source object.
   Callback (const Callback<P>& c)
-    : container(c.container ? c.container->clone() : 0)
+    : container(c.container ? c.container->clone_to(&this->storage, sizeof(this->storage)) : 0)
   {};
 
   //! \brief Destructor.
   ~Callback ()
   {
-    delete this->container;
-    this->container = 0;
+    this->release_i();
   };
 
   //! \brief operator=.
@@ -106,8 +154,10 @@ public:
   {
     if (this != &callback)
     {
-      delete this->container;
-      this->container =  callback.container ? callback.container->clone() : 0;
+      this->release_i();
+      this->container = callback.container
+                      ? callback.container->clone_to(&this->storage, sizeof(this->storage))
+                      : 0;
     }
     return *this;
   };
@@ -115,7 +165,7 @@ public:
   //! \brief Executes operation defined in body.
   //! \param p Generic type \<P\> argument.
   //! \exception NULL_POINTER Thrown when the callback is null.
-  void operator() (P p)
+  void operator() (P p) const
   {
     if (this->container)
       (*this->container)(p);
@@ -146,8 +196,117 @@ public:
     return this->container->is_equal(s.container);
   }
 
+  //! \brief Returns the underlying container (null if the callback is empty).
+  const CallbackContainer<P>* get_container () const
+  {
+    return this->container;
+  }
+
 private:
+  //- destroys the container
+  void release_i ()
+  {
+    if (static_cast<void*>(this->container) == static_cast<void*>(&this->storage))
+      this->container->~CallbackContainer<P>();
+    else
+      delete this->container;
+    this->container = 0;
+  }
+
   CallbackContainer<P>* container;
+
+  //- inline storage of the small containers
+  union
+  {
+    char  bytes[kCALLBACK_INLINE_SIZE];
+    void* align_ptr;
+    double align_double;
+  } storage;
+};
+
+// ============================================================================
+//! \class CallbackRef
+//! \brief Non-owning reference to a callable taking a \<P\> argument.
+//!
+//! A CallbackRef is two pointers: it never allocates and may be passed by value
+//! to the hot paths. It refers to a Callback (which must outlive it), to a 'free'
+//! function or to an object member function (bound at compile time: no virtual
+//! call).
+//!
+//! \verbatim
+//! void process (yat::CallbackRef<double> on_value);
+//! process(myCallback);
+//! process(yat::CallbackRef<double>::bind<MyClass, &MyClass::on_value>(obj));
+//! \endverbatim
+// ============================================================================
+template <typename P>
+class CallbackRef
+{
+public:
+  //! \brief Constructor: refers to a Callback.
+  //! \param cb The callback.
+  CallbackRef (const Callback<P>& cb)
+    : object_(const_cast<CallbackContainer<P>*>(cb.get_container())),
+      call_(&CallbackRef::call_container_i)
+  {}
+
+  //! \brief Constructor: refers to a 'free' function.
+  //! \param f The function.
+  CallbackRef (void (*f)(P))
+    : object_(reinterpret_cast<void*>(f)),
+      call_(&CallbackRef::call_function_i)
+  {}
+
+  //! \brief Returns a reference to the member function \<M\> of \<c\>.
+  //! \param c The object.
+  template <typename C, void (C::*M)(P)>
+  static CallbackRef bind (C& c)
+  {
+    return CallbackRef(&c, &CallbackRef::template call_member_i<C, M>);
+  }
+
+  //! \brief Calls the referred callable.
+  //! \param p Generic type \<P\> argument.
+  //! \exception NULL_POINTER Thrown when the referred callback is null.
+  void operator() (P p) const
+  {
+    if (! this->object_)
+      THROW_YAT_ERROR("NULL_POINTER", "null/empty callback called", "CallbackRef::operator()");
+    this->call_(this->object_, p);
+  }
+
+  //! \brief Is the referred callable empty?
+  bool is_empty () const
+  {
+    return this->object_ == 0;
+  }
+
+private:
+  CallbackRef (void * o, void (*c)(void *, P))
+    : object_(o), call_(c)
+  {}
+
+  static void call_container_i (void * o, P p)
+  {
+    (*static_cast<const CallbackContainer<P>*>(o))(p);
+  }
+
+  static void call_function_i (void * o, P p)
+  {
+    reinterpret_cast<void (*)(P)>(o)(p);
+  }
+
+  template <typename C, void (C::*M)(P)>
+  static void call_member_i (void * o, P p)
+  {
+    (static_cast<C*>(o)->*M)(p);
+  }
+
+  //- the referred object (container, function or object)
+  void * object_;
+
+  //- the object call trampoline
+  void (*call_)(void *, P);
 };
 
 // ============================================================================
@@ -349,6 +508,10 @@ private:
     { \
       return new Function_##CallbackClass##Container(*this); \
     } \
+    yat::CallbackContainer<CallbackArg>* clone_to(void* s, size_t n) const \
+    { \
+      return yat::callback_clone_to<CallbackArg>(*this, s, n); \
+    } \
   }; \
   template <typename Client, class Member> \
   class Member_##CallbackClass##Container : public yat::MemberCallbackContainer<CallbackArg, Client, Member> \
@@ -362,6 +525,10 @@ private:
     { \
       return new Member_##CallbackClass##Container(*this); \
     } \
+    yat::CallbackContainer<CallbackArg>* clone_to(void* s, size_t n) const \
+    { \
+      return yat::callback_clone_to<CallbackArg>(*this, s, n); \
+    } \
   }; \
   class CallbackClass : public yat::Callback<CallbackArg> \
   { \
@@ -370,6 +537,10 @@ private:
     CallbackClass (yat::CallbackContainer<CallbackArg>* cc = 0) \
       : InHerited(cc) \
     {} \
+    template <typename Container> \
+    CallbackClass (const Container& c, yat::CallbackInline tag) \
+      : InHerited(c, tag) \
+    {} \
     CallbackClass (const CallbackClass& cb) \
       : InHerited(cb) \
     {} \
@@ -381,12 +552,12 @@ private:
     template <typename Function> \
     static CallbackClass instanciate (Function f) \
     { \
-      return new Function_##CallbackClass##Container<Function>(f); \
+      return CallbackClass(Function_##CallbackClass##Container<Function>(f), yat::CallbackInline()); \
     } \
     template <typename Client, class Member> \
     static CallbackClass instanciate (Client& c, Member m) \
     { \
-      return new Member_##CallbackClass##Container<Client, Member>(c, m); \
+      return CallbackClass(Member_##CallbackClass##Container<Client, Member>(c, m), yat::CallbackInline()); \
     } \
   };
 
@@ -49,6 +49,10 @@
 #include <yat/CommonHeader.h>
 #include <yat/threading/Mutex.h>
 #include <yat/threading/Utilities.h>
+#if defined (YAT_CPP11)
+# include <atomic>
+# include <type_traits>
+#endif
 
 namespace yat
 {
@@ -59,6 +63,145 @@ namespace yat
 //! Defines the default counter type.
 typedef yat::uint32 counter_t;
 
+//- keeps a function out of line (see CountBase::destroy)
+#if defined (__GNUC__)
+# define YAT_COUNTER_NOINLINE __attribute__ ((noinline))
+#else
+# define YAT_COUNTER_NOINLINE
+#endif
+
+#if defined (YAT_CPP11)
+// ============================================================================
+//! \class AtomicCount
+//! \brief Lock-free counting policy.
+//!
+//! To be used as \<L\> template parameter of the counters and pointers
+//! (see CountBase, SharedPtr, WeakPtr): the reference counts are atomic
+//! counters, so that copying or destroying a pointer never locks a mutex.
+//!
+//! The lock() and unlock() functions only serve explicit locking (e.g.
+//! AutoMutex on a SharedPtr) - they are never called by the counters.
+//! \remark Requires c++11 support.
+// ============================================================================
+class AtomicCount
+{
+public:
+  //! \brief Explicitly locks the underlying mutex.
+  void lock ()
+  {
+    m_lock.lock();
+  }
+
+  //! \brief Explicitly unlocks the underlying mutex.
+  void unlock ()
+  {
+    m_lock.unlock();
+  }
+
+private:
+  yat::Mutex m_lock;
+};
+
+//! Defines the default counting policy (lock-free if c++11 support).
+typedef AtomicCount DefaultCountLock;
+#else
+//! Defines the default counting policy (lock-free if c++11 support).
+typedef yat::Mutex DefaultCountLock;
+#endif
+
+// ============================================================================
+//! \class CountPolicy
+//! \brief Reference count operations for the \<L\> locking strategy.
+//!
+//! The generic implementation protects the counts with the \<L\> lock.
+// ============================================================================
+template <typename C, typename L>
+struct CountPolicy
+{
+  //! Counter storage type.
+  typedef C value_type;
+
+  //! \brief Increments the counter, returns the new value.
+  static C increment (value_type & c, L & l)
+  {
+    yat::AutoMutex<L> guard(l);
+    return ++c;
+  }
+
+  //! \brief Decrements the counter, returns the new value.
+  static C decrement (value_type & c, L & l)
+  {
+    yat::AutoMutex<L> guard(l);
+    //- the count is read once, before the caller may free the counter on a null
+    //- value (i.e. the returned value is not a read of <c> after the store)
+    C v = c - 1;
+    c = v;
+    return v;
+  }
+
+  //! \brief Increments the counter unless it is null, returns false if null.
+  static bool increment_if_not_zero (value_type & c, L & l)
+  {
+    yat::AutoMutex<L> guard(l);
+    if( ! c )
+      return false;
+    ++c;
+    return true;
+  }
+
+  //! \brief Returns the counter value.
+  static C load (const value_type & c, L & l)
+  {
+    yat::AutoMutex<L> guard(l);
+    return c;
+  }
+};
+
+#if defined (YAT_CPP11)
+// ============================================================================
+//! \class CountPolicy
+//! \brief Lock-free reference count operations (see AtomicCount).
+// ============================================================================
+template <typename C>
+struct CountPolicy<C, AtomicCount>
+{
+  //! Counter storage type.
+  typedef std::atomic<C> value_type;
+
+  //! \brief Increments the counter, returns the new value.
+  static C increment (value_type & c, AtomicCount &)
+  {
+    //- the caller already owns a reference: no ordering required
+    return c.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  //! \brief Decrements the counter, returns the new value.
+  static C decrement (value_type & c, AtomicCount &)
+  {
+    //- the thread releasing the last reference sees the changes made by the other owners
+    return c.fetch_sub(1, std::memory_order_acq_rel) - 1;
+  }
+
+  //! \brief Increments the counter unless it is null, returns false if null.
+  static bool increment_if_not_zero (value_type & c, AtomicCount &)
+  {
+    C v = c.load(std::memory_order_relaxed);
+    while( v )
+    {
+      if( c.compare_exchange_weak(v, v + 1, std::memory_order_acq_rel, std::memory_order_relaxed) )
+        return true;
+    }
+    return false;
+  }
+
+  //! \brief Returns the counter value.
+  static C load (const value_type & c, AtomicCount &)
+  {
+    return c.load(std::memory_order_acquire);
+  }
+};
+#endif
+
 // ============================================================================
 //! \class DefaultDeleter
 //! \brief Default deleter function.
@@ -94,17 +237,22 @@ struct DefaultDeleter
 //! If counter lock is not necessary, use a yat::NullMutex type for example:
 //! \verbatim myCounter = new CountBase<yat::uint64, yat::NullMutex>(); \endverbatim
 //!
-//! If counter lock is necessary, use a mutex type (default value in
-//! the template definition), for example:
+//! If counter lock is necessary, use yat::AtomicCount (lock-free - default value
+//! in the template definition if c++11 support) or a mutex type, for example:
 //! \verbatim myCounter = new CountBase<yat::uint64>(); \endverbatim
 //!
 // ============================================================================
-template <typename C = counter_t, typename L = yat::Mutex>
+template <typename C = counter_t, typename L = DefaultCountLock>
 class CountBase
 {
+  typedef CountPolicy<C,L> Policy;
+
 public:
   //! \brief Default constructor.
-  CountBase() : m_use_count(1), m_weak_count(0)
+  //!
+  //! The shared references collectively own a weak reference, released with the
+  //! last shared reference (i.e. the counter outlives the object disposal).
+  CountBase() : m_use_count(1), m_weak_count(1)
   {
     PTR_DBG("CountBase::CountBase");
   }
@@ -123,10 +271,17 @@ public:
   //! Increments counter by 1.
   C add_ref()
   {
-    PTR_DBG("CountImpl::add_ref(->" << m_use_count+1 << ")");
-    yat::AutoMutex<L> guard(m_lock);
-    ++m_use_count;
-    return m_use_count;
+    PTR_DBG("CountImpl::add_ref");
+    return Policy::increment(m_use_count, m_lock);
+  }
+
+  //! \brief Adds a reference to counter unless the object has already been disposed.
+  //!
+  //! Returns false if the use counter equals to 0.
+  bool add_ref_lock()
+  {
+    PTR_DBG("CountImpl::add_ref_lock");
+    return Policy::increment_if_not_zero(m_use_count, m_lock);
   }
 
   //! \brief Adds a weak reference to counter.
@@ -134,46 +289,46 @@ public:
   //! Increments weak counter by 1.
   C add_weak_ref()
   {
-    PTR_DBG("CountImpl::add_weak_ref(->" << m_weak_count+1 << ")");
-    yat::AutoMutex<L> guard(m_lock);
-    ++m_weak_count;
-    return m_weak_count;
+    PTR_DBG("CountImpl::add_weak_ref");
+    return Policy::increment(m_weak_count, m_lock);
   }
 
   //! \brief Removes a reference from counter.
   //!
-  //! Decreases counter by 1.
-  std::pair<C,C> dec_ref()
+  //! Decreases counter by 1. Disposes the object on last reference
+  //! and destroys *this* if there is no more weak reference.
+  void release()
   {
-    PTR_DBG("CountImpl::dec_ref(->" << m_use_count-1 << ")");
-    yat::AutoMutex<L> guard(m_lock);
-    --m_use_count;
-    return std::make_pair(m_use_count, m_weak_count);
+    PTR_DBG("CountImpl::release");
+    if( 0 == Policy::decrement(m_use_count, m_lock) )
+    {
+      dispose();
+      weak_release();
+    }
   }
 
   //! \brief Removes a weak reference from counter.
   //!
-  //! Decreases weak counter by 1.
-  std::pair<C,C> dec_weak_ref()
+  //! Decreases weak counter by 1. Destroys *this* on last weak reference.
+  void weak_release()
   {
-    PTR_DBG("CountImpl::dec_weak_ref(->" << m_weak_count-1 << ")");
-    yat::AutoMutex<L> guard(m_lock);
-    --m_weak_count;
-    return std::make_pair(m_use_count, m_weak_count);
+    PTR_DBG("CountImpl::weak_release");
+    if( 0 == Policy::decrement(m_weak_count, m_lock) )
+      destroy();
   }
 
   //! \brief Gets the counter value.
   C use_count() const
   {
-    yat::AutoMutex<L> guard(m_lock);
-    return m_use_count;
+    return Policy::load(m_use_count, m_lock);
   }
 
   //! \brief Gets the weak counter value.
   C weak_count() const
   {
-    yat::AutoMutex<L> guard(m_lock);
-    return m_weak_count;
+    C w = Policy::load(m_weak_count, m_lock);
+    //- don't count the weak reference owned by the shared references
+    return use_count() ? w - 1 : w;
   }
 
   //! \brief Explicitly locks the counter.
@@ -189,11 +344,20 @@ public:
   }
 
 protected:
+  //- deletes *this*: kept out of line, otherwise, once inlined in a function
+  //- releasing several pointers to the same (non atomic) counter, the delete
+  //- is seen by gcc as followed by a decrement of the freed counts (false
+  //- positive -Wuse-after-free: the compiler can't prove the counts were > 1)
+  YAT_COUNTER_NOINLINE void destroy()
+  {
+    delete this;
+  }
+
   //! Use counter.
-  C m_use_count;
+  typename Policy::value_type m_use_count;
 
   //! Weak counter.
-  C m_weak_count;
+  typename Policy::value_type m_weak_count;
 
   //! Counter lock.
   mutable L m_lock;
@@ -211,12 +375,12 @@ protected:
 //! If counter lock is not necessary, use a yat::NullMutex type for example:
 //! \verbatim myCounter = new CountImpl<myDeleterType, myObjType, yat::NullMutex>(); \endverbatim
 //!
-//! If counter lock is necessary, use a mutex type (default value in
-//! the template definition), for example:
+//! If counter lock is necessary, use yat::AtomicCount (lock-free - default value
+//! in the template definition if c++11 support) or a mutex type, for example:
 //! \verbatim myCounter = new CountImpl<myDeleterType, myObjType>(); \endverbatim
 //!
 // ============================================================================
-template <typename T, typename D, typename C = counter_t, typename L = yat::Mutex>
+template <typename T, typename D, typename C = counter_t, typename L = DefaultCountLock>
 class CountImpl: public CountBase<C,L>
 {
 public:
@@ -248,7 +412,69 @@ private:
   T* m_data;
 };
 
-template <typename C = counter_t, typename L = yat::Mutex> class WeakCounter;
+// ============================================================================
+//! \class CountInplace
+//! \brief Counter implementation embedding the managed object.
+//!
+//! This template class is a generic \<C\> type counter implementation storing
+//! the \<T\> type object it manages, so that the object and its counter share
+//! a single allocation (see yat::make_shared). The object is constructed in
+//! place by the caller (see storage and constructed).
+// ============================================================================
+template <typename T, typename C = counter_t, typename L = DefaultCountLock>
+class CountInplace: public CountBase<C,L>
+{
+public:
+  //! \brief Constructor (the object is not constructed).
+  CountInplace() : m_constructed(false)
+  {
+    PTR_DBG("CountInplace::CountInplace");
+  }
+
+  //! \brief A "do nothing" destructor.
+  ~CountInplace()
+  {
+    PTR_DBG("CountInplace::~CountInplace");
+  }
+
+  //! \brief Returns the (raw) object storage.
+  void * storage()
+  {
+    return &m_storage;
+  }
+
+  //! \brief Tells the object has been constructed in the storage, returns it.
+  T * constructed()
+  {
+    m_constructed = true;
+    return static_cast<T*>(storage());
+  }
+
+  //! \brief The specific deletion function.
+  //!
+  //! Destroys the object (the storage is released with the counter).
+  void dispose()
+  {
+    if( m_constructed )
+      static_cast<T*>(storage())->~T();
+  }
+
+private:
+#if defined (YAT_CPP11)
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+#else
+  union
+  {
+    char m_bytes[sizeof(T)];
+    yat::uint64 m_align_u64;
+    long double m_align_ld;
+    void * m_align_ptr;
+  } m_storage;
+#endif
+  bool m_constructed;
+};
+
+template <typename C = counter_t, typename L = DefaultCountLock> class WeakCounter;
 
 // ============================================================================
 //! \class SharedCounter
@@ -260,12 +486,12 @@ template <typename C = counter_t, typename L = yat::Mutex> class WeakCounter;
 //! If counter lock is not necessary, use a yat::NullMutex type for example:
 //! \verbatim myCounter = new SharedCounter<yat::NullMutex>(); \endverbatim
 //!
-//! If counter lock is necessary, use a mutex type (default value in
-//! the template definition), for example:
+//! If counter lock is necessary, use yat::AtomicCount (lock-free - default value
+//! in the template definition if c++11 support) or a mutex type, for example:
 //! \verbatim myCounter = new SharedCounter<>(); \endverbatim
 //!
 // ============================================================================
-template <typename C = counter_t, typename L = yat::Mutex>
+template <typename C = counter_t, typename L = DefaultCountLock>
 class SharedCounter
 {
   friend class WeakCounter<C,L>;
@@ -307,15 +533,17 @@ public:
   explicit SharedCounter (const WeakCounter<C,L>& cnt)
   {
     PTR_DBG("SharedCounter::SharedCounter(const WeakCounter<T,L>&)");
-    cnt.m_count->lock();
-    if( cnt.m_count->use_count() > 0 )
-    {
-      m_count = cnt.m_count;
-      m_count->add_ref();
-    }
-    else
-      m_count = 0;
-    cnt.m_count->unlock();
+    m_count = cnt.m_count && cnt.m_count->add_ref_lock() ? cnt.m_count : 0;
+  }
+
+  //! \brief Constructor from an existing counter (e.g. see yat::make_shared).
+  //!
+  //! Takes ownership of the specified counter initial reference.
+  //! \param cnt The counter.
+  explicit SharedCounter (CountBase<C,L>* cnt)
+    : m_count(cnt)
+  {
+    PTR_DBG("SharedCounter::SharedCounter(CountBase<C,L>*)");
   }
 
   //! \brief copy constructor.
@@ -333,16 +561,9 @@ public:
     PTR_DBG("SharedCounter::release()");
     if( m_count )
     {
-      const std::pair<C, C> counters = m_count->dec_ref();
-      if( 0 == counters.first ) // use_count
-      {
-        // No more reference to the counter object, we can destroy it
-        m_count->dispose();
-        if( 0 == counters.second ) // weak_count
-          // No more weak ref, we can destroy the counter
-          delete m_count;
-        m_count = 0;
-      }
+      // disposes the object on last reference
+      m_count->release();
+      m_count = 0;
     }
   }
 
@@ -374,15 +595,7 @@ public:
   {
     PTR_DBG("SharedCounter::operator=(const ThisType&)");
     release();
-    cnt.m_count->lock();
-    if( cnt.m_count->use_count() > 0 )
-    {
-      m_count = cnt.m_count;
-      m_count->add_ref();
-    }
-    else
-      m_count = 0;
-    cnt.m_count->unlock();
+    m_count = cnt.m_count && cnt.m_count->add_ref_lock() ? cnt.m_count : 0;
     return *this;
   }
 
@@ -524,12 +737,9 @@ public:
     PTR_DBG("WeakCounter::release()");
     if( m_count )
     {
-      const std::pair<C, C> counters = m_count->dec_weak_ref();
-      if( 0 == counters.first && 0 == counters.second )
-      {       //       use_count             weak_count
-        delete m_count;
-        m_count = 0;
-      }
+      // destroys the counter on last (weak) reference
+      m_count->weak_release();
+      m_count = 0;
     }
   }
 
@@ -39,14 +39,17 @@
 
 #pragma once
 
-#include <list>
+#include <vector>
 #include <yat/utils/Callback.h>
 #include <yat/threading/Mutex.h>
-
-
+#include <yat/threading/Atomic.h>
+#include <yat/threading/SharedObject.h>
+#include <yat/threading/Published.h>
 
 namespace yat
 {
+template <typename ParamType_, typename LockType_> class SignalAsyncEmission;
+
 // ============================================================================
 //! \class Signal
 //! \brief The YAT signal class.
@@ -60,13 +63,22 @@ namespace yat
 //!
 //! The callbacks are defined as yat::Callback objects.
 //!
-//! If signal lock is not necessary, use a yat::NullMutex type (default value in
-//! the template definition), for example:
+//! The connected observers are kept in an immutable array, replaced (copy-on-write)
+//! by connect and disconnect. An emission calls the observers connected when it
+//! starts, without any lock: a slow observer blocks neither the other emitters nor
+//! connect/disconnect, and an observer may connect or disconnect observers (the
+//! change applies to the next emissions).
+//!
+//! The lock type only serializes connect/disconnect. If they are not called
+//! concurrently, use a yat::NullMutex type (default value in the template
+//! definition), for example:
 //! \verbatim mySignal = new Signal<myCallbackArgType>(); \endverbatim
 //!
-//! If signal lock is necessary, use a mutex type, for example:
+//! Otherwise, use a mutex type, for example:
 //! \verbatim mySignal = new Signal<myCallbackArgType, yat::Mutex>(); \endverbatim
 //!
+//! The observers may also be called asynchronously by a SignalTask (see
+//! SignalTask::run_async in yat/threading/SignalTask.h).
 // ============================================================================
 template <typename ParamType_, typename LockType_ = yat::NullMutex>
 class Signal
@@ -75,28 +87,72 @@ public:
   //! \brief Macro to define the callback function type (Slot).
   YAT_DEFINE_CALLBACK(Slot, ParamType_);
 
+  //! \brief Constructor.
+  Signal()
+    : observers_(0), readers_(1)
+  {
+  }
+
+  //! \brief Copy constructor (shares the observers of \<s\>).
+  Signal(const Signal & s)
+    : observers_(s._observers()), readers_(1)
+  {
+  }
+
+  //! \brief Assignment operator (connects the observers of \<s\> instead of the current ones).
+  Signal & operator=(const Signal & s)
+  {
+    if (this != &s) {
+      yat::AutoMutex<LockType_> guard(this->lock_);
+      Observers * o = new Observers;
+      Observers * other = s._observers();
+      if (other) {
+        o->slots = other->slots;
+        other->release();
+      }
+      this->_publish(o);
+    }
+    return *this;
+  }
+
+  //! \brief Destructor.
+  ~Signal()
+  {
+    Observers * o = this->observers_.load();
+    if (o)
+      o->release();
+  }
+
 protected:
-  //! \brief %Signal lock.
+  //! \brief Immutable array of observers (shared by the running emissions).
+  class Observers : public SharedObject
+  {
+  public:
+    //! The observers callbacks.
+    std::vector<Slot> slots;
+  };
+
+  //! \brief %Signal lock (serializes connect/disconnect).
   mutable LockType_ lock_;
 
-  //! \brief List of observers (contains callback functions).
-  std::list<Slot> observers_;
+  //! \brief Current observers (null if none).
+  Atomic<Observers *> observers_;
+
+  //! \brief Emitters getting a reference to the current observers.
+  mutable PublishedReaders readers_;
 
   //! \brief Internal run function.
   //!
   //! Calls for each connected observer's callback function.
   //! Returns true if no problem occurs, false otherwise.
   //! \param param %Callback parameter.
-  //! \param observers Connected observers list.
-  bool _run(ParamType_ param, std::list<Slot> & observers)
+  //! \param observers Connected observers array.
+  static bool _run(ParamType_ param, std::vector<Slot> & observers)
   {
-    typename std::list<Slot>::iterator
-                i(observers.begin()),
-                e(observers.end());
     bool everythingOk = true;
-    for (; i!=e; ++i) {
+    for (size_t i = 0; i < observers.size(); ++i) {
       try {
-        (*i)(param);
+        observers[i](param);
       } catch(...) {
         everythingOk = false;
       }
@@ -104,6 +160,34 @@ protected:
     return everythingOk;
   }
 
+  //! \brief Returns a reference to the current observers (to be released), null if none.
+  Observers * _observers() const
+  {
+    PublishedReaders::Token t = this->readers_.read_lock();
+    Observers * o = this->observers_.load();
+    if (o)
+      o->duplicate();
+    PublishedReaders::read_unlock(t);
+    return o;
+  }
+
+  //! \brief Replaces the current observers (must be called under the signal lock).
+  //! \param observers New observers (ownership transferred), deleted if empty.
+  void _publish(Observers * observers)
+  {
+    if (observers->slots.empty()) {
+      delete observers;
+      observers = 0;
+    }
+    Observers * former = this->observers_.exchange(observers);
+    //- the emitters may still be getting a reference on the former observers
+    this->readers_.synchronize();
+    if (former)
+      former->release();
+  }
+
+  template <typename P, typename L> friend class SignalAsyncEmission;
+
 public:
 
   //! \brief Run function.
@@ -113,8 +197,12 @@ public:
   //! \param param %Callback parameter.
   bool run(ParamType_ param)
   {
-    yat::AutoMutex<LockType_> guard(this->lock_);
-    return this->_run(param, this->observers_);
+    Observers * o = this->_observers();
+    if (!o)
+      return true;
+    bool everythingOk = _run(param, o->slots);
+    o->release();
+    return everythingOk;
   }
 
   //! \brief Tests whether the connected observers list is empty.
@@ -122,8 +210,7 @@ public:
   //! Returns true if the connected observers list is empty, false otherwise.
   bool connected() const
   {
-    yat::AutoMutex<LockType_> guard(this->lock_);
-    return !this->observers_.empty();
+    return this->observers_.load() != 0;
   }
 
   //! \brief Connects an observer to the signal object.
@@ -133,8 +220,16 @@ public:
   void connect(Slot cb)
   {
     yat::AutoMutex<LockType_> guard(this->lock_);
-    this->observers_.remove(cb);
-    this->observers_.push_front(cb);
+    Observers * o = new Observers;
+    o->slots.push_back(cb);
+    Observers * current = this->observers_.load();
+    if (current) {
+      o->slots.reserve(current->slots.size() + 1);
+      for (size_t i = 0; i < current->slots.size(); ++i)
+        if (!(current->slots[i] == cb))
+          o->slots.push_back(current->slots[i]);
+    }
+    this->_publish(o);
   }
 
   //! \brief Disconnects an observer from the signal object.
@@ -144,7 +239,14 @@ public:
   void disconnect(Slot cb)
   {
     yat::AutoMutex<LockType_> guard(this->lock_);
-    this->observers_.remove(cb);
+    Observers * current = this->observers_.load();
+    if (!current)
+      return;
+    Observers * o = new Observers;
+    for (size_t i = 0; i < current->slots.size(); ++i)
+      if (!(current->slots[i] == cb))
+        o->slots.push_back(current->slots[i]);
+    this->_publish(o);
   }
 };
 
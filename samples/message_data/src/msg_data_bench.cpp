@@ -0,0 +1,128 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2004-2021 Synchrotron SOLEIL
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the GNU Lesser Public License v3
+// which accompanies this distribution, and is available at
+// http://www.gnu.org/licenses/lgpl.html
+//----------------------------------------------------------------------------
+/*!
+ * \file
+ * \brief    yat::Message data access microbenchmark (RTTI vs type tags)
+ * \author   See AUTHORS file
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <typeinfo>
+#include <yat/time/Timer.h>
+#include <yat/threading/Message.h>
+
+//-----------------------------------------------------------------------------
+// the payload types
+//-----------------------------------------------------------------------------
+struct Event
+{
+  yat::uint32 number;
+  double timestamp;
+};
+
+//-----------------------------------------------------------------------------
+// previous Message::get_data implementation (RTTI based)
+//-----------------------------------------------------------------------------
+template <typename T> T * rtti_get_data (yat::Container * c)
+{
+  yat::GenericContainer<T> * gc = 0;
+  try
+  {
+    gc = dynamic_cast<yat::GenericContainer<T>*>(c);
+    if (gc == 0)
+      return 0;
+  }
+  catch (const std::bad_cast&)
+  {
+    return 0;
+  }
+  return gc->get_content(false);
+}
+
+//-----------------------------------------------------------------------------
+// current Message::get_data implementation (type tags based)
+//-----------------------------------------------------------------------------
+template <typename T> T * tag_get_data (yat::Container * c)
+{
+  yat::GenericContainer<T> * gc = yat::container_cast<T>(c);
+  return gc ? gc->get_content(false) : 0;
+}
+
+//-----------------------------------------------------------------------------
+// print result
+//-----------------------------------------------------------------------------
+void report (const char * what, double usecs, size_t n)
+{
+  std::cout << what
+            << ": "
+            << (usecs * 1000.) / n
+            << " nsecs per msg"
+            << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+// MAIN
+//-----------------------------------------------------------------------------
+int main (int argc, char* argv[])
+{
+  size_t n = 10000000;
+  if (argc > 1)
+    n = static_cast<size_t>(::atol(argv[1]));
+
+  //- a container per payload type (msgs handled by a task usually carry various types)
+  yat::Container * c[3];
+  c[0] = new yat::GenericContainer<Event>(Event());
+  c[1] = new yat::GenericContainer<double>(1.);
+  c[2] = new yat::GenericContainer<yat::uint32>(1);
+
+  volatile yat::uint32 sink = 0;
+  yat::Timer t;
+
+  //- dispatch on payload type using RTTI
+  t.restart();
+  for (size_t i = 0; i < n; i++)
+  {
+    yat::Container * ci = c[i % 3];
+    if (Event * e = rtti_get_data<Event>(ci))
+      sink += e->number;
+    else if (double * d = rtti_get_data<double>(ci))
+      sink += static_cast<yat::uint32>(*d);
+    else if (yat::uint32 * u = rtti_get_data<yat::uint32>(ci))
+      sink += *u;
+  }
+  report("dispatch [dynamic_cast]", t.elapsed_usec(), n);
+
+  //- dispatch on payload type using type tags
+  t.restart();
+  for (size_t i = 0; i < n; i++)
+  {
+    yat::Container * ci = c[i % 3];
+    if (Event * e = tag_get_data<Event>(ci))
+      sink += e->number;
+    else if (double * d = tag_get_data<double>(ci))
+      sink += static_cast<yat::uint32>(*d);
+    else if (yat::uint32 * u = tag_get_data<yat::uint32>(ci))
+      sink += *u;
+  }
+  report("dispatch [type tags].....", t.elapsed_usec(), n);
+
+  //- Message::get_data (payload of the expected type)
+  yat::Message * m = new yat::Message(yat::FIRST_USER_MSG);
+  m->attach_data(yat::uint32(1));
+  t.restart();
+  for (size_t i = 0; i < n; i++)
+    sink += m->get_data<yat::uint32>();
+  report("Message::get_data........", t.elapsed_usec(), n);
+  m->release();
+
+  for (size_t i = 0; i < 3; i++)
+    delete c[i];
+
+  return 0;
+}
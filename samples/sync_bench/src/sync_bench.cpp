@@ -0,0 +1,259 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2004-2021 Synchrotron SOLEIL
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the GNU Lesser Public License v3
+// which accompanies this distribution, and is available at
+// http://www.gnu.org/licenses/lgpl.html
+//----------------------------------------------------------------------------
+/*!
+ * \file
+ * \brief    yat synchronization primitives microbenchmark (contended access)
+ * \author   See AUTHORS file
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <yat/time/Timer.h>
+#include <yat/threading/Atomic.h>
+#include <yat/threading/Message.h>
+#include <yat/threading/ReadersWriterMutex.h>
+#include <yat/threading/SeqLocked.h>
+#include <yat/threading/Published.h>
+#include <yat/threading/SyncAccess.h>
+#include <yat/utils/Signal.h>
+#include <yat/utils/Callback.h>
+#include <yat/memory/SharedPtr.h>
+
+//-----------------------------------------------------------------------------
+// a benchmarked operation: executes <loops> times the operation on <arg>
+//-----------------------------------------------------------------------------
+typedef void (*BenchFunc) (void * arg, size_t index, size_t loops);
+
+//-----------------------------------------------------------------------------
+// a thread running a benchmarked operation
+//-----------------------------------------------------------------------------
+class BenchThread : public yat::Thread
+{
+public:
+  BenchThread (BenchFunc f, void * arg, size_t index, size_t loops)
+    : func_(f), arg_(arg), index_(index), loops_(loops)
+  {}
+
+  virtual void exit ()
+  {
+    yat::Thread::IOArg dummy = 0;
+    this->join(&dummy);
+  }
+
+protected:
+  virtual yat::Thread::IOArg run_undetached (yat::Thread::IOArg)
+  {
+    func_(arg_, index_, loops_);
+    return 0;
+  }
+
+private:
+  BenchFunc func_;
+  void * arg_;
+  size_t index_;
+  size_t loops_;
+};
+
+//-----------------------------------------------------------------------------
+// runs the operation from <n> threads and prints the time per operation
+//-----------------------------------------------------------------------------
+void run (const char * what, BenchFunc f, void * arg, size_t n, size_t loops)
+{
+  std::vector<BenchThread *> threads;
+  yat::Timer t;
+  for (size_t i = 0; i < n; i++)
+  {
+    threads.push_back(new BenchThread(f, arg, i, loops));
+    threads.back()->start_undetached();
+  }
+  for (size_t i = 0; i < n; i++)
+    threads[i]->exit();
+  std::cout << what
+            << ": "
+            << (t.elapsed_usec() * 1000.) / (n * loops)
+            << " nsecs per op ("
+            << n
+            << " thread(s))"
+            << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+// the benchmarked operations
+//-----------------------------------------------------------------------------
+struct Position
+{
+  yat::uint64 x, y, z;
+};
+
+struct Observer
+{
+  Observer () : sum(0) {}
+  void on_value (int v) { sum += v; }
+  yat::atomic_int sum;
+};
+
+typedef yat::Signal<int, yat::Mutex> IntSignal;
+
+YAT_DEFINE_CALLBACK(IntCallback, int);
+
+void atomic_increment (void * arg, size_t, size_t loops)
+{
+  yat::atomic_uint64 * counter = static_cast<yat::atomic_uint64 *>(arg);
+  for (size_t i = 0; i < loops; i++)
+    ++(*counter);
+}
+
+void msg_duplicate_release (void * arg, size_t, size_t loops)
+{
+  yat::Message * m = static_cast<yat::Message *>(arg);
+  for (size_t i = 0; i < loops; i++)
+  {
+    m->duplicate();
+    m->release();
+  }
+}
+
+void rw_read_lock (void * arg, size_t, size_t loops)
+{
+  yat::ReadersWriterMutex * rw = static_cast<yat::ReadersWriterMutex *>(arg);
+  for (size_t i = 0; i < loops; i++)
+  {
+    rw->lock_for_reading();
+    rw->unlock_for_reading();
+  }
+}
+
+yat::Mutex position_lock;
+Position position = { 0, 0, 0 };
+
+void mutex_read (void *, size_t, size_t loops)
+{
+  volatile yat::uint64 sink = 0;
+  for (size_t i = 0; i < loops; i++)
+  {
+    yat::MutexLock guard(position_lock);
+    sink += position.x;
+  }
+}
+
+void seqlocked_read (void * arg, size_t, size_t loops)
+{
+  yat::SeqLocked<Position> * p = static_cast<yat::SeqLocked<Position> *>(arg);
+  volatile yat::uint64 sink = 0;
+  for (size_t i = 0; i < loops; i++)
+    sink += p->load().x;
+}
+
+void published_read (void * arg, size_t, size_t loops)
+{
+  yat::Published<Position> * p = static_cast<yat::Published<Position> *>(arg);
+  volatile yat::uint64 sink = 0;
+  for (size_t i = 0; i < loops; i++)
+    sink += yat::Published<Position>::Snapshot(*p)->x;
+}
+
+void sync_access_distinct (void * arg, size_t index, size_t loops)
+{
+  //- one object per thread (on its own cache line)
+  yat::uint64 * obj = static_cast<yat::uint64 *>(arg) + 8 * index;
+  for (size_t i = 0; i < loops; i++)
+  {
+    yat::SyncAccess guard(obj);
+    ++(*obj);
+  }
+}
+
+void signal_run (void * arg, size_t, size_t loops)
+{
+  IntSignal * s = static_cast<IntSignal *>(arg);
+  for (size_t i = 0; i < loops; i++)
+    s->run(1);
+}
+
+void callback_copy_call (void * arg, size_t, size_t loops)
+{
+  IntCallback * cb = static_cast<IntCallback *>(arg);
+  for (size_t i = 0; i < loops; i++)
+  {
+    IntCallback c(*cb);
+    c(1);
+  }
+}
+
+void callback_ref_call (void * arg, size_t, size_t loops)
+{
+  yat::CallbackRef<int> * cb = static_cast<yat::CallbackRef<int> *>(arg);
+  for (size_t i = 0; i < loops; i++)
+    (*cb)(1);
+}
+
+template <typename L> void shared_ptr_copy (void * arg, size_t, size_t loops)
+{
+  yat::SharedPtr<int, L> * p = static_cast<yat::SharedPtr<int, L> *>(arg);
+  for (size_t i = 0; i < loops; i++)
+  {
+    yat::SharedPtr<int, L> copy(*p);
+    yat::WeakPtr<int, L> w(copy);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// MAIN
+//-----------------------------------------------------------------------------
+int main (int argc, char* argv[])
+{
+  size_t n = 4;
+  if (argc > 1)
+    n = static_cast<size_t>(::atol(argv[1]));
+  size_t loops = 250000;
+  if (argc > 2)
+    loops = static_cast<size_t>(::atol(argv[2]));
+
+  yat::atomic_uint64 counter;
+  run("Atomic increment..............", atomic_increment, &counter, n, loops);
+
+  yat::Message * m = new yat::Message(yat::FIRST_USER_MSG);
+  run("Message duplicate/release.....", msg_duplicate_release, m, n, loops);
+  m->release();
+
+  yat::ReadersWriterMutex rw_shared(yat::ReadersWriterMutex::RW_SHARED_COUNTER);
+  run("read lock [shared counter]....", rw_read_lock, &rw_shared, n, loops);
+  yat::ReadersWriterMutex rw_per_core(yat::ReadersWriterMutex::RW_PER_CORE_COUNTERS);
+  run("read lock [per-core counters].", rw_read_lock, &rw_per_core, n, loops);
+
+  yat::SeqLocked<Position> seqlocked;
+  yat::Published<Position> published;
+  run("read [Mutex]..................", mutex_read, 0, n, loops);
+  run("read [SeqLocked]..............", seqlocked_read, &seqlocked, n, loops);
+  run("read [Published]..............", published_read, &published, n, loops);
+
+  std::vector<yat::uint64> objs(8 * n, 0);
+  run("SyncAccess [distinct objects].", sync_access_distinct, &objs[0], n, loops);
+
+  Observer o;
+  IntSignal s;
+  s.connect(IntSignal::Slot::instanciate(o, &Observer::on_value));
+  run("Signal::run...................", signal_run, &s, n, loops);
+
+  //- single threaded
+  Observer co;
+  IntCallback cb = IntCallback::instanciate(co, &Observer::on_value);
+  run("Callback copy+call............", callback_copy_call, &cb, 1, loops);
+  yat::CallbackRef<int> ref = yat::CallbackRef<int>::bind<Observer, &Observer::on_value>(co);
+  run("CallbackRef call..............", callback_ref_call, &ref, 1, loops);
+
+  yat::SharedPtr<int, yat::Mutex> mp(new int(0));
+  run("SharedPtr copy [Mutex]........", shared_ptr_copy<yat::Mutex>, &mp, n, loops);
+#if defined (YAT_CPP11)
+  yat::SharedPtr<int, yat::AtomicCount> ap(new int(0));
+  run("SharedPtr copy [AtomicCount]..", shared_ptr_copy<yat::AtomicCount>, &ap, n, loops);
+#endif
+
+  return 0;
+}
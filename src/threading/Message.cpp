@@ -41,7 +41,12 @@
 // DEPENDENCIES
 // ============================================================================
 #include <yat/threading/Message.h>
+#include <yat/time/Timer.h>
 #include <iostream>
+#include <vector>
+#if defined (YAT_CPP11)
+# include <atomic>
+#endif
 
 #if !defined (YAT_INLINE_IMPL)
 # include <yat/threading/Message.i>
@@ -50,11 +55,383 @@
 namespace yat
 {
 // ============================================================================
-// Message::cache
+// MsgBlockHeader: header of each block allocated by Message::operator new
+// ============================================================================
+union MsgBlockHeader
+{
+  struct
+  {
+    //- the pool the block belongs to (0 for a non pooled block)
+    void * pool;
+    //- next free block (pool free lists)
+    MsgBlockHeader * next;
+  } h;
+  //- preserves the alignment of the msg
+  long double align;
+};
+
+#if defined (YAT_CPP11)
+
+// ============================================================================
+// MsgPool: per-thread message pool
+// ============================================================================
+struct MsgPool
+{
+  MsgPool ()
+    : local_free (0), local_count (0), remote_free (0), remote_count (0),
+      hits (0), misses (0), remote_frees (0), next_orphan (0)
+  {}
+
+  //- free blocks (owner thread only)
+  MsgBlockHeader * local_free;
+  size_t local_count;
+
+  //- blocks released by other threads (lock-free stack, taken at once by the owner)
+  std::atomic<MsgBlockHeader *> remote_free;
+
+  //- blocks in <remote_free> (upper bound: incremented before each push) - the
+  //- blocks released beyond kMSG_POOL_CAPACITY go back to the heap, so that a
+  //- pool with no owner (exited thread) can't grow without bound
+  std::atomic<size_t> remote_count;
+
+  //- stats (<hits> & <misses> are only written by the owner thread)
+  std::atomic<unsigned long> hits;
+  std::atomic<unsigned long> misses;
+  std::atomic<unsigned long> remote_frees;
+
+  //- next pool in the orphan pools list
+  MsgPool * next_orphan;
+};
+
+// ============================================================================
+// MsgPoolRegistry: all the pools ever created
+// ============================================================================
+struct MsgPoolRegistry
+{
+  MsgPoolRegistry () : orphans (0) {}
+
+  //- protects the registry
+  Mutex lock;
+
+  //- pools are never destroyed (blocks may be released after their owner exited)
+  std::vector<MsgPool *> pools;
+
+  //- pools of exited threads (adopted by the next new threads)
+  MsgPool * orphans;
+
+  //- stats at last reset
+  Message::PoolStatistics base;
+};
+
+static MsgPoolRegistry & msg_pool_registry ()
+{
+  //- intentionally leaked (msgs may be released during the static objects destruction)
+  static MsgPoolRegistry * r = new MsgPoolRegistry;
+  return *r;
+}
+
+//- pools enabled?
+static std::atomic<bool> msg_pool_enabled (false);
+
+//- the pool of the current thread
+static thread_local MsgPool * tls_msg_pool = 0;
+
+//- true once the current thread released its pool (i.e. the thread is exiting)
+static thread_local bool tls_msg_pool_released = false;
+
+// ============================================================================
+// take_remote_free_blocks: gets the blocks released by the other threads
+// ============================================================================
+static MsgBlockHeader * take_remote_free_blocks (MsgPool * pool, size_t & count)
+{
+  MsgBlockHeader * blocks = pool->remote_free.exchange(0, std::memory_order_acquire);
+  count = 0;
+  for (MsgBlockHeader * b = blocks; b; b = b->h.next)
+    count++;
+  pool->remote_count.fetch_sub(count, std::memory_order_relaxed);
+  return blocks;
+}
+
+// ============================================================================
+// MsgPoolHolder: gives the pool of an exiting thread back to the registry
+// ============================================================================
+struct MsgPoolHolder
+{
+  ~MsgPoolHolder ()
+  {
+    MsgPool * pool = tls_msg_pool;
+    tls_msg_pool = 0;
+    tls_msg_pool_released = true;
+    if (! pool)
+      return;
+
+    //- release the cached blocks
+    while (pool->local_free)
+    {
+      MsgBlockHeader * b = pool->local_free;
+      pool->local_free = b->h.next;
+      ::operator delete(b);
+    }
+    pool->local_count = 0;
+
+    //- ... and the ones already released by the other threads
+    size_t count = 0;
+    MsgBlockHeader * remote = take_remote_free_blocks(pool, count);
+    while (remote)
+    {
+      MsgBlockHeader * b = remote;
+      remote = b->h.next;
+      ::operator delete(b);
+    }
+
+    //- the pool can now be adopted by a new thread
+    MsgPoolRegistry & r = msg_pool_registry();
+    MutexLock guard(r.lock);
+    pool->next_orphan = r.orphans;
+    r.orphans = pool;
+  }
+};
+
+static thread_local MsgPoolHolder tls_msg_pool_holder;
+
+// ============================================================================
+// current_msg_pool: returns the pool of the current thread (0 if none)
+// ============================================================================
+static MsgPool * current_msg_pool ()
+{
+  MsgPool * pool = tls_msg_pool;
+  if (pool || tls_msg_pool_released)
+    return pool;
+
+  { //- critical section
+    MsgPoolRegistry & r = msg_pool_registry();
+    MutexLock guard(r.lock);
+    if (r.orphans)
+    {
+      //- adopt the pool of an exited thread
+      pool = r.orphans;
+      r.orphans = pool->next_orphan;
+      pool->next_orphan = 0;
+    }
+    else
+    {
+      pool = new (std::nothrow) MsgPool;
+      if (! pool)
+        return 0;
+      try
+      {
+        r.pools.push_back(pool);
+      }
+      catch (...)
+      {
+        delete pool;
+        return 0;
+      }
+    }
+  }
+
+  //- make sure the pool is given back on thread exit
+  (void)&tls_msg_pool_holder;
+  tls_msg_pool = pool;
+
+  return pool;
+}
+
+#endif // YAT_CPP11
+
+// ============================================================================
+// Message::PoolStatistics::PoolStatistics
+// ============================================================================
+Message::PoolStatistics::PoolStatistics ()
+  : hits_ (0),
+    misses_ (0),
+    remote_frees_ (0)
+{
+  /* noop ctor */
+}
+
+// ============================================================================
+// Message::operator new
+// ============================================================================
+void * Message::operator new (size_t _size)
+{
+  void * p = Message::operator new(_size, std::nothrow);
+  if (! p)
+    throw std::bad_alloc();
+  return p;
+}
+
+// ============================================================================
+// Message::operator new
+// ============================================================================
+void * Message::operator new (size_t _size, const std::nothrow_t &) throw()
+{
+  MsgBlockHeader * b = 0;
+
+#if defined (YAT_CPP11)
+  //- pools only hold yat::Message sized blocks (i.e. not derived classes)
+  if (_size == sizeof(Message) && msg_pool_enabled.load(std::memory_order_relaxed))
+  {
+    MsgPool * pool = current_msg_pool();
+    if (pool)
+    {
+      //- local free list empty: get the blocks released by the other threads
+      if (! pool->local_free && pool->remote_free.load(std::memory_order_relaxed))
+      {
+        size_t count = 0;
+        pool->local_free = take_remote_free_blocks(pool, count);
+        pool->local_count += count;
+      }
+      b = pool->local_free;
+      if (b)
+      {
+        pool->local_free = b->h.next;
+        pool->local_count--;
+        pool->hits.store(pool->hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return b + 1;
+      }
+      pool->misses.store(pool->misses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      b = static_cast<MsgBlockHeader *>(::operator new(sizeof(MsgBlockHeader) + _size, std::nothrow));
+      if (! b)
+        return 0;
+      b->h.pool = pool;
+      return b + 1;
+    }
+  }
+#endif
+
+  b = static_cast<MsgBlockHeader *>(::operator new(sizeof(MsgBlockHeader) + _size, std::nothrow));
+  if (! b)
+    return 0;
+  b->h.pool = 0;
+  return b + 1;
+}
+
+// ============================================================================
+// Message::operator delete
+// ============================================================================
+void Message::operator delete (void * p)
+{
+  if (! p)
+    return;
+
+  MsgBlockHeader * b = static_cast<MsgBlockHeader *>(p) - 1;
+
+#if defined (YAT_CPP11)
+  MsgPool * owner = static_cast<MsgPool *>(b->h.pool);
+  if (owner && msg_pool_enabled.load(std::memory_order_relaxed))
+  {
+    if (owner == tls_msg_pool)
+    {
+      //- local free: keep the block (unless the pool is full)
+      if (owner->local_count < kMSG_POOL_CAPACITY)
+      {
+        b->h.next = owner->local_free;
+        owner->local_free = b;
+        owner->local_count++;
+        return;
+      }
+    }
+    //- remote free: give the block back to its pool (lock-free push) unless
+    //- the pool already holds enough remotely released blocks
+    else if (owner->remote_count.fetch_add(1, std::memory_order_relaxed) < kMSG_POOL_CAPACITY)
+    {
+      b->h.next = owner->remote_free.load(std::memory_order_relaxed);
+      while (! owner->remote_free.compare_exchange_weak(b->h.next, b,
+                                                        std::memory_order_release,
+                                                        std::memory_order_relaxed))
+        ;
+      owner->remote_frees.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    else
+    {
+      owner->remote_count.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+#endif
+
+  ::operator delete(b);
+}
+
+// ============================================================================
+// Message::operator delete
+// ============================================================================
+void Message::operator delete (void * p, const std::nothrow_t &) throw()
+{
+  Message::operator delete(p);
+}
+
+// ============================================================================
+// Message::enable_pool
+// ============================================================================
+void Message::enable_pool (bool _enable)
+{
+#if defined (YAT_CPP11)
+  msg_pool_enabled.store(_enable);
+#else
+  (void)_enable;
+#endif
+}
+
+// ============================================================================
+// Message::pool_enabled
 // ============================================================================
-#if defined(_USE_MSG_CACHE_)
-  Message::Cache  Message::m_cache;
+bool Message::pool_enabled ()
+{
+#if defined (YAT_CPP11)
+  return msg_pool_enabled.load();
+#else
+  return false;
 #endif
+}
+
+#if defined (YAT_CPP11)
+// ============================================================================
+// msg_pool_totals: sums the stats of all the pools
+// ============================================================================
+static Message::PoolStatistics msg_pool_totals (const MsgPoolRegistry & r)
+{
+  //- <r.lock> MUST be locked by the calling thread
+  Message::PoolStatistics s;
+  for (size_t i = 0; i < r.pools.size(); i++)
+  {
+    s.hits_ += r.pools[i]->hits.load(std::memory_order_relaxed);
+    s.misses_ += r.pools[i]->misses.load(std::memory_order_relaxed);
+    s.remote_frees_ += r.pools[i]->remote_frees.load(std::memory_order_relaxed);
+  }
+  return s;
+}
+#endif
+
+// ============================================================================
+// Message::pool_statistics
+// ============================================================================
+Message::PoolStatistics Message::pool_statistics ()
+{
+  Message::PoolStatistics s;
+#if defined (YAT_CPP11)
+  MsgPoolRegistry & r = msg_pool_registry();
+  MutexLock guard(r.lock);
+  s = msg_pool_totals(r);
+  s.hits_ -= r.base.hits_;
+  s.misses_ -= r.base.misses_;
+  s.remote_frees_ -= r.base.remote_frees_;
+#endif
+  return s;
+}
+
+// ============================================================================
+// Message::reset_pool_statistics
+// ============================================================================
+void Message::reset_pool_statistics ()
+{
+#if defined (YAT_CPP11)
+  MsgPoolRegistry & r = msg_pool_registry();
+  MutexLock guard(r.lock);
+  r.base = msg_pool_totals(r);
+#endif
+}
 
 // ============================================================================
 // Message::msg_counter
@@ -108,7 +485,16 @@ Message::Message ()
     msg_data_ (0),
     has_error_ (false),
     cond_ (0),
-    size_in_bytes_ (sizeof(yat::Message))
+    size_in_bytes_ (sizeof(yat::Message)),
+    inline_data_ (false),
+    post_time_ns_ (0),
+    inbox_next_ (0),
+    reply_data_ (0),
+    reply_cb_ (0),
+    future_refs_ (0),
+    reply_expected_ (false),
+    replied_ (false),
+    released_ (false)
 #if defined (YAT_DEBUG)
     , id_ (++Message::msg_counter)
 #endif
@@ -132,7 +518,16 @@ Message::Message (size_t _msg_type, size_t _msg_priority, bool _waitable)
     msg_data_ (0),
     has_error_ (false),
     cond_ (0),
-    size_in_bytes_ (sizeof(yat::Message))
+    size_in_bytes_ (sizeof(yat::Message)),
+    inline_data_ (false),
+    post_time_ns_ (0),
+    inbox_next_ (0),
+    reply_data_ (0),
+    reply_cb_ (0),
+    future_refs_ (0),
+    reply_expected_ (false),
+    replied_ (false),
+    released_ (false)
 #if defined (YAT_DEBUG)
     , id_ (++Message::msg_counter)
 #endif
@@ -160,11 +555,13 @@ Message::~Message ()
   YAT_LOG("Message::~Message::dtor_counter: " << Message::dtor_counter);
 #endif
 
-  if (this->msg_data_)
-  {
-    delete this->msg_data_;
-    this->msg_data_ = 0;
-  }
+  this->release_data_i();
+
+  delete this->reply_data_;
+  this->reply_data_ = 0;
+
+  delete this->reply_cb_;
+  this->reply_cb_ = 0;
 
   if (this->cond_)
   {
@@ -197,6 +594,15 @@ const char * Message::to_string () const
     case TASK_EXIT:
       return "TASK_EXIT";
       break;
+    case PIPELINE_ITEM_MSG:
+      return "PIPELINE_ITEM_MSG";
+      break;
+    case PIPELINE_FLUSH_MSG:
+      return "PIPELINE_FLUSH_MSG";
+      break;
+    case SIGNAL_EMISSION_MSG:
+      return "SIGNAL_EMISSION_MSG";
+      break;
   }
   return "UNKNOWN OR USER DEFINED MSG";
 }
@@ -247,5 +653,161 @@ void Message::make_waitable ()
   }
 }
 
-} // namespace
+// ============================================================================
+// MsgReplySync: mutex/condition pair shared by the request/reply messages
+// ============================================================================
+struct MsgReplySync
+{
+  MsgReplySync ()
+    : cond (lock)
+  {}
 
+  Mutex lock;
+  Condition cond;
+};
+
+static MsgReplySync & msg_reply_sync (const Message * _msg)
+{
+  //- intentionally leaked (msgs may be released during the static objects destruction)
+  static MsgReplySync * stripes = new MsgReplySync[kMSG_REPLY_SYNC_STRIPES];
+  //- drop the (always null) low order bits of the msg address
+  size_t h = reinterpret_cast<size_t>(_msg) >> 4;
+  h ^= h >> 7;
+  return stripes[h % kMSG_REPLY_SYNC_STRIPES];
+}
+
+// ============================================================================
+// Message::attach_future_i
+// ============================================================================
+void Message::attach_future_i ()
+{
+  MsgReplySync & s = msg_reply_sync(this);
+  MutexLock guard(s.lock);
+  this->future_refs_++;
+}
+
+// ============================================================================
+// Message::detach_future_i
+// ============================================================================
+void Message::detach_future_i ()
+{
+  bool last_ref = false;
+  {
+    MsgReplySync & s = msg_reply_sync(this);
+    MutexLock guard(s.lock);
+    this->future_refs_--;
+    last_ref = this->released_ && this->future_refs_ == 0;
+  }
+  if (last_ref)
+    delete this;
+}
+
+// ============================================================================
+// Message::reply_completed_i
+// ============================================================================
+bool Message::reply_completed_i ()
+{
+  MsgReplySync & s = msg_reply_sync(this);
+  MutexLock guard(s.lock);
+  return this->replied_;
+}
+
+// ============================================================================
+// Message::wait_reply_i
+// ============================================================================
+bool Message::wait_reply_i (size_t _tmo_msecs)
+{
+  MsgReplySync & s = msg_reply_sync(this);
+  MutexLock guard(s.lock);
+
+  if (! _tmo_msecs)
+  {
+    while (! this->replied_)
+      s.cond.wait();
+    return true;
+  }
+
+  //- the condition is shared: loop till our own request is completed
+  yat::Timer t;
+  while (! this->replied_)
+  {
+    double remaining_msecs = static_cast<double>(_tmo_msecs) - t.elapsed_msec();
+    if (remaining_msecs <= 0.)
+      return false;
+    s.cond.timed_wait(static_cast<unsigned long>(remaining_msecs) + 1);
+  }
+  return true;
+}
+
+// ============================================================================
+// Message::on_reply_i
+// ============================================================================
+void Message::on_reply_i (const ReplyCallback & _cb)
+{
+  {
+    MsgReplySync & s = msg_reply_sync(this);
+    MutexLock guard(s.lock);
+    if (! this->replied_)
+    {
+      if (this->reply_cb_)
+        *this->reply_cb_ = _cb;
+      else
+        this->reply_cb_ = new ReplyCallback(_cb);
+      return;
+    }
+  }
+  //- already completed: call the callback from the calling thread
+  ReplyCallback cb(_cb);
+  cb(*this);
+}
+
+// ============================================================================
+// Message::complete_reply_i
+// ============================================================================
+void Message::complete_reply_i ()
+{
+  ReplyCallback * cb = 0;
+  {
+    MsgReplySync & s = msg_reply_sync(this);
+    MutexLock guard(s.lock);
+    if (this->replied_)
+      return;
+    this->replied_ = true;
+    cb = this->reply_cb_;
+    this->reply_cb_ = 0;
+    s.cond.broadcast();
+  }
+  if (cb)
+  {
+    try
+    {
+      (*cb)(*this);
+    }
+    catch (...)
+    {
+      //- ignore callback errors
+    }
+    delete cb;
+  }
+}
+
+// ============================================================================
+// Message::release_reply_i
+// ============================================================================
+void Message::release_reply_i ()
+{
+  //- dropped request (not handled): complete it anyway
+  this->complete_reply_i();
+
+  bool last_ref = false;
+  {
+    MsgReplySync & s = msg_reply_sync(this);
+    MutexLock guard(s.lock);
+    this->released_ = true;
+    last_ref = this->future_refs_ == 0;
+  }
+  if (last_ref)
+    delete this;
+}
+
+} // namespace
@@ -42,8 +42,11 @@
 // ============================================================================
 #include <cstring>
 #include <iostream>
+#include <iomanip>
 #include <math.h>
-#include <algorithm>
+#if ! defined (YAT_WIN32)
+# include <time.h>
+#endif
 #include <yat/CommonHeader.h>
 #include <yat/threading/Utilities.h>
 #include <yat/threading/MessageQ.h>
@@ -53,6 +56,11 @@
 // ============================================================================
 #define MAX_NSECS 1000000000
 #define MAX_USECS 1000000
+#define MAX_PRIORITY_VALUE HIGHEST_MSG_PRIORITY
+#define PRIORITIES_PER_PAGE 256
+#define TYPE_INDEX_MASK 63
+#define LATENCY_SUB_BUCKET_BITS 3
+#define LATENCY_EXACT_VALUES 16
 
 #if !defined (YAT_INLINE_IMPL)
 # include <yat/threading/MessageQ.i>
@@ -61,6 +69,275 @@
 namespace yat
 {
 
+// ============================================================================
+// highest_bit: index of the most significant bit set in <v> (v must be != 0)
+// ============================================================================
+static inline size_t highest_bit (yat::uint64 v)
+{
+#if defined (__GNUC__)
+  return 63 - static_cast<size_t>(__builtin_clzll(v));
+#else
+  size_t n = 0;
+  if (v & 0xFFFFFFFF00000000ULL) { v >>= 32; n += 32; }
+  if (v & 0x00000000FFFF0000ULL) { v >>= 16; n += 16; }
+  if (v & 0x000000000000FF00ULL) { v >>= 8;  n += 8;  }
+  if (v & 0x00000000000000F0ULL) { v >>= 4;  n += 4;  }
+  if (v & 0x000000000000000CULL) { v >>= 2;  n += 2;  }
+  if (v & 0x0000000000000002ULL) { n += 1; }
+  return n;
+#endif
+}
+
+// ============================================================================
+// highest_bit: index of the most significant bit set in a 256 bits bitmap
+// ============================================================================
+static inline size_t highest_bit (const yat::uint64 * bits)
+{
+  for (size_t i = 4; i-- > 0;)
+  {
+    if (bits[i])
+      return 64 * i + highest_bit(bits[i]);
+  }
+  DEBUG_ASSERT(false);
+  return 0;
+}
+
+// ============================================================================
+// MessageQ::MessageQImpl::MessageQImpl
+// ============================================================================
+MessageQ::MessageQImpl::MessageQImpl ()
+  : free_nodes_ (0),
+    size_ (0)
+{
+  ::memset(this->pages_, 0, sizeof(this->pages_));
+  ::memset(this->page_bits_, 0, sizeof(this->page_bits_));
+  ::memset(this->types_, 0, sizeof(this->types_));
+}
+
+// ============================================================================
+// MessageQ::MessageQImpl::~MessageQImpl
+// ============================================================================
+MessageQ::MessageQImpl::~MessageQImpl ()
+{
+  //- msgs are owned (and released) by the MessageQ: only free the storage
+  while (this->size_)
+    this->pop_front();
+
+  while (this->free_nodes_)
+  {
+    Node * n = this->free_nodes_;
+    this->free_nodes_ = n->next;
+    delete n;
+  }
+
+  for (size_t i = 0; i < PRIORITIES_PER_PAGE; i++)
+    delete this->pages_[i];
+}
+
+// ============================================================================
+// MessageQ::MessageQImpl::push
+// ============================================================================
+void MessageQ::MessageQImpl::push (Message * _msg)
+{
+  size_t prio = _msg->priority();
+  if (prio > MAX_PRIORITY_VALUE)
+    prio = MAX_PRIORITY_VALUE;
+
+  //- get the page of the msg priority (allocate it on first use)
+  size_t pg_idx = prio / PRIORITIES_PER_PAGE;
+  Page * pg = this->pages_[pg_idx];
+  if (! pg)
+  {
+    pg = new Page;
+    ::memset(pg, 0, sizeof(Page));
+    this->pages_[pg_idx] = pg;
+  }
+
+  //- get a node (recycle a previously allocated one if possible)
+  Node * n = this->free_nodes_;
+  if (n)
+    this->free_nodes_ = n->next;
+  else
+    n = new Node;
+
+  n->msg = _msg;
+  n->prio = prio;
+  n->type = _msg->type();
+
+  //- append the node to its priority FIFO
+  size_t b_idx = prio % PRIORITIES_PER_PAGE;
+  Band & b = pg->bands[b_idx];
+  n->next = 0;
+  n->prev = b.tail;
+  if (b.tail)
+  {
+    b.tail->next = n;
+  }
+  else
+  {
+    b.head = n;
+    pg->bits[b_idx / 64] |= yat::uint64(1) << (b_idx % 64);
+    this->page_bits_[pg_idx / 64] |= yat::uint64(1) << (pg_idx % 64);
+  }
+  b.tail = n;
+
+  //- link the node into the msg type index
+  Node *& t = this->types_[n->type & TYPE_INDEX_MASK];
+  n->type_prev = 0;
+  n->type_next = t;
+  if (t)
+    t->type_prev = n;
+  t = n;
+
+  this->size_++;
+}
+
+// ============================================================================
+// MessageQ::MessageQImpl::top_priority
+// ============================================================================
+size_t MessageQ::MessageQImpl::top_priority () const
+{
+  size_t pg_idx = highest_bit(this->page_bits_);
+  return pg_idx * PRIORITIES_PER_PAGE + highest_bit(this->pages_[pg_idx]->bits);
+}
+
+// ============================================================================
+// MessageQ::MessageQImpl::front
+// ============================================================================
+Message * MessageQ::MessageQImpl::front () const
+{
+  DEBUG_ASSERT(this->size_ != 0);
+
+  size_t prio = this->top_priority();
+  return this->pages_[prio / PRIORITIES_PER_PAGE]->bands[prio % PRIORITIES_PER_PAGE].head->msg;
+}
+
+// ============================================================================
+// MessageQ::MessageQImpl::pop_front
+// ============================================================================
+void MessageQ::MessageQImpl::pop_front ()
+{
+  DEBUG_ASSERT(this->size_ != 0);
+
+  size_t prio = this->top_priority();
+  this->unlink(this->pages_[prio / PRIORITIES_PER_PAGE]->bands[prio % PRIORITIES_PER_PAGE].head);
+}
+
+// ============================================================================
+// MessageQ::MessageQImpl::remove
+// ============================================================================
+size_t MessageQ::MessageQImpl::remove (size_t _msg_type, std::vector<Message *> & removed_)
+{
+  size_t cnt = 0;
+
+  //- only walk the msgs sharing the index bucket of <_msg_type>
+  Node * n = this->types_[_msg_type & TYPE_INDEX_MASK];
+  while (n)
+  {
+    Node * next = n->type_next;
+    if (n->type == _msg_type)
+    {
+      removed_.push_back(n->msg);
+      this->unlink(n);
+      cnt++;
+    }
+    n = next;
+  }
+
+  return cnt;
+}
+
+// ============================================================================
+// MessageQ::MessageQImpl::find_last_node
+// ============================================================================
+MessageQ::MessageQImpl::Node * MessageQ::MessageQImpl::find_last_node (size_t _msg_type) const
+{
+  //- nodes are pushed at the head of their type index bucket: the first match is the last posted
+  Node * n = this->types_[_msg_type & TYPE_INDEX_MASK];
+  while (n && n->type != _msg_type)
+    n = n->type_next;
+  return n;
+}
+
+// ============================================================================
+// MessageQ::MessageQImpl::find_last
+// ============================================================================
+Message * MessageQ::MessageQImpl::find_last (size_t _msg_type) const
+{
+  Node * n = this->find_last_node(_msg_type);
+  return n ? n->msg : 0;
+}
+
+// ============================================================================
+// MessageQ::MessageQImpl::replace_last
+// ============================================================================
+Message * MessageQ::MessageQImpl::replace_last (Message * _msg)
+{
+  Node * n = this->find_last_node(_msg->type());
+  DEBUG_ASSERT(n != 0);
+
+  Message * replaced = n->msg;
+
+  size_t prio = _msg->priority();
+  if (prio > MAX_PRIORITY_VALUE)
+    prio = MAX_PRIORITY_VALUE;
+
+  //- same priority: the new msg takes the position of the pending one
+  if (prio == n->prio)
+  {
+    n->msg = _msg;
+    return replaced;
+  }
+
+  //- otherwise it is queued in its own priority band (push first: may throw)
+  this->push(_msg);
+  this->unlink(n);
+  return replaced;
+}
+
+// ============================================================================
+// MessageQ::MessageQImpl::unlink
+// ============================================================================
+void MessageQ::MessageQImpl::unlink (Node * n)
+{
+  size_t pg_idx = n->prio / PRIORITIES_PER_PAGE;
+  size_t b_idx = n->prio % PRIORITIES_PER_PAGE;
+  Page * pg = this->pages_[pg_idx];
+  Band & b = pg->bands[b_idx];
+
+  //- remove the node from its priority FIFO
+  if (n->prev)
+    n->prev->next = n->next;
+  else
+    b.head = n->next;
+  if (n->next)
+    n->next->prev = n->prev;
+  else
+    b.tail = n->prev;
+
+  //- update the bitmaps if the FIFO is now empty
+  if (! b.head)
+  {
+    pg->bits[b_idx / 64] &= ~(yat::uint64(1) << (b_idx % 64));
+    if (! (pg->bits[0] | pg->bits[1] | pg->bits[2] | pg->bits[3]))
+      this->page_bits_[pg_idx / 64] &= ~(yat::uint64(1) << (pg_idx % 64));
+  }
+
+  //- remove the node from the msg type index
+  if (n->type_prev)
+    n->type_prev->type_next = n->type_next;
+  else
+    this->types_[n->type & TYPE_INDEX_MASK] = n->type_next;
+  if (n->type_next)
+    n->type_next->type_prev = n->type_prev;
+
+  //- recycle the node
+  n->next = this->free_nodes_;
+  this->free_nodes_ = n;
+
+  this->size_--;
+}
+
 // ============================================================================
 // MessageQ::Stats::Stats
 // ============================================================================
@@ -73,6 +350,13 @@ namespace yat
     posted_without_waiting_msg_counter_ (0),
     trashed_msg_counter_ (0),
     trashed_on_post_tmo_counter_ (0),
+    coalesced_msg_counter_ (0),
+    consumer_parked_counter_ (0),
+    consumer_spun_counter_ (0),
+    consumer_woken_counter_ (0),
+    producer_woken_counter_ (0),
+    periodic_overrun_counter_ (0),
+    periodic_jitter_ (),
     pending_charge_ (0),
     pending_mgs_ (0),
     wm_unit_ (MessageQ::NUM_OF_MSGS)
@@ -124,6 +408,22 @@ void MessageQ::Statistics::dump (std::ostream& out) const
             << this->trashed_msg_counter_
             << std::endl;
 
+  out << "MessageQ::statistics::coalesced msgs................"
+            << this->coalesced_msg_counter_
+            << std::endl;
+
+  out << "MessageQ::statistics::consumer parked/spun/woken....."
+            << this->consumer_parked_counter_
+            << "/"
+            << this->consumer_spun_counter_
+            << "/"
+            << this->consumer_woken_counter_
+            << std::endl;
+
+  out << "MessageQ::statistics::producer woken................"
+            << this->producer_woken_counter_
+            << std::endl;
+
   out << "MessageQ::statistics::pending charge................."
             << this->pending_charge_
             << " bytes"
@@ -137,19 +437,229 @@ void MessageQ::Statistics::dump (std::ostream& out) const
   unsigned long total_msg = this->posted_with_waiting_msg_counter_
                           + this->posted_without_waiting_msg_counter_
                           + this->trashed_msg_counter_
-                          + this->trashed_on_post_tmo_counter_;
+                          + this->trashed_on_post_tmo_counter_
+                          + this->coalesced_msg_counter_;
 
   out << "MessageQ::statistics::total msg....................."
             << total_msg
             << std::endl;
+
+  this->latency_.queue_wait_.dump(out, "queue wait [all msgs]");
+  this->latency_.handling_.dump(out, "handling [all msgs]");
+
+  std::map<size_t, MsgLatency>::const_iterator it = this->latency_per_msg_type_.begin();
+  for (; it != this->latency_per_msg_type_.end(); ++it)
+  {
+    std::ostringstream oss;
+    oss << "[msg type " << it->first << "]";
+    it->second.queue_wait_.dump(out, "queue wait " + oss.str());
+    it->second.handling_.dump(out, "handling " + oss.str());
+  }
+
+  if (this->periodic_jitter_.count_)
+  {
+    out << "MessageQ::statistics::periodic overruns............."
+              << this->periodic_overrun_counter_
+              << std::endl;
+
+    this->periodic_jitter_.dump(out, "periodic jitter");
+  }
+}
+
+// ============================================================================
+// latency_bucket: index of the LatencyHistogram bucket of <v>
+// ============================================================================
+static inline size_t latency_bucket (yat::uint64 v)
+{
+  if (v < LATENCY_EXACT_VALUES)
+    return static_cast<size_t>(v);
+  size_t e = highest_bit(v);
+  size_t sub = static_cast<size_t>(v >> (e - LATENCY_SUB_BUCKET_BITS)) & ((1 << LATENCY_SUB_BUCKET_BITS) - 1);
+  return LATENCY_EXACT_VALUES + ((e - 4) << LATENCY_SUB_BUCKET_BITS) + sub;
+}
+
+// ============================================================================
+// latency_bucket_upper_bound: highest value of the LatencyHistogram bucket <b>
+// ============================================================================
+static inline yat::uint64 latency_bucket_upper_bound (size_t b)
+{
+  if (b < LATENCY_EXACT_VALUES)
+    return b;
+  size_t e = 4 + ((b - LATENCY_EXACT_VALUES) >> LATENCY_SUB_BUCKET_BITS);
+  yat::uint64 sub = (b - LATENCY_EXACT_VALUES) & ((1 << LATENCY_SUB_BUCKET_BITS) - 1);
+  yat::uint64 width = static_cast<yat::uint64>(1) << (e - LATENCY_SUB_BUCKET_BITS);
+  return ((static_cast<yat::uint64>(1 << LATENCY_SUB_BUCKET_BITS) + sub) * width) + (width - 1);
+}
+
+// ============================================================================
+// MessageQ::LatencyHistogram::LatencyHistogram
+// ============================================================================
+MessageQ::LatencyHistogram::LatencyHistogram ()
+  : count_ (0), min_ (0), max_ (0), sum_ (0.), buckets_ (0)
+{
+  //- noop
+}
+
+// ============================================================================
+// MessageQ::LatencyHistogram::LatencyHistogram
+// ============================================================================
+MessageQ::LatencyHistogram::LatencyHistogram (const LatencyHistogram & h)
+  : count_ (0), min_ (0), max_ (0), sum_ (0.), buckets_ (0)
+{
+  *this = h;
+}
+
+// ============================================================================
+// MessageQ::LatencyHistogram::~LatencyHistogram
+// ============================================================================
+MessageQ::LatencyHistogram::~LatencyHistogram ()
+{
+  delete[] this->buckets_;
+}
+
+// ============================================================================
+// MessageQ::LatencyHistogram::operator=
+// ============================================================================
+MessageQ::LatencyHistogram & MessageQ::LatencyHistogram::operator= (const LatencyHistogram & h)
+{
+  if (this == &h)
+    return *this;
+
+  this->count_ = h.count_;
+  this->min_ = h.min_;
+  this->max_ = h.max_;
+  this->sum_ = h.sum_;
+
+  if (h.buckets_)
+  {
+    this->reserve();
+    ::memcpy(this->buckets_, h.buckets_, kLATENCY_HISTOGRAM_BUCKETS * sizeof(yat::uint64));
+  }
+  else if (this->buckets_)
+  {
+    ::memset(this->buckets_, 0, kLATENCY_HISTOGRAM_BUCKETS * sizeof(yat::uint64));
+  }
+
+  return *this;
+}
+
+// ============================================================================
+// MessageQ::LatencyHistogram::reserve
+// ============================================================================
+void MessageQ::LatencyHistogram::reserve ()
+{
+  if (! this->buckets_)
+    this->buckets_ = new yat::uint64[kLATENCY_HISTOGRAM_BUCKETS]();
+}
+
+// ============================================================================
+// MessageQ::LatencyHistogram::reset
+// ============================================================================
+void MessageQ::LatencyHistogram::reset ()
+{
+  this->count_ = 0;
+  this->min_ = 0;
+  this->max_ = 0;
+  this->sum_ = 0.;
+  if (this->buckets_)
+    ::memset(this->buckets_, 0, kLATENCY_HISTOGRAM_BUCKETS * sizeof(yat::uint64));
+}
+
+// ============================================================================
+// MessageQ::LatencyHistogram::record
+// ============================================================================
+void MessageQ::LatencyHistogram::record (yat::uint64 ns)
+{
+  if (! this->count_ || ns < this->min_)
+    this->min_ = ns;
+  if (ns > this->max_)
+    this->max_ = ns;
+  this->count_++;
+  this->sum_ += static_cast<double>(ns);
+
+  //- the buckets are allocated on the first value (on failure, the value is
+  //- only accounted in the count/min/max/mean)
+  if (! this->buckets_)
+    this->buckets_ = new (std::nothrow) yat::uint64[kLATENCY_HISTOGRAM_BUCKETS]();
+  if (this->buckets_)
+    this->buckets_[latency_bucket(ns)]++;
+}
+
+// ============================================================================
+// MessageQ::LatencyHistogram::mean
+// ============================================================================
+double MessageQ::LatencyHistogram::mean () const
+{
+  return this->count_ ? this->sum_ / static_cast<double>(this->count_) : 0.;
+}
+
+// ============================================================================
+// MessageQ::LatencyHistogram::percentile
+// ============================================================================
+yat::uint64 MessageQ::LatencyHistogram::percentile (double p) const
+{
+  if (! this->count_)
+    return 0;
+
+  if (! this->buckets_)
+    return this->max_;
+
+  //- rank of the requested value (1 based)
+  yat::uint64 rank = static_cast<yat::uint64>(::ceil(p / 100. * static_cast<double>(this->count_)));
+  if (rank < 1)
+    rank = 1;
+
+  yat::uint64 n = 0;
+  for (size_t b = 0; b < kLATENCY_HISTOGRAM_BUCKETS; b++)
+  {
+    n += this->buckets_[b];
+    if (n >= rank)
+    {
+      yat::uint64 v = latency_bucket_upper_bound(b);
+      return v < this->max_ ? v : this->max_;
+    }
+  }
+
+  return this->max_;
+}
+
+// ============================================================================
+// MessageQ::LatencyHistogram::dump
+// ============================================================================
+void MessageQ::LatencyHistogram::dump (std::ostream& out, const std::string & name) const
+{
+  if (! this->count_)
+    return;
+
+  std::ios::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+
+  out << "MessageQ::statistics::latency::"
+      << name
+      << "::"
+      << this->count_
+      << " msgs"
+      << std::fixed
+      << std::setprecision(1)
+      << " - min: " << this->min_ / 1000.
+      << " - mean: " << this->mean() / 1000.
+      << " - p50: " << this->percentile(50.) / 1000.
+      << " - p99: " << this->percentile(99.) / 1000.
+      << " - p99.9: " << this->percentile(99.9) / 1000.
+      << " - max: " << this->max_ / 1000.
+      << " usecs"
+      << std::endl;
+
+  out.flags(flags);
+  out.precision(precision);
 }
 
 // ============================================================================
 // MessageQ::MessageQ
 // ============================================================================
-MessageQ::MessageQ (size_t _lo_wm, size_t _hi_wm, bool _throw_on_post_tmo)
+MessageQ::MessageQ (size_t _lo_wm, size_t _hi_wm, bool _throw_on_post_tmo, bool _lock_free)
 :
-    msg_q_ (0),
+    msg_q_ (),
     msg_producer_sync_ (lock_),
     msg_consumer_sync_ (lock_),
     state_(MessageQ::OPEN),
@@ -158,6 +668,10 @@ MessageQ::MessageQ (size_t _lo_wm, size_t _hi_wm, bool _throw_on_post_tmo)
     total_elapsed_target_usec_(0),
     periodic_msg_timer_ (),
     last_requested_tmo_(0),
+    hp_periodic_ (false),
+    hp_spin_usecs_ (0),
+    hp_period_ns_ (0),
+    hp_next_deadline_ns_ (0),
     lo_wm_ (_lo_wm),
     hi_wm_ (_hi_wm),
     saturated_ (false),
@@ -165,7 +679,27 @@ MessageQ::MessageQ (size_t _lo_wm, size_t _hi_wm, bool _throw_on_post_tmo)
     last_returned_msg_periodic_ (false),
     wm_unit_ (NUM_OF_MSGS),
     pending_charge_ (0),
-    stats_()
+    stats_(),
+    latency_stats_mode_ (LATENCY_STATS_ON),
+#if defined (YAT_CPP11)
+    lock_free_ (_lock_free),
+#else
+    //- lock-free mode requires c++11 atomics: fall back to the default mode
+    lock_free_ (false),
+#endif
+    notifier_ (0),
+    coalesced_types_ (0),
+    consumers_waiting_ (0),
+    producers_waiting_ (0),
+    spin_usecs_ (0),
+    post_seq_ (0),
+    lf_inbox_ (0),
+    lf_pending_charge_ (0),
+    lf_consumer_parked_ (false),
+    lf_saturated_ (false),
+    lf_closed_ (false),
+    lf_posted_without_waiting_ (0),
+    lf_trashed_ (0)
 {
   next_periodic_msg_period_.tv_sec = 0;
   next_periodic_msg_period_.tv_nsec = 0;
@@ -196,6 +730,10 @@ void MessageQ::close ()
   MutexLock guard(this->lock_);
 
   this->state_ = MessageQ::CLOSED;
+
+#if defined (YAT_CPP11)
+  this->lf_closed_.store(true);
+#endif
 }
 
 // ============================================================================
@@ -203,12 +741,22 @@ void MessageQ::close ()
 // ============================================================================
 size_t MessageQ::clear_i (bool notify_waiters)
 {
+#if defined (YAT_CPP11)
+  //- lock-free mode: also trash the msgs still in the producers inbox
+  if (this->lock_free_)
+    this->drain_inbox_i();
+#endif
+
   size_t num_msg_in_q = this->msg_q_.size();
 
   while (! this->msg_q_.empty())
   {
     Message * m = this->msg_q_.front ();
-    if (m) m->release();
+    if (m)
+    {
+      this->dec_pending_charge_i(m);
+      m->release();
+    }
     this->msg_q_.pop_front();
   }
 
@@ -217,18 +765,81 @@ size_t MessageQ::clear_i (bool notify_waiters)
   //- messageQ is obviously unsaturated!
   if ( this->saturated_ )
   {
-    //- compute stats
-    this->stats_.has_been_unsaturated_++;
-    //- no more saturated
-    this->saturated_ = false;
     //- this will work since if we under critical section (caller locked the associated mutex)*
     if ( notify_waiters )
-      this->msg_producer_sync_.broadcast();
+    {
+      this->unsaturate_i();
+    }
+    else
+    {
+      //- compute stats
+      this->stats_.has_been_unsaturated_++;
+      //- no more saturated
+      this->saturated_ = false;
+    }
   }
 
   return num_msg_in_q;
 }
 
+// ============================================================================
+// MessageQ::unsaturate_i
+// ============================================================================
+void MessageQ::unsaturate_i ()
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  YAT_LOG("MessageQ::**** UNSATURATED ****");
+  //- compute stats
+  this->stats_.has_been_unsaturated_++;
+  //- no more saturated
+  this->saturated_ = false;
+#if defined (YAT_CPP11)
+  this->lf_saturated_.store(false);
+#endif
+  //- wake the producers up one at a time (see wait_not_full_i)
+  this->wakeup_producer_i();
+}
+
+// ============================================================================
+// MessageQ::wakeup_producer_i
+// ============================================================================
+void MessageQ::wakeup_producer_i ()
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  //- each woken producer wakes the next one up before posting its msg: all the
+  //- blocked producers end up being woken without any thundering herd
+  if (! this->saturated_ && this->producers_waiting_)
+  {
+    this->msg_producer_sync_.signal();
+    this->stats_.producer_woken_counter_++;
+  }
+}
+
+// ============================================================================
+// MessageQ::wakeup_consumer_i
+// ============================================================================
+void MessageQ::wakeup_consumer_i (size_t _num_msgs)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  //- nobody to wake up: save the syscall
+  if (! this->consumers_waiting_)
+    return;
+
+  //- one consumer per msg
+  if (_num_msgs > 1 && this->consumers_waiting_ > 1)
+    this->msg_consumer_sync_.broadcast();
+  else
+    this->msg_consumer_sync_.signal();
+
+  this->stats_.consumer_woken_counter_++;
+}
+
 // ============================================================================
 // MessageQ::post
 // ============================================================================
@@ -239,75 +850,33 @@ int MessageQ::post (yat::Message * msg, size_t _tmo_msecs)
   //- check input
   if (! msg) return 0;
 
-  //- can't post any TIMEOUT or PERIODIC msg (yat::Task model violation)
-  if (msg->type() == TASK_TIMEOUT || msg->type() == TASK_PERIODIC)
-  {
-    this->stats_.trashed_msg_counter_++;
-    //- silently trash the message
-    msg->release();
-    return 0;
-  }
+#if defined (YAT_CPP11)
+  //- lock-free mode: don't lock the msgQ unless it is saturated
+  if (this->lock_free_)
+    return this->post_lf_i(msg, _tmo_msecs);
+#endif
+
+  int result;
 
   { //- critical section
 
     //- lock (required to protect the msgQ and for cond. vars. to work properly)
     MutexLock guard(this->lock_);
 
-    //- can only post a msg on an opened MsgQ
-    if (this->state_ != MessageQ::OPEN)
+    try
     {
-      this->stats_.trashed_msg_counter_++;
-      //- silently trash the message (should we throw an exception instead?)
-      msg->release();
-      return 0;
+      result = this->post_i(msg, _tmo_msecs);
     }
-
-    //- we force post of ctrl message even if the msQ is saturated
-    if (msg->is_task_ctrl_message())
-    {
-      //- insert msg according to its priority
-      try
-      {
-        this->insert_i(msg);
-      }
-      catch (...)
-      {
-        //- insert_i released the message (no memory leak)
-        THROW_YAT_ERROR("INTERNAL_ERROR",
-                        "Could not post ctrl message [msgQ insertion error]",
-                        "MessageQ::post");
-      }
-
-      //- wakeup msg consumers (tell them there is a message to handle)
-      //- this will work since we are under critical section
-      msg_consumer_sync_.broadcast();
-
-      //- compute stats
-      this->stats_.posted_without_waiting_msg_counter_++;
-
-      //- done (skip remaining code)
-      return 0;
-    }
-
-    //- is the messageQ saturated?
-    if (! this->saturated_ && (this->pending_charge_ >= this->hi_wm_))
+    catch (...)
     {
-      YAT_LOG("MessageQ::post::**** SATURATED ****");
-      //- compute stats
-      this->stats_.has_been_saturated_++;
-      //- mark msgQ as saturated
-      this->saturated_ = true;
+      //- insert_i released the message (no memory leak)
+      THROW_YAT_ERROR("INTERNAL_ERROR",
+                      "Could not post message [msgQ insertion error]",
+                      "MessageQ::post");
     }
 
-    //- msg is not a ctrl message...
-    //- wait for the messageQ to have room for new messages
-    if (! this->wait_not_full_i(_tmo_msecs))
+    if (result == -1)
     {
-      YAT_LOG("MessageQ::post::tmo expired");
-      //- can't post msg, destroy it in order to avoid memory leak
-      msg->release();
-      //- compute stats
-      this->stats_.trashed_on_post_tmo_counter_++;
       //- throw exception if the messageQ is configured to do so
       if (this->throw_on_post_msg_timeout_)
       {
@@ -319,38 +888,236 @@ int MessageQ::post (yat::Message * msg, size_t _tmo_msecs)
       return -1;
     }
 
-    //- ok there is enough room to post our msg
-    DEBUG_ASSERT(this->pending_charge_ <= this->hi_wm_);
+    //- wakeup a blocked msg consumer (tell it there is a new message to handle)
+    //- this will work since we are still under critical section
+    if (result == 1)
+      this->wakeup_consumer_i();
+
+  } //- critical section
+
+  //- tell the notifier (if any) there is a new message to handle
+  if (result == 1 && this->notifier_)
+    this->notifier_->message_posted();
+
+  return 0;
+}
+
+// ============================================================================
+// MessageQ::post_batch
+// ============================================================================
+int MessageQ::post_batch (std::vector<yat::Message *> & msgs, size_t _tmo_msecs)
+{
+  YAT_TRACE("MessageQ::post_batch");
+
+  bool tmo_expired = false;
+  size_t i = 0;
+
+#if defined (YAT_CPP11)
+  //- lock-free mode: each msg is pushed without locking the msgQ (unless saturated)
+  if (this->lock_free_)
+  {
+    size_t trashed = 0;
+    try
+    {
+      for (; i < msgs.size(); i++)
+      {
+        if (! msgs[i])
+          continue;
+        //- tmo expired: trash the remaining msgs
+        if (tmo_expired)
+        {
+          msgs[i]->release();
+          trashed++;
+        }
+        else if (this->post_lf_i(msgs[i], _tmo_msecs) == -1)
+        {
+          tmo_expired = true;
+        }
+      }
+    }
+    catch (...)
+    {
+      //- release the msgs we didn't post
+      for (++i; i < msgs.size(); i++)
+        if (msgs[i]) msgs[i]->release();
+      msgs.clear();
+      throw;
+    }
+    if (trashed)
+    {
+      //- compute stats
+      MutexLock guard(this->lock_);
+      this->stats_.trashed_on_post_tmo_counter_ += static_cast<unsigned long>(trashed);
+    }
+    msgs.clear();
+    return tmo_expired ? -1 : 0;
+  }
+#endif
+
+  size_t posted = 0;
+
+  { //- critical section
+
+    //- lock once for the whole batch
+    MutexLock guard(this->lock_);
 
-    //- insert the message according to its priority
     try
     {
-      this->insert_i(msg);
+      for (; i < msgs.size(); i++)
+      {
+        if (! msgs[i])
+          continue;
+        //- tmo expired: trash the remaining msgs
+        if (tmo_expired)
+        {
+          msgs[i]->release();
+          this->stats_.trashed_on_post_tmo_counter_++;
+          continue;
+        }
+        int result = this->post_i(msgs[i], _tmo_msecs);
+        if (result == 1)
+          posted++;
+        else if (result == -1)
+          tmo_expired = true;
+      }
     }
     catch (...)
     {
-      //- insert_i released the message (no memory leak)
+      //- insert_i released the message: release the msgs we didn't post
+      for (++i; i < msgs.size(); i++)
+        if (msgs[i]) msgs[i]->release();
+      msgs.clear();
+      if (posted)
+        this->wakeup_consumer_i(posted);
       THROW_YAT_ERROR("INTERNAL_ERROR",
                       "Could not post message [msgQ insertion error]",
-                      "MessageQ::post");
+                      "MessageQ::post_batch");
     }
 
-    //- compute stats
-    if (this->pending_charge_ > this->stats_.max_pending_charge_reached_)
-      this->stats_.max_pending_charge_reached_ = this->pending_charge_;
+    //- wakeup msg consumers once for the whole batch
+    if (posted)
+      this->wakeup_consumer_i(posted);
 
-    if (this->msg_q_.size() > this->stats_.max_pending_msgs_reached_)
-      this->stats_.max_pending_msgs_reached_ = static_cast<unsigned long>(this->msg_q_.size());
+  } //- critical section
 
-    //- wakeup msg consumers (tell them there is a new message to handle)
-    //- this will work since we are still under critical section
-    msg_consumer_sync_.broadcast ();
+  //- the msgs now belong to the msgQ (or have been released)
+  msgs.clear();
 
-  } //- critical section
+  //- tell the notifier (if any) there are new messages to handle
+  if (posted && this->notifier_)
+    this->notifier_->message_posted();
+
+  if (tmo_expired)
+  {
+    //- throw exception if the messageQ is configured to do so
+    if (this->throw_on_post_msg_timeout_)
+    {
+      THROW_YAT_ERROR("TIMEOUT_EXPIRED",
+                      "Could not post message [timeout expired]",
+                      "MessageQ::post_batch");
+    }
+    return -1;
+  }
 
   return 0;
 }
 
+// ============================================================================
+// MessageQ::post_i
+// ============================================================================
+int MessageQ::post_i (yat::Message * msg, size_t _tmo_msecs)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  //- can't post any TIMEOUT or PERIODIC msg (yat::Task model violation)
+  if (msg->type() == TASK_TIMEOUT || msg->type() == TASK_PERIODIC)
+  {
+    this->stats_.trashed_msg_counter_++;
+    //- silently trash the message
+    msg->release();
+    return 0;
+  }
+
+  //- can only post a msg on an opened MsgQ
+  if (this->state_ != MessageQ::OPEN)
+  {
+    this->stats_.trashed_msg_counter_++;
+    //- silently trash the message (should we throw an exception instead?)
+    msg->release();
+    return 0;
+  }
+
+  //- latest-value coalescing: no need to wait for room in the msgQ
+  if (this->coalesce_i(msg))
+    return 0;
+
+  //- we force post of ctrl message even if the msQ is saturated
+  if (msg->is_task_ctrl_message())
+  {
+    //- latency stats: post date
+    if (this->latency_stats_mode_ != LATENCY_STATS_OFF)
+      msg->post_time_ns_ = MessageQ::latency_clock_ns();
+
+    //- insert msg according to its priority (releases the msg on error)
+    this->insert_i(msg);
+
+    //- compute stats
+    this->stats_.posted_without_waiting_msg_counter_++;
+
+    //- done (skip remaining code)
+    return 1;
+  }
+
+  //- is the messageQ saturated?
+  if (! this->saturated_ && (this->pending_charge_ >= this->hi_wm_))
+  {
+    YAT_LOG("MessageQ::post::**** SATURATED ****");
+    //- compute stats
+    this->stats_.has_been_saturated_++;
+    //- mark msgQ as saturated
+    this->saturated_ = true;
+  }
+
+  //- msg is not a ctrl message...
+  if (this->saturated_ && ! this->msg_q_.empty())
+  {
+    //- we are about to block: make sure the consumer knows about the pending msgs
+    //- (some of them may have been inserted by <post_batch> without notification)
+    this->wakeup_consumer_i(this->msg_q_.size());
+  }
+
+  //- wait for the messageQ to have room for new messages
+  if (! this->wait_not_full_i(_tmo_msecs))
+  {
+    YAT_LOG("MessageQ::post::tmo expired");
+    //- can't post msg, destroy it in order to avoid memory leak
+    msg->release();
+    //- compute stats
+    this->stats_.trashed_on_post_tmo_counter_++;
+    return -1;
+  }
+
+  //- ok there is enough room to post our msg
+  DEBUG_ASSERT(this->pending_charge_ <= this->hi_wm_);
+
+  //- latency stats: post date
+  if (this->latency_stats_mode_ != LATENCY_STATS_OFF)
+    msg->post_time_ns_ = MessageQ::latency_clock_ns();
+
+  //- insert the message according to its priority (releases the msg on error)
+  this->insert_i(msg);
+
+  //- compute stats
+  if (this->pending_charge_ > this->stats_.max_pending_charge_reached_)
+    this->stats_.max_pending_charge_reached_ = this->pending_charge_;
+
+  if (this->msg_q_.size() > this->stats_.max_pending_msgs_reached_)
+    this->stats_.max_pending_msgs_reached_ = static_cast<unsigned long>(this->msg_q_.size());
+
+  return 1;
+}
+
 // ============================================================================
 // MessageQ::compute_next_periodic_period
 // ============================================================================
@@ -390,7 +1157,110 @@ void MessageQ::compute_next_periodic_period (double _requested_tmo_ms)
 }
 
 // ============================================================================
-// MessageQ::next_messageex
+// MessageQ::next_message_hp_i
+// ============================================================================
+yat::Message * MessageQ::next_message_hp_i (double _tmo_msecs)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  yat::uint64 period_ns = static_cast<yat::uint64>(_tmo_msecs * 1000000.);
+  if (! period_ns)
+    period_ns = 1;
+
+  yat::uint64 now = MessageQ::latency_clock_ns();
+
+  //- new periodic series: first deadline one period from now
+  if (! this->hp_next_deadline_ns_ || period_ns != this->hp_period_ns_)
+  {
+    this->hp_period_ns_ = period_ns;
+    this->hp_next_deadline_ns_ = now + period_ns;
+  }
+
+  for (;;)
+  {
+#if defined (YAT_CPP11)
+    //- lock-free mode: get the msgs posted since last call
+    if (this->lock_free_)
+      this->drain_inbox_i();
+#endif
+
+    if (now >= this->hp_next_deadline_ns_)
+    {
+      //- deadline reached: return a PERIODIC msg unless the last returned msg
+      //- was already a PERIODIC one and msgs are pending (avoid starvation)
+      if (! this->last_returned_msg_periodic_ || this->msg_q_.empty())
+      {
+        yat::uint64 late_ns = now - this->hp_next_deadline_ns_;
+        this->stats_.periodic_jitter_.record(late_ns);
+        //- skip the missed deadlines (if any)
+        yat::uint64 missed = late_ns / this->hp_period_ns_;
+        this->stats_.periodic_overrun_counter_ += static_cast<unsigned long>(missed);
+        this->hp_next_deadline_ns_ += (missed + 1) * this->hp_period_ns_;
+        this->last_returned_msg_periodic_ = true;
+        return new Message(TASK_PERIODIC);
+      }
+      break;
+    }
+
+    if (! this->msg_q_.empty())
+      break;
+
+    //- wait for a msg or the deadline (minus the spin duration): the condition
+    //- only supports relative timeouts, so the time left is recomputed from the
+    //- absolute deadline at each iteration
+    yat::uint64 remaining_ns = this->hp_next_deadline_ns_ - now;
+    yat::uint64 spin_ns = 1000 * static_cast<yat::uint64>(this->hp_spin_usecs_);
+    if (remaining_ns > spin_ns)
+    {
+      yat::uint64 wait_ns = remaining_ns - spin_ns;
+      if (this->wait_not_empty_i(static_cast<unsigned long>(wait_ns / MAX_NSECS),
+                                 static_cast<unsigned long>(wait_ns % MAX_NSECS)))
+        break;
+    }
+    else
+    {
+      this->spin_until_i(this->hp_next_deadline_ns_);
+    }
+
+    now = MessageQ::latency_clock_ns();
+  }
+
+  //- there is at least one msg in the msgQ
+  this->last_returned_msg_periodic_ = false;
+
+  return this->pop_front_i();
+}
+
+// ============================================================================
+// MessageQ::pop_front_i
+// ============================================================================
+yat::Message * MessageQ::pop_front_i ()
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  DEBUG_ASSERT(this->msg_q_.empty() == false);
+
+  yat::Message * msg = this->msg_q_.front();
+
+  DEBUG_ASSERT(msg != 0);
+
+  this->msg_q_.pop_front();
+
+  //- dec pending charge then compute latency stats
+  this->dec_pending_charge_i(msg);
+  this->record_queue_wait_i(msg);
+
+  //- if we reach the low water mark, then wake up msg producer(s)
+  if (this->saturated_ && this->pending_charge_i() <= this->lo_wm_)
+    this->unsaturate_i();
+
+  return msg;
+}
+
+// ============================================================================
+// MessageQ::next_message_ex
 // ============================================================================
 yat::Message * MessageQ::next_message_ex (double _tmo_msecs)
 {
@@ -401,6 +1271,54 @@ yat::Message * MessageQ::next_message_ex (double _tmo_msecs)
   //- enter critical section (required for cond.var. to work properly)
   MutexLock guard(this->lock_);
 
+  return this->next_message_ex_i(_tmo_msecs);
+}
+
+// ============================================================================
+// MessageQ::next_messages_ex
+// ============================================================================
+size_t MessageQ::next_messages_ex (std::vector<yat::Message *> & msgs_,
+                                   size_t _max_msgs,
+                                   double _tmo_msecs)
+{
+  YAT_TRACE("MessageQ::next_messages");
+
+  //- enter critical section (required for cond.var. to work properly)
+  MutexLock guard(this->lock_);
+
+  //- wait for the first msg (task msgs are always returned alone)
+  yat::Message * msg = this->next_message_ex_i(_tmo_msecs);
+  if (! msg)
+    return 0;
+
+  msgs_.push_back(msg);
+  if (msg->type() < FIRST_USER_MSG)
+    return 1;
+
+  //- then drain the pending user msgs (we still own the lock)
+  return 1 + this->next_user_messages_i(msgs_, _max_msgs);
+}
+
+// ============================================================================
+// MessageQ::next_message_ex_i
+// ============================================================================
+yat::Message * MessageQ::next_message_ex_i (double _tmo_msecs)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  //- latency stats: the consumer is back, fold its msg handling durations
+  this->fold_handling_i();
+
+  //- high precision periodic mode
+  if (this->hp_periodic_)
+  {
+    if (this->enable_periodic_msg_)
+      return this->next_message_hp_i(_tmo_msecs);
+    //- periodic msgs disabled: next series starts from scratch
+    this->hp_next_deadline_ns_ = 0;
+  }
+
   Time_ns tmo;
 
   if( this->enable_periodic_msg_ )
@@ -508,20 +1426,13 @@ yat::Message * MessageQ::next_message_ex (double _tmo_msecs)
     //... then extract it from the Q and return it
     this->msg_q_.pop_front();
 
-    //- dec pending charge
+    //- dec pending charge then compute latency stats
     this->dec_pending_charge_i(msg);
+    this->record_queue_wait_i(msg);
 
     //- if we reach the low water mark, then wake up msg producer(s)
-    if (this->saturated_ && this->pending_charge_ <= this->lo_wm_)
-    {
-      YAT_LOG("MessageQ::next_message::**** UNSATURATED ****");
-      //- compute stats
-      this->stats_.has_been_unsaturated_++;
-      //- no more saturated
-      this->saturated_ = false;
-      //- this will work since we are still under critical section
-      this->msg_producer_sync_.broadcast();
-    }
+    if (this->saturated_ && this->pending_charge_i() <= this->lo_wm_)
+      this->unsaturate_i();
 
     //- we are about to return a ctrl msg so...
     this->last_returned_msg_periodic_ = false;
@@ -536,19 +1447,13 @@ yat::Message * MessageQ::next_message_ex (double _tmo_msecs)
   //- then extract it from the Q and return it
   this->msg_q_.pop_front();
 
-  //- dec pending charge
+  //- dec pending charge then compute latency stats
   this->dec_pending_charge_i(msg);
+  this->record_queue_wait_i(msg);
 
   //- if we reach the low water mark, then wakeup msg producer(s)
-  if (this->saturated_ && this->pending_charge_ <= this->lo_wm_)
-  {
-    //- compute stats
-    this->stats_.has_been_unsaturated_++;
-    //- no longer saturated
-    this->saturated_ = false;
-    //- this will work since we are still under critical section
-    this->msg_producer_sync_.broadcast();
-  }
+  if (this->saturated_ && this->pending_charge_i() <= this->lo_wm_)
+    this->unsaturate_i();
 
   return msg;
 }
@@ -564,69 +1469,257 @@ yat::Message * MessageQ::next_message (double _tmo_msecs)
   //- enter critical section (required for cond.var. to work properly)
   MutexLock guard(this->lock_);
 
-  //- wait for the messageQ to contain at least one message or tmo expired
-  if ( ! this->wait_not_empty_i(_tmo_msecs) )
-  {
-    //- <wait_not_empty_i> returned <false> : means no msg in msg queue after <_tmo_msecs>
-    YAT_LOG("MessageQ::next_message::tmo expired [MessageQ::wait_not_empty_i returned false]");
-
-    //- is it time to return a periodic message?
-    if (this->enable_periodic_msg_ && this->periodic_tmo_expired_i(_tmo_msecs))
-    {
-      this->last_returned_msg_periodic_ = true;
-      this->periodic_msg_timer_.restart();
-      return new Message(TASK_PERIODIC);
-    }
+  return this->next_message_i(_tmo_msecs);
+}
 
-    //- Task timeout expired (see <wait_not_empty_i> impl for details)
-    if (this->enable_timeout_msg_)
-    {
-      this->last_returned_msg_periodic_ = false;
-      return new Message(TASK_TIMEOUT);
-    }
+// ============================================================================
+// MessageQ::next_messages
+// ============================================================================
+size_t MessageQ::next_messages (std::vector<yat::Message *> & msgs_,
+                                size_t _max_msgs,
+                                double _tmo_msecs)
+{
+  YAT_TRACE("MessageQ::next_messages");
 
-    //- no msg
-    this->last_returned_msg_periodic_ = false;
+  //- enter critical section (required for cond.var. to work properly)
+  MutexLock guard(this->lock_);
 
+  //- wait for the first msg (task msgs are always returned alone)
+  yat::Message * msg = this->next_message_i(_tmo_msecs);
+  if (! msg)
     return 0;
-  }
 
-  //- <wait_not_empty_i> returned <true> : means there is at least one msg in msg queue
+  msgs_.push_back(msg);
+  if (msg->type() < FIRST_USER_MSG)
+    return 1;
 
-  //- ok, there should be at least one message in the messageQ
-  DEBUG_ASSERT(this->msg_q_.empty() == false);
+  //- then drain the pending user msgs (we still own the lock)
+  return 1 + this->next_user_messages_i(msgs_, _max_msgs);
+}
 
-  //- we are still under critical section since the "Condition::timed_wait"
-  //- located in "wait_not_empty_i" garantee that the associated mutex (i.e.
-  //- this->lock_ in the present case) is acquired when the function returns
+// ============================================================================
+// MessageQ::try_next_messages
+// ============================================================================
+size_t MessageQ::try_next_messages (std::vector<yat::Message *> & msgs_, size_t _max_msgs)
+{
+  YAT_TRACE("MessageQ::try_next_messages");
 
-  //- get msg from Q
-  yat::Message * msg = this->msg_q_.front();
+  MutexLock guard(this->lock_);
 
-  //- parano. debugging
-  DEBUG_ASSERT(msg != 0);
+  //- latency stats: the consumer is back, fold its msg handling durations
+  this->fold_handling_i();
 
-  //- if the extracted msg is a TASK ctrl msg...
-  if (msg->is_task_ctrl_message())
-  {
-    //... then extract it from the Q and return it
-    this->msg_q_.pop_front();
+#if defined (YAT_CPP11)
+  //- lock-free mode: get the msgs posted since last call
+  if (this->lock_free_)
+    this->drain_inbox_i();
+#endif
 
-    //- dec pending charge
-    this->dec_pending_charge_i(msg);
+  if (this->msg_q_.empty())
+    return 0;
 
-    //- if we reach the low water mark, then wake up msg producer(s)
-    if (this->saturated_ && this->pending_charge_ <= this->lo_wm_)
+  //- task msgs are always returned alone
+  yat::Message * msg = this->msg_q_.front();
+  if (msg->type() >= FIRST_USER_MSG)
+    return this->next_user_messages_i(msgs_, _max_msgs);
+
+  this->msg_q_.pop_front();
+
+  //- dec pending charge then compute latency stats
+  this->dec_pending_charge_i(msg);
+  this->record_queue_wait_i(msg);
+
+  //- if we reach the low water mark, then wake up msg producer(s)
+  if (this->saturated_ && this->pending_charge_i() <= this->lo_wm_)
+    this->unsaturate_i();
+
+  msgs_.push_back(msg);
+
+  return 1;
+}
+
+// ============================================================================
+// MessageQ::Notifier::~Notifier
+// ============================================================================
+MessageQ::Notifier::~Notifier ()
+{
+  //- noop dtor
+}
+
+// ============================================================================
+// MessageQ::Coalescer::~Coalescer
+// ============================================================================
+MessageQ::Coalescer::~Coalescer ()
+{
+  //- noop dtor
+}
+
+// ============================================================================
+// MessageQ::update_coalesced_types_i
+// ============================================================================
+void MessageQ::update_coalesced_types_i ()
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  yat::uint64 types = 0;
+  std::map<size_t, Coalescer *>::const_iterator it = this->coalescing_.begin();
+  for (; it != this->coalescing_.end(); ++it)
+    types |= yat::uint64(1) << (it->first & TYPE_INDEX_MASK);
+
+  this->coalesced_types_.store(types, memory_order_release);
+}
+
+// ============================================================================
+// MessageQ::coalesce_i
+// ============================================================================
+bool MessageQ::coalesce_i (yat::Message * msg)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  if (this->coalescing_.empty() || msg->waitable() || msg->is_task_ctrl_message())
+    return false;
+
+  std::map<size_t, Coalescer *>::const_iterator it = this->coalescing_.find(msg->type());
+  if (it == this->coalescing_.end())
+    return false;
+
+  //- someone may wait for the pending msg to be handled: don't touch it
+  Message * pending = this->msg_q_.find_last(msg->type());
+  if (! pending || pending->waitable())
+    return false;
+
+  //- the pending charge may change (NUM_OF_BYTES unit)
+  size_t charge = this->msg_charge_i(pending);
+
+  Message * kept = pending;
+  if (it->second)
+  {
+    //- merge the posted msg into the pending one
+    try
     {
-      YAT_LOG("MessageQ::next_message::**** UNSATURATED ****");
-      //- compute stats
-      this->stats_.has_been_unsaturated_++;
-      //- no more saturated
-      this->saturated_ = false;
-      //- this will work since we are still under critical section
-      this->msg_producer_sync_.broadcast();
+      it->second->merge(*pending, *msg);
+    }
+    catch (...)
+    {
+      //- merge failed: post the msg as usual
+      return false;
+    }
+    msg->release();
+  }
+  else
+  {
+    //- replace the pending msg
+    try
+    {
+      this->msg_q_.replace_last(msg);
+    }
+    catch (...)
+    {
+      //- could not queue the msg in its priority band: post it as usual
+      return false;
+    }
+    //- the queue wait is counted from the first post
+    msg->post_time_ns_ = pending->post_time_ns_;
+    pending->release();
+    kept = msg;
+  }
+
+  //- update the pending charge
+  size_t new_charge = this->msg_charge_i(kept);
+  if (new_charge != charge)
+  {
+#if defined (YAT_CPP11)
+    if (this->lock_free_)
+      this->lf_pending_charge_.fetch_add(new_charge - charge);
+    else
+#endif
+      this->pending_charge_ += new_charge - charge;
+  }
+
+  //- compute stats
+  this->stats_.coalesced_msg_counter_++;
+
+  return true;
+}
+
+// ============================================================================
+// MessageQ::next_message_i
+// ============================================================================
+yat::Message * MessageQ::next_message_i (double _tmo_msecs)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  //- latency stats: the consumer is back, fold its msg handling durations
+  this->fold_handling_i();
+
+  //- high precision periodic mode
+  if (this->hp_periodic_)
+  {
+    if (this->enable_periodic_msg_)
+      return this->next_message_hp_i(_tmo_msecs);
+    //- periodic msgs disabled: next series starts from scratch
+    this->hp_next_deadline_ns_ = 0;
+  }
+
+  //- wait for the messageQ to contain at least one message or tmo expired
+  if ( ! this->wait_not_empty_i(_tmo_msecs) )
+  {
+    //- <wait_not_empty_i> returned <false> : means no msg in msg queue after <_tmo_msecs>
+    YAT_LOG("MessageQ::next_message::tmo expired [MessageQ::wait_not_empty_i returned false]");
+
+    //- is it time to return a periodic message?
+    if (this->enable_periodic_msg_ && this->periodic_tmo_expired_i(_tmo_msecs))
+    {
+      this->last_returned_msg_periodic_ = true;
+      this->periodic_msg_timer_.restart();
+      return new Message(TASK_PERIODIC);
+    }
+
+    //- Task timeout expired (see <wait_not_empty_i> impl for details)
+    if (this->enable_timeout_msg_)
+    {
+      this->last_returned_msg_periodic_ = false;
+      return new Message(TASK_TIMEOUT);
     }
 
+    //- no msg
+    this->last_returned_msg_periodic_ = false;
+
+    return 0;
+  }
+
+  //- <wait_not_empty_i> returned <true> : means there is at least one msg in msg queue
+
+  //- ok, there should be at least one message in the messageQ
+  DEBUG_ASSERT(this->msg_q_.empty() == false);
+
+  //- we are still under critical section since the "Condition::timed_wait"
+  //- located in "wait_not_empty_i" garantee that the associated mutex (i.e.
+  //- this->lock_ in the present case) is acquired when the function returns
+
+  //- get msg from Q
+  yat::Message * msg = this->msg_q_.front();
+
+  //- parano. debugging
+  DEBUG_ASSERT(msg != 0);
+
+  //- if the extracted msg is a TASK ctrl msg...
+  if (msg->is_task_ctrl_message())
+  {
+    //... then extract it from the Q and return it
+    this->msg_q_.pop_front();
+
+    //- dec pending charge then compute latency stats
+    this->dec_pending_charge_i(msg);
+    this->record_queue_wait_i(msg);
+
+    //- if we reach the low water mark, then wake up msg producer(s)
+    if (this->saturated_ && this->pending_charge_i() <= this->lo_wm_)
+      this->unsaturate_i();
+
     //- we are about to return a ctrl msg so...
     this->last_returned_msg_periodic_ = false;
 
@@ -657,41 +1750,68 @@ yat::Message * MessageQ::next_message (double _tmo_msecs)
   //- then extract it from the Q and return it
   this->msg_q_.pop_front();
 
-  //- dec pending charge
+  //- dec pending charge then compute latency stats
   this->dec_pending_charge_i(msg);
+  this->record_queue_wait_i(msg);
 
   //- if we reach the low water mark, then wakeup msg producer(s)
-  if (this->saturated_ && this->pending_charge_ <= this->lo_wm_)
-  {
-    //- compute stats
-    this->stats_.has_been_unsaturated_++;
-    //- no longer saturated
-    this->saturated_ = false;
-    //- this will work since we are still under critical section
-    this->msg_producer_sync_.broadcast();
-  }
+  if (this->saturated_ && this->pending_charge_i() <= this->lo_wm_)
+    this->unsaturate_i();
 
   return msg;
 }
 
 // ============================================================================
-// MessageQ::wait_not_empty_i
+// MessageQ::next_user_messages_i
 // ============================================================================
-bool MessageQ::wait_not_empty_i (size_t _tmo_msecs)
+size_t MessageQ::next_user_messages_i (std::vector<yat::Message *> & msgs_, size_t _max_msgs)
 {
   //- <this->lock_> MUST be locked by the calling thread
   //----------------------------------------------------
 
-  //- while the messageQ is empty...
-  while (this->msg_q_.empty ())
+#if defined (YAT_CPP11)
+  //- lock-free mode: get the msgs posted since last call
+  if (this->lock_free_)
+    this->drain_inbox_i();
+#endif
+
+  size_t n = 0;
+
+  //- extract user msgs until we reach <_max_msgs> (taking count of the msgs
+  //- already in <msgs_>) or a task msg (which must be handled alone)
+  while (msgs_.size() < _max_msgs && ! this->msg_q_.empty())
   {
-     //- wait for a msg or tmo expiration
-    if (! this->msg_consumer_sync_.timed_wait(static_cast<unsigned long>(_tmo_msecs)))
-      return false;
+    yat::Message * msg = this->msg_q_.front();
+    if (msg->type() < FIRST_USER_MSG)
+      break;
+
+    this->msg_q_.pop_front();
+
+    //- dec pending charge then compute latency stats
+    this->dec_pending_charge_i(msg);
+    this->record_queue_wait_i(msg);
+
+    msgs_.push_back(msg);
+    n++;
   }
 
-  //- at least one message available in the MsgQ
-  return true;
+  //- if we reach the low water mark, then wakeup msg producer(s)
+  if (this->saturated_ && this->pending_charge_i() <= this->lo_wm_)
+    this->unsaturate_i();
+
+  return n;
+}
+
+// ============================================================================
+// MessageQ::wait_not_empty_i
+// ============================================================================
+bool MessageQ::wait_not_empty_i (size_t _tmo_msecs)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  return this->wait_not_empty_i(static_cast<unsigned long>(_tmo_msecs / 1000),
+                                static_cast<unsigned long>(_tmo_msecs % 1000) * 1000000);
 }
 
 // ============================================================================
@@ -702,11 +1822,60 @@ bool MessageQ::wait_not_empty_i (unsigned long _tmo_secs, unsigned long _tmo_nse
   //- <this->lock_> MUST be locked by the calling thread
   //----------------------------------------------------
 
+#if defined (YAT_CPP11)
+  //- lock-free mode: get the msgs posted since last call
+  if (this->lock_free_)
+    this->drain_inbox_i();
+#endif
+
+  //- the timeout in nsecs (0 means infinite wait)
+  yat::uint64 tmo_ns = static_cast<yat::uint64>(_tmo_secs) * MAX_NSECS + _tmo_nsecs;
+
+  //- spin at most once
+  bool spun = false;
+
   //- while the messageQ is empty...
   while (this->msg_q_.empty ())
   {
+    //- spin a while before blocking: a msg may be about to be posted
+    if (! spun)
+    {
+      spun = true;
+      bool timed = tmo_ns && this->spin_usecs_;
+      yat::uint64 t0 = timed ? MessageQ::latency_clock_ns() : 0;
+      size_t max_usecs = static_cast<size_t>(tmo_ns / 1000);
+      if (this->spin_not_empty_i(max_usecs ? max_usecs : this->spin_usecs_))
+      {
+#if defined (YAT_CPP11)
+        if (this->lock_free_)
+          this->drain_inbox_i();
+#endif
+        continue;
+      }
+      //- the spin is part of the timeout (don't delay the TIMEOUT/PERIODIC msgs)
+      if (timed)
+      {
+        yat::uint64 spun_ns = MessageQ::latency_clock_ns() - t0;
+        if (spun_ns >= tmo_ns)
+          return false;
+        tmo_ns -= spun_ns;
+      }
+    }
+#if defined (YAT_CPP11)
+    if (this->lock_free_ && ! this->park_consumer_i())
+      break;
+#endif
      //- wait for a msg or tmo expiration
-    if (! this->msg_consumer_sync_.timed_wait(_tmo_secs, _tmo_nsecs))
+    this->stats_.consumer_parked_counter_++;
+    this->consumers_waiting_++;
+    bool signaled = this->msg_consumer_sync_.timed_wait(static_cast<unsigned long>(tmo_ns / MAX_NSECS),
+                                                        static_cast<unsigned long>(tmo_ns % MAX_NSECS));
+    this->consumers_waiting_--;
+#if defined (YAT_CPP11)
+    if (this->lock_free_)
+      signaled = this->unpark_consumer_i(signaled);
+#endif
+    if (! signaled)
       return false;
   }
 
@@ -730,26 +1899,102 @@ bool MessageQ::wait_not_full_i (size_t _tmo_msecs)
     return true;
   }
 
-  //- while the messageQ is empty...
+  //- while the messageQ is saturated...
   while (this->saturated_)
   {
-    //- wait for a msg or tmo expiration
-    if (! this->msg_producer_sync_.timed_wait(static_cast<unsigned long>(_tmo_msecs)))
+    //- wait for room in the msgQ or tmo expiration
+    this->producers_waiting_++;
+    bool signaled = this->msg_producer_sync_.timed_wait(static_cast<unsigned long>(_tmo_msecs));
+    this->producers_waiting_--;
+    if (! signaled)
+    {
+      //- we may have been woken up just before the tmo expired: pass it on
+      this->wakeup_producer_i();
       return false;
+    }
     //- compute stats
     this->stats_.posted_with_waiting_msg_counter_++;
   }
 
-  //- at least one message available in the MsgQ
+  //- wake the next blocked producer up (if any)
+  this->wakeup_producer_i();
+
+  //- there is room in the MsgQ
   return true;
 }
 
 // ============================================================================
-// Binary predicate
+// MessageQ::spin_not_empty_i
+// ============================================================================
+bool MessageQ::spin_not_empty_i (size_t _max_usecs)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+#if defined (YAT_CPP11)
+  size_t max_usecs = this->spin_usecs_ < _max_usecs ? this->spin_usecs_ : _max_usecs;
+  if (! max_usecs)
+    return false;
+
+  bool posted = this->spin_until_i(MessageQ::latency_clock_ns() + 1000 * static_cast<yat::uint64>(max_usecs));
+
+  //- compute stats
+  if (posted)
+    this->stats_.consumer_spun_counter_++;
+
+  return posted;
+#else
+  //- c++11 atomics required
+  return false;
+#endif
+}
+
+// ============================================================================
+// MessageQ::spin_until_i
 // ============================================================================
-static bool insert_msg_criterion (Message * const m1, Message * const m2)
+bool MessageQ::spin_until_i (yat::uint64 _deadline_ns)
 {
-  return m2->priority() < m1->priority();
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+#if defined (YAT_CPP11)
+  size_t seq = this->post_seq_.load(std::memory_order_relaxed);
+
+  //- let the producers in while we are spinning
+  this->lock_.unlock();
+
+  bool posted = false;
+  for (size_t i = 1; ; i++)
+  {
+    //- lock-free mode: msgs are pushed onto the inbox, otherwise <post_seq_> changes
+    if (this->lock_free_)
+      posted = this->lf_inbox_.load(std::memory_order_relaxed) != 0;
+    else
+      posted = this->post_seq_.load(std::memory_order_relaxed) != seq;
+    if (posted)
+      break;
+    //- don't read the clock on each iteration
+    if (! (i % 16) && MessageQ::latency_clock_ns() >= _deadline_ns)
+      break;
+#if defined (__GNUC__) && (defined (__i386__) || defined (__x86_64__))
+    __builtin_ia32_pause();
+#endif
+  }
+
+  this->lock_.lock();
+
+  return posted;
+#else
+  //- c++11 atomics required: sleep until the deadline
+  yat::uint64 now = MessageQ::latency_clock_ns();
+  if (now < _deadline_ns)
+  {
+    this->lock_.unlock();
+    ThreadingUtilities::sleep(0, static_cast<long>(_deadline_ns - now));
+    this->lock_.lock();
+  }
+  return false;
+#endif
 }
 
 // ============================================================================
@@ -761,26 +2006,25 @@ void MessageQ::insert_i (Message * _msg)
 
   try
   {
-    if (this->msg_q_.empty())
-    {
-      //- optimization: no need to take count of the msg priority
-      this->msg_q_.push_front (_msg);
-    }
-    else
-    {
-      //- insert msg according to its priority
-      MessageQImpl::iterator pos = std::upper_bound(this->msg_q_.begin(),
-                                                    this->msg_q_.end(),
-                                                    _msg,
-                                                    insert_msg_criterion);
-      this->msg_q_.insert(pos, _msg);
-    }
+    //- insert msg according to its priority
+    this->msg_q_.push(_msg);
 
     //- inc pending charge
     this->inc_pending_charge_i(_msg);
+
+#if defined (YAT_CPP11)
+    //- tell a spinning consumer there is a new msg
+    if (! this->lock_free_)
+      this->post_seq_.fetch_add(1, std::memory_order_relaxed);
+#endif
   }
   catch (...)
   {
+#if defined (YAT_CPP11)
+    //- lock-free mode: the msg charge has been accounted by the producer
+    if (this->lock_free_)
+      this->lf_pending_charge_.fetch_sub(this->msg_charge_i(_msg));
+#endif
     Exception e("INTERNAL_ERROR",
                 "could insert message into the message queue",
                 "MessageQ::insert_i");
@@ -790,6 +2034,82 @@ void MessageQ::insert_i (Message * _msg)
   }
 }
 
+// ============================================================================
+// MessageQ::latency_clock_ns
+// ============================================================================
+yat::uint64 MessageQ::latency_clock_ns ()
+{
+#if defined (YAT_WIN32)
+  static LARGE_INTEGER frequency = { 0 };
+  if (! frequency.QuadPart)
+    ::QueryPerformanceFrequency(&frequency);
+  LARGE_INTEGER now;
+  ::QueryPerformanceCounter(&now);
+  return static_cast<yat::uint64>(now.QuadPart * (1.e9 / frequency.QuadPart));
+#else
+  struct timespec now;
+  ::clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<yat::uint64>(now.tv_sec) * 1000000000ULL + static_cast<yat::uint64>(now.tv_nsec);
+#endif
+}
+
+// ============================================================================
+// MessageQ::record_queue_wait_i
+// ============================================================================
+void MessageQ::record_queue_wait_i (Message * msg)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  if (this->latency_stats_mode_ == LATENCY_STATS_OFF || ! msg->post_time_ns_)
+    return;
+
+  yat::uint64 now = MessageQ::latency_clock_ns();
+  yat::uint64 dt = now > msg->post_time_ns_ ? now - msg->post_time_ns_ : 0;
+  msg->post_time_ns_ = 0;
+
+  this->stats_.latency_.queue_wait_.record(dt);
+  if (this->latency_stats_mode_ == LATENCY_STATS_PER_MSG_TYPE)
+    this->stats_.latency_per_msg_type_[msg->type()].queue_wait_.record(dt);
+}
+
+// ============================================================================
+// MessageQ::record_handling
+// ============================================================================
+void MessageQ::record_handling (size_t msg_type, yat::uint64 duration)
+{
+  //- consumer side: no lock (folded into the stats on next msg extraction)
+  this->pending_handling_.push_back(std::make_pair(msg_type, duration));
+}
+
+// ============================================================================
+// MessageQ::fold_handling_i
+// ============================================================================
+void MessageQ::fold_handling_i ()
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  if (this->pending_handling_.empty())
+    return;
+
+  //- stats might have been disabled since the msgs were handled
+  if (this->latency_stats_mode_ == LATENCY_STATS_OFF)
+  {
+    this->pending_handling_.clear();
+    return;
+  }
+
+  for (size_t i = 0; i < this->pending_handling_.size(); i++)
+  {
+    const std::pair<size_t, yat::uint64> & h = this->pending_handling_[i];
+    this->stats_.latency_.handling_.record(h.second);
+    if (this->latency_stats_mode_ == LATENCY_STATS_PER_MSG_TYPE)
+      this->stats_.latency_per_msg_type_[h.first].handling_.record(h.second);
+  }
+  this->pending_handling_.clear();
+}
+
 // ============================================================================
 // MessageQ::reset_statistics
 // ============================================================================
@@ -798,7 +2118,11 @@ void MessageQ::reset_statistics ()
   //- lock
   MutexLock guard(this->lock_);
   //- reset
-  ::memset(&this->stats_, 0, sizeof(MessageQ::Statistics));
+  this->stats_ = MessageQ::Statistics();
+#if defined (YAT_CPP11)
+  this->lf_posted_without_waiting_.store(0);
+  this->lf_trashed_.store(0);
+#endif
 }
 
 // ============================================================================
@@ -808,50 +2132,295 @@ size_t MessageQ::clear_pending_messages (size_t msg_type)
 {
   //- lock
   MutexLock guard(this->lock_);
+#if defined (YAT_CPP11)
+  //- lock-free mode: also consider the msgs still in the producers inbox
+  if ( this->lock_free_ )
+    this->drain_inbox_i();
+#endif
   //- any pending msg?
   if ( this->msg_q_.empty() )
     return 0;
-  //- copy msgQ
-  MessageQImpl copy = this->msg_q_;
-  //- parse content and remove msgs of type <msg_type>
-  MessageQImpl::iterator cit = copy.begin();
-  MessageQImpl::iterator  it = this->msg_q_.begin();
-  MessageQImpl::iterator end = this->msg_q_.end();
-  //- num of msgs removed from msgQ
-  size_t cnt = 0;
-  //- parse...
-  for( ; it != end; ++it )
+  //- remove msgs of type <msg_type> (uses the msg type index)
+  std::vector<Message *> removed;
+  size_t cnt = this->msg_q_.remove(msg_type, removed);
+  for (size_t i = 0; i < cnt; i++)
+  {
+    this->dec_pending_charge_i(removed[i]);
+    removed[i]->release();
+  }
+
+  //- is the messageQ unsaturated?
+  if ( this->saturated_ && this->pending_charge_i() <= this->lo_wm_ )
+    this->unsaturate_i();
+
+  //- return num of removed msgs
+  return cnt;
+}
+
+#if defined (YAT_CPP11)
+
+// ============================================================================
+// MessageQ::post_lf_i
+// ============================================================================
+int MessageQ::post_lf_i (yat::Message * msg, size_t _tmo_msecs)
+{
+  //- can't post any TIMEOUT or PERIODIC msg (yat::Task model violation)
+  if (msg->type() == TASK_TIMEOUT || msg->type() == TASK_PERIODIC)
   {
-    if ( (*it)->type() == msg_type )
+    this->lf_trashed_++;
+    //- silently trash the message
+    msg->release();
+    return 0;
+  }
+
+  //- can only post a msg on an opened MsgQ
+  if (this->lf_closed_.load())
+  {
+    this->lf_trashed_++;
+    //- silently trash the message (should we throw an exception instead?)
+    msg->release();
+    return 0;
+  }
+
+  //- latest-value coalescing (slow path): no need to wait for room in the msgQ
+  yat::uint64 coalesced_types = this->coalesced_types_.load(memory_order_acquire);
+  if (
+       ((coalesced_types >> (msg->type() & TYPE_INDEX_MASK)) & 1)
+         &&
+       this->coalesce_lf_i(msg)
+     )
+    return 0;
+
+  //- we force post of ctrl message even if the msQ is saturated
+  //- otherwise, we only take the slow path if there is no room for the msg
+  if (
+       ! msg->is_task_ctrl_message()
+         &&
+       ( this->lf_saturated_.load() || this->lf_pending_charge_.load() >= this->hi_wm_ )
+     )
+  {
+    //- wait for the messageQ to have room for new messages
+    if (! this->wait_not_full_lf_i(_tmo_msecs))
     {
-      this->pending_charge_ -= (this->wm_unit_ == NUM_OF_MSGS)
-                             ? 1
-                             : (*it)->size_in_bytes();
-      (*it)->release();
-      cit = copy.erase(cit);
-      cnt++;
+      YAT_LOG("MessageQ::post::tmo expired");
+      //- can't post msg, destroy it in order to avoid memory leak
+      msg->release();
+      //- throw exception if the messageQ is configured to do so
+      if (this->throw_on_post_msg_timeout_)
+      {
+        THROW_YAT_ERROR("TIMEOUT_EXPIRED",
+                        "Could not post message [timeout expired]",
+                        "MessageQ::post");
+      }
+      //- return if we didn't throw an exception
+      return -1;
     }
-    else
-       ++cit;
+  }
+  else
+  {
+    //- compute stats
+    this->lf_posted_without_waiting_++;
   }
 
-  //- copy back to msgq
-  this->msg_q_ = copy;
+  //- push the msg onto the producers inbox (wakes up the consumer if required)
+  this->push_lf_i(msg);
 
-  //- is the messageQ unsaturated?
-  if ( this->saturated_ && this->pending_charge_ <= this->lo_wm_ )
+  return 0;
+}
+
+// ============================================================================
+// MessageQ::coalesce_lf_i
+// ============================================================================
+bool MessageQ::coalesce_lf_i (yat::Message * msg)
+{
+  MutexLock guard(this->lock_);
+
+  //- the pending msg may still be in the producers inbox
+  this->drain_inbox_i();
+
+  return this->coalesce_i(msg);
+}
+
+// ============================================================================
+// MessageQ::wait_not_full_lf_i
+// ============================================================================
+bool MessageQ::wait_not_full_lf_i (size_t _tmo_msecs)
+{
+  MutexLock guard(this->lock_);
+
+  //- is the messageQ saturated?
+  if (! this->saturated_)
   {
-    YAT_LOG("MessageQ::next_message::**** UNSATURATED ****");
+    if (this->lf_pending_charge_.load() < this->hi_wm_)
+    {
+      //- compute stats
+      this->stats_.posted_without_waiting_msg_counter_++;
+      return true;
+    }
+    YAT_LOG("MessageQ::post::**** SATURATED ****");
     //- compute stats
-    this->stats_.has_been_unsaturated_++;
-    //- no more saturated
-    this->saturated_ = false;
-    //- this will work since we are still under critical section
-    this->msg_producer_sync_.broadcast();
+    this->stats_.has_been_saturated_++;
+    //- mark msgQ as saturated
+    this->saturated_ = true;
+    this->lf_saturated_.store(true);
   }
 
-  //- return num of removed msgs
-  return cnt;
+  //- wait for the consumer to reach the low water mark
+  while (this->saturated_)
+  {
+    //- the consumer may have consumed the pending msgs before the msgQ was
+    //- marked as saturated: it can't notice we are waiting, so check ourself
+    if (this->lf_pending_charge_.load() <= this->lo_wm_)
+    {
+      this->unsaturate_i();
+      break;
+    }
+    //- wait for room in the msgQ or tmo expiration
+    this->producers_waiting_++;
+    bool signaled = this->msg_producer_sync_.timed_wait(static_cast<unsigned long>(_tmo_msecs));
+    this->producers_waiting_--;
+    if (! signaled)
+    {
+      //- we may have been woken up just before the tmo expired: pass it on
+      this->wakeup_producer_i();
+      //- compute stats
+      this->stats_.trashed_on_post_tmo_counter_++;
+      return false;
+    }
+    //- compute stats
+    this->stats_.posted_with_waiting_msg_counter_++;
+  }
+
+  //- wake the next blocked producer up (if any)
+  this->wakeup_producer_i();
+
+  return true;
+}
+
+// ============================================================================
+// MessageQ::push_lf_i
+// ============================================================================
+void MessageQ::push_lf_i (yat::Message * msg)
+{
+  //- latency stats: post date
+  if (this->latency_stats_mode_ != LATENCY_STATS_OFF)
+    msg->post_time_ns_ = MessageQ::latency_clock_ns();
+
+  //- account the msg charge before publishing the msg (the consumer decrements it)
+  this->lf_pending_charge_.fetch_add(this->msg_charge_i(msg));
+
+  //- lock-free push, linked through the msg itself (no allocation)
+  //- the consumer takes the whole inbox at once: no ABA issue
+  msg->inbox_next_ = this->lf_inbox_.load(std::memory_order_relaxed);
+  while (! this->lf_inbox_.compare_exchange_weak(msg->inbox_next_, msg))
+    ;
+
+  //- wakeup the msg consumer if it is blocked (or about to block) on an empty msgQ
+  //- the consumer sets the flag then checks the inbox: at least one of us sees the other
+  if (this->lf_consumer_parked_.load())
+  {
+    MutexLock guard(this->lock_);
+    this->wakeup_consumer_i();
+  }
+
+  //- tell the notifier (if any) there is a new message to handle
+  if (this->notifier_)
+    this->notifier_->message_posted();
 }
 
+// ============================================================================
+// MessageQ::drain_inbox_i
+// ============================================================================
+void MessageQ::drain_inbox_i ()
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  //- take the whole inbox at once
+  Message * msg = this->lf_inbox_.exchange(0);
+  if (! msg)
+    return;
+
+  //- the inbox is a LIFO: reverse it in order to preserve the posting order
+  Message * fifo = 0;
+  while (msg)
+  {
+    Message * next = msg->inbox_next_;
+    msg->inbox_next_ = fifo;
+    fifo = msg;
+    msg = next;
+  }
+
+  //- insert msgs according to their priority
+  while (fifo)
+  {
+    Message * next = fifo->inbox_next_;
+    fifo->inbox_next_ = 0;
+    this->insert_i(fifo);
+    fifo = next;
+  }
+
+  //- compute stats
+  size_t charge = this->lf_pending_charge_.load();
+  if (charge > this->stats_.max_pending_charge_reached_)
+    this->stats_.max_pending_charge_reached_ = static_cast<unsigned long>(charge);
+
+  if (this->msg_q_.size() > this->stats_.max_pending_msgs_reached_)
+    this->stats_.max_pending_msgs_reached_ = static_cast<unsigned long>(this->msg_q_.size());
+}
+
+// ============================================================================
+// MessageQ::park_consumer_i
+// ============================================================================
+bool MessageQ::park_consumer_i ()
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  //- tell the producers we are about to block...
+  this->lf_consumer_parked_.store(true);
+
+  //- ...then check the inbox again: a msg may have been posted meanwhile
+  this->drain_inbox_i();
+  if (! this->msg_q_.empty())
+  {
+    this->lf_consumer_parked_.store(false);
+    return false;
+  }
+
+  //- ok, we can safely wait on the consumer condition
+  return true;
+}
+
+// ============================================================================
+// MessageQ::unpark_consumer_i
+// ============================================================================
+bool MessageQ::unpark_consumer_i (bool _signaled)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  this->lf_consumer_parked_.store(false);
+
+  //- get the msgs posted while we were blocked
+  this->drain_inbox_i();
+
+  //- on tmo expiration, a msg may have been posted just before we returned
+  return _signaled || ! this->msg_q_.empty();
+}
+
+// ============================================================================
+// MessageQ::fold_lf_statistics_i
+// ============================================================================
+void MessageQ::fold_lf_statistics_i ()
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  this->stats_.posted_without_waiting_msg_counter_ += this->lf_posted_without_waiting_.exchange(0);
+  this->stats_.trashed_msg_counter_ += this->lf_trashed_.exchange(0);
+}
+
+#endif //- YAT_CPP11
+
 } // namespace
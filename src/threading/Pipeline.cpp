@@ -0,0 +1,434 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2004-2021 Synchrotron SOLEIL
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the GNU Lesser Public License v3
+// which accompanies this distribution, and is available at
+// http://www.gnu.org/licenses/lgpl.html
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// YAT LIBRARY
+//----------------------------------------------------------------------------
+//
+// Copyright (C) 2006-2021 The Tango Community
+//
+// Part of the code comes from the ACE Framework (asm bytes swaping code)
+// see http://www.cs.wustl.edu/~schmidt/ACE.html for more about ACE
+//
+// The thread native implementation has been initially inspired by omniThread
+// - the threading support library that comes with omniORB.
+// see http://omniorb.sourceforge.net/ for more about omniORB.
+//
+// Contributors form the TANGO community:
+// See AUTHORS file
+//
+// The YAT library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// The YAT library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// See COPYING file for license details
+//
+// Contact:
+//      Stephane Poirier
+//      Synchrotron SOLEIL
+//------------------------------------------------------------------------------
+/*!
+ * \author See AUTHORS file
+ */
+
+// ============================================================================
+// DEPENDENCIES
+// ============================================================================
+#include <iomanip>
+#include <map>
+#include <yat/threading/Pipeline.h>
+
+namespace yat
+{
+
+// ======================================================================
+// PipelineLink::PipelineLink
+// ======================================================================
+PipelineLink::PipelineLink (PipelineStageBase * _to, size_t _credits)
+  : to_ (_to),
+    available_ (static_cast<unsigned int>(_credits)),
+    credits_ (_credits)
+{
+}
+
+// ======================================================================
+// PipelineLink::acquire
+// ======================================================================
+double PipelineLink::acquire ()
+{
+  //- fast path: a credit is available
+  if (this->available_.try_wait() == SEMAPHORE_DEC)
+    return 0.;
+
+  //- backpressure: wait for the receiving stage to process an item
+  Timer t;
+  this->available_.wait();
+  return t.elapsed_sec();
+}
+
+// ======================================================================
+// PipelineLink::release
+// ======================================================================
+void PipelineLink::release ()
+{
+  this->available_.post();
+}
+
+// ======================================================================
+// PipelineLink::credits
+// ======================================================================
+size_t PipelineLink::credits () const
+{
+  return this->credits_;
+}
+
+// ======================================================================
+// PipelineStageStatistics::PipelineStageStatistics
+// ======================================================================
+PipelineStageStatistics::PipelineStageStatistics ()
+  : items_in_ (0),
+    items_out_ (0),
+    errors_ (0),
+    emit_blocked_counter_ (0),
+    emit_blocked_secs_ (0.),
+    busy_secs_ (0.),
+    elapsed_secs_ (0.)
+{
+}
+
+// ======================================================================
+// PipelineStageStatistics::throughput
+// ======================================================================
+double PipelineStageStatistics::throughput () const
+{
+  return this->elapsed_secs_ > 0. ? this->items_in_ / this->elapsed_secs_ : 0.;
+}
+
+// ======================================================================
+// PipelineStageStatistics::utilization
+// ======================================================================
+double PipelineStageStatistics::utilization () const
+{
+  return this->elapsed_secs_ > 0. ? this->busy_secs_ / this->elapsed_secs_ : 0.;
+}
+
+// ======================================================================
+// PipelineStageStatistics::dump
+// ======================================================================
+void PipelineStageStatistics::dump (std::ostream & out) const
+{
+  std::ios::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+
+  out << "Pipeline::statistics::"
+      << this->name_
+      << "::in: " << this->items_in_
+      << " - out: " << this->items_out_
+      << " - errors: " << this->errors_
+      << std::fixed
+      << std::setprecision(1)
+      << " - throughput: " << this->throughput() << " items/s"
+      << " - utilization: " << 100. * this->utilization() << "%"
+      << " - blocked: " << this->emit_blocked_counter_
+      << " times (" << 1000. * this->emit_blocked_secs_ << " ms)"
+      << std::endl;
+
+  out.flags(flags);
+  out.precision(precision);
+}
+
+// ======================================================================
+// PipelineStageBase::PipelineStageBase
+// ======================================================================
+PipelineStageBase::PipelineStageBase (const std::string & _name, const Task::Config & _cfg)
+  : Task (_cfg),
+    push_link_ (0),
+    name_ (_name),
+    started_ (false)
+{
+  this->stats_.name_ = _name;
+}
+
+// ======================================================================
+// PipelineStageBase::~PipelineStageBase
+// ======================================================================
+PipelineStageBase::~PipelineStageBase ()
+{
+  for (size_t i = 0; i < this->inputs_.size(); i++)
+    delete this->inputs_[i];
+}
+
+// ======================================================================
+// PipelineStageBase::name
+// ======================================================================
+const std::string & PipelineStageBase::name () const
+{
+  return this->name_;
+}
+
+// ======================================================================
+// PipelineStageBase::handle_message
+// ======================================================================
+void PipelineStageBase::handle_message (yat::Message &)
+{
+  //- noop
+}
+
+// ======================================================================
+// PipelineStageBase::add_input_i
+// ======================================================================
+PipelineLink * PipelineStageBase::add_input_i (size_t _credits)
+{
+  if (! _credits)
+  {
+    THROW_YAT_ERROR("BAD_ARG",
+                    "a pipeline link must have at least one credit",
+                    "PipelineStage::connect");
+  }
+
+  PipelineLink * l = new (std::nothrow) PipelineLink(this, _credits);
+  if (! l)
+  {
+    THROW_YAT_ERROR("OUT_OF_MEMORY",
+                    "yat::PipelineLink allocation failed",
+                    "PipelineStage::connect");
+  }
+  this->inputs_.push_back(l);
+
+  //- make room in the msgQ for all the items in flight: the msgQ never saturates
+  if (this->msgq_wm_unit() == MessageQ::NUM_OF_MSGS)
+  {
+    size_t in_flight = 0;
+    for (size_t i = 0; i < this->inputs_.size(); i++)
+      in_flight += this->inputs_[i]->credits();
+    if (this->msgq_hi_wm() < in_flight + kMIN_WATER_MARKS_DIFF)
+      this->msgq_hi_wm(in_flight + kMIN_WATER_MARKS_DIFF);
+  }
+
+  return l;
+}
+
+// ======================================================================
+// PipelineStageBase::connect_i
+// ======================================================================
+void PipelineStageBase::connect_i (PipelineStageBase & _next, size_t _credits)
+{
+  if (&_next == this)
+  {
+    THROW_YAT_ERROR("BAD_ARG",
+                    "a pipeline stage can't be connected to itself",
+                    "PipelineStage::connect");
+  }
+  this->outputs_.push_back(_next.add_input_i(_credits));
+}
+
+// ======================================================================
+// PipelineStageBase::processed_i
+// ======================================================================
+void PipelineStageBase::processed_i (double _busy_secs, bool _error)
+{
+  MutexLock guard(this->stats_lock_);
+  if (! this->started_)
+  {
+    this->started_ = true;
+    this->clock_.restart();
+  }
+  this->stats_.items_in_++;
+  this->stats_.busy_secs_ += _busy_secs;
+  if (_error)
+    this->stats_.errors_++;
+}
+
+// ======================================================================
+// PipelineStageBase::emitted_i
+// ======================================================================
+void PipelineStageBase::emitted_i (size_t _num_items, double _blocked_secs)
+{
+  MutexLock guard(this->stats_lock_);
+  this->stats_.items_out_ += static_cast<unsigned long>(_num_items);
+  if (_blocked_secs > 0.)
+  {
+    this->stats_.emit_blocked_counter_++;
+    this->stats_.emit_blocked_secs_ += _blocked_secs;
+  }
+}
+
+// ======================================================================
+// PipelineStageBase::statistics
+// ======================================================================
+PipelineStageStatistics PipelineStageBase::statistics ()
+{
+  MutexLock guard(this->stats_lock_);
+  PipelineStageStatistics s = this->stats_;
+  s.elapsed_secs_ = this->started_ ? this->clock_.elapsed_sec() : 0.;
+  return s;
+}
+
+// ======================================================================
+// Pipeline::Pipeline
+// ======================================================================
+Pipeline::Pipeline ()
+  : started_ (false)
+{
+}
+
+// ======================================================================
+// Pipeline::~Pipeline
+// ======================================================================
+Pipeline::~Pipeline ()
+{
+  try
+  {
+    this->stop();
+  }
+  catch (...)
+  {
+    //- ignore any error
+  }
+}
+
+// ======================================================================
+// Pipeline::add_i
+// ======================================================================
+void Pipeline::add_i (PipelineStageBase * _stage)
+{
+  if (this->started_)
+  {
+    THROW_YAT_ERROR("PROGRAMMING_ERROR",
+                    "can't add a stage to a running pipeline",
+                    "Pipeline::add");
+  }
+  if (! _stage)
+  {
+    THROW_YAT_ERROR("BAD_ARG",
+                    "unexpected null pipeline stage",
+                    "Pipeline::add");
+  }
+  this->stages_.push_back(_stage);
+}
+
+// ======================================================================
+// Pipeline::sort_i
+// ======================================================================
+void Pipeline::sort_i ()
+{
+  //- topological sort: a stage comes after all its upstream stages
+  std::map<PipelineStageBase *, size_t> upstreams;
+  for (size_t i = 0; i < this->stages_.size(); i++)
+    upstreams[this->stages_[i]];
+  for (size_t i = 0; i < this->stages_.size(); i++)
+  {
+    std::vector<PipelineLink *> & out = this->stages_[i]->outputs_;
+    for (size_t j = 0; j < out.size(); j++)
+    {
+      std::map<PipelineStageBase *, size_t>::iterator it = upstreams.find(out[j]->to_);
+      if (it != upstreams.end())
+        it->second++;
+    }
+  }
+
+  std::vector<PipelineStageBase *> sorted;
+  std::vector<PipelineStageBase *> ready;
+  for (size_t i = 0; i < this->stages_.size(); i++)
+    if (! upstreams[this->stages_[i]])
+      ready.push_back(this->stages_[i]);
+
+  while (! ready.empty())
+  {
+    PipelineStageBase * s = ready.front();
+    ready.erase(ready.begin());
+    sorted.push_back(s);
+    for (size_t j = 0; j < s->outputs_.size(); j++)
+    {
+      std::map<PipelineStageBase *, size_t>::iterator it = upstreams.find(s->outputs_[j]->to_);
+      if (it != upstreams.end() && ! --it->second)
+        ready.push_back(it->first);
+    }
+  }
+
+  if (sorted.size() != this->stages_.size())
+  {
+    THROW_YAT_ERROR("PROGRAMMING_ERROR",
+                    "the pipeline stages connections contain a cycle",
+                    "Pipeline::start");
+  }
+
+  this->stages_.swap(sorted);
+}
+
+// ======================================================================
+// Pipeline::start
+// ======================================================================
+void Pipeline::start (size_t _tmo_msecs)
+{
+  if (this->started_)
+    return;
+
+  this->sort_i();
+
+  //- downstream stages first
+  for (size_t i = this->stages_.size(); i > 0; i--)
+    this->stages_[i - 1]->go(_tmo_msecs);
+
+  this->started_ = true;
+}
+
+// ======================================================================
+// Pipeline::stop
+// ======================================================================
+void Pipeline::stop (size_t _tmo_msecs)
+{
+  //- upstream stages first: once a stage is drained, no more items are
+  //- emitted to its downstream stages
+  for (size_t i = 0; i < this->stages_.size(); i++)
+  {
+    if (this->started_)
+    {
+      try
+      {
+        this->stages_[i]->wait_msg_handled(kPIPELINE_FLUSH_MSG, _tmo_msecs);
+      }
+      catch (...)
+      {
+        //- ignore any error
+      }
+    }
+    this->stages_[i]->exit();
+  }
+
+  this->stages_.clear();
+  this->started_ = false;
+}
+
+// ======================================================================
+// Pipeline::statistics
+// ======================================================================
+std::vector<PipelineStageStatistics> Pipeline::statistics ()
+{
+  std::vector<PipelineStageStatistics> s;
+  for (size_t i = 0; i < this->stages_.size(); i++)
+    s.push_back(this->stages_[i]->statistics());
+  return s;
+}
+
+// ======================================================================
+// Pipeline::dump_statistics
+// ======================================================================
+void Pipeline::dump_statistics (std::ostream & out)
+{
+  std::vector<PipelineStageStatistics> s = this->statistics();
+  for (size_t i = 0; i < s.size(); i++)
+    s[i].dump(out);
+}
+
+} // namespace
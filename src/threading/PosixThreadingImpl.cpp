@@ -46,9 +46,13 @@
 // ----------------------------------------------------------------------------
 #include <errno.h>
 #include <unistd.h>
+#include <limits.h>
+#include <sched.h>
+#include <cstring>
 #include <iostream>
 #include <sys/time.h>
 #include <yat/threading/Utilities.h>
+#include <yat/threading/Atomic.h>
 #include <yat/threading/Mutex.h>
 #include <yat/threading/Condition.h>
 #include <yat/threading/Semaphore.h>
@@ -68,6 +72,30 @@
 #define MAX_SLEEP_SECONDS  (long)4294966  //- this is (2^32 - 2) / 1000
 #define MAX_NSECS 1000000000
 
+//- the clock used for the timed waits absolute deadlines
+//- the monotonic clock is immune to system time changes, but macOS does not
+//- support pthread_condattr_setclock
+#if defined (YAT_MACOSX)
+# define YAT_TIMED_WAIT_CLOCK CLOCK_REALTIME
+#else
+# define YAT_TIMED_WAIT_CLOCK CLOCK_MONOTONIC
+#endif
+
+//- absolute time: the current time of <clock> plus the given relative offset
+static void clock_deadline (clockid_t clock,
+                            struct timespec & abs_time,
+                            unsigned long delay_secs,
+                            unsigned long nano_secs)
+{
+  struct timespec now;
+  ::clock_gettime(clock, &now);
+
+  abs_time.tv_sec  = now.tv_sec + delay_secs + nano_secs / MAX_NSECS;
+  abs_time.tv_nsec = now.tv_nsec + nano_secs % MAX_NSECS;
+  abs_time.tv_sec  += abs_time.tv_nsec / MAX_NSECS;
+  abs_time.tv_nsec %= MAX_NSECS;
+}
+
 // ----------------------------------------------------------------------------
 // PLATFORM SPECIFIC THREAD PRIORITIES
 // ----------------------------------------------------------------------------
@@ -194,8 +222,14 @@ Condition::Condition (Mutex & external_lock)
 
 #if (PthreadDraftVersion == 4)
   ::pthread_cond_init(&m_posix_cond, pthread_condattr_default);
-#else
+#elif defined (YAT_MACOSX)
   ::pthread_cond_init(&m_posix_cond, 0);
+#else
+  pthread_condattr_t attr;
+  ::pthread_condattr_init(&attr);
+  ::pthread_condattr_setclock(&attr, YAT_TIMED_WAIT_CLOCK);
+  ::pthread_cond_init(&m_posix_cond, &attr);
+  ::pthread_condattr_destroy(&attr);
 #endif
 }
 
@@ -224,9 +258,9 @@ bool Condition::timed_wait (unsigned long _tmo_msecs)
   }
   else
   {
-    //- get absoulte time
+    //- get absoulte time (on the clock of the condition)
     struct timespec ts;
-    ThreadingUtilities::get_time(ts, _tmo_msecs);
+    clock_deadline(YAT_TIMED_WAIT_CLOCK, ts, _tmo_msecs / 1000, (_tmo_msecs % 1000) * 1000000);
     //- wait for the condition to be signaled or tmo expiration
     int result = ::pthread_cond_timedwait(&m_posix_cond,
                                           &m_external_lock.m_posix_mux,
@@ -253,9 +287,9 @@ bool Condition::timed_wait (unsigned long _tmo_secs, unsigned long _tmo_nsecs)
   }
   else
   {
-    //- get absoulte time
+    //- get absoulte time (on the clock of the condition)
     struct timespec ts;
-    ThreadingUtilities::get_time(ts, _tmo_secs, _tmo_nsecs);
+    clock_deadline(YAT_TIMED_WAIT_CLOCK, ts, _tmo_secs, _tmo_nsecs);
     //- wait for the condition to be signaled or tmo expiration
     int result = ::pthread_cond_timedwait(&m_posix_cond,
                                           &m_external_lock.m_posix_mux,
@@ -352,6 +386,68 @@ Thread::IOArg yat_thread_common_entry_point (Thread::IOArg _p)
   return 0;
 }
 
+// ----------------------------------------------------------------------------
+// yat_to_posix_policy
+// ----------------------------------------------------------------------------
+static int yat_to_posix_policy (Thread::SchedPolicy _p)
+{
+  switch (_p)
+  {
+    case yat::Thread::SCHED_POLICY_FIFO:
+      return SCHED_FIFO;
+
+    case yat::Thread::SCHED_POLICY_RR:
+      return SCHED_RR;
+
+    default:
+      return SCHED_OTHER;
+  }
+}
+
+// ----------------------------------------------------------------------------
+// posix_to_yat_policy
+// ----------------------------------------------------------------------------
+static Thread::SchedPolicy posix_to_yat_policy (int _p)
+{
+  switch (_p)
+  {
+    case SCHED_FIFO:
+      return yat::Thread::SCHED_POLICY_FIFO;
+
+    case SCHED_RR:
+      return yat::Thread::SCHED_POLICY_RR;
+
+    default:
+      return yat::Thread::SCHED_POLICY_DEFAULT;
+  }
+}
+
+// ----------------------------------------------------------------------------
+// posix_error_desc
+// ----------------------------------------------------------------------------
+static std::string posix_error_desc (const char * _what, int _err)
+{
+  return std::string(_what) + " [" + ::strerror(_err) + "]";
+}
+
+#if defined (YAT_LINUX)
+// ----------------------------------------------------------------------------
+// yat_to_cpu_set (an empty CpuSet means any CPU)
+// ----------------------------------------------------------------------------
+static void yat_to_cpu_set (const Thread::CpuSet & _cpus, cpu_set_t & cs_)
+{
+  CPU_ZERO(&cs_);
+  if (_cpus.empty())
+  {
+    for (size_t i = 0; i < CPU_SETSIZE; i++)
+      CPU_SET(i, &cs_);
+    return;
+  }
+  for (Thread::CpuSet::const_iterator it = _cpus.begin(); it != _cpus.end(); ++it)
+    CPU_SET(*it, &cs_);
+}
+#endif
+
 // ----------------------------------------------------------------------------
 // Thread::Thread
 // ----------------------------------------------------------------------------
@@ -359,6 +455,10 @@ Thread::Thread (Thread::IOArg _iarg, Thread::Priority _p)
  : //- platform independent members
    m_state (yat::Thread::STATE_NEW),
    m_priority (_p),
+   m_cpu_affinity (),
+   m_sched_policy (yat::Thread::SCHED_POLICY_DEFAULT),
+   m_sched_priority (0),
+   m_stack_size (0),
    m_iarg (_iarg),
    m_oarg (0),
    m_detached (true),
@@ -456,6 +556,41 @@ void Thread::spawn ()
          : PTHREAD_CREATE_JOINABLE;
   ::pthread_attr_setdetachstate(&thread_attrs, ds);
 
+  //- set stack size (rounded up to the system min. and to the page size)
+  if (this->m_stack_size)
+  {
+    YAT_LOG("Thread::spawn::changing thread stack size attr");
+    size_t ss = this->m_stack_size < static_cast<size_t>(PTHREAD_STACK_MIN)
+              ? static_cast<size_t>(PTHREAD_STACK_MIN)
+              : this->m_stack_size;
+    size_t pg = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    if (pg)
+      ss = ((ss + pg - 1) / pg) * pg;
+    ::pthread_attr_setstacksize(&thread_attrs, ss);
+  }
+
+  //- set scheduling policy (otherwise inherited from the calling thread)
+  if (this->m_sched_policy != yat::Thread::SCHED_POLICY_DEFAULT)
+  {
+    YAT_LOG("Thread::spawn::changing thread scheduling policy attr");
+    struct sched_param sched;
+    sched.sched_priority = this->m_sched_priority;
+    ::pthread_attr_setinheritsched(&thread_attrs, PTHREAD_EXPLICIT_SCHED);
+    ::pthread_attr_setschedpolicy(&thread_attrs, yat_to_posix_policy(this->m_sched_policy));
+    ::pthread_attr_setschedparam(&thread_attrs, &sched);
+  }
+
+#if defined (YAT_LINUX)
+  //- set cpu affinity
+  if (! this->m_cpu_affinity.empty())
+  {
+    YAT_LOG("Thread::spawn::changing thread cpu affinity attr");
+    cpu_set_t cs;
+    yat_to_cpu_set(this->m_cpu_affinity, cs);
+    ::pthread_attr_setaffinity_np(&thread_attrs, sizeof(cs), &cs);
+  }
+#endif
+
   //- set thread priority
 #if defined(PthreadSupportThreadPriority)
   YAT_LOG("Thread::spawn::changing thread priority attr");
@@ -486,7 +621,9 @@ void Thread::spawn ()
 #endif
   //- check result
   if (result)
-    throw Exception(); //-TODO
+    THROW_YAT_ERROR("RUNTIME_ERROR",
+                    posix_error_desc("could not spawn thread", result),
+                    "Thread::spawn");
 
   //- mark the thread as running (before leaving the critical section)
   this->m_state = yat::Thread::STATE_RUNNING;
@@ -574,6 +711,195 @@ void Thread::priority (Priority _p)
   this->m_priority = _p;
 }
 
+// ----------------------------------------------------------------------------
+// Thread::cpu_affinity
+// ----------------------------------------------------------------------------
+void Thread::cpu_affinity (const CpuSet & _cpus)
+{
+  YAT_TRACE("Thread::cpu_affinity");
+
+  //- enter critical section
+  AutoMutex<Mutex> guard(this->m_lock);
+
+#if defined (YAT_LINUX)
+  //- check input
+  if (! _cpus.empty() && *_cpus.rbegin() >= static_cast<size_t>(CPU_SETSIZE))
+    THROW_YAT_ERROR("BAD_ARG",
+                    "invalid cpu index specified",
+                    "Thread::cpu_affinity");
+
+  //- apply affinity if thread is running
+  if (this->m_state == yat::Thread::STATE_RUNNING)
+  {
+    cpu_set_t cs;
+    yat_to_cpu_set(_cpus, cs);
+    int err = ::pthread_setaffinity_np(this->m_posix_thread, sizeof(cs), &cs);
+    if (err)
+      THROW_YAT_ERROR("RUNTIME_ERROR",
+                      posix_error_desc("could not change the thread cpu affinity", err),
+                      "Thread::cpu_affinity");
+  }
+#endif
+
+  //- store new affinity
+  this->m_cpu_affinity = _cpus;
+}
+
+// ----------------------------------------------------------------------------
+// Thread::cpu_affinity
+// ----------------------------------------------------------------------------
+Thread::CpuSet Thread::cpu_affinity ()
+{
+  //- enter critical section
+  AutoMutex<Mutex> guard(this->m_lock);
+
+#if defined (YAT_LINUX)
+  //- get the actual affinity if thread is running
+  cpu_set_t cs;
+  if (
+       this->m_state == yat::Thread::STATE_RUNNING
+         &&
+       ! ::pthread_getaffinity_np(this->m_posix_thread, sizeof(cs), &cs)
+     )
+  {
+    CpuSet cpus;
+    for (size_t i = 0; i < CPU_SETSIZE; i++)
+      if (CPU_ISSET(i, &cs))
+        cpus.insert(i);
+    return cpus;
+  }
+#endif
+
+  return this->m_cpu_affinity;
+}
+
+// ----------------------------------------------------------------------------
+// Thread::scheduling
+// ----------------------------------------------------------------------------
+void Thread::scheduling (SchedPolicy _p, int _prio)
+{
+  YAT_TRACE("Thread::scheduling");
+
+  int policy = yat_to_posix_policy(_p);
+
+  //- check input
+  if (_p == yat::Thread::SCHED_POLICY_DEFAULT)
+  {
+    _prio = 0;
+  }
+  else if (_prio < ::sched_get_priority_min(policy) || _prio > ::sched_get_priority_max(policy))
+  {
+    THROW_YAT_ERROR("BAD_ARG",
+                    "scheduling priority out of the policy range",
+                    "Thread::scheduling");
+  }
+
+  //- enter critical section
+  AutoMutex<Mutex> guard(this->m_lock);
+
+  //- apply policy if thread is running
+  if (this->m_state == yat::Thread::STATE_RUNNING)
+  {
+    struct sched_param sched;
+    sched.sched_priority = _prio;
+    int err = ::pthread_setschedparam(this->m_posix_thread, policy, &sched);
+    if (err)
+      THROW_YAT_ERROR("RUNTIME_ERROR",
+                      posix_error_desc("could not change the thread scheduling policy", err),
+                      "Thread::scheduling");
+  }
+
+  //- store new policy
+  this->m_sched_policy = _p;
+  this->m_sched_priority = _prio;
+}
+
+// ----------------------------------------------------------------------------
+// Thread::sched_policy
+// ----------------------------------------------------------------------------
+Thread::SchedPolicy Thread::sched_policy ()
+{
+  //- enter critical section
+  AutoMutex<Mutex> guard(this->m_lock);
+
+  //- get the actual policy if thread is running
+  int policy;
+  struct sched_param sched;
+  if (
+       this->m_state == yat::Thread::STATE_RUNNING
+         &&
+       ! ::pthread_getschedparam(this->m_posix_thread, &policy, &sched)
+     )
+    return posix_to_yat_policy(policy);
+
+  return this->m_sched_policy;
+}
+
+// ----------------------------------------------------------------------------
+// Thread::sched_priority
+// ----------------------------------------------------------------------------
+int Thread::sched_priority ()
+{
+  //- enter critical section
+  AutoMutex<Mutex> guard(this->m_lock);
+
+  //- get the actual priority if thread is running
+  int policy;
+  struct sched_param sched;
+  if (
+       this->m_state == yat::Thread::STATE_RUNNING
+         &&
+       ! ::pthread_getschedparam(this->m_posix_thread, &policy, &sched)
+     )
+    return sched.sched_priority;
+
+  return this->m_sched_priority;
+}
+
+// ----------------------------------------------------------------------------
+// Thread::stack_size
+// ----------------------------------------------------------------------------
+void Thread::stack_size (size_t _bytes)
+{
+  //- enter critical section
+  AutoMutex<Mutex> guard(this->m_lock);
+
+  //- the stack is allocated when the thread is spawned
+  if (this->m_state != yat::Thread::STATE_NEW)
+    THROW_YAT_ERROR("PROGRAMMING_ERROR",
+                    "can't change the stack size of a thread once it has been started",
+                    "Thread::stack_size");
+
+  this->m_stack_size = _bytes;
+}
+
+// ----------------------------------------------------------------------------
+// Thread::stack_size
+// ----------------------------------------------------------------------------
+size_t Thread::stack_size ()
+{
+  //- enter critical section
+  AutoMutex<Mutex> guard(this->m_lock);
+
+#if defined (YAT_LINUX)
+  //- get the actual stack size if thread is running
+  pthread_attr_t attrs;
+  if (
+       this->m_state == yat::Thread::STATE_RUNNING
+         &&
+       ! ::pthread_getattr_np(this->m_posix_thread, &attrs)
+     )
+  {
+    size_t ss = 0;
+    ::pthread_attr_getstacksize(&attrs, &ss);
+    ::pthread_attr_destroy(&attrs);
+    return ss;
+  }
+#endif
+
+  return this->m_stack_size;
+}
+
 // ----------------------------------------------------------------------------
 // Thread::yield
 // ----------------------------------------------------------------------------
@@ -665,6 +991,33 @@ unsigned int ThreadingUtilities::harware_concurrency()
   return ::sysconf(_SC_NPROCESSORS_ONLN);
 }
 
+// ----------------------------------------------------------------------------
+// ThreadingUtilities::yield
+// ----------------------------------------------------------------------------
+void ThreadingUtilities::yield ()
+{
+  ::sched_yield();
+}
+
+#if defined (YAT_CPP11)
+//- next thread index to give
+static Atomic<unsigned int> next_thread_index;
+#endif
+
+// ----------------------------------------------------------------------------
+// ThreadingUtilities::thread_index
+// ----------------------------------------------------------------------------
+unsigned int ThreadingUtilities::thread_index ()
+{
+#if defined (YAT_CPP11)
+  static thread_local unsigned int index = next_thread_index++;
+  return index;
+#else
+  size_t h = (size_t)(::pthread_self());
+  return static_cast<unsigned int>(h ^ (h >> 12));
+#endif
+}
+
 // ----------------------------------------------------------------------------
 // ThreadingUtilities::get_time
 // ----------------------------------------------------------------------------
@@ -673,17 +1026,8 @@ void ThreadingUtilities::get_time (unsigned long & abs_sec_,
                                    unsigned long _rel_sec,
                                    unsigned long _rel_nano_sec)
 {
-  timespec abs;
-
-  struct timeval tv;
-  ::gettimeofday(&tv, NULL);
-
-  abs.tv_sec = tv.tv_sec;
-  abs.tv_nsec = tv.tv_usec * 1000;
-
-  abs.tv_sec += _rel_sec + abs.tv_nsec / MAX_NSECS;
-  abs.tv_nsec += _rel_nano_sec;
-  abs.tv_nsec %= MAX_NSECS;
+  Timespec abs;
+  ThreadingUtilities::get_time(abs, _rel_sec, _rel_nano_sec);
 
   abs_sec_ = abs.tv_sec;
   abs_nano_sec_ = abs.tv_nsec;
@@ -694,15 +1038,9 @@ void ThreadingUtilities::get_time (unsigned long & abs_sec_,
 // ----------------------------------------------------------------------------
 void ThreadingUtilities::get_time (Timespec & abs_time, unsigned long delay_msecs)
 {
-  struct timeval now;
-  ::gettimeofday(&now, NULL);
-
-  abs_time.tv_sec  = now.tv_sec + delay_msecs / 1000;
-  delay_msecs -=  delay_msecs / 1000 * 1000;
-  abs_time.tv_nsec = now.tv_usec * 1000;
-  abs_time.tv_nsec += delay_msecs * 1000000;
-  abs_time.tv_sec  += abs_time.tv_nsec / MAX_NSECS;
-  abs_time.tv_nsec %= MAX_NSECS;
+  ThreadingUtilities::get_time(abs_time,
+                               delay_msecs / 1000,
+                               (delay_msecs % 1000) * 1000000);
 }
 
 // ----------------------------------------------------------------------------
@@ -710,14 +1048,7 @@ void ThreadingUtilities::get_time (Timespec & abs_time, unsigned long delay_msec
 // ----------------------------------------------------------------------------
 void ThreadingUtilities::get_time (Timespec & abs_time, unsigned long delay_secs, unsigned long nano_secs)
 {
-  struct timeval now;
-  ::gettimeofday(&now, NULL);
-
-  abs_time.tv_sec  = now.tv_sec + delay_secs;
-  abs_time.tv_nsec = now.tv_usec * 1000;
-  abs_time.tv_nsec += nano_secs;
-  abs_time.tv_sec  += abs_time.tv_nsec / MAX_NSECS;
-  abs_time.tv_nsec %= MAX_NSECS;
+  clock_deadline(CLOCK_REALTIME, abs_time, delay_secs, nano_secs);
 }
 
 } // namespace yat
@@ -0,0 +1,118 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2004-2021 Synchrotron SOLEIL
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the GNU Lesser Public License v3
+// which accompanies this distribution, and is available at
+// http://www.gnu.org/licenses/lgpl.html
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// YAT LIBRARY
+//----------------------------------------------------------------------------
+//
+// Copyright (C) 2006-2021 The Tango Community
+//
+// Part of the code comes from the ACE Framework (asm bytes swaping code)
+// see http://www.cs.wustl.edu/~schmidt/ACE.html for more about ACE
+//
+// The thread native implementation has been initially inspired by omniThread
+// - the threading support library that comes with omniORB.
+// see http://omniorb.sourceforge.net/ for more about omniORB.
+//
+// Contributors form the TANGO community:
+// See AUTHORS file
+//
+// The YAT library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// The YAT library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// See COPYING file for license details
+//
+/*!
+ * \author See AUTHORS file
+ */
+
+// ============================================================================
+// DEPENDENCIES
+// ============================================================================
+#include <yat/threading/Published.h>
+#include <yat/threading/Utilities.h>
+
+namespace yat
+{
+
+// ============================================================================
+// PublishedReaders::PublishedReaders
+// ============================================================================
+PublishedReaders::PublishedReaders (size_t _max_counters)
+  : m_readers_counters (1)
+{
+  size_t cores = ThreadingUtilities::harware_concurrency();
+  while (this->m_readers_counters < cores
+      && this->m_readers_counters * 2 <= _max_counters)
+    this->m_readers_counters *= 2;
+  this->m_readers = new ReadersCounters[this->m_readers_counters];
+}
+
+// ============================================================================
+// PublishedReaders::~PublishedReaders
+// ============================================================================
+PublishedReaders::~PublishedReaders ()
+{
+  delete[] this->m_readers;
+}
+
+// ============================================================================
+// PublishedReaders::read_lock
+// ============================================================================
+PublishedReaders::Token PublishedReaders::read_lock ()
+{
+  ReadersCounters & rc = this->m_readers_counters == 1
+                       ? this->m_readers[0]
+                       : this->m_readers[ThreadingUtilities::thread_index() & (this->m_readers_counters - 1)];
+  Token t = &rc.count[this->m_phase.load(memory_order_acquire) & 1];
+  //- seq. consistent: the value is loaded after the registration
+  t->fetch_add(1);
+  return t;
+}
+
+// ============================================================================
+// PublishedReaders::synchronize
+// ============================================================================
+void PublishedReaders::synchronize ()
+{
+  //- a reader may register on the former phase counters after the phase
+  //- switch (phase read before): the counters of both phases are drained,
+  //- each one after the new readers have been sent to the other one
+  for (size_t i = 0; i < 2; ++i)
+  {
+    yat::uint32 phase = this->m_phase.load(memory_order_relaxed);
+    this->m_phase.store(phase + 1);
+    this->wait_readers_i(phase & 1);
+  }
+}
+
+// ============================================================================
+// PublishedReaders::wait_readers_i
+// ============================================================================
+void PublishedReaders::wait_readers_i (size_t _phase)
+{
+  for (size_t i = 0; i < this->m_readers_counters; ++i)
+  {
+    for (size_t attempt = 1; this->m_readers[i].count[_phase].load(); ++attempt)
+    {
+      //- readers are short-lived: spin a bit, then back off
+      if (attempt < 64)
+        ThreadingUtilities::yield();
+      else
+        ThreadingUtilities::sleep(0, 50000);
+    }
+  }
+}
+
+} // namespace
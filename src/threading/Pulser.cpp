@@ -44,141 +44,531 @@
 // ============================================================================
 // DEPENDENCIES
 // ============================================================================
+#include <cstdlib>
+#include <map>
 #include <yat/threading/Pulser.h>
 
 namespace yat
 {
 
+class PulserTimerService;
+
 // ======================================================================
-// Pulser's underlying implementation
+// Pulser's underlying implementation: a timer of the pulsers timer service
 // ======================================================================
-class PulserCoreImpl : public yat::Task
+class PulserCoreImpl
 {
-  typedef enum
-  {
-    START_MSG = yat::FIRST_USER_MSG,
-    STOP_MSG,
-    SUSPEND_MSG,
-    RESUME_MSG,
-    NUM_PULSES_CHANGED
-  } PulserCoreImplMsgType;
-
 public:
-  PulserCoreImpl (const Pulser::Config& cfg)
-    : cfg_(cfg), pulses_(0)
+  PulserCoreImpl (const Pulser::Config& cfg, PulserTimerService * service)
+    : cfg_(cfg), pulses_(0), enabled_(false), in_callback_(false),
+      dead_(false), generation_(0), deadline_(-1.), service_(service)
   {}
 
-  ~PulserCoreImpl ()
-  {}
+  //- pulser's config
+  Pulser::Config cfg_;
+
+  //- number of pulses generated since last start
+  size_t pulses_;
+
+  //- true if the pulser is started (and neither stopped nor suspended)
+  bool enabled_;
+
+  //- true while the callback is executing
+  bool in_callback_;
+
+  //- set when the pulser is deleted from its own callback (reclaimed by the
+  //- service once the callback returned)
+  bool dead_;
+
+  //- incremented on each state change (tells the service the pulser changed
+  //- while its callback was executing)
+  size_t generation_;
+
+  //- next pulse date in msecs (-1 if not armed)
+  double deadline_;
+
+  //- the timer service
+  PulserTimerService * service_;
+};
+
+// ======================================================================
+// PulserTimerService: the thread running all the pulsers callbacks
+// ======================================================================
+class PulserTimerService : public yat::Thread
+{
+public:
+  //- returns the service, starting it if required (one ref. per pulser)
+  static PulserTimerService * acquire ();
+
+  //- releases a ref. on the service (the last one stops it)
+  static void release ();
+
+  //- joins the service stopped by its own thread (if any)
+  static void join_orphan ();
+
+  //- starts the pulser
+  void start (PulserCoreImpl * p, bool sync);
+
+  //- stops/suspends the pulser
+  void stop (PulserCoreImpl * p, bool sync);
+
+  //- resumes the pulser
+  void resume (PulserCoreImpl * p, bool sync);
+
+  //- changes the pulser's period (applies from the next pulse)
+  void set_period (PulserCoreImpl * p, double p_msecs);
+
+  //- returns the pulser's period
+  double get_period (PulserCoreImpl * p);
 
-  void start (bool sync)
+  //- changes the number of pulses to be generated
+  void set_num_pulses (PulserCoreImpl * p, size_t num_pulses);
+
+  //- returns the number of pulses to be generated
+  size_t get_num_pulses (PulserCoreImpl * p);
+
+  //- pulser activity
+  bool is_running (PulserCoreImpl * p);
+  bool is_done (PulserCoreImpl * p);
+
+  //- stops the pulser and waits for its callback to return
+  //- returns false if called from the pulser's own callback: the service then
+  //- reclaims the pulser (and its ref. on the service) once the callback returned
+  bool remove (PulserCoreImpl * p);
+
+  //- Thread::exit impl.
+  virtual void exit ();
+
+protected:
+  //- the service thread body
+  virtual Thread::IOArg run_undetached (Thread::IOArg);
+
+private:
+  PulserTimerService ();
+
+  //- (re)arms/disarms the pulser timer (<lock_> MUST be locked by the calling thread)
+  void arm_i (PulserCoreImpl * p, double deadline);
+
+  //- waits for the pulser callback to return (<lock_> MUST be locked by the calling thread)
+  void wait_callback_i (PulserCoreImpl * p);
+
+  //- deletes a pulser removed from its own callback (<lock_> MUST be locked by the calling thread)
+  void reclaim_i (PulserCoreImpl * p);
+
+  //- the service clock in msecs
+  double now_msec ();
+
+  //- protects the timers and the pulsers state
+  Mutex lock_;
+
+  //- signaled on timers change and callback return
+  Condition cond_;
+
+  //- the armed timers (next pulse date in msecs)
+  std::multimap<double, PulserCoreImpl *> timers_;
+
+  //- set when the service must quit
+  bool stop_;
+
+  //- the service thread id
+  ThreadUID uid_;
+
+  //- the service clock
+  Timer clock_;
+
+  //- the service instance and its refs count
+  static Mutex instance_lock;
+  static PulserTimerService * instance;
+  static size_t instance_refs;
+
+  //- the service stopped by its own thread (last pulser deleted from its
+  //- callback) and not joined yet - joined by the next acquire or at exit
+  static PulserTimerService * orphan;
+  static bool orphan_hook_installed;
+};
+
+Mutex PulserTimerService::instance_lock;
+PulserTimerService * PulserTimerService::instance = 0;
+size_t PulserTimerService::instance_refs = 0;
+PulserTimerService * PulserTimerService::orphan = 0;
+bool PulserTimerService::orphan_hook_installed = false;
+
+// ======================================================================
+// join_orphan_pulser_service: atexit hook
+// ======================================================================
+extern "C" void join_orphan_pulser_service ()
+{
+  PulserTimerService::join_orphan();
+}
+
+// ======================================================================
+// PulserTimerService::PulserTimerService
+// ======================================================================
+PulserTimerService::PulserTimerService ()
+  : cond_ (lock_), stop_ (false), uid_ (0)
+{
+}
+
+// ======================================================================
+// PulserTimerService::acquire
+// ======================================================================
+PulserTimerService * PulserTimerService::acquire ()
+{
+  //- a previous service stopped by its own thread is joined first
+  PulserTimerService::join_orphan();
+
+  MutexLock guard(instance_lock);
+  if ( ! instance )
   {
-    if( sync )
-      this->wait_msg_handled(START_MSG);
-    else
-      this->post(START_MSG);
+    //- the static <instance_lock> must outlive an orphan service thread
+    if ( ! orphan_hook_installed )
+    {
+      ::atexit(join_orphan_pulser_service);
+      orphan_hook_installed = true;
+    }
+    PulserTimerService * s = new PulserTimerService;
+    s->start_undetached();
+    instance = s;
   }
+  instance_refs++;
+  return instance;
+}
 
-  void stop (bool sync)
+// ======================================================================
+// PulserTimerService::release
+// ======================================================================
+void PulserTimerService::release ()
+{
+  PulserTimerService * s = 0;
   {
-    if( sync )
-      this->wait_msg_handled(STOP_MSG);
-    else
-      this->post(STOP_MSG);
+    MutexLock guard(instance_lock);
+    if ( --instance_refs == 0 )
+    {
+      s = instance;
+      instance = 0;
+    }
   }
+  //- last pulser gone: stop the service thread
+  if ( s )
+    s->exit();
+}
 
-  void suspend (bool sync)
+// ======================================================================
+// PulserTimerService::join_orphan
+// ======================================================================
+void PulserTimerService::join_orphan ()
+{
+  PulserTimerService * s = 0;
   {
-    if( sync )
-      this->wait_msg_handled(SUSPEND_MSG);
-    else
-      this->post(SUSPEND_MSG);
+    MutexLock guard(instance_lock);
+    s = orphan;
+    orphan = 0;
   }
+  //- the orphan already left its loop: just join it
+  if ( s )
+    s->exit();
+}
 
-  void resume (bool sync)
+// ======================================================================
+// PulserTimerService::exit
+// ======================================================================
+void PulserTimerService::exit ()
+{
   {
-    if( sync )
-      this->wait_msg_handled(RESUME_MSG);
-    else
-      this->post(RESUME_MSG);
+    MutexLock guard(this->lock_);
+    this->stop_ = true;
+    this->cond_.broadcast();
   }
+  Thread::IOArg dummy = 0;
+  this->join(&dummy);
+}
+
+// ======================================================================
+// PulserTimerService::now_msec
+// ======================================================================
+double PulserTimerService::now_msec ()
+{
+  return this->clock_.elapsed_msec();
+}
 
-  size_t get_num_pulses () const {
-    return this->cfg_.num_pulses;
+// ======================================================================
+// PulserTimerService::arm_i
+// ======================================================================
+void PulserTimerService::arm_i (PulserCoreImpl * p, double _deadline)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  //- disarm the current timer (if any)
+  if ( p->deadline_ >= 0. )
+  {
+    typedef std::multimap<double, PulserCoreImpl *>::iterator Iterator;
+    std::pair<Iterator, Iterator> r = this->timers_.equal_range(p->deadline_);
+    for ( Iterator it = r.first; it != r.second; ++it )
+    {
+      if ( it->second == p )
+      {
+        this->timers_.erase(it);
+        break;
+      }
+    }
+  }
+
+  p->deadline_ = _deadline;
+
+  if ( _deadline >= 0. )
+  {
+    //- wakeup the service if this is the new earliest timer
+    bool earliest = this->timers_.empty() || _deadline < this->timers_.begin()->first;
+    this->timers_.insert(std::make_pair(_deadline, p));
+    if ( earliest )
+      this->cond_.broadcast();
   }
+}
+
+// ======================================================================
+// PulserTimerService::wait_callback_i
+// ======================================================================
+void PulserTimerService::wait_callback_i (PulserCoreImpl * p)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  //- called from a callback: can't wait for ourself
+  if ( ThreadingUtilities::self() == this->uid_ )
+    return;
 
-  bool is_running() const {
-    return this->periodic_msg_enabled();
+  while ( p->in_callback_ )
+    this->cond_.wait();
+}
+
+// ======================================================================
+// PulserTimerService::start
+// ======================================================================
+void PulserTimerService::start (PulserCoreImpl * p, bool sync)
+{
+  MutexLock guard(this->lock_);
+  p->generation_++;
+  p->pulses_ = 0;
+  p->enabled_ = true;
+  this->arm_i(p, this->now_msec() + p->cfg_.period_in_msecs);
+  if ( sync )
+    this->wait_callback_i(p);
+}
+
+// ======================================================================
+// PulserTimerService::stop
+// ======================================================================
+void PulserTimerService::stop (PulserCoreImpl * p, bool sync)
+{
+  MutexLock guard(this->lock_);
+  p->generation_++;
+  p->enabled_ = false;
+  this->arm_i(p, -1.);
+  if ( sync )
+    this->wait_callback_i(p);
+}
+
+// ======================================================================
+// PulserTimerService::resume
+// ======================================================================
+void PulserTimerService::resume (PulserCoreImpl * p, bool sync)
+{
+  MutexLock guard(this->lock_);
+  if ( ! p->enabled_ && ( ! p->cfg_.num_pulses || p->pulses_ < p->cfg_.num_pulses ) )
+  {
+    p->generation_++;
+    p->enabled_ = true;
+    this->arm_i(p, this->now_msec() + p->cfg_.period_in_msecs);
   }
+  if ( sync )
+    this->wait_callback_i(p);
+}
+
+// ======================================================================
+// PulserTimerService::set_period
+// ======================================================================
+void PulserTimerService::set_period (PulserCoreImpl * p, double p_msecs)
+{
+  MutexLock guard(this->lock_);
+  double previous = p->cfg_.period_in_msecs;
+  p->cfg_.period_in_msecs = p_msecs;
+  //- reschedule the next pulse according to the new period
+  if ( p->deadline_ >= 0. )
+    this->arm_i(p, p->deadline_ - previous + p_msecs);
+}
+
+// ======================================================================
+// PulserTimerService::get_period
+// ======================================================================
+double PulserTimerService::get_period (PulserCoreImpl * p)
+{
+  MutexLock guard(this->lock_);
+  return p->cfg_.period_in_msecs;
+}
+
+// ======================================================================
+// PulserTimerService::set_num_pulses
+// ======================================================================
+void PulserTimerService::set_num_pulses (PulserCoreImpl * p, size_t num_pulses)
+{
+  MutexLock guard(this->lock_);
+  p->cfg_.num_pulses = num_pulses;
+}
+
+// ======================================================================
+// PulserTimerService::get_num_pulses
+// ======================================================================
+size_t PulserTimerService::get_num_pulses (PulserCoreImpl * p)
+{
+  MutexLock guard(this->lock_);
+  return p->cfg_.num_pulses;
+}
+
+// ======================================================================
+// PulserTimerService::is_running
+// ======================================================================
+bool PulserTimerService::is_running (PulserCoreImpl * p)
+{
+  MutexLock guard(this->lock_);
+  return p->enabled_;
+}
 
-  bool is_done() const {
-    return this->pulses_ == this->cfg_.num_pulses;
+// ======================================================================
+// PulserTimerService::is_done
+// ======================================================================
+bool PulserTimerService::is_done (PulserCoreImpl * p)
+{
+  MutexLock guard(this->lock_);
+  return p->pulses_ == p->cfg_.num_pulses;
+}
+
+// ======================================================================
+// PulserTimerService::remove
+// ======================================================================
+bool PulserTimerService::remove (PulserCoreImpl * p)
+{
+  MutexLock guard(this->lock_);
+  p->generation_++;
+  p->enabled_ = false;
+  this->arm_i(p, -1.);
+
+  //- deleted from its own callback: defer the reclamation
+  if ( p->in_callback_ && ThreadingUtilities::self() == this->uid_ )
+  {
+    p->dead_ = true;
+    return false;
   }
 
-  void set_num_pulses (size_t num_pulses) {
-    this->wait_msg_handled(NUM_PULSES_CHANGED, num_pulses, 1000);
+  this->wait_callback_i(p);
+  return true;
+}
+
+// ======================================================================
+// PulserTimerService::reclaim_i
+// ======================================================================
+void PulserTimerService::reclaim_i (PulserCoreImpl * p)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  delete p;
+
+  //- release the pulser's ref. on the service without going through release():
+  //- the service can't join itself, so if this was the last pulser it just
+  //- leaves its loop and is joined by the next acquire (or at exit)
+  MutexLock guard(instance_lock);
+  if ( --instance_refs == 0 && instance == this )
+  {
+    instance = 0;
+    orphan = this;
+    this->stop_ = true;
   }
+}
 
-protected:
-  virtual void handle_message (yat::Message& msg)
+// ======================================================================
+// PulserTimerService::run_undetached
+// ======================================================================
+Thread::IOArg PulserTimerService::run_undetached (Thread::IOArg)
+{
+  MutexLock guard(this->lock_);
+
+  this->uid_ = ThreadingUtilities::self();
+
+  while ( ! this->stop_ )
   {
-    switch ( msg.type() )
+    //- no armed timer: wait for a pulser to be started
+    if ( this->timers_.empty() )
     {
-      case START_MSG:
-        {
-          this->pulses_ = 0;
-          this->set_periodic_msg_period(this->cfg_.period_in_msecs);
-          this->enable_periodic_msg(true);
-          this->enable_precise_periodic_timing(true);
-        }
-        break;
-      case RESUME_MSG:
-        {
-          if( this->pulses_ < this->cfg_.num_pulses )
-            this->enable_periodic_msg(true);
-        }
-        break;
-      case STOP_MSG:
-      case SUSPEND_MSG:
-        {
-          this->enable_periodic_msg(false);
-        }
-        break;
-      case NUM_PULSES_CHANGED:
-        {
-          this->cfg_.num_pulses = msg.get_data<size_t>();
-        }
-        break;
-      case yat::TASK_PERIODIC:
-        {
-          if ( this->cfg_.callback.is_empty() )
-          {
-            this->enable_periodic_msg(false);
-            return;
-          }
-          try
-          {
-            this->cfg_.callback(this->cfg_.user_data);
-          }
-          catch ( ... )
-          {
-            //- noop
-          }
-          if ( this->cfg_.num_pulses && ( ++this->pulses_ == this->cfg_.num_pulses ) )
-          {
-            this->enable_periodic_msg(false);
-          }
-        }
-        break;
-      default:
-        break;
+      this->cond_.wait();
+      continue;
+    }
+
+    //- wait for the earliest timer to expire (or a new earliest timer)
+    double now = this->now_msec();
+    double dt = this->timers_.begin()->first - now;
+    if ( dt > 0. )
+    {
+      unsigned long secs = static_cast<unsigned long>(dt / 1000.);
+      unsigned long nsecs = static_cast<unsigned long>((dt - 1000. * secs) * 1.e6);
+      this->cond_.timed_wait(secs, nsecs ? nsecs : 1);
+      continue;
     }
+
+    //- pulse
+    PulserCoreImpl * p = this->timers_.begin()->second;
+    double deadline = p->deadline_;
+    this->arm_i(p, -1.);
+
+    if ( p->cfg_.callback.is_empty() )
+    {
+      p->enabled_ = false;
+      continue;
+    }
+
+    size_t generation = p->generation_;
+    p->in_callback_ = true;
+    //- call the callback outside of the critical section
+    this->lock_.unlock();
+    try
+    {
+      p->cfg_.callback(p->cfg_.user_data);
+    }
+    catch ( ... )
+    {
+      //- noop
+    }
+    this->lock_.lock();
+    p->in_callback_ = false;
+    this->cond_.broadcast();
+
+    //- pulser deleted by its callback
+    if ( p->dead_ )
+    {
+      this->reclaim_i(p);
+      continue;
+    }
+
+    //- pulser started/stopped/... by the callback (or meanwhile): nothing more to do
+    if ( p->generation_ != generation )
+      continue;
+
+    if ( p->cfg_.num_pulses && ( ++p->pulses_ == p->cfg_.num_pulses ) )
+    {
+      p->enabled_ = false;
+      continue;
+    }
+
+    //- absolute dates: no drift (missed pulses are skipped)
+    deadline += p->cfg_.period_in_msecs;
+    now = this->now_msec();
+    if ( deadline <= now )
+      deadline = now + p->cfg_.period_in_msecs;
+    this->arm_i(p, deadline);
   }
 
-private:
-  Pulser::Config cfg_;
-  size_t pulses_;
-};
+  return 0;
+}
 
 // ======================================================================
 // Pulser::Config::Config
@@ -210,8 +600,15 @@ Pulser::Pulser (const Pulser::Config& cfg)
                     "pulses number too high (may be a negative value is passed)",
                     "Pulser::Pulser");
 
-  this->impl_ = new PulserCoreImpl(this->cfg_);
-  this->impl_->go();
+  PulserTimerService * service = PulserTimerService::acquire();
+  this->impl_ = new (std::nothrow) PulserCoreImpl(this->cfg_, service);
+  if ( ! this->impl_ )
+  {
+    PulserTimerService::release();
+    THROW_YAT_ERROR("OUT_OF_MEMORY",
+                    "PulserCoreImpl allocation failed",
+                    "Pulser::Pulser");
+  }
 }
 
 // ======================================================================
@@ -221,8 +618,12 @@ Pulser::~Pulser ()
 {
   try
   {
-    if ( this->impl_ )
-      this->impl_->exit();
+    //- if deleted from its own callback, the service reclaims the impl.
+    if ( this->impl_ && this->impl_->service_->remove(this->impl_) )
+    {
+      delete this->impl_;
+      PulserTimerService::release();
+    }
   }
   catch ( ... ) {}
 }
@@ -235,7 +636,7 @@ void Pulser::start ()
   YAT_TRACE("Pulser::start");
 
   if ( this->impl_ )
-    this->impl_->start(false);
+    this->impl_->service_->start(this->impl_, false);
 }
 
 // ============================================================================
@@ -246,7 +647,7 @@ void Pulser::start_sync ()
   YAT_TRACE("Pulser::start_sync");
 
   if ( this->impl_ )
-    this->impl_->start(true);
+    this->impl_->service_->start(this->impl_, true);
 }
 
 // ============================================================================
@@ -257,7 +658,7 @@ void Pulser::stop ()
   YAT_TRACE("Pulser::stop");
 
   if ( this->impl_ )
-    this->impl_->stop(false);
+    this->impl_->service_->stop(this->impl_, false);
 }
 
 // ============================================================================
@@ -268,7 +669,7 @@ void Pulser::stop_sync ()
   YAT_TRACE("Pulser::stop_sync");
 
   if ( this->impl_ )
-    this->impl_->stop(true);
+    this->impl_->service_->stop(this->impl_, true);
 }
 
 // ============================================================================
@@ -281,7 +682,7 @@ void Pulser::set_period (double p_msecs)
   cfg_.period_in_msecs = p_msecs;
 
   if ( this->impl_ )
-    this->impl_->set_periodic_msg_period(p_msecs);
+    this->impl_->service_->set_period(this->impl_, p_msecs);
 }
 
 // ============================================================================
@@ -291,7 +692,7 @@ double Pulser::get_period () const
 {
   YAT_TRACE("Pulser::get_period");
 
-  return is_running() ? this->impl_->get_periodic_msg_period() : cfg_.period_in_msecs;
+  return is_running() ? this->impl_->service_->get_period(this->impl_) : cfg_.period_in_msecs;
 }
 
 // ============================================================================
@@ -304,7 +705,7 @@ void Pulser::set_num_pulses (size_t num_pulses)
   cfg_.num_pulses = num_pulses;
 
   if ( this->impl_ )
-    this->impl_->set_num_pulses(num_pulses);
+    this->impl_->service_->set_num_pulses(this->impl_, num_pulses);
 }
 
 // ============================================================================
@@ -314,7 +715,7 @@ size_t Pulser::get_num_pulses () const
 {
   YAT_TRACE("Pulser::get_num_pulses");
 
-  return is_running() ? this->impl_->get_num_pulses() : cfg_.num_pulses;
+  return is_running() ? this->impl_->service_->get_num_pulses(this->impl_) : cfg_.num_pulses;
 }
 
 // ============================================================================
@@ -325,7 +726,7 @@ void Pulser::suspend ()
   YAT_TRACE("Pulser::suspend");
 
   if ( this->impl_ )
-    this->impl_->suspend(false);
+    this->impl_->service_->stop(this->impl_, false);
 }
 
 // ============================================================================
@@ -336,7 +737,7 @@ void Pulser::suspend_sync ()
   YAT_TRACE("Pulser::suspend_sync");
 
   if ( this->impl_ )
-    this->impl_->suspend(true);
+    this->impl_->service_->stop(this->impl_, true);
 }
 
 // ============================================================================
@@ -347,7 +748,7 @@ void Pulser::resume ()
   YAT_TRACE("Pulser::resume");
 
   if ( this->impl_ )
-    this->impl_->resume(false);
+    this->impl_->service_->resume(this->impl_, false);
 }
 
 // ============================================================================
@@ -358,7 +759,7 @@ void Pulser::resume_sync ()
   YAT_TRACE("Pulser::resume_sync");
 
   if ( this->impl_ )
-    this->impl_->resume(true);
+    this->impl_->service_->resume(this->impl_, true);
 }
 
 // ============================================================================
@@ -369,7 +770,7 @@ bool Pulser::is_done () const
   YAT_TRACE("Pulser::is_done");
 
   if ( this->impl_ )
-    return this->impl_->is_done();
+    return this->impl_->service_->is_done(this->impl_);
 
   // code never reached!
   return false;
@@ -383,7 +784,7 @@ bool Pulser::is_running () const
   YAT_TRACE("Pulser::is_running");
 
   if ( this->impl_ )
-    return this->impl_->is_running();
+    return this->impl_->service_->is_running(this->impl_);
 
   // code never reached!
   return false;
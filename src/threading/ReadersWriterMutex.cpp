@@ -0,0 +1,190 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2004-2021 Synchrotron SOLEIL
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the GNU Lesser Public License v3
+// which accompanies this distribution, and is available at
+// http://www.gnu.org/licenses/lgpl.html
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// YAT LIBRARY
+//----------------------------------------------------------------------------
+//
+// Copyright (C) 2006-2021 The Tango Community
+//
+// Part of the code comes from the ACE Framework (asm bytes swaping code)
+// see http://www.cs.wustl.edu/~schmidt/ACE.html for more about ACE
+//
+// The thread native implementation has been initially inspired by omniThread
+// - the threading support library that comes with omniORB.
+// see http://omniorb.sourceforge.net/ for more about omniORB.
+//
+// Contributors form the TANGO community:
+// See AUTHORS file
+//
+// The YAT library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// The YAT library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// See COPYING file for license details
+//
+/*!
+ * \author See AUTHORS file
+ */
+
+// ============================================================================
+// DEPENDENCIES
+// ============================================================================
+#include <yat/threading/ReadersWriterMutex.h>
+#include <yat/threading/Utilities.h>
+
+namespace yat
+{
+
+// ============================================================================
+// ReadersWriterMutex::ReadersWriterMutex
+// ============================================================================
+ReadersWriterMutex::ReadersWriterMutex (size_t)
+  : m_readers_cond (m_mutex),
+    m_writer_cond (m_mutex)
+{
+  this->init_i(RW_SHARED_COUNTER);
+}
+
+// ============================================================================
+// ReadersWriterMutex::ReadersWriterMutex
+// ============================================================================
+ReadersWriterMutex::ReadersWriterMutex (ReadersMode _mode)
+  : m_readers_cond (m_mutex),
+    m_writer_cond (m_mutex)
+{
+  this->init_i(_mode);
+}
+
+// ============================================================================
+// ReadersWriterMutex::~ReadersWriterMutex
+// ============================================================================
+ReadersWriterMutex::~ReadersWriterMutex ()
+{
+  delete[] this->m_readers;
+}
+
+// ============================================================================
+// ReadersWriterMutex::init_i
+// ============================================================================
+void ReadersWriterMutex::init_i (ReadersMode _mode)
+{
+  this->m_mode = _mode;
+  this->m_readers_counters = 1;
+  if (_mode == RW_PER_CORE_COUNTERS)
+  {
+    size_t cores = ThreadingUtilities::harware_concurrency();
+    while (this->m_readers_counters < cores
+        && this->m_readers_counters < kRW_MUTEX_MAX_READERS_COUNTERS)
+      this->m_readers_counters *= 2;
+  }
+  this->m_readers = new ReadersCounter[this->m_readers_counters];
+}
+
+// ============================================================================
+// ReadersWriterMutex::readers_mode
+// ============================================================================
+ReadersWriterMutex::ReadersMode ReadersWriterMutex::readers_mode () const
+{
+  return this->m_mode;
+}
+
+// ============================================================================
+// ReadersWriterMutex::readers_counter_i
+// ============================================================================
+ReadersWriterMutex::ReadersCounter & ReadersWriterMutex::readers_counter_i ()
+{
+  if (this->m_readers_counters == 1)
+    return this->m_readers[0];
+  return this->m_readers[ThreadingUtilities::thread_index() & (this->m_readers_counters - 1)];
+}
+
+// ============================================================================
+// ReadersWriterMutex::has_readers_i
+// ============================================================================
+bool ReadersWriterMutex::has_readers_i ()
+{
+  for (size_t i = 0; i < this->m_readers_counters; ++i)
+    if (this->m_readers[i].count.load())
+      return true;
+  return false;
+}
+
+// ============================================================================
+// ReadersWriterMutex::lock_for_reading
+// ============================================================================
+void ReadersWriterMutex::lock_for_reading ()
+{
+  ReadersCounter & rc = this->readers_counter_i();
+  for (;;)
+  {
+    //- fast path: register then make sure no writer is pending
+    //- (both seq. consistent: a writer registers then checks the readers)
+    ++rc.count;
+    if (! this->m_writers.load())
+      return;
+
+    //- a writer is pending: step back and let it go
+    --rc.count;
+    MutexLock guard(this->m_mutex);
+    this->m_writer_cond.signal();
+    while (this->m_writers.load())
+      this->m_readers_cond.wait();
+  }
+}
+
+// ============================================================================
+// ReadersWriterMutex::unlock_for_reading
+// ============================================================================
+void ReadersWriterMutex::unlock_for_reading ()
+{
+  ReadersCounter & rc = this->readers_counter_i();
+  yat::uint32 remaining = --rc.count;
+  //- wake up the pending writer (if any) when the last reader leaves
+  //- (in per-core counters mode, we don't know whether we are the last one)
+  if (this->m_writers.load() && (! remaining || this->m_readers_counters > 1))
+  {
+    MutexLock guard(this->m_mutex);
+    this->m_writer_cond.signal();
+  }
+}
+
+// ============================================================================
+// ReadersWriterMutex::lock_for_writing
+// ============================================================================
+void ReadersWriterMutex::lock_for_writing ()
+{
+  //- block the new readers then wait for our turn
+  ++this->m_writers;
+  this->m_writer_mutex.lock();
+  //- wait for the current readers to leave
+  MutexLock guard(this->m_mutex);
+  while (this->has_readers_i())
+    this->m_writer_cond.wait();
+}
+
+// ============================================================================
+// ReadersWriterMutex::unlock_for_writing
+// ============================================================================
+void ReadersWriterMutex::unlock_for_writing ()
+{
+  this->m_writer_mutex.unlock();
+  //- last pending writer: let the readers go
+  if (--this->m_writers == 0)
+  {
+    MutexLock guard(this->m_mutex);
+    this->m_readers_cond.broadcast();
+  }
+}
+
+} // namespace
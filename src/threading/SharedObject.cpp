@@ -75,9 +75,14 @@ SharedObject * SharedObject::duplicate ()
 {
   YAT_TRACE("SharedObject::duplicate");
 
+#if defined (YAT_ATOMIC_LOCK_FREE)
+  //- the caller already owns a reference: no ordering required
+  this->reference_count_.fetch_add(1, memory_order_relaxed);
+#else
   MutexLock guard(this->lock_);
 
   this->reference_count_++;
+#endif
 
   return this;
 }
@@ -102,6 +107,15 @@ int SharedObject::release (bool _commit_suicide)
 // ============================================================================
 SharedObject *SharedObject::release_i ()
 {
+#if defined (YAT_ATOMIC_LOCK_FREE)
+  //- release: our changes to the object are visible to the thread deleting it
+  //- acquire: the deleting thread sees the changes made by the other owners
+  int prev = this->reference_count_.fetch_sub(1, memory_order_acq_rel);
+
+  DEBUG_ASSERT(prev > 0);
+
+  return (prev == 1) ? 0 : this;
+#else
   MutexLock guard (this->lock_);
 
   DEBUG_ASSERT(this->reference_count_ > 0);
@@ -109,6 +123,7 @@ SharedObject *SharedObject::release_i ()
   this->reference_count_--;
 
   return (this->reference_count_ == 0) ? 0 : this;
+#endif
 }
 
 } //- namespace
@@ -0,0 +1,74 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2004-2015 Synchrotron SOLEIL
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the GNU Lesser Public License v3
+// which accompanies this distribution, and is available at
+// http://www.gnu.org/licenses/lgpl.html
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// YAT LIBRARY
+//----------------------------------------------------------------------------
+//
+// Copyright (C) 2006-2012  N.Leclercq & The Tango Community
+//
+// Part of the code comes from the ACE Framework (asm bytes swaping code)
+// see http://www.cs.wustl.edu/~schmidt/ACE.html for more about ACE
+//
+// The thread native implementation has been initially inspired by omniThread
+// - the threading support library that comes with omniORB.
+// see http://omniorb.sourceforge.net/ for more about omniORB.
+//
+// Contributors form the TANGO community:
+// See AUTHORS file
+//
+// The YAT library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// The YAT library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// See COPYING file for license details
+//
+/*!
+ * \author See AUTHORS file
+ */
+
+// ============================================================================
+// DEPENDENCIES
+// ============================================================================
+#include <yat/threading/SignalTask.h>
+
+namespace yat
+{
+
+// ============================================================================
+// SignalTask::SignalTask
+// ============================================================================
+SignalTask::SignalTask (const Task::Config & _cfg)
+  : Task(_cfg)
+{
+  this->on<kSIGNAL_EMISSION_MSG, SignalTask, yat::Message, &SignalTask::emit_i>();
+}
+
+// ============================================================================
+// SignalTask::handle_message
+// ============================================================================
+void SignalTask::handle_message (yat::Message &)
+{
+  //- noop
+}
+
+// ============================================================================
+// SignalTask::emit_i
+// ============================================================================
+void SignalTask::emit_i (yat::Message & _msg)
+{
+  SharedPtr<SignalEmission> & e = _msg.get_data<SharedPtr<SignalEmission> >();
+  _msg.reply(e->emit());
+}
+
+} // namespace
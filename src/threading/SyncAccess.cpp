@@ -40,6 +40,7 @@
 // DEPENDENCIES
 //=============================================================================
 #include <iostream>
+#include <map>
 #include <yat/threading/SyncAccess.h>
 
 namespace yat
@@ -68,8 +69,35 @@ namespace yat
 //=============================================================================
 // class SyncAccess
 //=============================================================================
-std::map<SyncAccess::obj_ptr, SyncAccess::SyncObject *> SyncAccess::m_sSynObjMap;
-yat::Mutex SyncAccess::m_sLock;
+
+//----------------------------------------------------------------------------
+// SyncAccess::Stripe
+//----------------------------------------------------------------------------
+struct SyncAccess::Stripe
+{
+  //- To lock the stripe map access.
+  yat::Mutex m_Lock;
+
+  //- Synchronized objects of the stripe.
+  std::map<obj_ptr, SyncObject *> m_SynObjMap;
+
+  //- Keep the stripes on distinct cache lines.
+  char m_pad[64];
+};
+
+//----------------------------------------------------------------------------
+// SyncAccess::stripe
+//----------------------------------------------------------------------------
+SyncAccess::Stripe & SyncAccess::stripe(void *ptr)
+{
+  //- intentionally leaked (objects may be locked during the static objects destruction)
+  static Stripe *stripes = new Stripe[kSYNC_ACCESS_STRIPES];
+  //- drop the (always null) low order bits of the object address
+  size_t h = reinterpret_cast<size_t>(ptr) >> 3;
+  h ^= h >> 7;
+  return stripes[h & (kSYNC_ACCESS_STRIPES - 1)];
+}
+
 //----------------------------------------------------------------------------
 // SyncAccess::SyncAccess
 //----------------------------------------------------------------------------
@@ -94,28 +122,29 @@ SyncAccess::~SyncAccess()
 void SyncAccess::lock_obj(void *ptr)
 {
   // Lock access to map
-  m_sLock.lock();
+  Stripe &st = stripe(ptr);
+  st.m_Lock.lock();
 
   DEBUG_LOG("lock_obj: lock addr: " << ptr << " in thread: " << yat::ThreadingUtilities::self() << "\n")
   SyncObject *pSyncObj = NULL;
   // Look in map for pointer
-  std::map<obj_ptr, SyncObject *>::iterator it = m_sSynObjMap.find(ptr);
-  if( it == m_sSynObjMap.end() )
+  std::map<obj_ptr, SyncObject *>::iterator it = st.m_SynObjMap.find(ptr);
+  if( it == st.m_SynObjMap.end() )
   {
     // Object is not referenced => create SyncObj
     pSyncObj = new SyncObject(ptr);
-    m_sSynObjMap[ptr] = pSyncObj;
+    st.m_SynObjMap[ptr] = pSyncObj;
     m_pSyncObj = pSyncObj;
     pSyncObj->m_uiLockCount++;
 
-    LOCK_STAT_OBJ_COUNT(m_sSynObjMap)
+    LOCK_STAT_OBJ_COUNT(st.m_SynObjMap)
     DEBUG_LOG("lock_obj: new sync object. lock count: " << pSyncObj->m_uiLockCount-1 << " -> " << pSyncObj->m_uiLockCount << "\n")
   }
   else
   {
     pSyncObj = it->second;
     m_pSyncObj = pSyncObj;
-    if( pSyncObj->m_CurrentThreadId == yat::ThreadingUtilities::self() )
+    if( pSyncObj->m_CurrentThreadId.load(yat::memory_order_relaxed) == yat::ThreadingUtilities::self() )
     {
       // Current thread already lock the object
       DEBUG_LOG("lock_obj: Current thread already lock the object\n")
@@ -129,7 +158,7 @@ void SyncAccess::lock_obj(void *ptr)
 
       // Release access to map
       DEBUG_LOG("lock_obj: unlock sync access mutex in thread " <<  yat::ThreadingUtilities::self() << "\n")
-      m_sLock.unlock();
+      st.m_Lock.unlock();
       return;
     }
     pSyncObj->m_uiLockCount++;
@@ -141,7 +170,7 @@ void SyncAccess::lock_obj(void *ptr)
   DEBUG_LOG("lock_obj: unlock sync access mutex in thread " <<  yat::ThreadingUtilities::self() << "\n")
   
   // Release access to map to allow a unlock from another thread
-  m_sLock.unlock();
+  st.m_Lock.unlock();
   
   DEBUG_LOG("lock_obj: wait for object access\n")
   // finally lock access to object
@@ -150,7 +179,7 @@ void SyncAccess::lock_obj(void *ptr)
   DEBUG_LOG("lock_obj: Object locked in thread: " << yat::ThreadingUtilities::self() << "\n")
 
   // Setting thread id of the access owner
-  pSyncObj->m_CurrentThreadId = yat::ThreadingUtilities::self();
+  pSyncObj->m_CurrentThreadId.store(yat::ThreadingUtilities::self(), yat::memory_order_relaxed);
   pSyncObj->m_uiThreadCount++;
 }
 
@@ -160,16 +189,17 @@ void SyncAccess::lock_obj(void *ptr)
 void SyncAccess::unlock_obj(void *ptr)
 {
   // Lock access to map
-  m_sLock.lock();
+  Stripe &st = stripe(ptr);
+  st.m_Lock.lock();
 
   DEBUG_LOG("unlock_obj: unlock addr: " << ptr << " in thread: " << yat::ThreadingUtilities::self() << "\n")
 
   // Look in map for pointer
-  std::map<obj_ptr, SyncObject *>::iterator it = m_sSynObjMap.find(ptr);
-  if( it == m_sSynObjMap.end() )
+  std::map<obj_ptr, SyncObject *>::iterator it = st.m_SynObjMap.find(ptr);
+  if( it == st.m_SynObjMap.end() )
   {
     //## Object never locked => exception
-    m_sLock.unlock();
+    st.m_Lock.unlock();
     DEBUG_LOG("unlock_obj: !!!!Object never locked!!!!\n")
     return;
   }
@@ -185,7 +215,7 @@ void SyncAccess::unlock_obj(void *ptr)
   {
     DEBUG_LOG("unlock_obj: Objet no longer in use in the current thread\n")
     // Objet no longer in use in the current thread
-    pSyncObj->m_CurrentThreadId = YAT_INVALID_THREAD_UID;
+    pSyncObj->m_CurrentThreadId.store(YAT_INVALID_THREAD_UID, yat::memory_order_relaxed);
     pSyncObj->m_Mutex.unlock();
   }
   
@@ -194,10 +224,10 @@ void SyncAccess::unlock_obj(void *ptr)
     DEBUG_LOG("unlock_obj: No more LOCK() on this object => delete entry\n")
     // No more LOCK() on this object =>  delete the entry in map
     delete pSyncObj;
-    m_sSynObjMap.erase(it);
+    st.m_SynObjMap.erase(it);
   }  
   DEBUG_LOG("unlock_obj: unlock sync access mutex in thread " <<  yat::ThreadingUtilities::self() << "\n")
-  m_sLock.unlock();
+  st.m_Lock.unlock();
 }
 
 
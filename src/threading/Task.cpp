@@ -41,6 +41,7 @@
 // DEPENDENCIES
 // ============================================================================
 #include <yat/threading/Task.h>
+#include <yat/threading/TaskExecutor.h>
 
 #if !defined (YAT_INLINE_IMPL)
 # include <yat/threading/Task.i>
@@ -58,10 +59,20 @@ namespace yat
       enable_periodic_msg (false),
       periodic_msg_period_ms (0),
       enable_precise_periodic_timing(false),
+      enable_high_precision_periodic_timing (false),
+      periodic_msg_spin_usecs (0),
       lock_msg_handling (false),
       lo_wm (kDEFAULT_LO_WATER_MARK),
       hi_wm (kDEFAULT_HI_WATER_MARK),
       throw_on_post_tmo (false),
+      lock_free_msgq (false),
+      msg_batch_size (1),
+      msgq_spin_usecs (0),
+      cpu_affinity (),
+      sched_policy (Thread::SCHED_POLICY_DEFAULT),
+      sched_priority (0),
+      stack_size (0),
+      executor (0),
       user_data (0)
 {
   /* noop ctor */
@@ -84,10 +95,20 @@ namespace yat
       enable_periodic_msg (_enable_periodic_msg),
       periodic_msg_period_ms (_periodic_msg_period_ms),
       enable_precise_periodic_timing (false),
+      enable_high_precision_periodic_timing (false),
+      periodic_msg_spin_usecs (0),
       lock_msg_handling (_lock_msg_handling),
       lo_wm (_lo_wm),
       hi_wm (_hi_wm),
       throw_on_post_tmo (_throw_on_post_tmo),
+      lock_free_msgq (false),
+      msg_batch_size (1),
+      msgq_spin_usecs (0),
+      cpu_affinity (),
+      sched_policy (Thread::SCHED_POLICY_DEFAULT),
+      sched_priority (0),
+      stack_size (0),
+      executor (0),
       user_data (_user_data)
 {
   /* noop ctor */
@@ -111,10 +132,20 @@ namespace yat
       enable_periodic_msg (_enable_periodic_msg),
       periodic_msg_period_ms (_periodic_msg_period_ms),
       enable_precise_periodic_timing (_enable_precise_periodic_timing),
+      enable_high_precision_periodic_timing (false),
+      periodic_msg_spin_usecs (0),
       lock_msg_handling (_lock_msg_handling),
       lo_wm (_lo_wm),
       hi_wm (_hi_wm),
       throw_on_post_tmo (_throw_on_post_tmo),
+      lock_free_msgq (false),
+      msg_batch_size (1),
+      msgq_spin_usecs (0),
+      cpu_affinity (),
+      sched_policy (Thread::SCHED_POLICY_DEFAULT),
+      sched_priority (0),
+      stack_size (0),
+      executor (0),
       user_data (_user_data)
 {
   /* noop ctor */
@@ -129,7 +160,14 @@ Task::Task ()
     periodic_msg_period_ms_ (0),
     precise_periodic_timing_enabled_(false),
     user_data_ (0),
-    lock_msg_handling_ (false)
+    lock_msg_handling_ (false),
+    msg_batch_size_ (1),
+    received_init_msg_(false),
+    executor_ (0),
+    exec_slot_ (0),
+    exec_last_activity_ms_ (0.),
+    exec_next_periodic_ms_ (-1.),
+    exec_exited_ (false)
 {
   YAT_TRACE("Task::Task");
 
@@ -144,18 +182,44 @@ Task::Task ()
 // Task::Task
 // ======================================================================
 Task::Task (const Task::Config& cfg)
-  : msg_q_ (cfg.lo_wm, cfg.hi_wm, cfg.throw_on_post_tmo),
+  : msg_q_ (cfg.lo_wm, cfg.hi_wm, cfg.throw_on_post_tmo, cfg.lock_free_msgq),
     timeout_msg_period_ms_ (cfg.timeout_msg_period_ms),
     periodic_msg_period_ms_ (cfg.periodic_msg_period_ms),
     precise_periodic_timing_enabled_ (cfg.enable_precise_periodic_timing),
     user_data_ (cfg.user_data),
     lock_msg_handling_ (cfg.lock_msg_handling),
-    received_init_msg_(false)
+    msg_batch_size_ (cfg.msg_batch_size ? cfg.msg_batch_size : 1),
+    received_init_msg_(false),
+    executor_ (cfg.executor),
+    exec_slot_ (0),
+    exec_last_activity_ms_ (0.),
+    exec_next_periodic_ms_ (-1.),
+    exec_exited_ (false)
 {
   YAT_TRACE("Task::Task");
 
   msg_q_.enable_timeout_msg_ = cfg.enable_timeout_msg;
   msg_q_.enable_periodic_msg_ = cfg.enable_periodic_msg;
+  msg_q_.spin_usecs_ = cfg.msgq_spin_usecs;
+  msg_q_.hp_periodic_ = cfg.enable_high_precision_periodic_timing;
+  msg_q_.hp_spin_usecs_ = cfg.periodic_msg_spin_usecs;
+
+  //- executor mode: the task is scheduled each time a msg is posted
+  if (this->executor_)
+  {
+    this->exec_slot_ = this->executor_->register_task(this);
+    this->msg_q_.notifier(this);
+  }
+  else
+  {
+    //- thread settings (applied when the thread is spawned)
+    if (! cfg.cpu_affinity.empty())
+      this->cpu_affinity(cfg.cpu_affinity);
+    if (cfg.sched_policy != Thread::SCHED_POLICY_DEFAULT)
+      this->scheduling(cfg.sched_policy, cfg.sched_priority);
+    if (cfg.stack_size)
+      this->stack_size(cfg.stack_size);
+  }
 
 #if defined (YAT_DEBUG)
   this->next_msg_counter = 0;
@@ -185,6 +249,79 @@ Task::~Task ()
   YAT_LOG("Task::run_undetached::total processed msg:: "
         << this->user_msg_counter + this->ctrl_msg_counter);
 #endif
+
+  if (this->exec_slot_)
+  {
+    this->msg_q_.notifier(0);
+    this->executor_->unregister_task(this->exec_slot_);
+  }
+}
+
+// ============================================================================
+// Task::on_i
+// ============================================================================
+void Task::on_i (size_t _msg_type, Dispatch _d)
+{
+  //- the reserved msg types have their own table
+  std::vector<Dispatch> * table = &this->dispatch_;
+  size_t index = _msg_type;
+  if (_msg_type >= FIRST_RESERVED_MSG && _msg_type <= LAST_RESERVED_MSG)
+  {
+    table = &this->reserved_dispatch_;
+    index = _msg_type - FIRST_RESERVED_MSG;
+  }
+  else if (_msg_type >= kMAX_TASK_HANDLER_MSG_TYPE)
+  {
+    THROW_YAT_ERROR("BAD_ARG",
+                    "message type out of range [must be lower than kMAX_TASK_HANDLER_MSG_TYPE]",
+                    "Task::on");
+  }
+
+  if (index >= table->size())
+  {
+    try
+    {
+      table->resize(index + 1, Dispatch(0));
+    }
+    catch (...)
+    {
+      THROW_YAT_ERROR("OUT_OF_MEMORY",
+                      "dispatch table allocation failed",
+                      "Task::on");
+    }
+  }
+
+  //- replace the previous handler (if any)
+  (*table)[index] = _d;
+}
+
+// ============================================================================
+// Task::off
+// ============================================================================
+void Task::off (size_t _msg_type)
+{
+  Dispatch * d = this->dispatch_entry_i(_msg_type);
+  if (d)
+    *d = 0;
+}
+
+// ============================================================================
+// Task::start_i
+// ============================================================================
+void Task::start_i ()
+{
+  if (this->executor_)
+    this->executor_->attach(this->exec_slot_);
+  else
+    this->start_undetached();
+}
+
+// ============================================================================
+// Task::message_posted
+// ============================================================================
+void Task::message_posted ()
+{
+  this->executor_->notify(this->exec_slot_);
 }
 
 // ============================================================================
@@ -204,7 +341,7 @@ void Task::go (size_t _tmo_ms)
 {
   YAT_TRACE("Task::go");
 
-  this->start_undetached();
+  this->start_i();
 
   Message * msg = 0;
   try
@@ -239,7 +376,7 @@ void Task::go (Message * _msg, size_t _tmo_ms)
 {
   YAT_TRACE("Task::go");
 
-  this->start_undetached();
+  this->start_i();
 
   if (
          (_msg == 0)
@@ -262,7 +399,7 @@ void Task::go_asynchronously (size_t _tmo_ms)
 {
   YAT_TRACE("Task::go_asynchronously");
 
-  this->start_undetached();
+  this->start_i();
 
   Message * msg = 0;
   try
@@ -287,7 +424,7 @@ void Task::go_asynchronously (Message * _msg, size_t _tmo_ms)
 {
   YAT_TRACE("Task::go_asynchronously");
 
-  this->start_undetached();
+  this->start_i();
 
   if (
          (_msg == 0)
@@ -303,20 +440,223 @@ void Task::go_asynchronously (Message * _msg, size_t _tmo_ms)
 
 
 // ============================================================================
-// Task::run_undetached
+// Task::next_message_i
 // ============================================================================
-void * Task::run_undetached (void *)
+Message * Task::next_message_i (double _tmo_msecs, std::vector<Message *> & msgs_)
 {
-  YAT_TRACE("Task::run_undetached");
+  msgs_.clear();
+
+  //- no batching: one msg per msgQ access
+  if (this->msg_batch_size_ <= 1)
+  {
+    if( precise_periodic_timing_enabled_ )
+      return this->msg_q_.next_message_ex (_tmo_msecs);
+    return this->msg_q_.next_message (_tmo_msecs);
+  }
+
+  //- batch mode: extract up to <msg_batch_size_> msgs per msgQ access
+  if( precise_periodic_timing_enabled_ )
+    this->msg_q_.next_messages_ex (msgs_, this->msg_batch_size_, _tmo_msecs);
+  else
+    this->msg_q_.next_messages (msgs_, this->msg_batch_size_, _tmo_msecs);
+
+  return msgs_.empty() ? 0 : msgs_[0];
+}
+
+// ============================================================================
+// Task::handle_messages
+// ============================================================================
+void Task::handle_messages (std::vector<yat::Message *>& _msgs)
+{
+  for (size_t i = 0; i < _msgs.size(); i++)
+  {
+    try
+    {
+      this->dispatch_i (*_msgs[i]);
+    }
+    catch (const Exception& e)
+    {
+      //- store exception into the message
+      _msgs[i]->set_error(e);
+    }
+    catch (...)
+    {
+      Exception e("UNKNOWN_ERROR",
+                  "unknown error caught while handling msg",
+                  "Task::handle_messages");
+      //- store exception into the message
+      _msgs[i]->set_error(e);
+    }
+  }
+}
+
+// ============================================================================
+// Task::handle_message_i
+// ============================================================================
+bool Task::handle_message_i (Message * msg)
+{
+  //- set msg user data
+  msg->user_data(this->user_data_);
+
+  //- we may need msg type after msg release
+  size_t msg_type = msg->type();
 
 #if defined (YAT_DEBUG)
-  yat::Timestamp last_notification_timestamp, now;
+  if (msg->is_task_ctrl_message ())
+    this->ctrl_msg_counter++;
+  else
+    this->user_msg_counter++;
+
+ YAT_LOG("Task::run_undetached::handling msg ["
+         << std::hex
+         << (void*)msg
+         << std::dec
+         << "]");
+#endif
+
+  //- latency stats: handling start date
+  yat::uint64 t0 = 0;
+  if (this->msg_q_.latency_stats_mode_ != MessageQ::LATENCY_STATS_OFF)
+    t0 = MessageQ::latency_clock_ns();
+
+  //- got a valid message from message Q
+  try
+  {
+    //- std::cout << "Task::handling msg::"
+    //-            << std::hex
+    //-            << long(msg)
+    //-            << std::dec
+    //-            << "::"
+    //-            << msg->to_string()
+    //-            << std::endl;
+    //- call message handler
+    if (this->lock_msg_handling_)
+    {
+      //- enter critical section
+      MutexLock guard (this->m_lock);
+      this->dispatch_i (*msg);
+    }
+    else
+    {
+      this->dispatch_i (*msg);
+    }
+  }
+  catch (const Exception& e)
+  {
+    //- store exception into the message
+    msg->set_error(e);
+  }
+  catch (...)
+  {
+    Exception e("UNKNOWN_ERROR",
+                "unknown error caught while handling msg",
+                "Task::run_undetached");
+    //- store exception into the message
+    msg->set_error(e);
+  }
+
+  //- latency stats: handling duration
+  if (t0)
+    this->msg_q_.record_handling(msg_type, MessageQ::latency_clock_ns() - t0);
+
+#if defined (YAT_DEBUG)
+
+ YAT_LOG("Task::run_undetached::msg ["
+         << std::hex
+         << (void*)msg
+         << std::dec
+         << "] handled - notifying waiters");
 #endif
+  //- mark message as "processed" (this will signal waiters if any)
+  msg->processed();
+  //- release our msg ref
+  msg->release();
+  //- abort requested?
+  if (msg_type == TASK_EXIT)
+  {
+    //- close the msgQ
+    this->msg_q_.close();
+    return true;
+  }
+  return false;
+}
+
+// ============================================================================
+// Task::handle_messages_i
+// ============================================================================
+void Task::handle_messages_i (std::vector<Message *> & batch)
+{
+#if defined (YAT_DEBUG)
+  this->user_msg_counter += batch.size();
+#endif
+  //- set msgs user data
+  for (size_t i = 0; i < batch.size(); i++)
+    batch[i]->user_data(this->user_data_);
+
+  //- latency stats: handling start date
+  yat::uint64 t0 = 0;
+  if (this->msg_q_.latency_stats_mode_ != MessageQ::LATENCY_STATS_OFF)
+    t0 = MessageQ::latency_clock_ns();
+
+  try
+  {
+    //- call batch message handler
+    if (this->lock_msg_handling_)
+    {
+      //- enter critical section
+      MutexLock guard (this->m_lock);
+      this->handle_messages (batch);
+    }
+    else
+    {
+      this->handle_messages (batch);
+    }
+  }
+  catch (const Exception& e)
+  {
+    //- store exception into the msgs
+    for (size_t i = 0; i < batch.size(); i++)
+      if (! batch[i]->has_error())
+        batch[i]->set_error(e);
+  }
+  catch (...)
+  {
+    Exception e("UNKNOWN_ERROR",
+                "unknown error caught while handling msgs",
+                "Task::run_undetached");
+    //- store exception into the msgs
+    for (size_t i = 0; i < batch.size(); i++)
+      if (! batch[i]->has_error())
+        batch[i]->set_error(e);
+  }
+
+  //- latency stats: handling duration (evenly spread over the msgs of the batch)
+  if (t0 && ! batch.empty())
+  {
+    yat::uint64 dt = (MessageQ::latency_clock_ns() - t0) / batch.size();
+    for (size_t i = 0; i < batch.size(); i++)
+      this->msg_q_.record_handling(batch[i]->type(), dt);
+  }
+
+  //- mark messages as "processed" then release our msg refs
+  for (size_t i = 0; i < batch.size(); i++)
+  {
+    batch[i]->processed();
+    batch[i]->release();
+  }
+  batch.clear();
+}
+
+// ============================================================================
+// Task::run_undetached
+// ============================================================================
+void * Task::run_undetached (void *)
+{
+  YAT_TRACE("Task::run_undetached");
 
   //- init flag - set to true when TASK_INIT received
   this->received_init_msg_ = false;
 
-  size_t msg_type;
   Message * msg = 0;
 
   //- actual tmo on msg waiting
@@ -345,6 +685,9 @@ void * Task::run_undetached (void *)
   //- exit flag - set to true when TASK_EXIT received
   bool received_exit_msg = false;
 
+  //- batch mode: msgs extracted in one go from the msgQ
+  std::vector<Message *> batch;
+
   //- enter thread's main loop
   while ( ! received_exit_msg )
   {
@@ -364,11 +707,8 @@ void * Task::run_undetached (void *)
 #if defined (YAT_DEBUG)
         this->next_msg_counter++;
 #endif
-        //- get next message
-        if( precise_periodic_timing_enabled_ )
-          msg = this->msg_q_.next_message_ex (tmo);
-        else
-          msg = this->msg_q_.next_message (tmo);
+        //- get next message(s)
+        msg = this->next_message_i (tmo, batch);
         //- do not handle TASK_INIT twice
         if (msg && msg->type() == TASK_INIT && this->received_init_msg_)
         {
@@ -386,94 +726,125 @@ void * Task::run_undetached (void *)
       }
     }
 
-#if defined (YAT_DEBUG)
-    _GET_TIME (now);
-    YAT_LOG("Task::run_undetached::handling msg::elapsed msecs since last msg::"
-            << _ELAPSED_MSEC(last_notification_timestamp, now)
-            << " - actual tmo::"
-            << this->actual_timeout());
-    _GET_TIME (last_notification_timestamp);
-#endif
+    //- batch mode: pass the extracted user msgs to the batch handler
+    if (msg->type() >= FIRST_USER_MSG && ! batch.empty())
+      this->handle_messages_i (batch);
+    else
+      received_exit_msg = this->handle_message_i (msg);
+
+    //- reset msg in order to get next msg from msgQ
+    msg = 0;
+  } //- thread's while loop
 
-    //- set msg user data
-    msg->user_data(this->user_data_);
+  return 0;
+}
 
-    //- we may need msg type after msg release
-    msg_type = msg->type();
+// ============================================================================
+// Task::run_slice_i
+// ============================================================================
+bool Task::run_slice_i (double & deadline_)
+{
+  deadline_ = -1.;
 
-#if defined (YAT_DEBUG)
-    if (msg->is_task_ctrl_message ())
-      this->ctrl_msg_counter++;
-    else
-      this->user_msg_counter++;
+  //- TASK_EXIT handled: nothing more to do
+  if (this->exec_exited_)
+    return false;
 
-   YAT_LOG("Task::run_undetached::handling msg ["
-           << std::hex
-           << (void*)msg
-           << std::dec
-           << "]");
-#endif
+  double now = this->executor_->now_msec();
 
-    //- got a valid message from message Q
-    try
+  //- PERIODIC msg first (avoid its starvation in case of heavy msg load)
+  if (
+       this->received_init_msg_
+         &&
+       this->msg_q_.enable_periodic_msg_
+         &&
+       this->exec_next_periodic_ms_ >= 0.
+         &&
+       now >= this->exec_next_periodic_ms_
+     )
+  {
+    //- absolute dates: no drift (missed periods are skipped)
+    this->exec_next_periodic_ms_ += this->actual_timeout();
+    if (this->exec_next_periodic_ms_ <= now)
+      this->exec_next_periodic_ms_ = now + this->actual_timeout();
+    this->handle_message_i (new Message(TASK_PERIODIC));
+  }
+
+  //- then the pending msgs (up to the quantum - let the other tasks run)
+  bool more = false;
+  size_t handled = 0;
+  while (! this->exec_exited_)
+  {
+    if (handled >= kEXECUTOR_TASK_QUANTUM)
     {
-      //- std::cout << "Task::handling msg::"
-      //-            << std::hex
-      //-            << long(msg)
-      //-            << std::dec
-      //-            << "::"
-      //-            << msg->to_string()
-      //-            << std::endl;
-      //- call message handler
-      if (this->lock_msg_handling_)
-      {
-        //- enter critical section
-        MutexLock guard (this->m_lock);
-        this->handle_message (*msg);
-      }
-      else
-      {
-        this->handle_message (*msg);
-      }
+      more = true;
+      break;
     }
-    catch (const Exception& e)
+
+    //- get next message(s)
+    this->exec_msgs_.clear();
+    if (! this->msg_q_.try_next_messages (this->exec_msgs_, this->msg_batch_size_))
+      break;
+
+    handled += this->exec_msgs_.size();
+    this->exec_last_activity_ms_ = this->executor_->now_msec();
+
+    Message * msg = this->exec_msgs_[0];
+
+    //- do not handle TASK_INIT twice (nor any msg before TASK_INIT)
+    //- special case: ignore self-posted WAKEUP msg
+    bool ignore;
+    if (msg->type() == TASK_INIT)
     {
-      //- store exception into the message
-      msg->set_error(e);
+      ignore = this->received_init_msg_;
+      this->received_init_msg_ = true;
     }
-    catch (...)
+    else
     {
-      Exception e("UNKNOWN_ERROR",
-                  "unknown error caught while handling msg",
-                  "Task::run_undetached");
-      //- store exception into the message
-      msg->set_error(e);
+      ignore = ! this->received_init_msg_ || msg->type() == TASK_WAKEUP;
+    }
+    if (ignore)
+    {
+      for (size_t i = 0; i < this->exec_msgs_.size(); i++)
+        this->exec_msgs_[i]->release();
+      continue;
     }
-#if defined (YAT_DEBUG)
 
-   YAT_LOG("Task::run_undetached::msg ["
-           << std::hex
-           << (void*)msg
-           << std::dec
-           << "] handled - notifying waiters");
-#endif
-    //- mark message as "processed" (this will signal waiters if any)
-    msg->processed();
-    //- release our msg ref
-    msg->release();
-    //- abort requested?
-    if (msg_type == TASK_EXIT)
+    //- batch mode: pass the extracted user msgs to the batch handler
+    if (msg->type() >= FIRST_USER_MSG && this->msg_batch_size_ > 1)
+      this->handle_messages_i (this->exec_msgs_);
+    else
+      this->exec_exited_ = this->handle_message_i (msg);
+  }
+  this->exec_msgs_.clear();
+
+  if (this->exec_exited_ || ! this->received_init_msg_)
+    return false;
+
+  now = this->executor_->now_msec();
+
+  //- PERIODIC msg enabled: compute first PERIODIC msg date (if required)
+  if (this->msg_q_.enable_periodic_msg_)
+  {
+    if (this->exec_next_periodic_ms_ < 0.)
+      this->exec_next_periodic_ms_ = now + this->actual_timeout();
+    deadline_ = this->exec_next_periodic_ms_;
+    return more;
+  }
+  this->exec_next_periodic_ms_ = -1.;
+
+  //- TIMEOUT msg enabled: no msg received during the timeout period?
+  if (this->msg_q_.enable_timeout_msg_)
+  {
+    if (now >= this->exec_last_activity_ms_ + this->actual_timeout())
     {
-      //- close the msgQ
-      this->msg_q_.close();
-      //- mark TASK_EXIT as received (exit thread's main loop)
-      received_exit_msg = true;
+      this->exec_last_activity_ms_ = now;
+      this->handle_message_i (new Message(TASK_TIMEOUT));
     }
-    //- reset msg in order to get next msg from msgQ
-    msg = 0;
-  } //- thread's while loop
+    deadline_ = this->exec_last_activity_ms_ + this->actual_timeout();
+  }
 
-  return 0;
+  return more;
 }
 
 // ======================================================================
@@ -483,6 +854,38 @@ void Task::exit ()
 {
   YAT_TRACE("Task::exit");
 
+  //- executor mode: no underlying thread, just stop scheduling the task
+  if (this->executor_)
+  {
+    if (this->executor_->attached(this->exec_slot_))
+    {
+      yat::Message * msg = 0;
+      try
+      {
+        msg = Message::allocate (yat::TASK_EXIT, EXIT_MSG_PRIORITY, true);
+      }
+      catch (Exception &ex)
+      {
+        RETHROW_YAT_ERROR(ex,
+                          "SOFTWARE_ERROR",
+                          "Could not stop task [yat::Message allocation failed]",
+                          "Task::exit");
+      }
+      try
+      {
+        this->wait_msg_handled (msg, kINFINITE_WAIT);
+      }
+      catch (...)
+      {
+        //- ignore any error
+      }
+      //- wait for the task to leave its worker
+      this->executor_->detach(this->exec_slot_);
+    }
+    delete this;
+    return;
+  }
+
   //- we may have to implicitly delete the thread
   bool delete_self = false;
 
@@ -0,0 +1,551 @@
+//----------------------------------------------------------------------------
+// Copyright (c) 2004-2021 Synchrotron SOLEIL
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the GNU Lesser Public License v3
+// which accompanies this distribution, and is available at
+// http://www.gnu.org/licenses/lgpl.html
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// YAT LIBRARY
+//----------------------------------------------------------------------------
+//
+// Copyright (C) 2006-2021 The Tango Community
+//
+// Part of the code comes from the ACE Framework (asm bytes swaping code)
+// see http://www.cs.wustl.edu/~schmidt/ACE.html for more about ACE
+//
+// The thread native implementation has been initially inspired by omniThread
+// - the threading support library that comes with omniORB.
+// see http://omniorb.sourceforge.net/ for more about omniORB.
+//
+// Contributors form the TANGO community:
+// See AUTHORS file
+//
+// The YAT library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// The YAT library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+// Public License for more details.
+//
+// See COPYING file for license details
+//
+// Contact:
+//      Stephane Poirier
+//      Synchrotron SOLEIL
+//------------------------------------------------------------------------------
+/*!
+ * \author See AUTHORS file
+ */
+
+// ============================================================================
+// DEPENDENCIES
+// ============================================================================
+#include <deque>
+#include <yat/threading/Task.h>
+#include <yat/threading/TaskExecutor.h>
+
+namespace yat
+{
+
+// ======================================================================
+// TaskExecutorSlot: the scheduling state of a task
+// ======================================================================
+class TaskExecutorSlot
+{
+public:
+  typedef enum
+  {
+    //- not (or no more) scheduled: posted msgs are ignored
+    DETACHED,
+    //- waiting for a msg or its timer
+    IDLE,
+    //- in a run queue
+    SCHEDULED,
+    //- running on a worker
+    RUNNING,
+    //- running on a worker and notified meanwhile (must be requeued)
+    RUNNING_NOTIFIED
+  } State;
+
+  TaskExecutorSlot (Task * t)
+    : task (t), cond (lock), state (DETACHED), deadline (-1.)
+  {}
+
+  //- the task
+  Task * task;
+
+  //- protects <state>
+  Mutex lock;
+
+  //- signaled when the task leaves its worker
+  Condition cond;
+
+  //- scheduling state
+  State state;
+
+  //- armed timer deadline in msecs (-1 if none) - protected by the executor lock
+  double deadline;
+};
+
+// ======================================================================
+// TaskExecutorRunQueue: the run queue of a worker
+// ======================================================================
+class TaskExecutorRunQueue
+{
+public:
+  //- protects the run queue
+  Mutex lock;
+
+  //- the worker pops from the front, thieves steal from the back
+  std::deque<TaskExecutorSlot *> rq;
+};
+
+// ======================================================================
+// TaskExecutorWorker: a worker thread
+// ======================================================================
+class TaskExecutorWorker : public Thread
+{
+public:
+  TaskExecutorWorker (TaskExecutor * e, size_t i)
+    : executor_ (e), index_ (i)
+  {}
+
+  //- waits for the thread to quit (then deletes it)
+  virtual void exit ()
+  {
+    Thread::IOArg dummy = 0;
+    this->join(&dummy);
+  }
+
+protected:
+  virtual Thread::IOArg run_undetached (Thread::IOArg)
+  {
+    this->executor_->work(this->index_);
+    return 0;
+  }
+
+private:
+  TaskExecutor * executor_;
+  size_t index_;
+};
+
+// ======================================================================
+// TaskExecutor::TaskExecutor
+// ======================================================================
+TaskExecutor::TaskExecutor (size_t _num_workers)
+  : work_cond_ (lock_),
+    idle_workers_ (0),
+    next_worker_ (0),
+    stop_ (false)
+{
+  YAT_TRACE("TaskExecutor::TaskExecutor");
+
+  if (! _num_workers)
+    _num_workers = 1;
+
+  try
+  {
+    //- the run queues are owned by the executor: a worker is deleted when
+    //- joined while the others may still be stealing from its run queue
+    for (size_t i = 0; i < _num_workers; i++)
+      this->run_queues_.push_back(new TaskExecutorRunQueue);
+    for (size_t i = 0; i < _num_workers; i++)
+    {
+      TaskExecutorWorker * w = new TaskExecutorWorker(this, i);
+      this->workers_.push_back(w);
+    }
+    for (size_t i = 0; i < this->workers_.size(); i++)
+      this->workers_[i]->start_undetached();
+  }
+  catch (...)
+  {
+    {
+      MutexLock guard(this->lock_);
+      this->stop_ = true;
+      this->work_cond_.broadcast();
+    }
+    for (size_t i = 0; i < this->workers_.size(); i++)
+      this->workers_[i]->exit();
+    this->workers_.clear();
+    for (size_t i = 0; i < this->run_queues_.size(); i++)
+      delete this->run_queues_[i];
+    this->run_queues_.clear();
+    THROW_YAT_ERROR("OUT_OF_MEMORY",
+                    "could not start the executor worker threads",
+                    "TaskExecutor::TaskExecutor");
+  }
+}
+
+// ======================================================================
+// TaskExecutor::~TaskExecutor
+// ======================================================================
+TaskExecutor::~TaskExecutor ()
+{
+  YAT_TRACE("TaskExecutor::~TaskExecutor");
+
+  {
+    MutexLock guard(this->lock_);
+    this->stop_ = true;
+    this->work_cond_.broadcast();
+  }
+
+  for (size_t i = 0; i < this->workers_.size(); i++)
+  {
+    try
+    {
+      this->workers_[i]->exit();
+    }
+    catch (...)
+    {
+      //- ignore any error
+    }
+  }
+
+  //- all the workers are gone: nobody can access the run queues anymore
+  for (size_t i = 0; i < this->run_queues_.size(); i++)
+    delete this->run_queues_[i];
+}
+
+// ======================================================================
+// TaskExecutor::num_workers
+// ======================================================================
+size_t TaskExecutor::num_workers () const
+{
+  return this->run_queues_.size();
+}
+
+// ======================================================================
+// TaskExecutor::now_msec
+// ======================================================================
+double TaskExecutor::now_msec ()
+{
+  return this->clock_.elapsed_msec();
+}
+
+// ======================================================================
+// TaskExecutor::register_task
+// ======================================================================
+TaskExecutorSlot * TaskExecutor::register_task (Task * t)
+{
+  TaskExecutorSlot * s = new (std::nothrow) TaskExecutorSlot(t);
+  if (! s)
+  {
+    THROW_YAT_ERROR("OUT_OF_MEMORY",
+                    "TaskExecutorSlot allocation failed",
+                    "TaskExecutor::register_task");
+  }
+  return s;
+}
+
+// ======================================================================
+// TaskExecutor::unregister_task
+// ======================================================================
+void TaskExecutor::unregister_task (TaskExecutorSlot * s)
+{
+  //- the task has been detached (or never attached): nobody refers to the slot
+  delete s;
+}
+
+// ======================================================================
+// TaskExecutor::attach
+// ======================================================================
+void TaskExecutor::attach (TaskExecutorSlot * s)
+{
+  {
+    MutexLock guard(s->lock);
+    if (s->state != TaskExecutorSlot::DETACHED)
+      return;
+    s->state = TaskExecutorSlot::IDLE;
+  }
+  //- msgs may have been posted before the task was started
+  this->notify(s);
+}
+
+// ======================================================================
+// TaskExecutor::attached
+// ======================================================================
+bool TaskExecutor::attached (TaskExecutorSlot * s)
+{
+  MutexLock guard(s->lock);
+  return s->state != TaskExecutorSlot::DETACHED;
+}
+
+// ======================================================================
+// TaskExecutor::detach
+// ======================================================================
+void TaskExecutor::detach (TaskExecutorSlot * s)
+{
+  {
+    //- wait for the task to leave its worker (and any run queue)
+    MutexLock guard(s->lock);
+    while (s->state != TaskExecutorSlot::IDLE && s->state != TaskExecutorSlot::DETACHED)
+      s->cond.wait();
+    s->state = TaskExecutorSlot::DETACHED;
+  }
+  {
+    //- a detached task is no more scheduled on timer expiration
+    MutexLock guard(this->lock_);
+    this->arm_timer_i(s, -1.);
+  }
+}
+
+// ======================================================================
+// TaskExecutor::notify
+// ======================================================================
+void TaskExecutor::notify (TaskExecutorSlot * s)
+{
+  {
+    MutexLock guard(s->lock);
+    switch (s->state)
+    {
+      case TaskExecutorSlot::IDLE:
+        s->state = TaskExecutorSlot::SCHEDULED;
+        break;
+      case TaskExecutorSlot::RUNNING:
+        //- the worker running the task will requeue it
+        s->state = TaskExecutorSlot::RUNNING_NOTIFIED;
+        return;
+      default:
+        //- already scheduled (or detached)
+        return;
+    }
+  }
+
+  //- the notifying thread is not a worker: spread the tasks over the workers
+  size_t w = this->next_worker_.fetch_add(1, memory_order_relaxed) % this->run_queues_.size();
+  this->enqueue_i(s, w);
+}
+
+// ======================================================================
+// TaskExecutor::enqueue_i
+// ======================================================================
+void TaskExecutor::enqueue_i (TaskExecutorSlot * s, size_t w)
+{
+  {
+    MutexLock guard(this->run_queues_[w]->lock);
+    this->run_queues_[w]->rq.push_back(s);
+  }
+  //- wakeup an idle worker (if any) - no lost wakeup: a worker going idle
+  //- increments <idle_workers_> before checking the run queues (under their
+  //- lock) and holds <lock_> until it waits on <work_cond_>
+  if (! this->idle_workers_.load())
+    return;
+  MutexLock guard(this->lock_);
+  if (this->idle_workers_.load(memory_order_relaxed))
+    this->work_cond_.signal();
+}
+
+// ======================================================================
+// TaskExecutor::dequeue_i
+// ======================================================================
+TaskExecutorSlot * TaskExecutor::dequeue_i (size_t w)
+{
+  size_t n = this->run_queues_.size();
+
+  //- own run queue first, then try to steal from the others
+  for (size_t i = 0; i < n; i++)
+  {
+    TaskExecutorRunQueue * victim = this->run_queues_[(w + i) % n];
+    MutexLock guard(victim->lock);
+    if (victim->rq.empty())
+      continue;
+    TaskExecutorSlot * s;
+    if (i == 0)
+    {
+      s = victim->rq.front();
+      victim->rq.pop_front();
+    }
+    else
+    {
+      s = victim->rq.back();
+      victim->rq.pop_back();
+    }
+    return s;
+  }
+
+  return 0;
+}
+
+// ======================================================================
+// TaskExecutor::has_work_i
+// ======================================================================
+bool TaskExecutor::has_work_i ()
+{
+  for (size_t i = 0; i < this->run_queues_.size(); i++)
+  {
+    MutexLock guard(this->run_queues_[i]->lock);
+    if (! this->run_queues_[i]->rq.empty())
+      return true;
+  }
+  return false;
+}
+
+// ======================================================================
+// TaskExecutor::arm_timer_i
+// ======================================================================
+void TaskExecutor::arm_timer_i (TaskExecutorSlot * s, double _deadline)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  if (s->deadline == _deadline)
+    return;
+
+  //- disarm the current timer (if any)
+  if (s->deadline >= 0.)
+  {
+    typedef std::multimap<double, TaskExecutorSlot *>::iterator Iterator;
+    std::pair<Iterator, Iterator> r = this->timers_.equal_range(s->deadline);
+    for (Iterator it = r.first; it != r.second; ++it)
+    {
+      if (it->second == s)
+      {
+        this->timers_.erase(it);
+        break;
+      }
+    }
+  }
+
+  s->deadline = _deadline;
+
+  if (_deadline >= 0.)
+    this->timers_.insert(std::make_pair(_deadline, s));
+}
+
+// ======================================================================
+// TaskExecutor::fire_timers_i
+// ======================================================================
+void TaskExecutor::fire_timers_i (double _now, std::vector<TaskExecutorSlot *> & fired_)
+{
+  //- <this->lock_> MUST be locked by the calling thread
+  //----------------------------------------------------
+
+  while (! this->timers_.empty() && this->timers_.begin()->first <= _now)
+  {
+    TaskExecutorSlot * s = this->timers_.begin()->second;
+    this->timers_.erase(this->timers_.begin());
+    s->deadline = -1.;
+    //- lock order: executor lock then slot lock
+    MutexLock guard(s->lock);
+    if (s->state == TaskExecutorSlot::IDLE)
+    {
+      s->state = TaskExecutorSlot::SCHEDULED;
+      fired_.push_back(s);
+    }
+    else if (s->state == TaskExecutorSlot::RUNNING)
+    {
+      s->state = TaskExecutorSlot::RUNNING_NOTIFIED;
+    }
+  }
+}
+
+// ======================================================================
+// TaskExecutor::run_i
+// ======================================================================
+void TaskExecutor::run_i (TaskExecutorSlot * s, size_t w)
+{
+  {
+    MutexLock guard(s->lock);
+    s->state = TaskExecutorSlot::RUNNING;
+  }
+
+  //- handle (some of) the pending msgs
+  double deadline = -1.;
+  bool more = false;
+  try
+  {
+    more = s->task->run_slice_i(deadline);
+  }
+  catch (...)
+  {
+    //- ignore any error (msg handling errors are stored into the msgs)
+  }
+
+  //- arm the task timer before the task can be detached (i.e. before it
+  //- goes idle) then schedule the tasks which timer expired meanwhile
+  std::vector<TaskExecutorSlot *> fired;
+  {
+    MutexLock guard(this->lock_);
+    this->arm_timer_i(s, deadline);
+    this->fire_timers_i(this->now_msec(), fired);
+  }
+
+  bool requeue;
+  {
+    MutexLock guard(s->lock);
+    requeue = more || s->state == TaskExecutorSlot::RUNNING_NOTIFIED;
+    s->state = requeue ? TaskExecutorSlot::SCHEDULED : TaskExecutorSlot::IDLE;
+    if (! requeue)
+      s->cond.broadcast();
+  }
+
+  //- don't touch <s> from here unless it has been requeued (could be detached)
+  if (requeue)
+    this->enqueue_i(s, w);
+
+  for (size_t i = 0; i < fired.size(); i++)
+    this->enqueue_i(fired[i], w);
+}
+
+// ======================================================================
+// TaskExecutor::work
+// ======================================================================
+void TaskExecutor::work (size_t w)
+{
+  std::vector<TaskExecutorSlot *> fired;
+
+  while (true)
+  {
+    //- run the next task (if any)
+    TaskExecutorSlot * s = this->dequeue_i(w);
+    if (s)
+    {
+      this->run_i(s, w);
+      continue;
+    }
+
+    fired.clear();
+
+    { //- critical section
+
+      MutexLock guard(this->lock_);
+
+      if (this->stop_)
+        break;
+
+      //- no task to run: check the timers
+      this->fire_timers_i(this->now_msec(), fired);
+
+      if (fired.empty())
+      {
+        //- wait for a task to be scheduled or the next timer to expire
+        //- the run queues are checked once again since the enqueuing threads
+        //- only signal the condition if there is an idle worker
+        this->idle_workers_++;
+        if (! this->has_work_i())
+        {
+          if (this->timers_.empty())
+          {
+            this->work_cond_.wait();
+          }
+          else
+          {
+            double dt = this->timers_.begin()->first - this->now_msec();
+            this->work_cond_.timed_wait(dt < 1. ? 1 : static_cast<unsigned long>(dt + 0.5));
+          }
+        }
+        this->idle_workers_--;
+      }
+
+    } //- critical section
+
+    for (size_t i = 0; i < fired.size(); i++)
+      this->enqueue_i(fired[i], w);
+  }
+}
+
+} // namespace
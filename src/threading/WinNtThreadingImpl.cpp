@@ -263,8 +263,9 @@ bool Condition::timed_wait (unsigned long _tmo_msecs)
 // ----------------------------------------------------------------------------
 bool Condition::timed_wait (unsigned long _tmo_secs, unsigned long _tmo_nsecs)
 {
-  // Still limited to milliseconds precision on Win32
-  return timed_wait((_tmo_secs * 1000) + (_tmo_nsecs / 1000000));
+  // Still limited to milliseconds precision on Win32 (rounded up: a sub-millisecond
+  // tmo must not turn into an infinite wait)
+  return timed_wait((_tmo_secs * 1000) + ((_tmo_nsecs + 999999) / 1000000));
 }
 
 // ----------------------------------------------------------------------------
@@ -392,6 +393,18 @@ unsigned __stdcall yat_thread_common_entry_point (Thread::IOArg _p)
   return 0;
 }
 
+// ----------------------------------------------------------------------------
+// yat_to_nt_affinity (cpus above the mask size are ignored)
+// ----------------------------------------------------------------------------
+static DWORD_PTR yat_to_nt_affinity (const Thread::CpuSet & _cpus)
+{
+  DWORD_PTR mask = 0;
+  for (Thread::CpuSet::const_iterator it = _cpus.begin(); it != _cpus.end(); ++it)
+    if (*it < 8 * sizeof(DWORD_PTR))
+      mask |= static_cast<DWORD_PTR>(1) << *it;
+  return mask;
+}
+
 // ----------------------------------------------------------------------------
 // Thread::Thread
 // ----------------------------------------------------------------------------
@@ -399,6 +412,10 @@ Thread::Thread (Thread::IOArg _iarg, Thread::Priority _p)
  : //- platform independent members
    m_state (yat::Thread::STATE_NEW),
    m_priority (_p),
+   m_cpu_affinity (),
+   m_sched_policy (yat::Thread::SCHED_POLICY_DEFAULT),
+   m_sched_priority (0),
+   m_stack_size (0),
    m_iarg (_iarg),
    m_oarg (0),
    m_detached (true),
@@ -468,11 +485,14 @@ void Thread::spawn ()
 
   //- spawn the thread
   unsigned int nt_uid;
+  unsigned int flags = CREATE_SUSPENDED;
+  if (this->m_stack_size)
+    flags |= STACK_SIZE_PARAM_IS_A_RESERVATION;
   this->m_nt_thread_handle = (HANDLE)::_beginthreadex(WIN_NT_NULL,
-                                                      0,
+                                                      static_cast<unsigned int>(this->m_stack_size),
                                                       yat_thread_common_entry_point,
                                                       (LPVOID)this,
-                                                      CREATE_SUSPENDED,
+                                                      flags,
                                                       &nt_uid);
   //- check result
   if (this->m_nt_thread_handle == 0)
@@ -489,6 +509,13 @@ void Thread::spawn ()
   if (! ::SetThreadPriority(this->m_nt_thread_handle, yat_to_nt_priority(this->m_priority)))
     throw Exception(); //-TODO: GetLastError(), ..., ...
 
+  //- set the thread cpu affinity
+  DWORD_PTR mask = yat_to_nt_affinity(this->m_cpu_affinity);
+  if (mask && ! ::SetThreadAffinityMask(this->m_nt_thread_handle, mask))
+    THROW_YAT_ERROR("RUNTIME_ERROR",
+                    "could not set the thread cpu affinity",
+                    "Thread::spawn");
+
   YAT_LOG("Thread::spawn::resuming thread [was created suspended]");
 
   //- resume the thread (was created suspended)
@@ -566,6 +593,117 @@ void Thread::priority (Priority _p)
   this->m_priority = _p;
 }
 
+// ----------------------------------------------------------------------------
+// Thread::cpu_affinity
+// ----------------------------------------------------------------------------
+void Thread::cpu_affinity (const CpuSet & _cpus)
+{
+  YAT_TRACE("Thread::cpu_affinity");
+
+  //- enter critical section
+  MutexLock guard(this->m_lock);
+
+  //- apply affinity if thread is running
+  if (this->m_state == yat::Thread::STATE_RUNNING)
+  {
+    DWORD_PTR mask = yat_to_nt_affinity(_cpus);
+    if (! mask)
+    {
+      //- any cpu: use the process affinity
+      DWORD_PTR sys_mask = 0;
+      ::GetProcessAffinityMask(::GetCurrentProcess(), &mask, &sys_mask);
+    }
+    if (! ::SetThreadAffinityMask(this->m_nt_thread_handle, mask))
+      THROW_YAT_ERROR("RUNTIME_ERROR",
+                      "could not change the thread cpu affinity",
+                      "Thread::cpu_affinity");
+  }
+
+  //- store new affinity
+  this->m_cpu_affinity = _cpus;
+}
+
+// ----------------------------------------------------------------------------
+// Thread::cpu_affinity
+// ----------------------------------------------------------------------------
+Thread::CpuSet Thread::cpu_affinity ()
+{
+  //- enter critical section (no way to get the actual affinity of a thread)
+  MutexLock guard(this->m_lock);
+
+  return this->m_cpu_affinity;
+}
+
+// ----------------------------------------------------------------------------
+// Thread::scheduling
+// ----------------------------------------------------------------------------
+void Thread::scheduling (SchedPolicy _p, int)
+{
+  YAT_TRACE("Thread::scheduling");
+
+  //- no real-time scheduling policy on Windows
+  if (_p != yat::Thread::SCHED_POLICY_DEFAULT)
+    THROW_YAT_ERROR("RUNTIME_ERROR",
+                    "real-time scheduling policies are not supported on this platform [use Thread::priority instead]",
+                    "Thread::scheduling");
+
+  //- enter critical section
+  MutexLock guard(this->m_lock);
+
+  this->m_sched_policy = _p;
+  this->m_sched_priority = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Thread::sched_policy
+// ----------------------------------------------------------------------------
+Thread::SchedPolicy Thread::sched_policy ()
+{
+  //- enter critical section
+  MutexLock guard(this->m_lock);
+
+  return this->m_sched_policy;
+}
+
+// ----------------------------------------------------------------------------
+// Thread::sched_priority
+// ----------------------------------------------------------------------------
+int Thread::sched_priority ()
+{
+  //- enter critical section
+  MutexLock guard(this->m_lock);
+
+  return this->m_sched_priority;
+}
+
+// ----------------------------------------------------------------------------
+// Thread::stack_size
+// ----------------------------------------------------------------------------
+void Thread::stack_size (size_t _bytes)
+{
+  //- enter critical section
+  MutexLock guard(this->m_lock);
+
+  //- the stack is allocated when the thread is spawned
+  if (this->m_state != yat::Thread::STATE_NEW)
+    THROW_YAT_ERROR("PROGRAMMING_ERROR",
+                    "can't change the stack size of a thread once it has been started",
+                    "Thread::stack_size");
+
+  this->m_stack_size = _bytes;
+}
+
+// ----------------------------------------------------------------------------
+// Thread::stack_size
+// ----------------------------------------------------------------------------
+size_t Thread::stack_size ()
+{
+  //- enter critical section
+  MutexLock guard(this->m_lock);
+
+  return this->m_stack_size;
+}
+
 // ----------------------------------------------------------------------------
 // Thread::yat_to_nt_priority
 // ----------------------------------------------------------------------------
@@ -627,6 +765,23 @@ unsigned int ThreadingUtilities::harware_concurrency()
   return sysinfo.dwNumberOfProcessors;
 }
 
+// ----------------------------------------------------------------------------
+// ThreadingUtilities::yield
+// ----------------------------------------------------------------------------
+void ThreadingUtilities::yield ()
+{
+  ::SwitchToThread();
+}
+
+// ----------------------------------------------------------------------------
+// ThreadingUtilities::thread_index
+// ----------------------------------------------------------------------------
+unsigned int ThreadingUtilities::thread_index ()
+{
+  //- thread identifiers are multiples of 4
+  return static_cast<unsigned int>(::GetCurrentThreadId() >> 2);
+}
+
 // ----------------------------------------------------------------------------
 // ThreadingUtilities::get_time
 // ----------------------------------------------------------------------------
@@ -41,6 +41,7 @@
 // DEPENDENCIES
 //=============================================================================
 #include <yat/time/Time.h>
+#include <yat/time/Timer.h>
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -57,6 +58,11 @@
   #include <sys/time.h>
 #endif
 
+#if defined (YAT_FAST_TIMER_TSC)
+  #include <cpuid.h>
+  #include <unistd.h>
+#endif
+
 // standard library objets
 #include <iostream>
 #include <time.h>
@@ -1914,4 +1920,60 @@ std::string Duration::to_iso8601() const
   return duration;
 }
 
+//----------------------------------------------------------------------------
+// FastTimer::calibration
+//----------------------------------------------------------------------------
+const FastTimer::Calibration & FastTimer::calibration()
+{
+  struct Calibrator
+  {
+    static Calibration calibrate()
+    {
+      Calibration c;
+      c.tsc = false;
+#if defined (YAT_WIN32)
+      LARGE_INTEGER f;
+      ::QueryPerformanceFrequency(&f);
+      c.nsecs_per_tick = 1e9 / static_cast<double>(f.QuadPart);
+#else
+      c.nsecs_per_tick = 1.;
+#endif
+
+#if defined (YAT_FAST_TIMER_TSC)
+      //- the TSC must be invariant (i.e. constant rate accross P/C-states)
+      unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+      if( ! __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || ! (edx & (1 << 8)) )
+        return c;
+
+      //- measure the TSC frequency against the monotonic clock
+      struct timespec t0, t1;
+      ::clock_gettime(CLOCK_MONOTONIC, &t0);
+      yat::uint64 tsc0 = __builtin_ia32_rdtsc();
+      ::usleep(5000);
+      ::clock_gettime(CLOCK_MONOTONIC, &t1);
+      yat::uint64 tsc1 = __builtin_ia32_rdtsc();
+
+      double dt_ns = 1e9 * (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec);
+      if( tsc1 > tsc0 && dt_ns > 0. )
+      {
+        c.tsc = true;
+        c.nsecs_per_tick = dt_ns / static_cast<double>(tsc1 - tsc0);
+      }
+#endif
+      return c;
+    }
+  };
+
+  static const Calibration c = Calibrator::calibrate();
+  return c;
+}
+
+//----------------------------------------------------------------------------
+// FastTimer::tsc_based
+//----------------------------------------------------------------------------
+bool FastTimer::tsc_based()
+{
+  return FastTimer::calibration().tsc;
+}
+
 }